@@ -0,0 +1,440 @@
+/******************************************************************************
+ADOBE SYSTEMS INCORPORATED
+ Copyright 2013 Adobe Systems Incorporated
+ All Rights Reserved.
+
+NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the 
+terms of the Adobe license agreement accompanying it.  If you have received this file from a 
+source other than Adobe, then your use, modification, or distribution of it requires the prior 
+written permission of Adobe.
+******************************************************************************/
+
+// Reads the binary container written by BinaryOutputWriter and builds the same
+// DOMDocument object that the JSON output produces. Ids are numbers, matrices and 
+// path coordinates are Float32Arrays and visibility is a boolean.
+
+var kBinaryMagic = "CJSB";
+var kBinaryVersion = 4;
+
+var kBinaryCapNames = ["butt", "round", "square"];
+var kBinaryJoinNames = ["miter", "round", "bevel"];
+var kBinarySpreadNames = ["pad", "reflect", "repeat", "none"];
+var kBinaryBlendModeNames = ["Normal", "Layer", "Darken", "Multiply", "Lighten", "Screen", "Overlay", 
+	"Hardlight", "Add", "Substract", "Difference", "Invert", "Alpha", "Erase"];
+
+// Typed array views can only be used when the file and the platform agree on byte order
+var kLittleEndianPlatform = (new Uint8Array(new Uint32Array([1]).buffer))[0] == 1;
+
+function LoadBinaryDocument(url, callback)
+{
+	var request = new XMLHttpRequest();
+	request.open("GET", url, true);
+	request.responseType = "arraybuffer";
+	request.onload = function() {
+		callback(ParseBinaryDocument(request.response));
+	};
+	request.send();
+}
+
+var BinaryReader = function(buffer) 
+{
+	this.m_buffer = buffer;
+	this.m_view = new DataView(buffer);
+	this.m_offset = 0;
+}
+
+BinaryReader.prototype.readU32 = function() {
+	var value = this.m_view.getUint32(this.m_offset, true);
+	this.m_offset += 4;
+	return value;
+}
+
+BinaryReader.prototype.readF32 = function() {
+	var value = this.m_view.getFloat32(this.m_offset, true);
+	this.m_offset += 4;
+	return value;
+}
+
+BinaryReader.prototype.readTag = function() {
+	var tag = String.fromCharCode(
+		this.m_view.getUint8(this.m_offset),
+		this.m_view.getUint8(this.m_offset + 1),
+		this.m_view.getUint8(this.m_offset + 2),
+		this.m_view.getUint8(this.m_offset + 3));
+	this.m_offset += 4;
+	return tag;
+}
+
+BinaryReader.prototype.readString = function() {
+	var length = this.readU32();
+	var bytes = new Uint8Array(this.m_buffer, this.m_offset, length);
+	var str;
+
+	if (typeof TextDecoder !== "undefined")
+	{
+		str = new TextDecoder("utf-8").decode(bytes);
+	}
+	else
+	{
+		str = "";
+		for (var i = 0; i < length; i++)
+		{
+			str += String.fromCharCode(bytes[i]);
+		}
+		str = decodeURIComponent(escape(str));
+	}
+
+	this.m_offset += (length + 3) & ~3;
+	return str;
+}
+
+BinaryReader.prototype.readF32Array = function(count) {
+	var array;
+
+	if (kLittleEndianPlatform)
+	{
+		array = new Float32Array(this.m_buffer, this.m_offset, count);
+		this.m_offset += count * 4;
+	}
+	else
+	{
+		array = new Float32Array(count);
+		for (var i = 0; i < count; i++)
+		{
+			array[i] = this.readF32();
+		}
+	}
+	return array;
+}
+
+BinaryReader.prototype.readU8Array = function(count) {
+	var array = new Uint8Array(this.m_buffer, this.m_offset, count);
+	this.m_offset += (count + 3) & ~3;
+	return array;
+}
+
+BinaryReader.prototype.readColor = function() {
+	var rgba = this.readU32();
+	var rgb = (rgba >>> 8).toString(16);
+	while (rgb.length < 6)
+	{
+		rgb = "0" + rgb;
+	}
+	return { color: "#" + rgb, opacity: (rgba & 0xFF) / 255 };
+}
+
+function ReadBinaryGradientStops(reader)
+{
+	var stops = [];
+	var count = reader.readU32();
+	for (var s = 0; s < count; s++)
+	{
+		var offset = reader.readF32();
+		var color = reader.readColor();
+		stops.push({ offset: offset, stopColor: color.color, stopOpacity: color.opacity });
+	}
+	return stops;
+}
+
+function ReadBinaryFillStyle(reader, path)
+{
+	var fillType = reader.readU32();
+	switch (fillType)
+	{
+		case 1: // Solid
+			var color = reader.readColor();
+			path.color = color.color;
+			path.colorOpacity = color.opacity;
+		break;
+
+		case 2: // Bitmap
+			path.image = {};
+			path.image.height = reader.readU32();
+			path.image.width = reader.readU32();
+			path.image.bitmapPath = reader.readString();
+			path.image.patternUnits = "userSpaceOnUse";
+			path.image.patternTransform = reader.readF32Array(6);
+		break;
+
+		case 5: // Bitmap on an atlas page
+			path.image = {};
+			path.image.height = reader.readU32();
+			path.image.width = reader.readU32();
+			path.image.bitmapPath = reader.readString();
+			path.image.patternUnits = "userSpaceOnUse";
+			path.image.patternTransform = reader.readF32Array(6);
+			path.image.atlasX = reader.readU32();
+			path.image.atlasY = reader.readU32();
+		break;
+
+		case 3: // Linear gradient
+			path.linearGradient = {};
+			path.linearGradient.x1 = reader.readF32();
+			path.linearGradient.y1 = reader.readF32();
+			path.linearGradient.x2 = reader.readF32();
+			path.linearGradient.y2 = reader.readF32();
+			path.linearGradient.spreadMethod = kBinarySpreadNames[reader.readU32()];
+			path.linearGradient.stop = ReadBinaryGradientStops(reader);
+		break;
+
+		case 4: // Radial gradient
+			path.radialGradient = {};
+			path.radialGradient.cx = 0;
+			path.radialGradient.cy = 0;
+			path.radialGradient.r = reader.readF32();
+			path.radialGradient.fx = reader.readF32();
+			path.radialGradient.fy = reader.readF32();
+			path.radialGradient.gradientTransform = reader.readF32Array(6);
+			path.radialGradient.spreadMethod = kBinarySpreadNames[reader.readU32()];
+			path.radialGradient.stop = ReadBinaryGradientStops(reader);
+		break;
+	}
+}
+
+function ReadBinaryShape(reader)
+{
+	var shape = { charid: reader.readU32(), path: [] };
+	var pathCount = reader.readU32();
+
+	for (var p = 0; p < pathCount; p++)
+	{
+		var path = {};
+		var pathType = reader.readU32();
+
+		ReadBinaryFillStyle(reader, path);
+
+		if (pathType == 0)
+		{
+			path.pathType = "Fill";
+			path.stroke = "none";
+		}
+		else if (pathType == 1)
+		{
+			path.pathType = "Stroke";
+			path.fill = "none";
+			path.strokeWidth = reader.readF32();
+			path.strokeLinecap = kBinaryCapNames[reader.readU32()];
+			path.strokeLinejoin = kBinaryJoinNames[reader.readU32()];
+			var miterLimit = reader.readF32();
+			if (path.strokeLinejoin == "miter")
+			{
+				path["stroke-miterlimit"] = miterLimit;
+			}
+		}
+
+		path.cmds = reader.readU8Array(reader.readU32());
+		path.coords = reader.readF32Array(reader.readU32());
+
+		shape.path.push(path);
+	}
+
+	return shape;
+}
+
+function ReadBinaryCommand(reader)
+{
+	var cmd = {};
+	var type = reader.readU32();
+
+	switch (type)
+	{
+		case 0:
+			var flags = reader.readU32();
+			cmd.cmdType = "Place";
+			cmd.charid = reader.readU32();
+			cmd.objectId = reader.readU32();
+			if (flags & 0x1)
+			{
+				cmd.placeAfter = reader.readU32();
+			}
+			if (flags & 0x2)
+			{
+				cmd.transformMatrix = reader.readF32Array(6);
+			}
+			if (flags & 0x4)
+			{
+				cmd.loopMode = reader.readU32();
+				cmd.repeatCount = reader.readU32();
+				cmd.syncMode = reader.readU32();
+				cmd.LimitInPos44 = reader.readU32();
+				cmd.LimitOutPos44 = reader.readU32();
+			}
+		break;
+
+		case 1:
+			cmd.cmdType = "Move";
+			cmd.objectId = reader.readU32();
+			cmd.transformMatrix = reader.readF32Array(6);
+		break;
+
+		case 2:
+			cmd.cmdType = "Remove";
+			cmd.objectId = reader.readU32();
+		break;
+
+		case 3:
+			cmd.cmdType = "UpdateZOrder";
+			cmd.objectId = reader.readU32();
+			cmd.placeAfter = reader.readU32();
+		break;
+
+		case 4:
+			cmd.cmdType = "UpdateVisibility";
+			cmd.objectId = reader.readU32();
+			cmd.visibility = reader.readU32() != 0;
+		break;
+
+		case 5:
+			cmd.cmdType = "UpdateBlendMode";
+			cmd.objectId = reader.readU32();
+			cmd.blendMode = kBinaryBlendModeNames[reader.readU32()];
+		break;
+	}
+
+	return cmd;
+}
+
+function ReadBinaryTimeline(reader)
+{
+	var timeline = {};
+	var charid = reader.readU32();
+	var frameCount = reader.readU32();
+
+	// The main timeline has no charid
+	if (charid != 0)
+	{
+		timeline.charid = charid;
+	}
+	timeline.Frame = [];
+
+	for (var f = 0; f < frameCount; f++)
+	{
+		var frame = { num: reader.readU32(), Command: [] };
+
+		var commandCount = reader.readU32();
+		for (var c = 0; c < commandCount; c++)
+		{
+			frame.Command.push(ReadBinaryCommand(reader));
+		}
+
+		var scriptCount = reader.readU32();
+		for (var s = 0; s < scriptCount; s++)
+		{
+			var layerNum = reader.readU32();
+			frame["script Layer" + layerNum] = reader.readString();
+		}
+
+		var labelCount = reader.readU32();
+		for (var l = 0; l < labelCount; l++)
+		{
+			var labelType = reader.readU32();
+			var label = reader.readString();
+			if (labelType == 1)
+				frame["LabelType:Name"] = label;
+			else if (labelType == 2)
+				frame["labelType:Comment"] = label;
+			else if (labelType == 3)
+				frame["labelType:Ancor"] = label;
+			else if (labelType == 0)
+				frame["labelType"] = "None";
+		}
+
+		timeline.Frame.push(frame);
+	}
+
+	return timeline;
+}
+
+function ParseBinaryDocument(buffer)
+{
+	var reader = new BinaryReader(buffer);
+	var doc = { Shape: [], Bitmaps: [], Sounds: [], Text: [], Aliases: {}, Resampled: {}, Timeline: [] };
+
+	if (reader.readTag() != kBinaryMagic)
+	{
+		console.log("Not a binary CreateJS document");
+		return undefined;
+	}
+
+	var version = reader.readU32();
+	if (version > kBinaryVersion)
+	{
+		console.log("Unsupported binary document version " + version);
+		return undefined;
+	}
+
+	while (reader.m_offset < buffer.byteLength)
+	{
+		var tag = reader.readTag();
+		var length = reader.readU32();
+		var chunkEnd = reader.m_offset + length;
+
+		switch (tag)
+		{
+			case "SHAP":
+				doc.Shape.push(ReadBinaryShape(reader));
+			break;
+
+			case "BTMP":
+				var bitmap = {};
+				bitmap.charid = reader.readU32();
+				bitmap.height = reader.readU32();
+				bitmap.width = reader.readU32();
+				bitmap.bitmapPath = reader.readString();
+				if (reader.m_offset < chunkEnd)
+				{
+					// Position on the atlas page
+					bitmap.atlasX = reader.readU32();
+					bitmap.atlasY = reader.readU32();
+				}
+				doc.Bitmaps.push(bitmap);
+			break;
+
+			case "SOND":
+				var sound = {};
+				sound.charid = reader.readU32();
+				sound.soundPath = reader.readString();
+				doc.Sounds.push(sound);
+			break;
+
+			case "TEXT":
+				var text = {};
+				text.charid = reader.readU32();
+				text.displayText = reader.readString();
+				text.font = reader.readString();
+				text.color = reader.readColor().color;
+				doc.Text.push(text);
+			break;
+
+			case "TMLN":
+				doc.Timeline.push(ReadBinaryTimeline(reader));
+			break;
+
+			case "ALIS":
+				var count = reader.readU32();
+				for (var i = 0; i < count; i++)
+				{
+					var path = reader.readString();
+					doc.Aliases[path] = reader.readString();
+				}
+			break;
+
+			case "RSMP":
+				var count = reader.readU32();
+				for (var i = 0; i < count; i++)
+				{
+					var path = reader.readString();
+					var size = {};
+					size.width = reader.readU32();
+					size.height = reader.readU32();
+					doc.Resampled[path] = size;
+				}
+			break;
+		}
+
+		// Unknown chunks are skipped
+		reader.m_offset = chunkEnd;
+	}
+
+	return { DOMDocument: doc };
+}
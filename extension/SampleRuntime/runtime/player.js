@@ -14,6 +14,8 @@ var rootAnimator = undefined;
 var cbk = undefined;
 var interval = 1000/24;
 var gStage = undefined;
+var liveReload = undefined;
+var bitmapVersion = 0;
 
 function init(stage, jsonOutputFile, fps)
 {
@@ -21,15 +23,26 @@ function init(stage, jsonOutputFile, fps)
 	gStage = stage;
 	interval = 1000 / fps;
 	//TODO - Wait for load for everything else
-	//Load the json
-	$.get(jsonOutputFile, function(json) {
+	var onLoad = function(json) {
 		data = json;
 		console.log(data);
 		resourceManager = new ResourceManager(data);
-		reset(stage);
-		
-		play();
-	});
+		resourceManager.loadAtlasPages(function() {
+			reset(stage);
+			
+			play();
+			connectLiveReload();
+		});
+	};
+	//Load the json (or the binary document)
+	if(/\.bin$/i.test(jsonOutputFile))
+	{
+		LoadBinaryDocument(jsonOutputFile, onLoad);
+	}
+	else
+	{
+		$.get(jsonOutputFile, onLoad);
+	}
 }		
 	
 function play() 
@@ -78,3 +91,96 @@ function reset(stage)
 	rootAnimator = new TimelineAnimator(stage, MainTimeline);
 	//play();
 }
+
+//Previews are served by the publisher on localhost, which tells the page when the
+//document is published again
+function connectLiveReload()
+{
+	if(location.hostname != "localhost" || typeof WebSocket === "undefined" || liveReload !== undefined)
+	{
+		return;
+	}
+	var pageName = decodeURIComponent(location.pathname.substring(1));
+	liveReload = new WebSocket("ws://" + location.host + "/livereload");
+	liveReload.onopen = function() {
+		liveReload.send(pageName);
+	};
+	liveReload.onmessage = function(event) {
+		var message = JSON.parse(event.data);
+		if(message.type == "update")
+		{
+			applyUpdate(message.DOMDocument);
+		}
+		else
+		{
+			location.reload();
+		}
+	};
+}
+
+//Replaces the shapes, bitmaps, texts, sounds and timelines that changed and restarts
+//the animation
+function applyUpdate(update)
+{
+	var doc = resourceManager.m_data.DOMDocument;
+	for(var name in update)
+	{
+		var elements = doc[name];
+		var changed = update[name];
+		for(var i = 0; i < changed.length; i++)
+		{
+			var index = -1;
+			for(var j = 0; j < elements.length; j++)
+			{
+				if(elements[j].charid == changed[i].charid)
+				{
+					index = j;
+					break;
+				}
+			}
+			if(index >= 0)
+			{
+				elements[index] = changed[i];
+			}
+			else if(name == "Timeline")
+			{
+				//The main timeline stays the last one
+				elements.splice(elements.length - 1, 0, changed[i]);
+			}
+			else
+			{
+				elements.push(changed[i]);
+			}
+		}
+	}
+
+	//Bitmaps are exported again under the same name
+	bitmapVersion++;
+	var setVersion = function(image) {
+		image.bitmapPath = image.bitmapPath.replace(/\?.*$/, "") + "?v=" + bitmapVersion;
+	};
+	for(var i = 0; i < doc.Bitmaps.length; i++)
+	{
+		setVersion(doc.Bitmaps[i]);
+	}
+	for(var i = 0; i < doc.Shape.length; i++)
+	{
+		var paths = doc.Shape[i].path || [];
+		for(var j = 0; j < paths.length; j++)
+		{
+			if(paths[j].image)
+			{
+				setVersion(paths[j].image);
+			}
+		}
+	}
+
+	pause();
+	gStage.removeAllChildren();
+	rootAnimator = undefined;
+	resourceManager = new ResourceManager(resourceManager.m_data);
+	resourceManager.loadAtlasPages(function() {
+		reset(gStage);
+		play();
+	});
+}
@@ -14,7 +14,11 @@ var ResourceManager = function(data) {
 	this.m_movieClips = [];
 	this.m_bitmaps = [];
 	this.m_text =[];
+	this.m_atlasPages = {};
+	this.m_atlasImages = {};
 	this.m_data = data;
+	this.m_aliases = this.m_data.DOMDocument.Aliases || {};
+	this.m_resampled = this.m_data.DOMDocument.Resampled || {};
 	
 	//Parse shapes and movieClips	
 	for(var shapeIndex =0; shapeIndex < this.m_data.DOMDocument.Shape.length; shapeIndex++)
@@ -23,12 +27,45 @@ var ResourceManager = function(data) {
 		var shapeData = this.m_data.DOMDocument.Shape[shapeIndex];
 		this.m_shapes[id] = shapeData;
 	}
+
+	//The keys of a morph are always full shapes
+	for(var shapeIndex =0; shapeIndex < this.m_data.DOMDocument.Shape.length; shapeIndex++)
+	{
+		var shapeData = this.m_data.DOMDocument.Shape[shapeIndex];
+		if(shapeData.morph !== undefined)
+		{
+			this.resolveMorph(shapeData);
+		}
+	}
 	
 	for(var bitmapIndex =0; bitmapIndex < this.m_data.DOMDocument.Bitmaps.length; bitmapIndex++)
 	{
 		var id = this.m_data.DOMDocument.Bitmaps[bitmapIndex].charid;
 		var bitmapData = this.m_data.DOMDocument.Bitmaps[bitmapIndex];
 		this.m_bitmaps[id] = bitmapData;
+		this.setFileSize(bitmapData);
+		bitmapData.bitmapPath = this.resolvePath(bitmapData.bitmapPath);
+		this.addAtlasPage(bitmapData);
+	}
+
+	for(var shapeIndex =0; shapeIndex < this.m_data.DOMDocument.Shape.length; shapeIndex++)
+	{
+		var paths = this.m_data.DOMDocument.Shape[shapeIndex].path || [];
+		for(var pathIndex =0; pathIndex < paths.length; pathIndex++)
+		{
+			if(paths[pathIndex].image)
+			{
+				this.setFileSize(paths[pathIndex].image);
+				paths[pathIndex].image.bitmapPath = this.resolvePath(paths[pathIndex].image.bitmapPath);
+				this.addAtlasPage(paths[pathIndex].image);
+			}
+		}
+	}
+	
+	var sounds = this.m_data.DOMDocument.Sounds || [];
+	for(var soundIndex =0; soundIndex < sounds.length; soundIndex++)
+	{
+		sounds[soundIndex].soundPath = this.resolvePath(sounds[soundIndex].soundPath);
 	}
 	
 	for(var textIndex =0; textIndex < this.m_data.DOMDocument.Text.length; textIndex++)
@@ -66,5 +103,142 @@ ResourceManager.prototype.getText = function(id) {
 	return this.m_text[id];
 }
 
+//Shapes between the keys of a shape tween are written as "morph": the paths of the
+//"from" key with every number moved the ratio of the way to the "to" key. Must match
+//the ShapeMorpher of the publisher.
+ResourceManager.prototype.resolveMorph = function(shapeData) {
+	var from = this.m_shapes[shapeData.morph.from].path;
+	var to = this.m_shapes[shapeData.morph.to].path;
+	var ratio = parseFloat(shapeData.morph.ratio);
+	shapeData.path = [];
+	for(var pathIndex =0; pathIndex < from.length; pathIndex++)
+	{
+		var path = {};
+		for(var key in from[pathIndex])
+		{
+			path[key] = this.morphValue(key, from[pathIndex][key], to[pathIndex][key], ratio);
+		}
+		shapeData.path.push(path);
+	}
+}
 
+ResourceManager.prototype.morphValue = function(key, from, to, ratio) {
+	var lerp = function(a, b) {
+		return a + (b - a) * ratio;
+	};
+	if(key == "d")
+	{
+		var fromTokens = from.split(" ");
+		var toTokens = to.split(" ");
+		for(var i = 0; i < fromTokens.length; i++)
+		{
+			if(fromTokens[i] != "" && !isNaN(fromTokens[i]))
+			{
+				fromTokens[i] = lerp(parseFloat(fromTokens[i]), parseFloat(toTokens[i]));
+			}
+		}
+		return fromTokens.join(" ");
+	}
+	if(key == "color")
+	{
+		var color = "#";
+		for(var i = 1; i < 7; i += 2)
+		{
+			var channel = Math.round(lerp(parseInt(from.substring(i, i + 2), 16), parseInt(to.substring(i, i + 2), 16)));
+			color += (channel < 16 ? "0" : "") + channel.toString(16);
+		}
+		return color;
+	}
+	if(key == "colorOpacity" || key == "strokeWidth" || key == "stroke-miterlimit")
+	{
+		return String(lerp(parseFloat(from), parseFloat(to)));
+	}
+	//Caps, joins and path types are the same in both keys
+	return from;
+}
+
+//Files with the same content as another one are removed by the publisher and listed
+//in Aliases. A version added by a live update is kept.
+ResourceManager.prototype.resolvePath = function(path) {
+	var query = path.indexOf("?");
+	var file = (query < 0) ? path : path.substring(0, query);
+	if(this.m_aliases[file] === undefined)
+	{
+		return path;
+	}
+	return this.m_aliases[file] + ((query < 0) ? "" : path.substring(query));
+}
+
+//Bitmaps written smaller than their library item are listed in Resampled (under the
+//path before aliasing) with the size of the file
+ResourceManager.prototype.setFileSize = function(image) {
+	var query = image.bitmapPath.indexOf("?");
+	var file = (query < 0) ? image.bitmapPath : image.bitmapPath.substring(0, query);
+	var size = this.m_resampled[file];
+	if(size !== undefined)
+	{
+		image.fileWidth = parseInt(size.width);
+		image.fileHeight = parseInt(size.height);
+	}
+}
+
+//Bitmaps packed by the publisher have atlasX/atlasY and the page as bitmapPath
+ResourceManager.prototype.addAtlasPage = function(image) {
+	if(image.atlasX !== undefined && this.m_atlasPages[image.bitmapPath] === undefined)
+	{
+		this.m_atlasPages[image.bitmapPath] = new Image();
+	}
+}
+
+//Fills need the bitmap on its own, so all the pages are loaded before playback starts
+ResourceManager.prototype.loadAtlasPages = function(callback) {
+	var pending = 1;
+	var onPageLoad = function() {
+		if(--pending == 0)
+		{
+			callback();
+		}
+	};
+	for(var path in this.m_atlasPages)
+	{
+		pending++;
+		this.m_atlasPages[path].onload = onPageLoad;
+		this.m_atlasPages[path].onerror = onPageLoad;
+		this.m_atlasPages[path].src = path;
+	}
+	onPageLoad();
+}
 
+//The image to draw a bitmap with (and its rectangle on it), or to fill a path with
+ResourceManager.prototype.getBitmapImage = function(image) {
+	if(image.atlasX === undefined)
+	{
+		var standalone = new Image();
+		standalone.src = image.bitmapPath;
+		return standalone;
+	}
+	var key = image.bitmapPath + "#" + image.atlasX + "," + image.atlasY;
+	if(this.m_atlasImages[key] === undefined)
+	{
+		var canvas = document.createElement("canvas");
+		canvas.width = image.width;
+		canvas.height = image.height;
+		canvas.getContext("2d").drawImage(this.m_atlasPages[image.bitmapPath], 
+			-parseInt(image.atlasX), -parseInt(image.atlasY));
+		this.m_atlasImages[key] = canvas;
+	}
+	return this.m_atlasImages[key];
+}
+
+ResourceManager.prototype.getBitmapSourceRect = function(image) {
+	if(image.atlasX === undefined)
+	{
+		return null;
+	}
+	return new createjs.Rectangle(parseInt(image.atlasX), parseInt(image.atlasY), 
+		parseInt(image.width), parseInt(image.height));
+}
+
+ResourceManager.prototype.getAtlasPage = function(image) {
+	return this.m_atlasPages[image.bitmapPath];
+}
@@ -19,12 +19,25 @@ var TimelineAnimator = function(targetMovieClip, timeline , transform)
 	//Frame is a collection of Command Objects
 	this.m_timeline = timeline;
 	this.m_currentFrameNo = 0;
-	this.m_frameCount = this.m_timeline.Frame.length;
+	if(this.m_timeline.encoding == "delta" || this.m_timeline.tweens !== undefined)
+	{
+		//The decoded frames are shared by all the instances of the timeline
+		if(this.m_timeline.m_decoder === undefined)
+		{
+			this.m_timeline.m_decoder = new TimelineDecoder(this.m_timeline);
+		}
+		this.m_decoder = this.m_timeline.m_decoder;
+		this.m_frameCount = this.m_decoder.m_frameCount;
+	}
+	else
+	{
+		this.m_frameCount = this.m_timeline.Frame.length;
+	}
 	if(this.m_transform !== undefined) 
 	{
 		//Apply the transformation on the parent MC
 		var transformData =  this.m_transform;
-		var transformArray = transformData.split(",");
+		var transformArray = GetTransformArray(transformData);
 		var scaleX,scaleY,rotation,skewX,skewY;
 		var TransformMat = new createjs.Matrix2D(transformArray[0],transformArray[1],transformArray[2],transformArray[3],transformArray[4],transformArray[5])
 		scaleX = Math.sqrt((transformArray[0]*transformArray[0])+ (transformArray[1]*transformArray[1]));
@@ -41,6 +54,16 @@ var TimelineAnimator = function(targetMovieClip, timeline , transform)
 	//this.kStr_CharID = "charid";
 };
 
+//Returns the frame (a collection of Command Objects) at the given index
+TimelineAnimator.prototype.getFrame = function(frameNo) 
+{
+	if(this.m_decoder !== undefined)
+	{
+		return this.m_decoder.getFrame(frameNo);
+	}
+	return this.m_timeline.Frame[frameNo];
+}
+
 //member functions for MovieClip
 TimelineAnimator.prototype.play = function(resourceManager) 
 {
@@ -66,7 +89,7 @@ TimelineAnimator.prototype.play = function(resourceManager)
         // Reset frame number 
 	    this.m_currentFrameNo = 0;
 
-	    var frame = this.m_timeline.Frame[this.m_currentFrameNo];	
+	    var frame = this.getFrame(this.m_currentFrameNo);	
 
 	    //Get the commands for the first frame
 	    var commands = frame.Command;	
@@ -98,7 +121,7 @@ TimelineAnimator.prototype.play = function(resourceManager)
 	}
 		
 	//Get the current frame
-	var frame = this.m_timeline.Frame[this.m_currentFrameNo];	
+	var frame = this.getFrame(this.m_currentFrameNo);	
 	//Get the commands for the current frame
 	var commands = frame.Command;
 
@@ -254,7 +277,7 @@ MoveObjectCommand.prototype.execute = function(timelineAnimator, resourceManager
 	console.log("Move command execute");
 	var parentMC = timelineAnimator.m_targetMC;
 	var transform =  this.m_transform;
-	var transformArray = transform.split(",");
+	var transformArray = GetTransformArray(transform);
 	var scaleX,scaleY,rotation,skewX,skewY;
 	var TransformMat = new createjs.Matrix2D(transformArray[0],transformArray[1],transformArray[2],transformArray[3],transformArray[4],transformArray[5])
 	scaleX = Math.sqrt((transformArray[0]*transformArray[0])+ (transformArray[1]*transformArray[1]));
@@ -345,6 +368,17 @@ RemoveObjectCommand.prototype.execute = function(timelineAnimator, resourceManag
 				index --;									
 			}				
 		}		
+
+		//Stop animating the removed movie clip (a scene replaced by the next one)
+		var children = timelineAnimator.m_children;
+		for(var i=0; i<children.length; i++)
+		{
+			if(children[i].m_targetMC.id == parseInt(this.m_objectID))
+			{
+				children.splice(i, 1);
+				i --;
+			}
+		}
 	}	
 }
 
@@ -370,7 +404,7 @@ UpdateVisibilityCommand.prototype.execute = function(timelineAnimator, resourceM
 		{
 			if(parentMC.children[index].id == parseInt(this.m_objectID))
 			{
-				if(this.m_visibilty == "true")
+				if(this.m_visibilty === true || this.m_visibilty == "true")
 					visibleBool = true;
 					else
 					visibleBool = false;
@@ -381,3 +415,250 @@ UpdateVisibilityCommand.prototype.execute = function(timelineAnimator, resourceM
 		}		
 	}	
 }
+
+//Steps per unit of the matrices in a compressed timeline (see OutputWriter.h)
+var TIMELINE_TRANSLATE_QUANTUM = 20;
+var TIMELINE_SCALE_QUANTUM = 65536;
+
+//TimelineDecoder Class
+//Expands a timeline written with "encoding":"delta" or with "tweens". Move commands
+//carry either an absolute quantized "matrix" or a "delta" against the previous matrix
+//of the object, and "hold" is the number of unchanged frames following a frame. A
+//Tween command stands for the Move commands of an object in the next "frames" frames
+//(see TweenFitter.h). Frames are decoded in order, the first time they are played.
+var TimelineDecoder = function(timeline) 
+{
+	this.m_timeline = timeline;
+	this.m_frames = [];
+	this.m_nextElement = 0;
+	//Quantized matrix of each object, as of the last decoded frame
+	this.m_matrices = {};
+	this.m_emptyFrame = { Command : [] };
+	//Move commands of the tweens by frame number, added to the frames when decoded
+	this.m_tweenCommands = {};
+
+	this.m_frameCount = 0;
+	for(var i=0; i<timeline.Frame.length; ++i)
+	{
+		this.m_frameCount++;
+		if(timeline.Frame[i].hold !== undefined)
+		{
+			this.m_frameCount += parseInt(timeline.Frame[i].hold);
+		}
+	}
+}
+
+TimelineDecoder.prototype.getFrame = function(frameNo)
+{
+	while(this.m_frames.length <= frameNo && this.m_nextElement < this.m_timeline.Frame.length)
+	{
+		this.decodeFrame(this.m_timeline.Frame[this.m_nextElement++]);
+	}
+	return this.m_frames[frameNo];
+}
+
+TimelineDecoder.prototype.decodeFrame = function(element)
+{
+	var frame = {};
+	for(var key in element)
+	{
+		frame[key] = element[key];
+	}
+
+	var commands = element.Command;
+	frame.Command = this.takeTweenCommands();
+	for(var c=0; c<commands.length; ++c)
+	{
+		if(commands[c].cmdType == "Tween")
+		{
+			frame.Command.push(this.decodeTween(commands[c]));
+		}
+		else
+		{
+			frame.Command.push(this.decodeCommand(commands[c]));
+		}
+	}
+	this.m_frames.push(frame);
+
+	if(element.hold !== undefined)
+	{
+		var hold = parseInt(element.hold);
+		for(var i=0; i<hold; ++i)
+		{
+			var tweenCommands = this.takeTweenCommands();
+			if(tweenCommands.length > 0)
+			{
+				this.m_frames.push({ Command : tweenCommands });
+			}
+			else
+			{
+				this.m_frames.push(this.m_emptyFrame);
+			}
+		}
+	}
+}
+
+//Returns the Move commands of the tweens in the next frame to decode
+TimelineDecoder.prototype.takeTweenCommands = function()
+{
+	var frameNo = this.m_frames.length;
+	var commands = this.m_tweenCommands[frameNo];
+	if(commands === undefined)
+	{
+		return [];
+	}
+	delete this.m_tweenCommands[frameNo];
+	return commands;
+}
+
+//Returns the Move command of the first frame of a tween and keeps the others
+TimelineDecoder.prototype.decodeTween = function(cmdData)
+{
+	var from = cmdData.from.split(",");
+	var to = cmdData.to.split(",");
+	var frames = parseInt(cmdData.frames);
+	var ease = parseFloat(cmdData.ease);
+
+	for(var i=0; i<6; ++i)
+	{
+		from[i] = parseFloat(from[i]);
+		to[i] = parseFloat(to[i]);
+	}
+
+	if(this.m_timeline.encoding == "delta")
+	{
+		//Later deltas are against the end of the tween
+		this.m_matrices[cmdData.objectId] = to.slice(0);
+		from = this.toTransformMatrix(from);
+		to = this.toTransformMatrix(to);
+	}
+
+	var start = new TweenTransform(from);
+	var end = new TweenTransform(to);
+	var frameNo = this.m_frames.length;
+	var first;
+
+	for(var i=1; i<=frames; ++i)
+	{
+		var command = {
+			cmdType : "Move",
+			objectId : cmdData.objectId,
+			transformMatrix : start.interpolate(end, i / frames, ease)
+		};
+
+		if(i == 1)
+		{
+			first = command;
+			continue;
+		}
+
+		var tweenFrameNo = frameNo + i - 1;
+		if(this.m_tweenCommands[tweenFrameNo] === undefined)
+		{
+			this.m_tweenCommands[tweenFrameNo] = [];
+		}
+		this.m_tweenCommands[tweenFrameNo].push(command);
+	}
+	return first;
+}
+
+TimelineDecoder.prototype.decodeCommand = function(cmdData)
+{
+	var matrix;
+
+	if(cmdData.matrix !== undefined)
+	{
+		matrix = cmdData.matrix.split(",");
+		for(var i=0; i<6; ++i)
+		{
+			matrix[i] = parseInt(matrix[i]);
+		}
+	}
+	else if(cmdData.delta !== undefined)
+	{
+		var delta = cmdData.delta.split(",");
+		matrix = this.m_matrices[cmdData.objectId].slice(0);
+		for(var i=0; i<delta.length; ++i)
+		{
+			matrix[i] += parseInt(delta[i]);
+		}
+	}
+	else
+	{
+		if(cmdData.cmdType == "Place" || cmdData.cmdType == "Remove")
+		{
+			delete this.m_matrices[cmdData.objectId];
+		}
+		return cmdData;
+	}
+
+	this.m_matrices[cmdData.objectId] = matrix;
+
+	var command = {};
+	for(var key in cmdData)
+	{
+		if(key != "matrix" && key != "delta")
+		{
+			command[key] = cmdData[key];
+		}
+	}
+	command.transformMatrix = this.toTransformMatrix(matrix);
+	return command;
+}
+
+TimelineDecoder.prototype.toTransformMatrix = function(matrix)
+{
+	return [
+		matrix[0] / TIMELINE_SCALE_QUANTUM,
+		matrix[1] / TIMELINE_SCALE_QUANTUM,
+		matrix[2] / TIMELINE_SCALE_QUANTUM,
+		matrix[3] / TIMELINE_SCALE_QUANTUM,
+		matrix[4] / TIMELINE_TRANSLATE_QUANTUM,
+		matrix[5] / TIMELINE_TRANSLATE_QUANTUM];
+}
+
+//TweenTransform Class
+//A matrix as the properties set by MoveObjectCommand, with the skew angles in radians
+var TweenTransform = function(matrix)
+{
+	this.x = matrix[4];
+	this.y = matrix[5];
+	this.scaleX = Math.sqrt((matrix[0]*matrix[0]) + (matrix[1]*matrix[1]));
+	this.scaleY = Math.sqrt((matrix[2]*matrix[2]) + (matrix[3]*matrix[3]));
+	this.skewX = Math.atan2(-matrix[2], matrix[3]);
+	this.skewY = Math.atan2(matrix[1], matrix[0]);
+}
+
+//Returns the matrix at time t (0 to 1) of the tween to "end", eased by
+//f(t) = t + ease * t * (1 - t). The skew angles take the shorter way round.
+TweenTransform.prototype.interpolate = function(end, t, ease)
+{
+	var f = t + ease * t * (1 - t);
+	var scaleX = this.scaleX + (end.scaleX - this.scaleX) * f;
+	var scaleY = this.scaleY + (end.scaleY - this.scaleY) * f;
+	var skewX = this.skewX + GetAngleDelta(this.skewX, end.skewX) * f;
+	var skewY = this.skewY + GetAngleDelta(this.skewY, end.skewY) * f;
+
+	return [
+		scaleX * Math.cos(skewY),
+		scaleX * Math.sin(skewY),
+		-scaleY * Math.sin(skewX),
+		scaleY * Math.cos(skewX),
+		this.x + (end.x - this.x) * f,
+		this.y + (end.y - this.y) * f];
+}
+
+//Difference of two angles in (-pi, pi]
+function GetAngleDelta(from, to)
+{
+	var delta = (to - from) % (2 * Math.PI);
+	if(delta > Math.PI)
+	{
+		delta -= 2 * Math.PI;
+	}
+	else if(delta <= -Math.PI)
+	{
+		delta += 2 * Math.PI;
+	}
+	return delta;
+}
@@ -9,6 +9,16 @@ source other than Adobe, then your use, modification, or distribution of it requ
 written permission of Adobe.
 ******************************************************************************/
 
+//Transforms are "a,b,c,d,tx,ty" strings in JSON documents and Float32Arrays in binary ones
+function GetTransformArray(transform)
+{
+	if(typeof transform == "string")
+	{
+		return transform.split(",");
+	}
+	return transform;
+}
+
 function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transform)
 {
 	var pathContainer = new createjs.Container();
@@ -37,11 +47,11 @@ function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transfo
 					}
 					if(resourceManager.m_data.DOMDocument.Shape[k].path[j].image)
 					{ 
-						var patternArray = resourceManager.m_data.DOMDocument.Shape[k].path[j].image.patternTransform.split(",");						
+						var patternArray = GetTransformArray(resourceManager.m_data.DOMDocument.Shape[k].path[j].image.patternTransform);						
 						var p =0;
 						var mat = new createjs.Matrix2D(patternArray[p],patternArray[p+1],patternArray[p+1],patternArray[p+3],patternArray[p+4],patternArray[p+5]);
-						var image = new Image();
-						image.src = resourceManager.m_data.DOMDocument.Shape[k].path[j].image.bitmapPath;						
+						ScaleResampledFill(mat, resourceManager.m_data.DOMDocument.Shape[k].path[j].image);
+						var image = resourceManager.getBitmapImage(resourceManager.m_data.DOMDocument.Shape[k].path[j].image);
 						shape1.graphics.beginBitmapFill(image,"no-repeat",mat);						
 					}
 					if(resourceManager.m_data.DOMDocument.Shape[k].path[j].linearGradient)
@@ -85,11 +95,10 @@ function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transfo
 					}
 					if(resourceManager.m_data.DOMDocument.Shape[k].path[j].image)
 					{ 
-						var patternArray = resourceManager.m_data.DOMDocument.Shape[k].path[j].image.patternTransform.split(",");
+						var patternArray = GetTransformArray(resourceManager.m_data.DOMDocument.Shape[k].path[j].image.patternTransform);
 						var p =0;
 						var mat = new createjs.Matrix2D(patternArray[p],patternArray[p+1],patternArray[p+1],patternArray[p+3],patternArray[p+4],patternArray[p+5]);
-						var image = new Image();
-						image.src = resourceManager.m_data.DOMDocument.Shape[k].path[j].image.bitmapPath;
+						var image = resourceManager.getBitmapImage(resourceManager.m_data.DOMDocument.Shape[k].path[j].image);
 						shape1.graphics.beginBitmapStroke(image,"no-repeat").beginStroke().setStrokeStyle(data.DOMDocument.Shape[k].path[j].strokeWidth,resourceManager.m_data.DOMDocument.Shape[k].path[j].strokeLinecap,resourceManager.m_data.DOMDocument.Shape[k].path[j].strokeLinejoin);
 						
 					}						
@@ -108,17 +117,50 @@ function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transfo
 					}
 					
 				}
-				var path = resourceManager.m_data.DOMDocument.Shape[k].path[j].d;
-				var pathParts = path.split(" ");
-				for(var i =0;i < pathParts.length;i++)
+				if(resourceManager.m_data.DOMDocument.Shape[k].path[j].coords)
+				{
+					//Binary document: one command byte per segment, coordinates in a Float32Array
+					var cmds = resourceManager.m_data.DOMDocument.Shape[k].path[j].cmds;
+					var coords = resourceManager.m_data.DOMDocument.Shape[k].path[j].coords;
+					var c = 0;
+					for(var i =0;i < cmds.length;i++)
+					{
+						if(cmds[i] == 0)
+						{
+							shape1.graphics.moveTo(coords[c],coords[c+1]);
+							c += 2;
+						}
+						else if(cmds[i] == 1)
+						{
+							shape1.graphics.lineTo(coords[c],coords[c+1]);
+							c += 2;
+						}
+						else if(cmds[i] == 2)
+						{
+							shape1.graphics.quadraticCurveTo(coords[c],coords[c+1],coords[c+2],coords[c+3]);
+							c += 4;
+						}
+					}
+				}
+				else if(resourceManager.m_data.DOMDocument.Shape[k].path[j].compactPath)
+				{
+					//Compact path: Graphics.decodePath format, coordinates in tenths of a pixel
+					shape1.graphics.decodePath(resourceManager.m_data.DOMDocument.Shape[k].path[j].compactPath);
+				}
+				else
 				{
+					var path = resourceManager.m_data.DOMDocument.Shape[k].path[j].d;
+					var pathParts = path.split(" ");
+					for(var i =0;i < pathParts.length;i++)
+					{
 
-					if(pathParts[i] == "M")
-					shape1.graphics.moveTo(pathParts[i+1],pathParts[i+2]);
-					if(pathParts[i] == "Q")
-					shape1.graphics.quadraticCurveTo(pathParts[i+1],pathParts[i+2],pathParts[i+3],pathParts[i+4]);
-					if(pathParts[i] == "L")
-					shape1.graphics.lineTo(pathParts[i+1],pathParts[i+2]);
+						if(pathParts[i] == "M")
+						shape1.graphics.moveTo(pathParts[i+1],pathParts[i+2]);
+						if(pathParts[i] == "Q")
+						shape1.graphics.quadraticCurveTo(pathParts[i+1],pathParts[i+2],pathParts[i+3],pathParts[i+4]);
+						if(pathParts[i] == "L")
+						shape1.graphics.lineTo(pathParts[i+1],pathParts[i+2]);
+					}
 				}
 
 			/*	if(resourceManager.m_data.DOMDocument.Shape[k].path[j].colorOpacity)
@@ -134,7 +176,7 @@ function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transfo
 			
 	}
 			
-	var transformArray = transform.split(",");
+	var transformArray = GetTransformArray(transform);
 	var scaleX,scaleY,rotation,skewX,skewY;
 	var TransformMat = new createjs.Matrix2D(transformArray[0],transformArray[1],transformArray[2],transformArray[3],transformArray[4],transformArray[5])
 	scaleX = Math.sqrt((transformArray[0]*transformArray[0])+ (transformArray[1]*transformArray[1]));
@@ -181,19 +223,54 @@ function CreateShape(parentMC,resourceManager,charId,ObjectId,placeAfter,transfo
 
 
 
+//The fill matrix of a bitmap written smaller than its library item maps the pixels
+//of the item; they are scaled to the pixels of the file
+function ScaleResampledFill(mat, image)
+{
+	if(image.fileWidth !== undefined)
+	{
+		var scaleX = parseInt(image.width) / image.fileWidth;
+		var scaleY = parseInt(image.height) / image.fileHeight;
+		mat.a *= scaleX;
+		mat.b *= scaleX;
+		mat.c *= scaleY;
+		mat.d *= scaleY;
+	}
+}
+
 function CreateBitmap(parentMC,resourceManager,charId,ObjectId,placeAfter,transform)
 {
 for(var b =0;b<resourceManager.m_data.DOMDocument.Bitmaps.length;b++)
 	{
 		if(resourceManager.m_data.DOMDocument.Bitmaps[b].charid == charId)
 		{
-		var path = resourceManager.m_data.DOMDocument.Bitmaps[b].bitmapPath;
-		var bitmap = new createjs.Bitmap(path);
+		var bitmapData = resourceManager.m_data.DOMDocument.Bitmaps[b];
+		var bitmap;
+		if(bitmapData.atlasX !== undefined)
+		{
+			//Drawn from its rectangle on the shared atlas page
+			bitmap = new createjs.Bitmap(resourceManager.getAtlasPage(bitmapData));
+			bitmap.sourceRect = resourceManager.getBitmapSourceRect(bitmapData);
+		}
+		else if(bitmapData.fileWidth !== undefined)
+		{
+			//Written at the size it is drawn at, and scaled back to the size of the item
+			//inside a container that takes the transform
+			var resampled = new createjs.Bitmap(bitmapData.bitmapPath);
+			resampled.scaleX = parseInt(bitmapData.width) / bitmapData.fileWidth;
+			resampled.scaleY = parseInt(bitmapData.height) / bitmapData.fileHeight;
+			bitmap = new createjs.Container();
+			bitmap.addChild(resampled);
+		}
+		else
+		{
+			bitmap = new createjs.Bitmap(bitmapData.bitmapPath);
+		}
 		bitmap.id = parseInt(ObjectId);
 		}
 		
 	}
-	var transformArray = transform.split(",");
+	var transformArray = GetTransformArray(transform);
 	var scaleX,scaleY,rotation,skewX,skewY;
 	var TransformMat = new createjs.Matrix2D(transformArray[0],transformArray[1],transformArray[2],transformArray[3],transformArray[4],transformArray[5])
 	scaleX = Math.sqrt((transformArray[0]*transformArray[0])+ (transformArray[1]*transformArray[1]));
@@ -254,7 +331,7 @@ for(var b =0;b<resourceManager.m_data.DOMDocument.Text.length;b++)
 		}
 		
 	}
-	var transformArray = transform.split(",");
+	var transformArray = GetTransformArray(transform);
 	var scaleX,scaleY,rotation,skewX,skewY;
 	var TransformMat = new createjs.Matrix2D(transformArray[0],transformArray[1],transformArray[2],transformArray[3],transformArray[4],transformArray[5])
 	scaleX = Math.sqrt((transformArray[0]*transformArray[0])+ (transformArray[1]*transformArray[1]));
@@ -8,6 +8,46 @@ workspace "AdobeHTMLPlugin"
     
     libjsonSrc = "project/lib/ThirdParty/libjson_7.6.1/libjson/_internal/Source/"
 
+    -- Sources of libjson, also built into the JSON arena benchmark
+    libjsonFiles = {
+        "%{libjsonSrc}JSONAllocator.cpp",
+        "%{libjsonSrc}JSONChildren.cpp",
+        "%{libjsonSrc}JSONDebug.cpp",
+        "%{libjsonSrc}JSONIterators.cpp",
+        "%{libjsonSrc}JSONMemory.cpp",
+        "%{libjsonSrc}JSONNode.cpp",
+        "%{libjsonSrc}JSONNode_Mutex.cpp",
+        "%{libjsonSrc}JSONPreparse.cpp",
+        "%{libjsonSrc}JSONStream.cpp",
+        "%{libjsonSrc}JSONValidator.cpp",
+        "%{libjsonSrc}JSONWorker.cpp",
+        "%{libjsonSrc}JSONWriter.cpp",
+        "%{libjsonSrc}internalJSONNode.cpp",
+        "%{libjsonSrc}libjson.cpp"
+    }
+
+    -- Sources of the plugin
+    pluginFiles = {
+        "project/include/**.h",
+        "project/src/**.cpp",
+        libjsonFiles,
+        "project/lib/ThirdParty/mongoose/mongoose.c"
+    }
+
+    -- Include folders of the plugin, also used by the benchmarks
+    pluginIncludeDirs = {
+        "$(SolutionDir)project/include",
+        "$(SolutionDir)project/lib",
+        "$(SolutionDir)project/lib/xdk/core/include/common",
+        "$(SolutionDir)project/lib/xdk/core/include/interfaces",
+        "$(SolutionDir)project/lib/xdk/app/include/common",
+        "$(SolutionDir)project/lib/xdk/app/include/interfaces",
+        "$(SolutionDir)project/lib/xdk/app/include/interfaces/DOM",
+        "$(SolutionDir)project/lib/xdk/app/include/interfaces/Exporter",
+        "$(SolutionDir)project/lib/ThirdParty/libjson_7.6.1/libjson",
+        "$(SolutionDir)project/lib/ThirdParty/mongoose"
+    }
+
     configurations {
         "Debug",
         "Release"
@@ -28,41 +68,13 @@ workspace "AdobeHTMLPlugin"
         defines {
             "_WINDOWS",
             "USE_HTTP_SERVER",
+            "USE_WEBSOCKET",
             "USE_RUNTIME"
         }
 
-        files {
-            "project/include/**.h",
-            "project/src/**.cpp",
-            "%{libjsonSrc}JSONAllocator.cpp",
-            "%{libjsonSrc}JSONChildren.cpp",
-            "%{libjsonSrc}JSONDebug.cpp",
-            "%{libjsonSrc}JSONIterators.cpp",
-            "%{libjsonSrc}JSONMemory.cpp",
-            "%{libjsonSrc}JSONNode.cpp",
-            "%{libjsonSrc}JSONNode_Mutex.cpp",
-            "%{libjsonSrc}JSONPreparse.cpp",
-            "%{libjsonSrc}JSONStream.cpp",
-            "%{libjsonSrc}JSONValidator.cpp",
-            "%{libjsonSrc}JSONWorker.cpp",
-            "%{libjsonSrc}JSONWriter.cpp",
-            "%{libjsonSrc}internalJSONNode.cpp",
-            "%{libjsonSrc}libjson.cpp",
-            "project/lib/ThirdParty/mongoose/mongoose.c"
-        }
+        files { pluginFiles }
 
-        includedirs {
-            "$(SolutionDir)project/include",
-            "$(SolutionDir)project/lib",
-            "$(SolutionDir)project/lib/xdk/core/include/common",
-            "$(SolutionDir)project/lib/xdk/core/include/interfaces",
-            "$(SolutionDir)project/lib/xdk/app/include/common",
-            "$(SolutionDir)project/lib/xdk/app/include/interfaces",
-            "$(SolutionDir)project/lib/xdk/app/include/interfaces/DOM",
-            "$(SolutionDir)project/lib/xdk/app/include/interfaces/Exporter",
-            "$(SolutionDir)project/lib/ThirdParty/libjson_7.6.1/libjson",
-            "$(SolutionDir)project/lib/ThirdParty/mongoose"
-        }
+        includedirs { pluginIncludeDirs }
 
         filter "configurations:Debug"
             defines "_DEBUG"
@@ -86,4 +98,102 @@ workspace "AdobeHTMLPlugin"
                 "if exist \"$(SolutionDir)extension\\plugin\\lib\\win\\$(TargetName).fcm\" del /Q \"$(SolutionDir)extension\\plugin\\lib\\win\\$(TargetName).fcm\"",
                 "ren \"$(SolutionDir)extension\\plugin\\lib\\win\\$(TargetName).dll\" \"$(TargetName).fcm\"",
                 "node \"$(SolutionDir)package.json\""
-            }
\ No newline at end of file
+            }
+
+
+    -- Times ResourcePalette::HasResource() for palettes of 100 to 100000 synthetic
+    -- resources. Runs without Animate, and builds only the palette and what it uses.
+    project "ResourcePaletteBenchmark"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++14"
+        staticruntime "off"
+
+        targetdir "$(SolutionDir)project\\bin"
+        objdir "$(SolutionDir)project\\obj\\%{prj.name}"
+        linkoptions { conan_exelinkflags }
+
+        buildoptions { "/Zc:wchar_t-" }
+
+        defines {
+            "_WINDOWS"
+        }
+
+        files {
+            "project/include/**.h",
+            "project/src/ResourcePalette.cpp",
+            "project/src/BitmapScaleTracker.cpp",
+            "project/src/PathSimplifier.cpp",
+            "project/src/PublishProfiler.cpp",
+            "project/src/ServiceRegistry.cpp",
+            "project/src/Utils.cpp",
+            "project/benchmark/ResourcePaletteBenchmark.cpp"
+        }
+
+        includedirs { pluginIncludeDirs }
+
+        filter "configurations:Debug"
+            defines "_DEBUG"
+            runtime "Debug"
+            symbols "on"
+
+            defines {
+                "DEBUG"
+            }
+        
+        filter "configurations:Release"
+            defines "_RELEASE"
+            runtime "Release"
+            optimize "on"
+
+            defines {
+                "NDEBUG"
+            }
+
+
+    -- Times building and writing a JSON shape array with libjson allocating from the
+    -- heap and from a JSONArena. Runs without Animate.
+    project "JSONArenaBenchmark"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++14"
+        staticruntime "off"
+
+        targetdir "$(SolutionDir)project\\bin"
+        objdir "$(SolutionDir)project\\obj\\%{prj.name}"
+        linkoptions { conan_exelinkflags }
+
+        buildoptions { "/Zc:wchar_t-" }
+
+        defines {
+            "_WINDOWS"
+        }
+
+        files {
+            "project/include/**.h",
+            "project/src/JSONArena.cpp",
+            "project/src/ServiceRegistry.cpp",
+            "project/src/Utils.cpp",
+            libjsonFiles,
+            "project/benchmark/JSONArenaBenchmark.cpp"
+        }
+
+        includedirs { pluginIncludeDirs }
+
+        filter "configurations:Debug"
+            defines "_DEBUG"
+            runtime "Debug"
+            symbols "on"
+
+            defines {
+                "DEBUG"
+            }
+        
+        filter "configurations:Release"
+            defines "_RELEASE"
+            runtime "Release"
+            optimize "on"
+
+            defines {
+                "NDEBUG"
+            }
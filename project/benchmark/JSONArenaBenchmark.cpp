@@ -0,0 +1,211 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  JSONArenaBenchmark.cpp
+ *
+ * @brief Builds and writes a JSON document shaped like the shape array of the JSON
+ *        output, with libjson allocating from the heap and then from a JSONArena,
+ *        and prints the time and allocation counts of each. Needs no host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+#include "libjson.h"
+#include "JSONArena.h"
+
+/* -------------------------------------------------- Constants */
+
+// Shapes in the document
+static const unsigned int SHAPE_COUNT = 100000;
+
+// Fill and stroke paths of each shape
+static const unsigned int PATHS_PER_SHAPE = 4;
+
+// Runs of each mode; they alternate so that both see the same heap state
+static const unsigned int RUN_COUNT = 3;
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+struct ARENA_BENCHMARK_RESULT
+{
+    double buildTime;
+
+    double writeTime;
+
+    size_t outputSize;
+
+    CreateJS::JSON_ARENA_STATS stats;
+};
+
+
+/* -------------------------------------------------- Static Functions */
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+
+// A path of a few curves, with coordinates that differ from shape to shape
+static std::string GetPathData(unsigned int shape, unsigned int path)
+{
+    char data[128];
+
+    snprintf(data, sizeof(data), "M %u %u Q %u %u %u %u L %u %u Q %u %u %u %u Z",
+        shape % 500, path * 7,
+        shape % 500 + 10, path * 7 + 20, shape % 500 + 30, path * 7 + 5,
+        shape % 500 + 40, path * 7 + 40,
+        shape % 500 + 20, path * 7 + 60, shape % 500, path * 7);
+
+    return data;
+}
+
+
+// Builds the nodes the way JSONOutputWriter does: each path and shape is a heap
+// node that is copied into its parent and then deleted
+static JSONNode* BuildShapeArray()
+{
+    JSONNode* pShapeArray = new JSONNode(JSON_ARRAY);
+    char id[16];
+
+    pShapeArray->set_name("Shape");
+
+    for (unsigned int i = 0; i < SHAPE_COUNT; i++)
+    {
+        JSONNode* pShapeElem = new JSONNode(JSON_NODE);
+        JSONNode* pPathArray = new JSONNode(JSON_ARRAY);
+
+        pPathArray->set_name("path");
+
+        for (unsigned int j = 0; j < PATHS_PER_SHAPE; j++)
+        {
+            JSONNode* pPathElem = new JSONNode(JSON_NODE);
+
+            pPathElem->push_back(JSONNode("d", GetPathData(i, j)));
+            pPathElem->push_back(JSONNode("color", "#336699"));
+            pPathElem->push_back(JSONNode("colorOpacity", "1"));
+            pPathElem->push_back(JSONNode("pathType", "Fill"));
+
+            pPathArray->push_back(*pPathElem);
+            delete pPathElem;
+        }
+
+        snprintf(id, sizeof(id), "%u", i + 1);
+
+        pShapeElem->push_back(JSONNode("charid", id));
+        pShapeElem->push_back(*pPathArray);
+
+        pShapeArray->push_back(*pShapeElem);
+
+        delete pPathArray;
+        delete pShapeElem;
+    }
+
+    return pShapeArray;
+}
+
+
+static void Run(bool useArena, ARENA_BENCHMARK_RESULT& result)
+{
+    CreateJS::JSON_ARENA_STATS before;
+
+    CreateJS::JSONArena::GetStats(before);
+
+    CreateJS::ScopedJSONArena arena(useArena);
+
+    // No node may outlive the arena
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        JSONNode root(JSON_NODE);
+        JSONNode* pShapeArray = BuildShapeArray();
+
+        root.push_back(*pShapeArray);
+        delete pShapeArray;
+
+        result.buildTime = GetMilliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+
+        std::string output = root.write();
+
+        result.writeTime = GetMilliseconds(start);
+        result.outputSize = output.size();
+    }
+
+    CreateJS::JSONArena::GetStats(result.stats);
+
+    if (!useArena)
+    {
+        // The statistics are those of the last arena, plus the heap allocations
+        // made since
+        result.stats.arenaAllocations = 0;
+        result.stats.heapAllocations -= before.heapAllocations;
+        result.stats.bytesReserved = 0;
+        result.stats.chunkCount = 0;
+    }
+}
+
+
+static void PrintResult(const char* pMode, const ARENA_BENCHMARK_RESULT& result)
+{
+    printf("%6s %10.1f %10.1f %12llu %12llu %10llu %8u\n",
+        pMode,
+        result.buildTime,
+        result.writeTime,
+        (unsigned long long)result.stats.arenaAllocations,
+        (unsigned long long)result.stats.heapAllocations,
+        (unsigned long long)(result.stats.bytesReserved / 1024),
+        result.stats.chunkCount);
+}
+
+
+int main()
+{
+    // The first publish registers the memory callbacks, so that later heap
+    // allocations also go through them
+    {
+        CreateJS::ScopedJSONArena arena(true);
+    }
+
+    printf("%u shapes of %u paths\n", SHAPE_COUNT, PATHS_PER_SHAPE);
+    printf("%6s %10s %10s %12s %12s %10s %8s\n",
+        "Mode", "Build (ms)", "Write (ms)", "Arena allocs", "Heap allocs", "Arena (KB)", "Chunks");
+
+    for (unsigned int i = 0; i < RUN_COUNT; i++)
+    {
+        ARENA_BENCHMARK_RESULT heapResult;
+        ARENA_BENCHMARK_RESULT arenaResult;
+
+        Run(false, heapResult);
+        Run(true, arenaResult);
+
+        PrintResult("heap", heapResult);
+        PrintResult("arena", arenaResult);
+
+        if (heapResult.outputSize != arenaResult.outputSize)
+        {
+            printf("The outputs differ (%llu and %llu bytes)\n",
+                (unsigned long long)heapResult.outputSize,
+                (unsigned long long)arenaResult.outputSize);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  ResourcePaletteBenchmark.cpp
+ *
+ * @brief Measures the cost of ResourcePalette::HasResource() (by resource id and by
+ *        library name) for palettes of 100 to 100000 synthetic resources. Needs no
+ *        host: the palette is filled directly rather than through the Add* calls.
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "FCMPluginInterface.h"
+#include "Publisher.h"
+
+/* -------------------------------------------------- Constants */
+
+// Resources in the palettes measured
+static const FCM::U_Int32 PALETTE_SIZES[] = { 100, 1000, 10000, 100000 };
+
+// Lookups timed for each palette
+static const FCM::U_Int32 LOOKUP_COUNT = 2000000;
+
+// Ids and names looked up, cycled through. Half of them are in the palette.
+static const FCM::U_Int32 QUERY_COUNT = 4096;
+
+
+/* -------------------------------------------------- Static Functions */
+
+static std::string GetResourceName(FCM::U_Int32 index)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "Symbol %u", index);
+
+    return name;
+}
+
+
+// Spreads the queries over twice the resources of the palette, so that half of
+// them miss
+static FCM::U_Int32 GetQueryIndex(FCM::U_Int32 query, FCM::U_Int32 paletteSize)
+{
+    return (FCM::U_Int32)((query * 2654435761ULL) % (2 * paletteSize)) + 1;
+}
+
+
+/* -------------------------------------------------- ResourcePaletteBenchmark */
+
+namespace CreateJS
+{
+    BEGIN_MODULE(BenchmarkModule)
+
+        BEGIN_CLASS_ENTRY
+
+        END_CLASS_ENTRY
+
+    END_MODULE
+
+
+    class ResourcePaletteBenchmark
+    {
+    public:
+
+        ResourcePaletteBenchmark(BenchmarkModule* pModule)
+        {
+            m_pObject = new FCM::FCMObject<ResourcePalette>(pModule);
+            m_pObject->FCMInit(NULL, NULL);
+            m_pObject->AddRef();
+        }
+
+        ~ResourcePaletteBenchmark()
+        {
+            m_pObject->Release();
+        }
+
+        void Fill(FCM::U_Int32 paletteSize)
+        {
+            ResourcePalette* pPalette = m_pObject;
+
+            pPalette->Clear();
+
+            for (FCM::U_Int32 i = 1; i <= paletteSize; i++)
+            {
+                pPalette->m_resourceIds.insert(i);
+                pPalette->m_resourceNames.insert(GetResourceName(i));
+            }
+        }
+
+        // Returns the time per lookup in nanoseconds
+        double TimeIdLookups(FCM::U_Int32 paletteSize, FCM::U_Int32& found)
+        {
+            std::vector<FCM::U_Int32> ids;
+            FCM::Boolean hasResource;
+
+            for (FCM::U_Int32 i = 0; i < QUERY_COUNT; i++)
+            {
+                ids.push_back(GetQueryIndex(i, paletteSize));
+            }
+
+            found = 0;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            for (FCM::U_Int32 i = 0; i < LOOKUP_COUNT; i++)
+            {
+                m_pObject->HasResource(ids[i % QUERY_COUNT], hasResource);
+                found += hasResource ? 1 : 0;
+            }
+
+            return GetNanoseconds(start) / LOOKUP_COUNT;
+        }
+
+        // Returns the time per lookup in nanoseconds
+        double TimeNameLookups(FCM::U_Int32 paletteSize, FCM::U_Int32& found)
+        {
+            std::vector<std::string> names;
+            FCM::Boolean hasResource;
+
+            for (FCM::U_Int32 i = 0; i < QUERY_COUNT; i++)
+            {
+                names.push_back(GetResourceName(GetQueryIndex(i, paletteSize)));
+            }
+
+            found = 0;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            for (FCM::U_Int32 i = 0; i < LOOKUP_COUNT; i++)
+            {
+                m_pObject->HasResource(names[i % QUERY_COUNT], hasResource);
+                found += hasResource ? 1 : 0;
+            }
+
+            return GetNanoseconds(start) / LOOKUP_COUNT;
+        }
+
+    private:
+
+        static double GetNanoseconds(std::chrono::steady_clock::time_point start)
+        {
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            return elapsed.count();
+        }
+
+    private:
+
+        FCM::FCMObject<ResourcePalette>* m_pObject;
+    };
+};
+
+
+int main()
+{
+    CreateJS::BenchmarkModule module;
+    CreateJS::ResourcePaletteBenchmark benchmark(&module);
+
+    printf("%10s %16s %18s %10s\n", "Resources", "By id (ns/call)", "By name (ns/call)", "Found");
+
+    for (size_t i = 0; i < sizeof(PALETTE_SIZES) / sizeof(PALETTE_SIZES[0]); i++)
+    {
+        FCM::U_Int32 idsFound;
+        FCM::U_Int32 namesFound;
+
+        benchmark.Fill(PALETTE_SIZES[i]);
+
+        double idTime = benchmark.TimeIdLookups(PALETTE_SIZES[i], idsFound);
+        double nameTime = benchmark.TimeNameLookups(PALETTE_SIZES[i], namesFound);
+
+        // Both lookups find the same resources
+        printf("%10u %16.1f %18.1f %10u%s\n",
+            PALETTE_SIZES[i],
+            idTime,
+            nameTime,
+            idsFound,
+            (idsFound == namesFound) ? "" : " (mismatch)");
+    }
+
+    return 0;
+}
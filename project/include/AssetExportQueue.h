@@ -0,0 +1,156 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  AssetExportQueue.h
+ *
+ * @brief This file contains declarations for a queue that exports bitmaps and
+ *        sounds on a pool of worker threads.
+ */
+
+#ifndef ASSET_EXPORT_QUEUE_H_
+#define ASSET_EXPORT_QUEUE_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+#include "LIbraryItem/IMediaItem.h"
+#include "Service/Image/IBitmapExportService.h"
+#include "Service/Sound/ISoundExportService.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+namespace CreateJS
+{
+    enum AssetType
+    {
+        BITMAP_ASSET,
+        SOUND_ASSET
+    };
+}
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Upper limit on the number of export threads
+#define MAX_ASSET_EXPORT_THREADS        4
+
+// Number of jobs that may be waiting per worker before the publish thread blocks
+#define ASSET_EXPORT_JOBS_PER_THREAD    4
+
+// Default quality of the bitmaps encoded by the host (see OUTPUT_SETTINGS::bitmapQuality)
+#define BITMAP_EXPORT_QUALITY           100
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    struct ASSET_EXPORT_JOB
+    {
+        AssetType type;
+
+        FCM::AutoPtr<DOM::LibraryItem::IMediaItem> pMediaItem;
+
+        // Null terminated UTF-16 path owned by the job
+        std::vector<FCM::U_Int16> filePath;
+
+        // The same path in UTF-8, used to report the size of the exported file
+        std::string filePath8;
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    class AssetExportQueue
+    {
+    public:
+
+        // A thread count of 0 exports every asset on the calling thread
+        AssetExportQueue(
+            FCM::PIFCMCallback pCallback, 
+            FCM::U_Int32 threadCount, 
+            FCM::U_Int32 bitmapQuality);
+
+        ~AssetExportQueue();
+
+        FCM::Result ExportBitmap(
+            DOM::LibraryItem::PIMediaItem pMediaItem,
+            const std::string& filePath);
+
+        FCM::Result ExportSound(
+            DOM::LibraryItem::PIMediaItem pMediaItem,
+            const std::string& filePath);
+
+        // Waits for the queued exports to finish. Returns the first failure (if any).
+        FCM::Result Join();
+
+    private:
+
+        FCM::Result Enqueue(
+            AssetType type,
+            DOM::LibraryItem::PIMediaItem pMediaItem,
+            const std::string& filePath);
+
+        FCM::Result Export(ASSET_EXPORT_JOB& job);
+
+        // Adds the size of an exported file to the publish profile (publish thread only)
+        void ProfileExportedFile(const ASSET_EXPORT_JOB& job);
+
+        void WorkerProc();
+
+    private:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> m_pBitmapExportService;
+
+        FCM::AutoPtr<DOM::Service::Sound::ISoundExportService> m_pSoundExportService;
+
+        std::vector<std::thread> m_workers;
+
+        // Jobs are only released on the publish thread (in Join). A deque is used so 
+        // that queuing more jobs does not move the ones being exported.
+        std::deque<ASSET_EXPORT_JOB> m_jobs;
+
+        FCM::U_Int32 m_nextJob;
+
+        FCM::U_Int32 m_completedJobs;
+
+        FCM::U_Int32 m_maxPendingJobs;
+
+        FCM::U_Int32 m_bitmapQuality;
+
+        FCM::Result m_result;
+
+        bool m_stop;
+
+        std::mutex m_mutex;
+
+        std::condition_variable m_jobAvailable;
+
+        std::condition_variable m_jobCompleted;
+    };
+};
+
+#endif // ASSET_EXPORT_QUEUE_H_
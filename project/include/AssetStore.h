@@ -0,0 +1,109 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  AssetStore.h
+ *
+ * @brief This file contains declarations for removing exported bitmaps and sounds
+ *        whose content is identical to another one.
+ */
+
+#ifndef ASSET_STORE_H_
+#define ASSET_STORE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+#include "AssetExportQueue.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Files are hashed and compared in blocks of this size
+#define ASSET_STORE_READ_BLOCK_SIZE     (64 * 1024)
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    // Path of a removed file (relative to the page) -> path of the file with the same
+    // content
+    typedef std::map<std::string, std::string> AssetAliasMap;
+
+    struct ASSET_STORE_FILE
+    {
+        AssetType type;
+
+        // Library item exported to the file
+        std::string libPathName;
+
+        std::string fileName;
+
+        std::string filePath;
+
+        // Path written to the output
+        std::string relPath;
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Collects the files of the bitmaps and sounds used by a publish. Once they have
+    // all been written, files are identified by a hash of their content, and every
+    // file with the same content as an earlier one is deleted in favour of it.
+    class AssetStore
+    {
+    public:
+
+        AssetStore(FCM::PIFCMCallback pCallback);
+
+        ~AssetStore();
+
+        // Records the file of a library item
+        void Add(
+            AssetType type,
+            const std::string& libPathName,
+            const std::string& fileName,
+            const std::string& filePath,
+            const std::string& relPath);
+
+        // Deletes the duplicate files and returns the paths that now refer to another
+        // file
+        FCM::Result Deduplicate(AssetAliasMap& aliases);
+
+    private:
+
+        // Returns false if the file cannot be read (e.g. its export failed)
+        FCM::Boolean GetContentHash(const std::string& filePath, FCM::U_Int64& size, FCM::U_Int64& hash);
+
+        FCM::Boolean IsContentEqual(const std::string& filePath1, const std::string& filePath2);
+
+    private:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        std::vector<ASSET_STORE_FILE> m_files;
+    };
+};
+
+#endif // ASSET_STORE_H_
@@ -0,0 +1,416 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  BinaryOutputWriter.h
+ *
+ * @brief This file contains declarations for a output writer that emits a compact
+ *        binary container (read by runtime/binaryloader.js) instead of JSON.
+ *
+ *        Layout (little-endian, every field 4 byte aligned):
+ *
+ *          Header : "CJSB" | u32 version
+ *          Chunk  : 4cc tag | u32 payload length | payload
+ *
+ *        Chunks are written in the order the resources are defined, so the main
+ *        timeline is always the last "TMLN" chunk. It may be followed by an "ALIS"
+ *        chunk (u32 count, then pairs of strings) that gives the path to load for each
+ *        bitmap or sound removed as a duplicate, and by an "RSMP" chunk (u32 count,
+ *        then a string and u32 width and height for each) that gives the size of
+ *        every bitmap file written smaller than its library item. Strings are
+ *        stored as a u32 byte count followed by UTF-8 bytes, padded to 4 bytes. Path
+ *        commands are u8 (padded) and path coordinates, matrices and gradient
+ *        geometry are f32, so that the loader can map them straight into typed arrays.
+ */
+
+#ifndef BINARY_OUTPUT_WRITER_H_
+#define BINARY_OUTPUT_WRITER_H_
+
+#include "OutputWriter.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+namespace CreateJS
+{
+    // Values are part of the file format. Only append.
+    enum BinaryPathType
+    {
+        BINARY_PATH_FILL,
+        BINARY_PATH_STROKE,
+        BINARY_PATH_UNSTYLED_STROKE
+    };
+
+    enum BinaryFillType
+    {
+        BINARY_FILL_NONE,
+        BINARY_FILL_SOLID,
+        BINARY_FILL_BITMAP,
+        BINARY_FILL_LINEAR_GRADIENT,
+        BINARY_FILL_RADIAL_GRADIENT,
+
+        // A bitmap fill followed by the position of the bitmap on its atlas page
+        BINARY_FILL_ATLAS_BITMAP
+    };
+
+    enum BinaryPathCommand
+    {
+        BINARY_PATH_MOVE_TO,
+        BINARY_PATH_LINE_TO,
+        BINARY_PATH_QUAD_CURVE_TO
+    };
+
+    enum BinaryTimelineCommand
+    {
+        BINARY_CMD_PLACE,
+        BINARY_CMD_MOVE,
+        BINARY_CMD_REMOVE,
+        BINARY_CMD_UPDATE_Z_ORDER,
+        BINARY_CMD_UPDATE_VISIBILITY,
+        BINARY_CMD_UPDATE_BLEND_MODE
+    };
+}
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+#define BINARY_FILE_MAGIC       "CJSB"
+// Version 2 added bitmaps on atlas pages, version 3 the asset aliases, version 4
+// the resampled bitmaps
+#define BINARY_FILE_VERSION     4
+
+#define BINARY_CHUNK_SHAPE      "SHAP"
+#define BINARY_CHUNK_BITMAP     "BTMP"
+#define BINARY_CHUNK_SOUND      "SOND"
+#define BINARY_CHUNK_TEXT       "TEXT"
+#define BINARY_CHUNK_TIMELINE   "TMLN"
+#define BINARY_CHUNK_ALIASES    "ALIS"
+#define BINARY_CHUNK_RESAMPLED  "RSMP"
+
+// Optional fields of a Place command
+#define BINARY_PLACE_HAS_PLACE_AFTER    0x1
+#define BINARY_PLACE_HAS_MATRIX         0x2
+#define BINARY_PLACE_HAS_SOUND          0x4
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Little-endian byte buffer with 4 byte aligned fields
+    class BinaryBuffer
+    {
+    public:
+
+        void WriteU32(FCM::U_Int32 value);
+
+        void WriteF32(FCM::Float value);
+
+        void WriteMatrix(const DOM::Utils::MATRIX2D& matrix);
+
+        void WriteColor(const DOM::Utils::COLOR& color);
+
+        void WriteString(const std::string& str);
+
+        void WriteBytes(const void* pData, FCM::U_Int32 size);
+
+        void WriteBuffer(const BinaryBuffer& buffer);
+
+        // Pads with zeros up to the next 4 byte boundary
+        void Align();
+
+        void Clear();
+
+        FCM::U_Int32 GetSize() const;
+
+        const char* GetData() const;
+
+    private:
+
+        std::string m_data;
+    };
+
+
+    class BinaryOutputWriter : public BaseOutputWriter
+    {
+    public:
+
+        // Marks the begining of the Document
+        virtual FCM::Result StartDocument(
+            const DOM::Utils::COLOR& background,
+            FCM::U_Int32 stageHeight,
+            FCM::U_Int32 stageWidth,
+            FCM::U_Int32 fps);
+
+        // Marks the end of the Document
+        virtual FCM::Result EndDocument();
+
+        // Creates a timeline writer owned by this writer
+        virtual ITimelineWriter* CreateTimelineWriter();
+
+        // Marks the start of a timeline
+        virtual FCM::Result StartDefineTimeline();
+
+        // Marks the end of a timeline
+        virtual FCM::Result EndDefineTimeline(
+            FCM::U_Int32 resId,
+            FCM::StringRep16 pName,
+            ITimelineWriter* pTimelineWriter);
+
+        // Marks the start of a shape
+        virtual FCM::Result StartDefineShape();
+
+        // Start of fill region definition
+        virtual FCM::Result StartDefineFill();
+
+        // Solid fill style definition
+        virtual FCM::Result DefineSolidFillStyle(const DOM::Utils::COLOR& color);
+
+        // Bitmap fill style definition
+        virtual FCM::Result DefineBitmapFillStyle(
+            FCM::Boolean clipped,
+            const DOM::Utils::MATRIX2D& matrix,
+            FCM::S_Int32 height,
+            FCM::S_Int32 width,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        // Start Linear Gradient fill style definition
+        virtual FCM::Result StartDefineLinearGradientFillStyle(
+            DOM::FillStyle::GradientSpread spread,
+            const DOM::Utils::MATRIX2D& matrix);
+
+        // Sets a specific key point in a color ramp (for both radial and linear gradient)
+        virtual FCM::Result SetKeyColorPoint(
+            const DOM::Utils::GRADIENT_COLOR_POINT& colorPoint);
+
+        // End Linear Gradient fill style definition
+        virtual FCM::Result EndDefineLinearGradientFillStyle();
+
+        // Start Radial Gradient fill style definition
+        virtual FCM::Result StartDefineRadialGradientFillStyle(
+            DOM::FillStyle::GradientSpread spread,
+            const DOM::Utils::MATRIX2D& matrix,
+            FCM::S_Int32 focalPoint);
+
+        // End Radial Gradient fill style definition
+        virtual FCM::Result EndDefineRadialGradientFillStyle();
+
+        // Start of fill region boundary
+        virtual FCM::Result StartDefineBoundary();
+
+        // Sets a segment of a path (Used for boundary, holes)
+        virtual FCM::Result SetSegment(const DOM::Utils::SEGMENT& segment);
+
+        // End of fill region boundary
+        virtual FCM::Result EndDefineBoundary();
+
+        // Start of fill region hole
+        virtual FCM::Result StartDefineHole();
+
+        // End of fill region hole
+        virtual FCM::Result EndDefineHole();
+
+        // Start of stroke group
+        virtual FCM::Result StartDefineStrokeGroup();
+
+        // Start solid stroke style definition
+        virtual FCM::Result StartDefineSolidStrokeStyle(
+            FCM::Double thickness,
+            const DOM::StrokeStyle::JOIN_STYLE& joinStyle,
+            const DOM::StrokeStyle::CAP_STYLE& capStyle,
+            DOM::Utils::ScaleType scaleType,
+            FCM::Boolean strokeHinting);
+
+        // End of solid stroke style
+        virtual FCM::Result EndDefineSolidStrokeStyle();
+
+        // Start of stroke
+        virtual FCM::Result StartDefineStroke();
+
+        // End of a stroke
+        virtual FCM::Result EndDefineStroke();
+
+        // End of stroke group
+        virtual FCM::Result EndDefineStrokeGroup();
+
+        // End of fill style definition
+        virtual FCM::Result EndDefineFill();
+
+        // Marks the end of a shape
+        virtual FCM::Result EndDefineShape(FCM::U_Int32 resId);
+
+        // Size in bytes of the definition written for a shape
+        virtual FCM::U_Int32 GetShapeSize(FCM::U_Int32 resId);
+
+        // Define a bitmap
+        virtual FCM::Result DefineBitmap(
+            FCM::U_Int32 resId,
+            FCM::S_Int32 height,
+            FCM::S_Int32 width,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        // Define text
+        virtual FCM::Result DefineText(
+            FCM::U_Int32 resId,
+            const std::string& name,
+            const DOM::Utils::COLOR& color,
+            const std::string& displayText,
+            DOM::FrameElement::PIClassicText pTextItem);
+
+        virtual FCM::Result DefineSound(
+            FCM::U_Int32 resId,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        BinaryOutputWriter(FCM::PIFCMCallback pCallback, const OUTPUT_SETTINGS& settings);
+
+        virtual ~BinaryOutputWriter();
+
+    private:
+
+        void StartDefinePath();
+
+        void AppendPoint(const DOM::Utils::POINT2D& point);
+
+        // Appends the current path (style, commands and coordinates) to the shape
+        void EndPath(BinaryPathType pathType);
+
+        void EndGradientFillStyle();
+
+        FCM::Result WriteChunk(const char* pTag, const BinaryBuffer& payload);
+
+    private:
+
+        std::fstream m_file;
+
+        BinaryBuffer m_shapeBuffer;
+
+        BinaryBuffer m_styleBuffer;
+
+        BinaryBuffer m_stopBuffer;
+
+        BinaryBuffer m_chunkBuffer;
+
+        FCM::U_Int32 m_pathCount;
+
+        FCM::U_Int32 m_stopCount;
+
+        std::vector<FCM::U_Int8> m_pathCmds;
+
+        std::vector<FCM::Float> m_pathCoords;
+
+        bool m_firstSegment;
+
+        STROKE_STYLE m_strokeStyle;
+
+        // Size of each SHAP chunk, including its header
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_shapeSizes;
+    };
+
+
+    class BinaryTimelineWriter : public ITimelineWriter
+    {
+    public:
+
+        virtual FCM::Result PlaceObject(
+            FCM::U_Int32 resId,
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 placeAfterObjectId,
+            const DOM::Utils::MATRIX2D* pMatrix,
+            FCM::PIFCMUnknown pUnknown = NULL);
+
+        virtual FCM::Result PlaceObject(
+            FCM::U_Int32 resId,
+            FCM::U_Int32 objectId,
+            FCM::PIFCMUnknown pUnknown = NULL);
+
+        virtual FCM::Result RemoveObject(
+            FCM::U_Int32 objectId);
+
+        virtual FCM::Result UpdateZOrder(
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 placeAfterObjectId);
+
+        virtual FCM::Result UpdateMask(
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 maskTillObjectId);
+
+        virtual FCM::Result UpdateBlendMode(
+            FCM::U_Int32 objectId,
+            DOM::FrameElement::BlendMode blendMode);
+
+        virtual FCM::Result UpdateVisibility(
+            FCM::U_Int32 objectId,
+            FCM::Boolean visible);
+
+        virtual FCM::Result AddGraphicFilter(
+            FCM::U_Int32 objectId,
+            FCM::PIFCMUnknown pFilter);
+
+        virtual FCM::Result UpdateDisplayTransform(
+            FCM::U_Int32 objectId,
+            const DOM::Utils::MATRIX2D& matrix);
+
+        virtual FCM::Result UpdateColorTransform(
+            FCM::U_Int32 objectId,
+            const DOM::Utils::COLOR_MATRIX& colorMatrix);
+
+        virtual FCM::Result ShowFrame(FCM::U_Int32 frameNum);
+
+        virtual FCM::Result AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum);
+
+        virtual FCM::Result RemoveFrameScript(FCM::U_Int32 layerNum);
+
+        virtual FCM::Result SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType);
+
+        BinaryTimelineWriter(FCM::PIFCMCallback pCallback);
+
+        virtual ~BinaryTimelineWriter();
+
+        // Builds the payload of the "TMLN" chunk
+        void Finish(FCM::U_Int32 resId, BinaryBuffer& payload);
+
+    private:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        // Frames written so far
+        BinaryBuffer m_frames;
+
+        FCM::U_Int32 m_frameCount;
+
+        // Commands, scripts and labels of the frame being built
+        BinaryBuffer m_commands;
+
+        FCM::U_Int32 m_commandCount;
+
+        BinaryBuffer m_scripts;
+
+        FCM::U_Int32 m_scriptCount;
+
+        BinaryBuffer m_labels;
+
+        FCM::U_Int32 m_labelCount;
+    };
+};
+
+#endif // BINARY_OUTPUT_WRITER_H_
@@ -0,0 +1,164 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  BitmapAtlas.h
+ *
+ * @brief This file contains declarations for packing the exported bitmaps into
+ *        shared atlas pages.
+ */
+
+#ifndef BITMAP_ATLAS_H_
+#define BITMAP_ATLAS_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Pages are written to the image folder as Atlas<page>.png
+#define BITMAP_ATLAS_FILE_PREFIX        "Atlas"
+
+// Largest page; every page is cropped to the bitmaps placed on it when written
+#define BITMAP_ATLAS_PAGE_SIZE          2048
+
+// Larger bitmaps gain little from sharing a page and are exported on their own
+#define BITMAP_ATLAS_MAX_BITMAP_SIZE    512
+
+// Edge pixels repeated around every bitmap, so that filtering when it is drawn
+// scaled does not pick up its neighbours
+#define BITMAP_ATLAS_PADDING            2
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    struct ATLAS_RECT
+    {
+        FCM::U_Int32 x;
+
+        FCM::U_Int32 y;
+
+        FCM::U_Int32 width;
+
+        FCM::U_Int32 height;
+    };
+
+    // Where a bitmap is drawn: the page and the position of its top-left pixel
+    struct ATLAS_REGION
+    {
+        FCM::U_Int32 page;
+
+        FCM::U_Int32 x;
+
+        FCM::U_Int32 y;
+    };
+
+    struct ATLAS_ENTRY
+    {
+        // The bitmap as exported by the host, deleted once drawn on its page
+        std::string sourcePath;
+
+        ATLAS_REGION region;
+
+        FCM::U_Int32 width;
+
+        FCM::U_Int32 height;
+    };
+
+    struct ATLAS_PAGE
+    {
+        // Maximal rectangles that are still free (they may overlap)
+        std::vector<ATLAS_RECT> freeRects;
+
+        // Extent of the bitmaps placed so far, to which the page is cropped
+        FCM::U_Int32 usedWidth;
+
+        FCM::U_Int32 usedHeight;
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Places bitmaps on pages with the MaxRects algorithm as they are defined, so
+    // that their position is known when the definition is written. Of the free
+    // positions, the one that grows the page least is taken, then the best short
+    // side fit. The pages are drawn once all the bitmaps have been exported.
+    class BitmapAtlas
+    {
+    public:
+
+        BitmapAtlas(FCM::PIFCMCallback pCallback);
+
+        ~BitmapAtlas();
+
+        static FCM::Boolean CanPack(FCM::S_Int32 width, FCM::S_Int32 height);
+
+        // Places the bitmap "name", to be read from "sourcePath" when the pages are
+        // written. A bitmap that was added before keeps its region.
+        void Add(
+            const std::string& name,
+            const std::string& sourcePath,
+            FCM::U_Int32 width,
+            FCM::U_Int32 height,
+            ATLAS_REGION& region);
+
+        FCM::Boolean Find(const std::string& name, ATLAS_REGION& region);
+
+        static void GetPageFileName(FCM::U_Int32 page, std::string& name);
+
+        // Draws the bitmaps on their pages and writes the pages to "folder". The
+        // exported bitmaps are deleted.
+        FCM::Result WritePages(const std::string& folder);
+
+    private:
+
+        // Returns false if the page has no room for the rectangle (lower scores are
+        // better)
+        static FCM::Boolean FindPosition(
+            const ATLAS_PAGE& page,
+            FCM::U_Int32 width,
+            FCM::U_Int32 height,
+            ATLAS_RECT& rect,
+            FCM::U_Int64& score);
+
+        static void PlaceRect(ATLAS_PAGE& page, const ATLAS_RECT& rect);
+
+        static void AddFreeRects(std::vector<ATLAS_RECT>& freeRects, const std::vector<ATLAS_RECT>& pieces);
+
+    private:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        std::vector<ATLAS_PAGE> m_pages;
+
+        std::vector<ATLAS_ENTRY> m_entries;
+
+        // Index in m_entries by bitmap name
+        std::map<std::string, FCM::U_Int32> m_entryMap;
+    };
+};
+
+#endif // BITMAP_ATLAS_H_
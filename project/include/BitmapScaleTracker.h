@@ -0,0 +1,106 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  BitmapScaleTracker.h
+ *
+ * @brief This file contains declarations for finding the largest scale at which
+ *        each bitmap is drawn on stage.
+ */
+
+#ifndef BITMAP_SCALE_TRACKER_H_
+#define BITMAP_SCALE_TRACKER_H_
+
+#include <string>
+#include <map>
+
+#include "FCMTypes.h"
+#include "Utils/DOMTypes.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Timelines nested deeper than this are not followed (symbols cannot contain
+// themselves, so this only guards against malformed documents)
+#define BITMAP_SCALE_MAX_NESTING        64
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    // Resource id -> largest scale
+    typedef std::map<FCM::U_Int32, FCM::Double> ResourceScaleMap;
+
+    // Library name of a bitmap -> largest scale
+    typedef std::map<std::string, FCM::Double> BitmapScaleMap;
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Records how every timeline places its children and how shapes fill with
+    // bitmaps. Once the document is complete, the scales are multiplied down from
+    // the timelines that no other timeline places (the main timeline or scenes).
+    class BitmapScaleTracker
+    {
+    public:
+
+        BitmapScaleTracker();
+
+        ~BitmapScaleTracker();
+
+        void Clear();
+
+        // Largest factor by which the matrix stretches any direction
+        static FCM::Double GetScale(const DOM::Utils::MATRIX2D& matrix);
+
+        // The largest scale of each child over all the frames of the timeline
+        void AddTimeline(FCM::U_Int32 resId, const ResourceScaleMap& childScales);
+
+        void AddBitmap(FCM::U_Int32 resId, const std::string& libPathName);
+
+        // "scale" maps bitmap pixels to the coordinates of the shape
+        void AddBitmapFill(FCM::U_Int32 shapeResId, const std::string& libPathName, FCM::Double scale);
+
+        // Bitmaps that are never drawn on stage are left out
+        void GetBitmapScales(BitmapScaleMap& scales);
+
+    private:
+
+        void Propagate(
+            FCM::U_Int32 resId,
+            FCM::Double scale,
+            FCM::U_Int32 depth,
+            ResourceScaleMap& resourceScales,
+            BitmapScaleMap& bitmapScales);
+
+        static void KeepLargest(BitmapScaleMap& scales, const std::string& libPathName, FCM::Double scale);
+
+    private:
+
+        std::map<FCM::U_Int32, ResourceScaleMap> m_timelines;
+
+        std::map<FCM::U_Int32, std::string> m_bitmaps;
+
+        // Shape resource id -> scales of the bitmaps it is filled with
+        std::map<FCM::U_Int32, BitmapScaleMap> m_bitmapFills;
+    };
+};
+
+#endif // BITMAP_SCALE_TRACKER_H_
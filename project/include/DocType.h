@@ -20,6 +20,7 @@
 #define DOC_TYPE_H_
 
 #include <map>
+#include <unordered_map>
 
 #include "Version.h"
 #include "FCMTypes.h"
@@ -56,9 +57,11 @@ namespace CreateJS
 
 namespace CreateJS
 {
-    typedef std::map<std::string, Value*> StrValueMap;
-    typedef std::map<std::string, Property*> StrPropertyMap;
-    typedef std::map<std::string, Feature*> StrFeatureMap;
+    // Keyed by the hash of the name, so that the UTF-16 names passed by the host
+    // can be looked up without converting them
+    typedef std::unordered_map<FCM::U_Int64, Value*> StrValueMap;
+    typedef std::unordered_map<FCM::U_Int64, Property*> StrPropertyMap;
+    typedef std::unordered_map<FCM::U_Int64, Feature*> StrFeatureMap;
 };
 
 
@@ -122,6 +125,9 @@ namespace CreateJS
 
     private:
 
+        // Builds the feature tree from the contents of Features.xml
+        void Parse(const char* pXML, size_t length);
+
         FCM::Result StartElement(
             const std::string name,
             const std::map<std::string, std::string>& attrs);
@@ -130,6 +136,8 @@ namespace CreateJS
 
         Feature* FindFeature(const std::string& inFeatureName);
 
+        Feature* FindFeature(CStringRep16 inFeatureName);
+
         Feature* UpdateFeature(const std::map<std::string, std::string>& inAttrs);
 
         Property* UpdateProperty(Feature* inFeature, const std::map<std::string,std::string>& inAttrs);
@@ -145,6 +153,9 @@ namespace CreateJS
         Property* mCurrentProperty;
 
         bool m_bInited;
+
+        // Callback registered with the ServiceRegistry by Init()
+        FCM::PIFCMCallback m_pServiceCallback;
         
         friend class FeatureDocumentHandler;
     };
@@ -154,13 +165,16 @@ namespace CreateJS
     {
     public:
 
-        Value(bool supported);
+        Value(const std::string& name, bool supported);
 
         ~Value();
 
         bool IsSupported();
 
+        const std::string& GetName();
+
     private:
+        std::string mName;
         bool mbSupported;
     };
 
@@ -168,19 +182,24 @@ namespace CreateJS
     class Property
     {
     public:
-        Property(const std::string& def, bool supported);
+        Property(const std::string& name, const std::string& def, bool supported);
 
         ~Property();
 
         Value* FindValue(const std::string& inValueName);
 
+        Value* FindValue(CStringRep16 inValueName);
+
         bool AddValue(const std::string& valueName, Value* pValue);
 
         bool IsSupported();
 
-        std::string GetDefault();
+        const std::string& GetDefault();
+
+        const std::string& GetName();
         
     private:
+        std::string mName;
         std::string mDefault;
         bool mbSupported;
         StrValueMap mValues;
@@ -192,18 +211,24 @@ namespace CreateJS
 
     public:
 
-        Feature(bool supported);
+        Feature(const std::string& name, bool supported);
 
         ~Feature();
 
         Property* FindProperty(const std::string& inPropertyName);
 
+        Property* FindProperty(CStringRep16 inPropertyName);
+
         bool AddProperty(const std::string& name, Property* pProperty);
 
         bool IsSupported();
 
+        const std::string& GetName();
+
     private:
 
+        std::string mName;
+
         bool mbSupported;
 
         StrPropertyMap mProperties;
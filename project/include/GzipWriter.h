@@ -0,0 +1,79 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  GzipWriter.h
+ *
+ * @brief This file contains declarations for the gzip compression of the published
+ *        files.
+ */
+
+#ifndef GZIP_WRITER_H_
+#define GZIP_WRITER_H_
+
+#include <string>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// The compressed copy of a file is written next to it as <file name>.gz
+#define GZIP_FILE_EXT                   ".gz"
+
+// zlib window bits for a gzip (RFC 1952) wrapper rather than a zlib (RFC 1950) one
+#define GZIP_WINDOW_BITS                (15 + 16)
+
+#define ZLIB_WINDOW_BITS                15
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Writes gzip (RFC 1952) files and zlib (RFC 1950) streams with zlib
+    class GzipWriter
+    {
+    public:
+
+        // Writes the compressed copy of "srcPath" to "destPath". Returns the sizes
+        // of both files through the optional pointers.
+        static FCM::Result CompressFile(
+            const std::string& srcPath,
+            const std::string& destPath,
+            FCM::PIFCMCallback pCallback,
+            FCM::U_Int64* pInSize = NULL,
+            FCM::U_Int64* pOutSize = NULL);
+
+        // Appends a gzip member holding "in" to "out"
+        static void Compress(const std::string& in, std::string& out);
+
+        // Appends a zlib (RFC 1950) stream holding "in" to "out", as stored in PNG files
+        static void CompressZlib(const std::string& in, std::string& out);
+
+        static FCM::U_Int32 GetCRC32(const std::string& in);
+
+    private:
+
+        static void Deflate(const std::string& in, int windowBits, std::string& out);
+    };
+};
+
+#endif // GZIP_WRITER_H_
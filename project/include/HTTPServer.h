@@ -20,8 +20,10 @@
 
 #ifdef USE_HTTP_SERVER
 
+#include <map>
 #include <string>
 #include <memory>
+#include <mutex>
 #ifdef _WINDOWS
 #include <xmemory>
 #endif
@@ -37,6 +39,9 @@
 
 /* -------------------------------------------------- Macros / Constants */
 
+// Websocket endpoint of the preview pages. A page sends its own name once connected,
+// and is then sent a message (see PreviewUpdate.h) whenever it is published again.
+#define LIVE_RELOAD_URI                 "/livereload"
 
 /* -------------------------------------------------- Structs / Unions */
 
@@ -46,6 +51,23 @@ struct ServerConfigParam
     int port;
 };
 
+namespace CreateJS
+{
+    // What a preview is served from. Replaced as a whole by every publish; requests
+    // being served hold on to the one they started with.
+    struct PREVIEW_CONTENT
+    {
+        // Output folder
+        std::string root;
+
+        // Runtime folder of the extension, served in place of the one under the root
+        std::string runtimeFolder;
+
+        // Contents of output files by name (relative to the root)
+        std::map<std::string, std::string> files;
+    };
+}
+
 /* -------------------------------------------------- Class Decl */
 
 namespace CreateJS
@@ -59,17 +81,53 @@ namespace CreateJS
         FCM::Result Start();
         void Stop();
 
+        FCM::Boolean IsRunning() const;
+
         void SetConfig(const ServerConfigParam& config);
 
+        const ServerConfigParam& GetConfig() const;
+
+        // Points the server (running or not) at the output of a publish. The files
+        // are taken over from "files".
+        void SetContent(
+            const std::string& root, 
+            const std::string& runtimeFolder, 
+            std::map<std::string, std::string>& files);
+
+        std::shared_ptr<const PREVIEW_CONTENT> GetContent();
+
+        // True if a preview page "pageName" is open and connected to LIVE_RELOAD_URI
+        FCM::Boolean HasLivePage(const std::string& pageName);
+
+        // Sends "message" to the open pages "pageName". Returns the number of pages reached.
+        FCM::U_Int32 SendLiveMessage(const std::string& pageName, const std::string& message);
+
     private:
         HTTPServer();
 
         static int BeginRequestHandler(struct mg_connection* conn);
 
+#ifdef USE_WEBSOCKET
+        static int WebSocketConnectHandler(const struct mg_connection* conn);
+
+        static void WebSocketReadyHandler(struct mg_connection* conn);
+
+        static int WebSocketDataHandler(struct mg_connection* conn, int bits, char* data, size_t dataLength);
+
+        static void EndRequestHandler(const struct mg_connection* conn, int replyStatusCode);
+#endif
+
     private:
         static std::auto_ptr<HTTPServer> m_instance;
         ServerConfigParam m_config;
         struct mg_context* m_context;
+
+        std::mutex m_contentMutex;
+        std::shared_ptr<const PREVIEW_CONTENT> m_content;
+
+        // Open pages by connection, with their names once they sent them
+        std::mutex m_liveMutex;
+        std::map<const struct mg_connection*, std::string> m_livePages;
     };
 
 };
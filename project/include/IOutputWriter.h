@@ -18,6 +18,7 @@
 #ifndef IOUTPUT_WRITER_H_
 #define IOUTPUT_WRITER_H_
 
+#include <map>
 #include <string>
 
 #include "FCMTypes.h"
@@ -38,12 +39,96 @@ namespace CreateJS
 
 /* -------------------------------------------------- Enums */
 
+namespace CreateJS
+{
+    enum OutputFormat
+    {
+        // Single JSON document (default)
+        JSON_OUTPUT_FORMAT,
+
+        // Compact binary container (see BinaryOutputWriter.h)
+        BINARY_OUTPUT_FORMAT
+    };
+}
 
 /* -------------------------------------------------- Macros / Constants */
 
 
 /* -------------------------------------------------- Structs / Unions */
 
+namespace CreateJS
+{
+    // Contents of output files by name (relative to the output folder)
+    typedef std::map<std::string, std::string> OutputFileMap;
+
+    struct OUTPUT_SETTINGS
+    {
+        // Write each shape and timeline to disk as soon as it is defined instead of
+        // holding the complete document in memory until EndDocument().
+        FCM::Boolean streamOutput;
+
+        // Maximum number of fractional digits written for coordinates and matrices
+        FCM::U_Int32 numberPrecision;
+
+        // Number of threads used to export bitmaps and sounds (0 exports them serially
+        // on the publish thread, for hosts that need single-threaded service calls)
+        FCM::U_Int32 assetExportThreads;
+
+        OutputFormat outputFormat;
+
+        // Write Move commands as quantized deltas and fold runs of unchanged frames
+        // (JSON output only, expanded by runtime/timelineanimator.js)
+        FCM::Boolean compressTimeline;
+
+        // Write the runs of Move commands that follow an eased tween as one Tween
+        // command (JSON output only, expanded by runtime/timelineanimator.js)
+        FCM::Boolean writeTweens;
+
+        // Write the shapes between the keys of a shape tween as a ratio of the way from
+        // one key to the other (JSON output only, not with streamOutput or compactPaths;
+        // expanded by runtime/resourcemanager.js)
+        FCM::Boolean morphShapes;
+
+        // Define identical shapes once and place the first definition for all of them
+        FCM::Boolean dedupShapes;
+
+        // Largest distance (in pixels) by which simplified paths may differ from the
+        // artwork (0 writes the paths as they are)
+        FCM::Double simplifyTolerance;
+
+        // Write paths in the compact encoding read by Graphics.decodePath() (EaselJS)
+        // instead of text (JSON output only; coordinates are rounded to COMPACT_PATH_SCALE)
+        FCM::Boolean compactPaths;
+
+        // Replay the output calls on a writer thread while the host traverses the
+        // document (see PipelinedOutputWriter.h)
+        FCM::Boolean pipelinedOutput;
+
+        // Write a gzip copy (<file>.gz) of the data file and of the HTML page, served
+        // by the preview server to clients that accept it
+        FCM::Boolean precompressOutput;
+
+        // Draw the PNG bitmaps of up to BITMAP_ATLAS_MAX_BITMAP_SIZE pixels on shared
+        // atlas pages instead of exporting a file for each (see BitmapAtlas.h)
+        FCM::Boolean packBitmaps;
+
+        // Write the PNG bitmaps that are never drawn at full size at the largest scale
+        // they are drawn at (see IOutputWriter::SetBitmapScale()), times
+        // resampleHeadroom. Bitmaps on atlas pages and JPEG bitmaps are not resampled.
+        FCM::Boolean resampleBitmaps;
+
+        FCM::Double resampleHeadroom;
+
+        // Quality (1-100) passed to the host when it encodes a bitmap; used by the
+        // JPEG bitmaps
+        FCM::U_Int32 bitmapQuality;
+
+        // Keep the contents of the files written in full (not streamed) for
+        // TakeOutputFiles(). Set by the publisher when the preview server serves them.
+        FCM::Boolean keepOutputFiles;
+    };
+}
+
 
 /* -------------------------------------------------- Class Decl */
 
@@ -53,12 +138,17 @@ namespace CreateJS
     {
     public:
 
+        virtual ~IOutputWriter() {}
+
         // Marks the begining of the output
         virtual FCM::Result StartOutput(std::string& outputFileName) = 0;
 
         // Marks the end of the output
         virtual FCM::Result EndOutput() = 0;
 
+        // Hands over the files kept after EndOutput() (see OUTPUT_SETTINGS::keepOutputFiles)
+        virtual void TakeOutputFiles(OutputFileMap& files) = 0;
+
         // Marks the begining of the Document
         virtual FCM::Result StartDocument(
             const DOM::Utils::COLOR& background, 
@@ -69,6 +159,10 @@ namespace CreateJS
         // Marks the end of the Document
         virtual FCM::Result EndDocument() = 0;
 
+        // Creates a writer for the commands of one timeline. The writer is owned
+        // by the output writer and stays valid until the output writer is deleted.
+        virtual ITimelineWriter* CreateTimelineWriter() = 0;
+
         // Marks the start of a timeline
         virtual FCM::Result StartDefineTimeline() = 0;
 
@@ -161,6 +255,9 @@ namespace CreateJS
         // Marks the end of a shape
         virtual FCM::Result EndDefineShape(FCM::U_Int32 resId) = 0;
 
+        // Size in bytes of the definition written for a shape (used for statistics)
+        virtual FCM::U_Int32 GetShapeSize(FCM::U_Int32 resId) = 0;
+
         // Define a bitmap
         virtual FCM::Result DefineBitmap(
             FCM::U_Int32 resId,
@@ -182,6 +279,10 @@ namespace CreateJS
             FCM::U_Int32 resId, 
             const std::string& libPathName,
             DOM::LibraryItem::PIMediaItem pMediaItem) = 0;
+
+        // Largest scale at which a bitmap is drawn on stage, over all its placements
+        // and fills. Given for the bitmaps that are drawn, before EndDocument().
+        virtual FCM::Result SetBitmapScale(const std::string& libPathName, FCM::Double scale) = 0;
     };
 
     
@@ -189,6 +290,8 @@ namespace CreateJS
     {
     public:
 
+        virtual ~ITimelineWriter() {}
+
         virtual FCM::Result PlaceObject(
             FCM::U_Int32 resId,
             FCM::U_Int32 objectId,
@@ -0,0 +1,126 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  JSONArena.h
+ *
+ * @brief This file contains declarations for the arena that serves libjson's node
+ *        allocations during a publish.
+ */
+
+#ifndef JSON_ARENA_H_
+#define JSON_ARENA_H_
+
+#include <cstddef>
+#include <thread>
+
+#include "FCMTypes.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Size of the first chunk; every further chunk is twice as large up to the maximum
+#define JSON_ARENA_MIN_CHUNK_SIZE       (256 * 1024)
+
+#define JSON_ARENA_MAX_CHUNK_SIZE       (8 * 1024 * 1024)
+
+// Blocks are aligned like malloc() results
+#define JSON_ARENA_ALIGNMENT            16
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    struct JSON_ARENA_STATS
+    {
+        // Allocations served by the arena
+        FCM::U_Int64 arenaAllocations;
+
+        // Allocations that went to the heap (other threads, or no arena open)
+        FCM::U_Int64 heapAllocations;
+
+        // Frees that the arena skipped
+        FCM::U_Int64 skippedFrees;
+
+        // Bytes handed out by the arena
+        FCM::U_Int64 bytesAllocated;
+
+        // Bytes reserved from the heap for the chunks
+        FCM::U_Int64 bytesReserved;
+
+        FCM::U_Int32 chunkCount;
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // libjson allocates every node and child array through the callbacks registered
+    // here (JSON_MEMORY_CALLBACKS). While an arena is open, those made on the thread
+    // that owns it (the one that opened it, unless it was handed on) are bump allocated
+    // and never freed individually; the arena is released as a whole by Close().
+    // Everything else goes to the heap.
+    class JSONArena
+    {
+    public:
+
+        static void Open();
+
+        // No node allocated while the arena was open may be alive at this point
+        static void Close();
+
+        // Hands the open arena (if any) to another thread. Called by the thread that
+        // holds it (which is then served by the heap) or once that thread has ended.
+        static void SetOwner(std::thread::id owner);
+
+        // Statistics since the last Open()
+        static void GetStats(JSON_ARENA_STATS& stats);
+
+    private:
+
+        static void* Allocate(size_t size);
+
+        static void* Reallocate(void* pBlock, size_t size);
+
+        static void Free(void* pBlock);
+
+        static void* AllocateFromChunk(size_t size);
+
+        static bool IsArenaBlock(void* pBlock);
+    };
+
+
+    // Opens an arena (if "open" is set) for the lifetime of the object or until Close()
+    class ScopedJSONArena
+    {
+    public:
+
+        ScopedJSONArena(bool open = true);
+
+        ~ScopedJSONArena();
+
+        void Close();
+
+    private:
+
+        bool m_open;
+    };
+};
+
+#endif // JSON_ARENA_H_
@@ -19,8 +19,12 @@
 #define OUTPUT_WRITER_H_
 
 #include "IOutputWriter.h"
+#include "ShapeMorpher.h"
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <fstream>
 
 /* -------------------------------------------------- Forward Decl */
 
@@ -29,6 +33,10 @@ class JSONNode;
 namespace CreateJS
 {
     class ITimelineWriter;
+    class AssetExportQueue;
+    class BitmapAtlas;
+    struct ATLAS_REGION;
+    class AssetStore;
 }
 
 /* -------------------------------------------------- Enums */
@@ -40,6 +48,28 @@ namespace CreateJS
         INVALID_STROKE_STYLE_TYPE,
         SOLID_STROKE_STYLE_TYPE
     };
+
+    // Instructions of a compact path, numbered as in Graphics.decodePath()
+    enum CompactPathCommand
+    {
+        COMPACT_PATH_MOVE_TO,
+        COMPACT_PATH_LINE_TO,
+        COMPACT_PATH_QUAD_CURVE_TO
+    };
+
+    // What a command recorded by a JSONTimelineWriter in tween mode does to the
+    // matrix of its object
+    enum TimelineSampleType
+    {
+        // Move command, written once the tweens are known
+        TIMELINE_SAMPLE_MOVE,
+
+        // Place command with a matrix (already written)
+        TIMELINE_SAMPLE_PLACE,
+
+        // Place command without a matrix or Remove command (already written)
+        TIMELINE_SAMPLE_RESET
+    };
 }
 
 
@@ -48,6 +78,28 @@ namespace CreateJS
 #define IMAGE_FOLDER "images"
 #define SOUND_FOLDER "sounds"
 
+// Size of the write buffer attached to each file in streaming mode
+#define JSON_STREAM_BUFFER_SIZE (64 * 1024)
+
+// Timelines are spilled to this file (next to the JSON) until the document ends
+#define TIMELINE_SPILL_FILE_EXT ".timeline.tmp"
+
+// Graphics.decodePath() reads coordinates in tenths of a pixel
+#define COMPACT_PATH_SCALE 10
+
+// Largest value of a compact path (17 bits in three base64 digits; 11 bits fit in two)
+#define MAX_COMPACT_PATH_VALUE 131071
+#define MAX_SHORT_COMPACT_PATH_VALUE 2047
+
+// Steps per unit used to quantize matrices in compressed timelines. Translation is
+// kept in twips and the scale/skew components in 16.16 fixed point, as in the SWF
+// format. Must match the decoder in runtime/timelineanimator.js.
+#define TIMELINE_TRANSLATE_QUANTUM  20
+#define TIMELINE_SCALE_QUANTUM      65536
+
+// Largest value of OUTPUT_SETTINGS::resampleHeadroom
+#define MAX_RESAMPLE_HEADROOM       4
+
 
 /* -------------------------------------------------- Structs / Unions */
 
@@ -71,6 +123,67 @@ namespace CreateJS
             SOLID_STROKE_STYLE solidStrokeStyle;
         };
     };
+
+    // a, b, c, d, tx, ty in quantization steps
+    struct QUANTIZED_MATRIX
+    {
+        FCM::S_Int32 value[6];
+    };
+
+    struct TIMELINE_SAMPLE
+    {
+        TimelineSampleType type;
+
+        // Index of the frame and of the command of the frame it goes before
+        FCM::U_Int32 frameIndex;
+
+        FCM::U_Int32 position;
+
+        FCM::U_Int32 objectId;
+
+        DOM::Utils::MATRIX2D matrix;
+
+        // Number of frames of the tween that starts with this Move (0 if none)
+        FCM::U_Int32 tweenFrames;
+
+        FCM::Double tweenEase;
+
+        DOM::Utils::MATRIX2D tweenStart;
+
+        DOM::Utils::MATRIX2D tweenEnd;
+
+        // The Move is replaced by a tween that starts in an earlier frame
+        FCM::Boolean inTween;
+    };
+
+    // A frame kept by a JSONTimelineWriter in tween mode until the timeline ends
+    struct TIMELINE_FRAME
+    {
+        FCM::U_Int32 frameNum;
+
+        JSONNode* pFrameElement;
+
+        JSONNode* pCommandArray;
+    };
+
+    // A PNG bitmap exported to a file of its own, which may be written again at the
+    // size it is drawn at (see OUTPUT_SETTINGS::resampleBitmaps)
+    struct RESAMPLE_CANDIDATE
+    {
+        std::string libPathName;
+
+        std::string filePath;
+
+        std::string relPath;
+    };
+
+    // Size in pixels of a resampled bitmap file
+    struct RESAMPLED_SIZE
+    {
+        FCM::U_Int32 width;
+
+        FCM::U_Int32 height;
+    };
 }
 
 
@@ -78,7 +191,9 @@ namespace CreateJS
 
 namespace CreateJS
 {
-    class JSONOutputWriter : public IOutputWriter
+    // Parts shared by all the output formats: output file names, the HTML page,
+    // bitmap/sound export and ownership of the timeline writers.
+    class BaseOutputWriter : public IOutputWriter
     {
     public:
 
@@ -88,6 +203,147 @@ namespace CreateJS
         // Marks the end of the output
         virtual FCM::Result EndOutput();
 
+        virtual void TakeOutputFiles(OutputFileMap& files);
+
+        virtual FCM::Result SetBitmapScale(const std::string& libPathName, FCM::Double scale);
+
+        virtual ~BaseOutputWriter();
+
+    protected:
+
+        BaseOutputWriter(
+            FCM::PIFCMCallback pCallback, 
+            const OUTPUT_SETTINGS& settings, 
+            const std::string& dataFileExtension);
+
+        // Takes ownership of a timeline writer created by CreateTimelineWriter()
+        ITimelineWriter* AddTimelineWriter(ITimelineWriter* pTimelineWriter);
+
+        // Prepares the HTML page that loads the data file in the runtime
+        FCM::Result CreateHTMLOutput(
+            const DOM::Utils::COLOR& background,
+            FCM::U_Int32 stageHeight, 
+            FCM::U_Int32 stageWidth,
+            FCM::U_Int32 fps);
+
+        FCM::Result WriteHTMLOutput();
+
+        // Keeps the contents of an output file if OUTPUT_SETTINGS::keepOutputFiles is set
+        void KeepOutputFile(const std::string& filePath, const std::string& content);
+
+        // Writes the gzip copy of an output file next to it
+        FCM::Result PrecompressFile(const std::string& filePath);
+
+        // Exports a bitmap (once per library item) and returns its path relative to the page.
+        // A bitmap packed on an atlas page (see OUTPUT_SETTINGS::packBitmaps) returns
+        // the path of the page, and "region" gives its position there.
+        FCM::Result ExportBitmap(
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem,
+            FCM::S_Int32 height,
+            FCM::S_Int32 width,
+            std::string& bitmapRelPath,
+            FCM::Boolean& packed,
+            ATLAS_REGION& region);
+
+        // Exports a sound (once per library item) and returns its path relative to the page
+        FCM::Result ExportSound(
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem,
+            std::string& soundRelPath);
+
+        // Waits for the bitmaps and sounds to be written, draws the atlas pages,
+        // resamples the bitmaps (see m_resampledBitmaps) and removes the duplicate
+        // files (see m_assetAliases)
+        FCM::Result FinishAssetExport();
+
+    private:
+
+        FCM::Result ResampleBitmaps();
+
+        FCM::Result CreateImageFolder();
+
+        FCM::Boolean IsPackable(const std::string& libPathName, FCM::S_Int32 height, FCM::S_Int32 width);
+        
+        FCM::Result CreateImageFileName(const std::string& libPathName, std::string& name);
+
+        FCM::Result CreateSoundFileName(const std::string& libPathName, std::string& name);
+
+        FCM::Boolean GetImageExportFileName(const std::string& libPathName, std::string& name);
+
+        void SetImageExportFileName(const std::string& libPathName, const std::string& name);
+
+        FCM::Boolean GetSoundExportFileName(const std::string& libPathName, std::string& name);
+
+        void SetSoundExportFileName(const std::string& libPathName, const std::string& name);
+
+    protected:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        OUTPUT_SETTINGS m_settings;
+
+        std::string m_outputHTMLFile;
+
+        std::string m_outputDataFilePath;
+
+        std::string m_outputDataFileName;
+
+        std::string m_outputImageFolder;
+
+        std::string m_outputSoundFolder;
+
+        // Paths of the bitmaps and sounds removed as duplicates by FinishAssetExport(),
+        // with the paths to load instead. Written at the end of the data file.
+        std::map<std::string, std::string> m_assetAliases;
+
+        // Paths of the bitmaps written smaller than their library item by
+        // FinishAssetExport(), with the size of the file. Written at the end of the
+        // data file, so that the runtime can draw them at the size of the item.
+        std::map<std::string, RESAMPLED_SIZE> m_resampledBitmaps;
+
+    private:
+
+        std::string m_dataFileExtension;
+
+        char* m_HTMLOutput;
+
+        OutputFileMap m_outputFiles;
+
+        FCM::U_Int32 m_imageFileNameLabel;
+
+        FCM::U_Int32 m_soundFileNameLabel;
+
+        std::map<std::string, std::string> m_imageMap;
+
+        std::map<std::string, std::string> m_soundMap;
+        
+        FCM::Boolean m_imageFolderCreated;
+        
+        FCM::Boolean m_soundFolderCreated;
+
+        // Bitmaps and sounds are encoded through this queue; it is joined in FinishAssetExport()
+        AssetExportQueue* m_pAssetExportQueue;
+
+        // Set if OUTPUT_SETTINGS::packBitmaps is
+        BitmapAtlas* m_pBitmapAtlas;
+
+        // Files of the bitmaps and sounds used by the publish, for removing duplicates
+        AssetStore* m_pAssetStore;
+
+        std::vector<RESAMPLE_CANDIDATE> m_resampleCandidates;
+
+        // Library name -> largest scale the bitmap is drawn at (see SetBitmapScale())
+        std::map<std::string, FCM::Double> m_bitmapScales;
+
+        std::vector<ITimelineWriter*> m_timelineWriters;
+    };
+
+
+    class JSONOutputWriter : public BaseOutputWriter
+    {
+    public:
+
         // Marks the begining of the Document
         virtual FCM::Result StartDocument(
             const DOM::Utils::COLOR& background,
@@ -190,6 +446,9 @@ namespace CreateJS
         // Marks the end of a shape
         virtual FCM::Result EndDefineShape(FCM::U_Int32 resId);
 
+        // Size in bytes of the definition written for a shape
+        virtual FCM::U_Int32 GetShapeSize(FCM::U_Int32 resId);
+
         // Define a bitmap
         virtual FCM::Result DefineBitmap(
             FCM::U_Int32 resId,
@@ -210,7 +469,11 @@ namespace CreateJS
             FCM::U_Int32 resId, 
             const std::string& libPathName,
             DOM::LibraryItem::PIMediaItem pMediaItem);
-        JSONOutputWriter(FCM::PIFCMCallback pCallback);
+
+        // Creates a timeline writer owned by this writer
+        virtual ITimelineWriter* CreateTimelineWriter();
+
+        JSONOutputWriter(FCM::PIFCMCallback pCallback, const OUTPUT_SETTINGS& settings);
 
         virtual ~JSONOutputWriter();
 
@@ -221,14 +484,30 @@ namespace CreateJS
         virtual FCM::Result EndDefinePath();
 
     private:
-        
-        FCM::Result CreateImageFileName(const std::string& libPathName, std::string& name);
 
-        FCM::Result CreateSoundFileName(const std::string& libPathName, std::string& name);
+        void AppendCommand(CompactPathCommand command);
 
-        FCM::Boolean GetImageExportFileName(const std::string& libPathName, std::string& name);
+        void AppendPoint(const DOM::Utils::POINT2D& point);
 
-        void SetImageExportFileName(const std::string& libPathName, const std::string& name);
+        // Adds the path data of the fill or stroke being defined to m_pathElem
+        void WritePathData();
+
+        FCM::Result OpenStream(
+            const std::string& fileName, 
+            std::fstream& file, 
+            char* pBuffer, 
+            std::ios_base::openmode mode);
+
+        FCM::Result EndStreamedDocument();
+
+        // "Aliases": the path to load for each path of a removed duplicate
+        void CreateAliasNode(JSONNode& node);
+
+        // "Resampled": the width and height of each bitmap file written smaller
+        void CreateResampledNode(JSONNode& node);
+
+        // Replaces the shapes between the keys of shape tweens with their morphs
+        void WriteMorphs();
 
     private:
 
@@ -258,31 +537,41 @@ namespace CreateJS
 
         bool        m_firstSegment;
 
+        // Compact paths: the commands and points (in COMPACT_PATH_SCALE units) of the
+        // fill or stroke being defined, encoded once it ends
+        std::vector<FCM::Byte> m_pathCmds;
+
+        std::vector<FCM::S_Int32> m_pathCoords;
+
         STROKE_STYLE m_strokeStyle;
 
-        std::string m_outputHTMLFile;
+        // Streaming mode: shapes go straight to the JSON file, timelines to a spill file
+        std::fstream m_jsonStream;
 
-        std::string m_outputJSONFilePath;
+        std::fstream m_timelineStream;
 
-        std::string m_outputJSONFileName;
+        std::string m_timelineSpillFilePath;
 
-        std::string m_outputImageFolder;
+        char* m_pJsonStreamBuffer;
 
-        std::string m_outputSoundFolder;
+        char* m_pTimelineStreamBuffer;
 
-        char* m_HTMLOutput;
+        FCM::U_Int32 m_streamedShapeCount;
 
-        FCM::PIFCMCallback m_pCallback;
+        FCM::U_Int32 m_streamedTimelineCount;
 
-        FCM::U_Int32 m_imageFileNameLabel;
+        // Size of each shape as written to the JSON file (unformatted), recorded
+        // when streaming and measured on request otherwise
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_shapeSizes;
 
-        FCM::U_Int32 m_soundFileNameLabel;
+        // Position of each shape in m_pShapeArray, when the shapes are held
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_shapeIndexes;
 
-        std::map<std::string, std::string> m_imageMap;
-        
-        FCM::Boolean m_imageFolderCreated;
-        
-        FCM::Boolean m_soundFolderCreated;
+        // Morphs need every shape until EndDocument() and the text paths to
+        // interpolate, so they are off when streaming or writing compact paths
+        FCM::Boolean m_morphShapes;
+
+        ShapeMorpher m_shapeMorpher;
     };
 
 
@@ -340,7 +629,10 @@ namespace CreateJS
 
         virtual FCM::Result SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType);
 
-        JSONTimelineWriter(FCM::PIFCMCallback pCallback);
+        JSONTimelineWriter(
+            FCM::PIFCMCallback pCallback, 
+            FCM::Boolean compress = false, 
+            FCM::Boolean writeTweens = false);
 
         virtual ~JSONTimelineWriter();
 
@@ -348,6 +640,32 @@ namespace CreateJS
 
         void Finish(FCM::U_Int32 resId, FCM::StringRep16 pName);
 
+    private:
+
+        // Adds a Place/Move matrix to a command. In compressed mode the matrix is
+        // written as an absolute keyframe or as a delta against the previous one.
+        // Returns false if the object has not moved (the command can be dropped).
+        FCM::Boolean AddMatrix(
+            JSONNode& commandElement, 
+            FCM::U_Int32 objectId, 
+            const DOM::Utils::MATRIX2D& matrix,
+            FCM::Boolean keyframe);
+
+        void FlushFrame();
+
+        void WriteFrame(FCM::U_Int32 frameNum);
+
+        void AddSample(TimelineSampleType type, FCM::U_Int32 objectId, const DOM::Utils::MATRIX2D* pMatrix);
+
+        // Replaces the runs of Move commands that follow a tween and writes the frames
+        void WriteTweens();
+
+        // Marks the tweens of a run of Move commands in consecutive frames
+        void FitTweens(const DOM::Utils::MATRIX2D& start, const std::vector<FCM::U_Int32>& run);
+
+        // Writes a Move or Tween command, or updates the matrix of the object
+        void WriteSample(JSONNode& commandArray, const TIMELINE_SAMPLE& sample);
+
     private:
 
         JSONNode* m_pCommandArray;
@@ -359,6 +677,26 @@ namespace CreateJS
         JSONNode* m_pFrameElement;
 
         FCM::PIFCMCallback m_pCallback;
+
+        FCM::Boolean m_compress;
+
+        // Compressed mode only: last matrix written for each object on the display list
+        std::unordered_map<FCM::U_Int32, QUANTIZED_MATRIX> m_matrices;
+
+        // Compressed mode only: last non-empty frame and the number of empty frames
+        // that follow it
+        JSONNode* m_pHeldFrameElement;
+
+        FCM::U_Int32 m_holdCount;
+
+        FCM::Boolean m_writeTweens;
+
+        // Tween mode only: the frames and the matrices of the timeline until it ends
+        std::vector<TIMELINE_FRAME> m_frames;
+
+        std::vector<TIMELINE_SAMPLE> m_samples;
+
+        FCM::U_Int32 m_tweenCount;
     };
 };
 
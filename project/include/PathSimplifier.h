@@ -0,0 +1,70 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  PathSimplifier.h
+ *
+ * @brief This file contains declarations for the simplification of the paths of a
+ *        shape before they are written.
+ */
+
+#ifndef PATH_SIMPLIFIER_H_
+#define PATH_SIMPLIFIER_H_
+
+#include <vector>
+
+#include "FCMTypes.h"
+#include "Utils/DOMTypes.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Largest tolerance (in pixels) accepted from the publish settings
+#define MAX_SIMPLIFY_TOLERANCE          10.0
+
+// Number of shapes listed by the simplification report
+#define MAX_SIMPLIFY_REPORT_SHAPES      10
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Removes detail smaller than a tolerance from a path, as a list of connected
+    // segments. Nearly flat curves become lines, runs of nearly collinear lines are
+    // merged and the remaining segments shorter than the tolerance are dropped. No
+    // point of the original path ends up farther than the tolerance from the result.
+    // The first and the last point of the path are kept, so closed paths stay closed.
+    class PathSimplifier
+    {
+    public:
+
+        static void Simplify(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance);
+
+    private:
+
+        static void FlattenCurves(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance);
+
+        static void MergeLines(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance);
+
+        static void DropShortLines(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance);
+    };
+};
+
+#endif // PATH_SIMPLIFIER_H_
@@ -0,0 +1,416 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  PipelinedOutputWriter.h
+ *
+ * @brief This file contains declarations for a output writer that hands the calls
+ *        made while the host traverses the document to a writer thread.
+ */
+
+#ifndef PIPELINED_OUTPUT_WRITER_H_
+#define PIPELINED_OUTPUT_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "OutputWriter.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+namespace CreateJS
+{
+    class PipelinedTimelineWriter;
+}
+
+
+/* -------------------------------------------------- Enums */
+
+namespace CreateJS
+{
+    enum PipelinedEventType
+    {
+        // IOutputWriter
+        PIPELINED_START_DOCUMENT,
+        PIPELINED_END_DOCUMENT,
+        PIPELINED_CREATE_TIMELINE_WRITER,
+        PIPELINED_START_DEFINE_TIMELINE,
+        PIPELINED_END_DEFINE_TIMELINE,
+        PIPELINED_START_DEFINE_SHAPE,
+        PIPELINED_START_DEFINE_FILL,
+        PIPELINED_DEFINE_SOLID_FILL_STYLE,
+        PIPELINED_START_DEFINE_LINEAR_GRADIENT_FILL_STYLE,
+        PIPELINED_SET_KEY_COLOR_POINT,
+        PIPELINED_END_DEFINE_LINEAR_GRADIENT_FILL_STYLE,
+        PIPELINED_START_DEFINE_RADIAL_GRADIENT_FILL_STYLE,
+        PIPELINED_END_DEFINE_RADIAL_GRADIENT_FILL_STYLE,
+        PIPELINED_START_DEFINE_BOUNDARY,
+        PIPELINED_SET_SEGMENT,
+        PIPELINED_END_DEFINE_BOUNDARY,
+        PIPELINED_START_DEFINE_HOLE,
+        PIPELINED_END_DEFINE_HOLE,
+        PIPELINED_START_DEFINE_STROKE_GROUP,
+        PIPELINED_START_DEFINE_SOLID_STROKE_STYLE,
+        PIPELINED_END_DEFINE_SOLID_STROKE_STYLE,
+        PIPELINED_START_DEFINE_STROKE,
+        PIPELINED_END_DEFINE_STROKE,
+        PIPELINED_END_DEFINE_STROKE_GROUP,
+        PIPELINED_END_DEFINE_FILL,
+        PIPELINED_END_DEFINE_SHAPE,
+
+        // ITimelineWriter
+        PIPELINED_PLACE_OBJECT,
+        PIPELINED_REMOVE_OBJECT,
+        PIPELINED_UPDATE_Z_ORDER,
+        PIPELINED_UPDATE_MASK,
+        PIPELINED_UPDATE_BLEND_MODE,
+        PIPELINED_UPDATE_VISIBILITY,
+        PIPELINED_UPDATE_DISPLAY_TRANSFORM,
+        PIPELINED_UPDATE_COLOR_TRANSFORM,
+        PIPELINED_SHOW_FRAME,
+        PIPELINED_ADD_FRAME_SCRIPT,
+        PIPELINED_REMOVE_FRAME_SCRIPT,
+        PIPELINED_SET_FRAME_LABEL,
+
+        // Ends the writer thread without writing anything
+        PIPELINED_STOP
+    };
+}
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Number of events the queue holds before the publish thread waits (a power of 2)
+#define PIPELINED_QUEUE_SIZE            4096
+
+// Times the writer thread polls an empty queue before it goes to sleep
+#define PIPELINED_SPIN_COUNT            256
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    struct PIPELINED_GRADIENT
+    {
+        DOM::FillStyle::GradientSpread spread;
+
+        DOM::Utils::MATRIX2D matrix;
+
+        FCM::S_Int32 focalPoint;
+    };
+
+    struct PIPELINED_DOCUMENT
+    {
+        DOM::Utils::COLOR background;
+
+        FCM::U_Int32 stageHeight;
+
+        FCM::U_Int32 stageWidth;
+
+        FCM::U_Int32 fps;
+    };
+
+    // One call, with its arguments copied. Nothing in it refers to the host.
+    struct PIPELINED_EVENT
+    {
+        PipelinedEventType type;
+
+        // Timeline writer the event is for (timeline events only)
+        PipelinedTimelineWriter* pTimelineWriter;
+
+        FCM::U_Int32 resId;
+
+        FCM::U_Int32 objectId;
+
+        // Other integer argument (place after / mask till object id, frame, layer,
+        // blend mode, visibility or label type)
+        FCM::U_Int32 value;
+
+        FCM::Boolean hasMatrix;
+
+        // Null terminated copy of a name, label or script, owned by the event
+        FCM::U_Int16* pText;
+
+        union
+        {
+            PIPELINED_DOCUMENT document;
+            DOM::Utils::COLOR color;
+            DOM::Utils::MATRIX2D matrix;
+            DOM::Utils::COLOR_MATRIX colorMatrix;
+            DOM::Utils::GRADIENT_COLOR_POINT colorPoint;
+            DOM::Utils::SEGMENT segment;
+            PIPELINED_GRADIENT gradient;
+            SOLID_STROKE_STYLE strokeStyle;
+        };
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Wraps a output writer (JSON or binary). The calls made while the host traverses
+    // the document only copy their arguments into a single producer/single consumer
+    // queue; a writer thread replays them on the wrapped writer, so that formatting,
+    // building the document and writing files overlap with the traversal.
+    //
+    // Calls that pass host objects (bitmaps, sounds, texts, bitmap fills, filters) or
+    // return a result first wait for the queue to drain and are then made directly, on
+    // the publish thread. The first failure of a queued call is returned by the queued
+    // calls after it. EndDocument() is queued last and returns once the writer thread
+    // has ended; the JSON arena (if open) is used by the writer thread until then.
+    class PipelinedOutputWriter : public IOutputWriter
+    {
+    public:
+
+        // Takes ownership of "pOutputWriter"
+        PipelinedOutputWriter(IOutputWriter* pOutputWriter);
+
+        virtual ~PipelinedOutputWriter();
+
+        virtual FCM::Result StartOutput(std::string& outputFileName);
+
+        virtual FCM::Result EndOutput();
+
+        virtual void TakeOutputFiles(OutputFileMap& files);
+
+        virtual FCM::Result StartDocument(
+            const DOM::Utils::COLOR& background,
+            FCM::U_Int32 stageHeight,
+            FCM::U_Int32 stageWidth,
+            FCM::U_Int32 fps);
+
+        virtual FCM::Result EndDocument();
+
+        virtual ITimelineWriter* CreateTimelineWriter();
+
+        virtual FCM::Result StartDefineTimeline();
+
+        virtual FCM::Result EndDefineTimeline(
+            FCM::U_Int32 resId,
+            FCM::StringRep16 pName,
+            ITimelineWriter* pTimelineWriter);
+
+        virtual FCM::Result StartDefineShape();
+
+        virtual FCM::Result StartDefineFill();
+
+        virtual FCM::Result DefineSolidFillStyle(const DOM::Utils::COLOR& color);
+
+        virtual FCM::Result DefineBitmapFillStyle(
+            FCM::Boolean clipped,
+            const DOM::Utils::MATRIX2D& matrix,
+            FCM::S_Int32 height,
+            FCM::S_Int32 width,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        virtual FCM::Result StartDefineLinearGradientFillStyle(
+            DOM::FillStyle::GradientSpread spread,
+            const DOM::Utils::MATRIX2D& matrix);
+
+        virtual FCM::Result SetKeyColorPoint(
+            const DOM::Utils::GRADIENT_COLOR_POINT& colorPoint);
+
+        virtual FCM::Result EndDefineLinearGradientFillStyle();
+
+        virtual FCM::Result StartDefineRadialGradientFillStyle(
+            DOM::FillStyle::GradientSpread spread,
+            const DOM::Utils::MATRIX2D& matrix,
+            FCM::S_Int32 focalPoint);
+
+        virtual FCM::Result EndDefineRadialGradientFillStyle();
+
+        virtual FCM::Result StartDefineBoundary();
+
+        virtual FCM::Result SetSegment(const DOM::Utils::SEGMENT& segment);
+
+        virtual FCM::Result EndDefineBoundary();
+
+        virtual FCM::Result StartDefineHole();
+
+        virtual FCM::Result EndDefineHole();
+
+        virtual FCM::Result StartDefineStrokeGroup();
+
+        virtual FCM::Result StartDefineSolidStrokeStyle(
+            FCM::Double thickness,
+            const DOM::StrokeStyle::JOIN_STYLE& joinStyle,
+            const DOM::StrokeStyle::CAP_STYLE& capStyle,
+            DOM::Utils::ScaleType scaleType,
+            FCM::Boolean strokeHinting);
+
+        virtual FCM::Result EndDefineSolidStrokeStyle();
+
+        virtual FCM::Result StartDefineStroke();
+
+        virtual FCM::Result EndDefineStroke();
+
+        virtual FCM::Result EndDefineStrokeGroup();
+
+        virtual FCM::Result EndDefineFill();
+
+        virtual FCM::Result EndDefineShape(FCM::U_Int32 resId);
+
+        virtual FCM::U_Int32 GetShapeSize(FCM::U_Int32 resId);
+
+        virtual FCM::Result DefineBitmap(
+            FCM::U_Int32 resId,
+            FCM::S_Int32 height,
+            FCM::S_Int32 width,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        virtual FCM::Result DefineText(
+            FCM::U_Int32 resId,
+            const std::string& name,
+            const DOM::Utils::COLOR& color,
+            const std::string& displayText,
+            DOM::FrameElement::PIClassicText pTextItem);
+
+        virtual FCM::Result DefineSound(
+            FCM::U_Int32 resId,
+            const std::string& libPathName,
+            DOM::LibraryItem::PIMediaItem pMediaItem);
+
+        virtual FCM::Result SetBitmapScale(const std::string& libPathName, FCM::Double scale);
+
+    public:
+
+        // Used by PipelinedTimelineWriter
+
+        // Copies an event into the queue. Waits while the queue is full.
+        FCM::Result Post(const PIPELINED_EVENT& event);
+
+        // Waits until the writer thread has replayed every queued event. Returns the
+        // first failure of a queued call (if any).
+        FCM::Result Drain();
+
+    private:
+
+        void StartThread();
+
+        // Queues "PIPELINED_STOP" (unless the thread ends by itself) and joins
+        void StopThread(FCM::Boolean post);
+
+        void WorkerProc();
+
+        FCM::Result Replay(const PIPELINED_EVENT& event);
+
+        FCM::Result Post(PipelinedEventType type);
+
+    private:
+
+        IOutputWriter* m_pOutputWriter;
+
+        std::vector<PipelinedTimelineWriter*> m_timelineWriters;
+
+        std::vector<PIPELINED_EVENT> m_queue;
+
+        // Index of the next event to replay; written by the writer thread only
+        std::atomic<size_t> m_head;
+
+        // Index of the next free slot; written by the publish thread only
+        std::atomic<size_t> m_tail;
+
+        // First failure of a queued call
+        std::atomic<FCM::Result> m_result;
+
+        std::thread m_thread;
+
+        // The writer thread sleeps on m_eventPosted while the queue stays empty
+        std::atomic<bool> m_sleeping;
+
+        std::mutex m_mutex;
+
+        std::condition_variable m_eventPosted;
+    };
+
+
+    class PipelinedTimelineWriter : public ITimelineWriter
+    {
+    public:
+
+        PipelinedTimelineWriter(PipelinedOutputWriter* pOutputWriter);
+
+        virtual ~PipelinedTimelineWriter();
+
+        virtual FCM::Result PlaceObject(
+            FCM::U_Int32 resId,
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 placeAfterObjectId,
+            const DOM::Utils::MATRIX2D* pMatrix,
+            FCM::PIFCMUnknown pUnknown = NULL);
+
+        virtual FCM::Result PlaceObject(
+            FCM::U_Int32 resId,
+            FCM::U_Int32 objectId,
+            FCM::PIFCMUnknown pUnknown = NULL);
+
+        virtual FCM::Result RemoveObject(
+            FCM::U_Int32 objectId);
+
+        virtual FCM::Result UpdateZOrder(
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 placeAfterObjectId);
+
+        virtual FCM::Result UpdateMask(
+            FCM::U_Int32 objectId,
+            FCM::U_Int32 maskTillObjectId);
+
+        virtual FCM::Result UpdateBlendMode(
+            FCM::U_Int32 objectId,
+            DOM::FrameElement::BlendMode blendMode);
+
+        virtual FCM::Result UpdateVisibility(
+            FCM::U_Int32 objectId,
+            FCM::Boolean visible);
+
+        virtual FCM::Result AddGraphicFilter(
+            FCM::U_Int32 objectId,
+            FCM::PIFCMUnknown pFilter);
+
+        virtual FCM::Result UpdateDisplayTransform(
+            FCM::U_Int32 objectId,
+            const DOM::Utils::MATRIX2D& matrix);
+
+        virtual FCM::Result UpdateColorTransform(
+            FCM::U_Int32 objectId,
+            const DOM::Utils::COLOR_MATRIX& colorMatrix);
+
+        virtual FCM::Result ShowFrame(FCM::U_Int32 frameNum);
+
+        virtual FCM::Result AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum);
+
+        virtual FCM::Result RemoveFrameScript(FCM::U_Int32 layerNum);
+
+        virtual FCM::Result SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType);
+
+        // Writer of the wrapped output writer. It is created on the writer thread, so
+        // the publish thread may only use it once the queue is drained.
+        ITimelineWriter* GetTimelineWriter() const;
+
+        void SetTimelineWriter(ITimelineWriter* pTimelineWriter);
+
+    private:
+
+        PipelinedOutputWriter* m_pOutputWriter;
+
+        ITimelineWriter* m_pTimelineWriter;
+    };
+};
+
+#endif // PIPELINED_OUTPUT_WRITER_H_
@@ -32,6 +32,9 @@
 /* The value of RUNTIME_FOLDER_NAME must be the name of the runtime folder present in EclipseProject/ExtensionContent. */
 #define RUNTIME_FOLDER_NAME                 "SampleRuntime"
 
+/* Written into the runtime folder copied to the output, to tell whether that copy is current */
+#define RUNTIME_STAMP_FILE_NAME             "runtime.stamp"
+
 namespace CreateJS
 {
     // {835B2A74-9646-43AD-AA86-A35F4E0ECD1B}
@@ -0,0 +1,99 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  PngImage.h
+ *
+ * @brief This file contains declarations for reading and writing the PNG files of
+ *        the exported bitmaps.
+ */
+
+#ifndef PNG_IMAGE_H_
+#define PNG_IMAGE_H_
+
+#include <string>
+#include <vector>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+#define PNG_FILE_EXT                    ".png"
+
+// Larger images are not read
+#define PNG_MAX_DIMENSION               16384
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // An image of 8-bit RGBA pixels (not premultiplied). Every standard PNG can be
+    // read (all color types and bit depths, interlaced or not); images are always
+    // written as 8-bit RGBA. The image data is inflated and deflated with zlib.
+    class PngImage
+    {
+    public:
+
+        PngImage();
+
+        // Makes the image fully transparent
+        void Create(FCM::U_Int32 width, FCM::U_Int32 height);
+
+        FCM::Result Read(const std::string& filePath, FCM::PIFCMCallback pCallback);
+
+        // Returns the size of the file through the optional pointer
+        FCM::Result Write(
+            const std::string& filePath,
+            FCM::PIFCMCallback pCallback,
+            FCM::U_Int64* pSize = NULL) const;
+
+        // Copies "src" to (x, y) and repeats its edge pixels "border" pixels outwards
+        void Copy(const PngImage& src, FCM::U_Int32 x, FCM::U_Int32 y, FCM::U_Int32 border);
+
+        // Scales the image down to "width" x "height" pixels (no larger than it is)
+        void Resize(FCM::U_Int32 width, FCM::U_Int32 height);
+
+        FCM::U_Int32 GetWidth() const { return m_width; }
+
+        FCM::U_Int32 GetHeight() const { return m_height; }
+
+    private:
+
+        FCM::Boolean Decode(
+            const std::string& header,
+            const std::string& palette,
+            const std::string& transparency,
+            const std::string& data);
+
+        static FCM::Boolean Inflate(const std::string& in, std::string& out);
+
+    private:
+
+        FCM::U_Int32 m_width;
+
+        FCM::U_Int32 m_height;
+
+        std::vector<FCM::Byte> m_pixels;
+    };
+};
+
+#endif // PNG_IMAGE_H_
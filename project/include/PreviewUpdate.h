@@ -0,0 +1,78 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  PreviewUpdate.h
+ *
+ * @brief This file contains declarations for the messages that bring the open
+ *        preview pages of a document up to date after it is published again.
+ */
+
+#ifndef PREVIEW_UPDATE_H_
+#define PREVIEW_UPDATE_H_
+
+#include <string>
+
+#include "FCMTypes.h"
+#include "IOutputWriter.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+class JSONNode;
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Key of the elements of the document arrays
+#define PREVIEW_UPDATE_ID_KEY           "charid"
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // A page is sent one of
+    //   {"type":"update","DOMDocument":{"Shape":[...],"Timeline":[...],...}}
+    //     with the elements of the document arrays that are new or changed (the main
+    //     timeline is the element of "Timeline" without an id), to be replaced in place
+    //   {"type":"reload"}
+    //     when anything else changed (the page, an element that was removed or moved
+    //     to another array, or a document that is not JSON)
+    class PreviewUpdate
+    {
+    public:
+
+        // "previous" and "current" are the output files of the two publishes of the
+        // page "pageName" (see IOutputWriter::TakeOutputFiles())
+        static void Create(
+            const OutputFileMap& previous,
+            const OutputFileMap& current,
+            const std::string& pageName,
+            std::string& message);
+
+    private:
+
+        static FCM::Boolean CreateUpdate(
+            const std::string& previousJSON,
+            const std::string& currentJSON,
+            JSONNode& update);
+
+        static std::string GetKey(const JSONNode& element, FCM::U_Int32& unnamedCount);
+    };
+};
+
+#endif // PREVIEW_UPDATE_H_
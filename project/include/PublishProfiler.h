@@ -0,0 +1,169 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  PublishProfiler.h
+ *
+ * @brief This file contains declarations for the timers and counters used to
+ *        report where a publish spends its time.
+ */
+
+#ifndef PUBLISH_PROFILER_H_
+#define PUBLISH_PROFILER_H_
+
+#include <string>
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+namespace CreateJS
+{
+    // Phases may nest (fills and strokes are exported from inside
+    // GenerateFrameCommands), so their times are not meant to add up.
+    enum ProfilePhase
+    {
+        PROFILE_PHASE_PUBLISH,
+        PROFILE_PHASE_GENERATE_FRAME_COMMANDS,
+        PROFILE_PHASE_EXPORT_FILL,
+        PROFILE_PHASE_EXPORT_STROKE,
+        PROFILE_PHASE_EXPORT_BITMAP,
+        PROFILE_PHASE_EXPORT_SOUND,
+        PROFILE_PHASE_SERIALIZE,
+
+        // Time the publish thread waits for the pipelined writer (full queue or drain)
+        PROFILE_PHASE_WRITER_WAIT,
+
+        PROFILE_PHASE_COPY_RUNTIME,
+
+        // Writing the gzip copies of the output
+        PROFILE_PHASE_COMPRESS,
+
+        // Drawing and writing the atlas pages
+        PROFILE_PHASE_PACK_BITMAPS,
+
+        // Hashing the exported bitmaps and sounds to remove duplicates
+        PROFILE_PHASE_DEDUPLICATE_ASSETS,
+
+        // Writing bitmaps again at the size they are drawn at
+        PROFILE_PHASE_RESAMPLE_BITMAPS,
+
+        PROFILE_PHASE_COUNT
+    };
+
+    enum ProfileCounter
+    {
+        // Shapes held in memory by the JSON writer until the end of the document
+        PROFILE_COUNTER_SHAPES_HELD,
+
+        // Commands written for a single frame
+        PROFILE_COUNTER_FRAME_COMMANDS,
+
+        PROFILE_COUNTER_COUNT
+    };
+}
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// The Chrome trace is written next to the output as <output name>.trace.json
+#define PROFILE_TRACE_FILE_EXT          ".trace.json"
+
+// Trace events beyond this limit are dropped (the summary still counts them)
+#define MAX_PROFILE_TRACE_EVENTS        200000
+
+// Times the enclosing scope. Does nothing unless the profiler is running.
+#define PROFILE_SCOPE(phase)            CreateJS::ScopedProfileTimer profileTimer(phase)
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    class PublishProfiler
+    {
+    public:
+
+        // Clears the previous results and starts collecting. Trace events are only
+        // recorded if "recordTrace" is set.
+        static void Start(FCM::Boolean recordTrace);
+
+        // Stops collecting, prints the summary to the output console and writes the
+        // Chrome trace if one was recorded and "traceFilePath" is not empty
+        static void Stop(FCM::PIFCMCallback pCallback, const std::string& traceFilePath);
+
+        static FCM::Boolean IsRunning();
+
+        // Microseconds since Start()
+        static FCM::U_Int64 Now();
+
+        // May be called from any thread
+        static void AddSample(ProfilePhase phase, FCM::U_Int64 startTime, FCM::U_Int64 endTime);
+
+        static void AddBytes(ProfilePhase phase, FCM::U_Int64 bytes);
+
+        static void RecordPeak(ProfileCounter counter, FCM::U_Int64 value);
+
+    private:
+
+        static void TraceSummary(FCM::PIFCMCallback pCallback);
+
+        static FCM::Result WriteTrace(FCM::PIFCMCallback pCallback, const std::string& traceFilePath);
+    };
+
+
+    class ScopedProfileTimer
+    {
+    public:
+
+        ScopedProfileTimer(ProfilePhase phase);
+
+        ~ScopedProfileTimer();
+
+    private:
+
+        ProfilePhase m_phase;
+
+        FCM::U_Int64 m_startTime;
+
+        FCM::Boolean m_running;
+    };
+
+
+    // Runs the profiler for one publish, if "enabled" is set. The profiler is stopped
+    // when the object goes out of scope, whichever way the publish ends.
+    class ScopedPublishProfiler
+    {
+    public:
+
+        ScopedPublishProfiler(FCM::PIFCMCallback pCallback, FCM::Boolean enabled, FCM::Boolean recordTrace);
+
+        ~ScopedPublishProfiler();
+
+        // Stops the profiler now (see PublishProfiler::Stop())
+        void Stop(const std::string& traceFilePath);
+
+    private:
+
+        FCM::PIFCMCallback m_pCallback;
+
+        FCM::Boolean m_started;
+    };
+};
+
+#endif // PUBLISH_PROFILER_H_
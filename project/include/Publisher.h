@@ -19,6 +19,9 @@
 #define PUBLISHER_H_
 
 #include <vector>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
 
 #include "Version.h"
 #include "FCMTypes.h"
@@ -32,8 +35,11 @@
 #include "FillStyle/IBitmapFillStyle.h"
 #include "FrameElement/IClassicText.h"
 #include "FrameElement/ITextStyle.h"
+#include "FrameElement/IShape.h"
+#include "Service/Shape/IShapeService.h"
 #include "Exporter/Service/IFrameCommandGenerator.h"
 #include "OutputWriter.h"
+#include "BitmapScaleTracker.h"
 #include "PluginConfiguration.h"
 
 /* -------------------------------------------------- Forward Decl */
@@ -85,9 +91,67 @@ namespace DOM
 
 #define MAX_RETRY_ATTEMPT               10
 
+#define kPublishSettingsKey_StreamOutput    "PublishSettings.StreamOutput"
+#define kPublishSettingsKey_NumberPrecision "PublishSettings.NumberPrecision"
+#define kPublishSettingsKey_SerialAssetExport "PublishSettings.SerialAssetExport"
+#define kPublishSettingsKey_OutputFormat    "PublishSettings.OutputFormat"
+#define kPublishSettingsKey_CompressTimeline "PublishSettings.CompressTimeline"
+#define kPublishSettingsKey_WriteTweens     "PublishSettings.WriteTweens"
+#define kPublishSettingsKey_MorphShapes     "PublishSettings.MorphShapes"
+#define kPublishSettingsKey_DedupShapes     "PublishSettings.DedupShapes"
+#define kPublishSettingsKey_Profile         "PublishSettings.Profile"
+#define kPublishSettingsKey_ProfileTrace    "PublishSettings.ProfileTrace"
+#define kPublishSettingsKey_SimplifyTolerance "PublishSettings.SimplifyTolerance"
+#define kPublishSettingsKey_CompactPaths    "PublishSettings.CompactPaths"
+#define kPublishSettingsKey_PipelinedOutput "PublishSettings.PipelinedOutput"
+#define kPublishSettingsKey_PrecompressOutput "PublishSettings.PrecompressOutput"
+#define kPublishSettingsKey_PackBitmaps     "PublishSettings.PackBitmaps"
+#define kPublishSettingsKey_ResampleBitmaps "PublishSettings.ResampleBitmaps"
+#define kPublishSettingsKey_ResampleHeadroom "PublishSettings.ResampleHeadroom"
+#define kPublishSettingsKey_BitmapQuality   "PublishSettings.BitmapQuality"
+
+// Bounds are compared in twips when looking for identical shapes
+#define SHAPE_BOUNDS_QUANTUM            20
+
+// Largest deviation from identity for the similarity transform of identical shapes
+#define SHAPE_IDENTITY_TOLERANCE        0.0001
+
 
 /* -------------------------------------------------- Structs / Unions */
 
+namespace CreateJS
+{
+    // A shape with a definition (written, or held until the end of the scene), kept
+    // to find identical shapes
+    struct DEFINED_SHAPE
+    {
+        FCM::AutoPtr<DOM::FrameElement::IShape> pShape;
+
+        FCM::U_Int32 resourceId;
+
+        // Number of shapes aliased to this one
+        FCM::U_Int32 aliasCount;
+    };
+
+    // A shape of a scene after the first, whose definition waits for the end of the scene
+    struct PENDING_SHAPE
+    {
+        FCM::AutoPtr<DOM::FrameElement::IShape> pShape;
+
+        FCM::U_Int64 geometryHash;
+    };
+
+    // Segment counts of a shape whose paths were simplified
+    struct SIMPLIFIED_SHAPE
+    {
+        FCM::U_Int32 resourceId;
+
+        FCM::U_Int32 segmentCount;
+
+        FCM::U_Int32 simplifiedCount;
+    };
+}
+
 
 /* -------------------------------------------------- Class Decl */
 
@@ -127,6 +191,15 @@ namespace CreateJS
             FCM::StringRep8 key, 
             std::string& retString);
 
+        FCM::Boolean ReadBoolean(
+            const FCM::PIFCMDictionary pDict, 
+            FCM::StringRep8 key, 
+            FCM::Boolean defaultValue);
+
+        void ReadOutputSettings(
+            const PIFCMDictionary pDictPublishSettings, 
+            OUTPUT_SETTINGS& settings);
+
         FCM::Result GetOutputFileName(        
             DOM::PIFLADocument pFlaDocument, 
             DOM::PITimeline pITimeline, 
@@ -140,20 +213,38 @@ namespace CreateJS
             const PIFCMDictionary pDictPublishSettings, 
             const PIFCMDictionary pDictConfig);
 
+        // Releases what the resource palette holds of the document once Export() returns
+        void EndExport();
+
         FCM::Boolean IsPreviewNeeded(const PIFCMDictionary pDictConfig);
 
         FCM::Result Init();
 
-        FCM::Result ShowPreview(const std::string& outFile);
+        FCM::Result ShowPreview(const std::string& outFile, OutputFileMap& outputFiles);
 
         FCM::Result ExportLibraryItems(FCM::FCMListPtr pLibraryItemList);
 
         FCM::Result CopyRuntime(const std::string& outputFolder);
 
+        void GetRuntimeFolder(std::string& runtimeFolder);
+
+        // Ends the document and the output
+        FCM::Result FinishOutput(IOutputWriter* pOutputWriter);
+
+        // Writes the main timeline of a document with several scenes. Each scene has
+        // been written as a movie clip; they are played one after the other.
+        FCM::Result ExportSceneTimeline(
+            IOutputWriter* pOutputWriter, 
+            const std::vector<FCM::U_Int32>& sceneResourceIds, 
+            const std::vector<FCM::U_Int32>& sceneFrameCounts);
+
     private:
 
         AutoPtr<IFrameCommandGenerator> m_frameCmdGeneratorService;
         AutoPtr<IResourcePalette> m_pResourcePalette;
+
+        // Callback registered with the ServiceRegistry (NULL until Init)
+        FCM::PIFCMCallback m_pServiceCallback;
     };
 
 
@@ -194,7 +285,10 @@ namespace CreateJS
 
         ~ResourcePalette();
 
-        void Init(IOutputWriter* pOutputWriter);
+        void Init(
+            IOutputWriter* pOutputWriter, 
+            FCM::Boolean dedupShapes, 
+            FCM::Double simplifyTolerance);
 
         void Clear();
 
@@ -202,8 +296,72 @@ namespace CreateJS
             const std::string& name, 
             FCM::Boolean& hasResource);
 
+        // Starts the resources of the next scene. Each scene is exported into an empty
+        // palette, with its own resource ids; these are mapped to ids that are unique in
+        // the document, and resources defined by an earlier scene are not written again.
+        void StartScene();
+
+        // Writes the shapes of a scene after the first. They are held until the end of
+        // the scene, as the shapes placed only by symbols that an earlier scene wrote
+        // are not defined again (see MapLibraryShapes()).
+        void EndScene();
+
+        // Called by a timeline builder the first time it places a shape
+        void AddShapeUser(FCM::U_Int32 resourceId);
+
+        // Returns the id under which a resource of the current scene is written. This
+        // differs if an identical shape or a resource of an earlier scene was defined
+        // first, or if the resource belongs to a scene after the first.
+        FCM::U_Int32 GetResourceId(FCM::U_Int32 resourceId);
+
+        // Returns an id not used by any resource of the document
+        FCM::U_Int32 AllocateResourceId();
+
+        // Traces the number of resources defined once for several scenes
+        void TraceSharedResourceReport();
+
+        // Traces the number of aliased shapes and the bytes their definitions would take
+        void TraceShapeDedupReport();
+
+        // Traces the segments removed by path simplification, in total and for the
+        // shapes that lost the most
+        void TraceSimplifyReport();
+
+        // Placements and bitmap fills of the resources written so far
+        BitmapScaleTracker& GetBitmapScaleTracker();
+
+        // Releases the host objects held for the export (the defined shapes kept
+        // to find identical ones)
+        void EndExport();
+
     private:
 
+        // Maps a symbol, bitmap or sound to the resource with the same library name, if an
+        // earlier scene defined one. Otherwise the name is recorded and false returned.
+        FCM::Boolean FindLibraryResource(FCM::U_Int32 resourceId, const std::string& name);
+
+        // Maps the shapes placed by a symbol that an earlier scene wrote to the shapes
+        // written for it then. The frame command generator sends the shapes of the
+        // symbol again, with the ids of the current scene, before the symbol itself.
+        void MapLibraryShapes(const std::string& name, TimelineBuilder* pTimeline);
+
+        // Writes the definition of a shape under the id it is placed with
+        FCM::Result DefineShape(FCM::U_Int32 resourceId, DOM::FrameElement::PIShape pShape);
+
+        // Moves a shape held for the end of the scene, among the shapes kept to find
+        // identical ones, to the id of its earlier definition. Returns false if other
+        // shapes are already placed using its id.
+        FCM::Boolean RemapDefinedShape(
+            FCM::U_Int32 resourceId, 
+            FCM::U_Int64 geometryHash, 
+            FCM::U_Int32 definedId);
+
+        FCM::U_Int64 GetGeometryHash(DOM::FrameElement::PIShape pShape);
+
+        DEFINED_SHAPE* FindIdenticalShape(
+            DOM::FrameElement::PIShape pShape, 
+            FCM::U_Int64 geometryHash);
+
         FCM::Result ExportFill(DOM::FrameElement::PIShape pIShape);
 
         FCM::Result ExportStroke(DOM::FrameElement::PIShape pIShape);
@@ -244,9 +402,60 @@ namespace CreateJS
 
         IOutputWriter* m_pOutputWriter;
 
-        std::vector<FCM::U_Int32> m_resourceList;
+        // Resources of the current scene. Hashed, as HasResource() is called for every
+        // placed instance.
+        std::unordered_set<FCM::U_Int32> m_resourceIds;
+
+        std::unordered_set<std::string> m_resourceNames;
+
+        FCM::Boolean m_dedupShapes;
+
+        AutoPtr<DOM::Service::Shape::IShapeService> m_pShapeService;
+
+        // Shapes with a definition, by geometry hash
+        std::unordered_multimap<FCM::U_Int64, DEFINED_SHAPE> m_definedShapes;
+
+        // Resource id in the current scene -> resource id written, for the resources
+        // whose ids differ (see GetResourceId())
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_sceneResourceIds;
+
+        // Library name -> resource id written, for the symbols, bitmaps and sounds
+        std::unordered_map<std::string, FCM::U_Int32> m_libraryResourceIds;
+
+        // Library name of a symbol -> resource ids written for the shapes its timeline
+        // places, in the order they are first placed (multi-scene export only)
+        std::unordered_map<std::string, std::vector<FCM::U_Int32> > m_libraryShapeIds;
+
+        // Shapes of the current scene held until EndScene() (scenes after the first)
+        std::map<FCM::U_Int32, PENDING_SHAPE> m_pendingShapes;
+
+        // Number of timelines of the current scene that place each shape, less those
+        // of the symbols that an earlier scene wrote
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_shapeUserCounts;
+
+        FCM::U_Int32 m_sceneCount;
+
+        FCM::U_Int32 m_nextResourceId;
+
+        FCM::U_Int32 m_aliasedShapeCount;
 
-        std::vector<std::string> m_resourceNames;
+        // Resources of a scene that an earlier scene defined
+        FCM::U_Int32 m_sharedResourceCount;
+
+        FCM::Double m_simplifyTolerance;
+
+        // Segments of the path being exported, reused from path to path
+        std::vector<DOM::Utils::SEGMENT> m_segments;
+
+        // Segments of the shape being exported, before and after simplification
+        SIMPLIFIED_SHAPE m_shapeSegments;
+
+        std::vector<SIMPLIFIED_SHAPE> m_simplifiedShapes;
+
+        BitmapScaleTracker m_bitmapScaleTracker;
+
+        // Fills the palette with synthetic resources, without a host
+        friend class ResourcePaletteBenchmark;
     };
 
 
@@ -331,15 +540,39 @@ namespace CreateJS
             FCM::StringRep16 pName,
             ITimelineWriter** ppTimelineWriter);
 
-        void Init(IOutputWriter* pOutputWriter);
+        void Init(IOutputWriter* pOutputWriter, ResourcePalette* pResourcePalette);
+
+        // Resource ids (of the scene) of the shapes placed, in the order they are
+        // first placed
+        const std::vector<FCM::U_Int32>& GetShapeResourceIds();
+
+    private:
+
+        // Records the resource placed as "objectId" and the scale it is drawn at
+        void AddChildScale(
+            FCM::U_Int32 objectId, 
+            FCM::U_Int32 resourceId, 
+            const DOM::Utils::MATRIX2D& matrix);
 
     private:
 
         IOutputWriter* m_pOutputWriter;
 
+        ResourcePalette* m_pResourcePalette;
+
         ITimelineWriter* m_pTimelineWriter;
 
         FCM::U_Int32 m_frameIndex;
+
+        // Object id -> resource id written, for the objects placed so far
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32> m_objectResourceIds;
+
+        // Largest scale of each resource placed on this timeline
+        ResourceScaleMap m_childScales;
+
+        std::vector<FCM::U_Int32> m_shapeResourceIds;
+
+        std::unordered_set<FCM::U_Int32> m_placedShapes;
     };
 
 
@@ -357,11 +590,13 @@ namespace CreateJS
 
         ~TimelineBuilderFactory();
 
-        void Init(IOutputWriter* pOutputWriter);
+        void Init(IOutputWriter* pOutputWriter, ResourcePalette* pResourcePalette);
 
     private:
 
         IOutputWriter* m_pOutputWriter;
+
+        ResourcePalette* m_pResourcePalette;
     };
 
     FCM::Result RegisterPublisher(PIFCMDictionary pPlugins, FCM::FCMCLSID docId);
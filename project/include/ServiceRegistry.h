@@ -0,0 +1,77 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  ServiceRegistry.h
+ *
+ * @brief This file contains declarations for the cache of the core host services
+ *        used by the Utils helpers.
+ */
+
+#ifndef SERVICE_REGISTRY_H_
+#define SERVICE_REGISTRY_H_
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+#include "IFCMStringUtils.h"
+#include "Application/Service/IOutputConsoleService.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Resolves the string, memory and output console services once per callback.
+    // An object that uses the Utils helpers registers its callback for as long as
+    // it lives; lookups for a callback that is not registered go to the host.
+    class ServiceRegistry
+    {
+    public:
+
+        // Registrations are counted; the services are released by the last Unregister()
+        static void Register(FCM::PIFCMCallback pCallback);
+
+        static void Unregister(FCM::PIFCMCallback pCallback);
+
+        static FCM::AutoPtr<FCM::IFCMStringUtils> GetStringUtilsService(FCM::PIFCMCallback pCallback);
+
+        static FCM::AutoPtr<FCM::IFCMCalloc> GetCallocService(FCM::PIFCMCallback pCallback);
+
+        static FCM::AutoPtr<Application::Service::IOutputConsoleService> GetOutputConsoleService(
+            FCM::PIFCMCallback pCallback);
+
+        // Number of lookups served from the registry and sent to the host since the
+        // last ResetStats()
+        static void GetStats(FCM::U_Int64& cachedLookups, FCM::U_Int64& hostLookups);
+
+        static void ResetStats();
+
+    private:
+
+        static FCM::Result LookUp(
+            FCM::PIFCMCallback pCallback,
+            const FCM::SRVCID& serviceId,
+            FCM::AutoPtr<FCM::IFCMUnknown>& pService);
+    };
+};
+
+#endif // SERVICE_REGISTRY_H_
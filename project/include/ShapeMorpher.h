@@ -0,0 +1,147 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  ShapeMorpher.h
+ *
+ * @brief This file contains declarations for finding the shapes that lie between
+ *        two other shapes of the same structure, as the frames of a shape tween do.
+ */
+
+#ifndef SHAPE_MORPHER_H_
+#define SHAPE_MORPHER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "FCMTypes.h"
+#include "Utils/DOMTypes.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Shortest run of shapes (both keys included) written as a morph
+#define MORPH_MIN_SHAPES                3
+
+// Largest distance (in pixels) between a value of a shape and the morph. Animate
+// rounds the points of the shapes of a tween to twips (0.05 pixels).
+#define MORPH_VALUE_TOLERANCE           0.05
+
+// Largest difference between a color channel (0 to 255) of a shape and the morph
+#define MORPH_COLOR_TOLERANCE           1
+
+// Decimal places of the ratio of a morph
+#define MORPH_RATIO_PRECISION           6
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    struct MORPH_SHAPE
+    {
+        FCM::U_Int32 resId;
+
+        // Everything that has to be the same in all the shapes of a morph
+        std::string structure;
+
+        // Points of the paths and stroke widths
+        std::vector<FCM::Double> values;
+
+        // Channels of the fill and stroke colors
+        std::vector<FCM::Double> colors;
+
+        FCM::Boolean morphable;
+    };
+
+    struct SHAPE_MORPH
+    {
+        FCM::U_Int32 fromResId;
+
+        FCM::U_Int32 toResId;
+
+        FCM::Double ratio;
+    };
+
+    // Resource id of a shape between two keys -> its morph
+    typedef std::map<FCM::U_Int32, SHAPE_MORPH> ShapeMorphMap;
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // Records the shapes as they are defined. Once the document is complete, the
+    // shapes of the same structure are walked in the order they were defined: a run
+    // of shapes in which every shape is the first one moved a growing ratio of the
+    // way to the last one is a morph. The keys stay full shapes. Must match the
+    // ResourceManager in runtime/resourcemanager.js.
+    class ShapeMorpher
+    {
+    public:
+
+        ShapeMorpher();
+
+        ~ShapeMorpher();
+
+        void Clear();
+
+        void StartShape();
+
+        // Path types, path commands, stroke caps and joins
+        void AddCommand(char command);
+
+        void AddValue(FCM::Double value);
+
+        void AddColor(const DOM::Utils::COLOR& color);
+
+        // Gradient and bitmap fills are not morphed
+        void SetNotMorphable();
+
+        void EndShape(FCM::U_Int32 resId);
+
+        void GetMorphs(ShapeMorphMap& morphs);
+
+    private:
+
+        // Index (into "shapes") of the last key of the longest morph starting at
+        // "start", or "start" if there is none
+        FCM::U_Int32 FindMorph(
+            const std::vector<FCM::U_Int32>& shapes,
+            FCM::U_Int32 start,
+            std::vector<FCM::Double>& ratios);
+
+        // Least squares ratio of "shape" on the way from "from" to "to", or false
+        // if the shape is not reproduced
+        static FCM::Boolean FitRatio(
+            const MORPH_SHAPE& from,
+            const MORPH_SHAPE& to,
+            const MORPH_SHAPE& shape,
+            FCM::Double& ratio);
+
+    private:
+
+        std::vector<MORPH_SHAPE> m_shapes;
+
+        MORPH_SHAPE m_shape;
+
+        FCM::Boolean m_inShape;
+    };
+};
+
+#endif // SHAPE_MORPHER_H_
@@ -0,0 +1,114 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+/**
+ * @file  TweenFitter.h
+ *
+ * @brief This file contains declarations for finding the runs of matrices of an
+ *        object that follow an eased tween.
+ */
+
+#ifndef TWEEN_FITTER_H_
+#define TWEEN_FITTER_H_
+
+#include "FCMTypes.h"
+#include "Utils/DOMTypes.h"
+
+/* -------------------------------------------------- Forward Decl */
+
+
+/* -------------------------------------------------- Enums */
+
+
+/* -------------------------------------------------- Macros / Constants */
+
+// Shortest run of frames written as a tween
+#define TWEEN_MIN_FRAMES                3
+
+// Largest distance (in pixels) between the translation of a frame and the tween
+#define TWEEN_TRANSLATE_TOLERANCE       0.025
+
+// Largest difference between the scale/skew components of a frame and the tween
+#define TWEEN_SCALE_TOLERANCE           0.0005
+
+
+/* -------------------------------------------------- Structs / Unions */
+
+namespace CreateJS
+{
+    // A matrix as the properties of a DisplayObject (see MoveObjectCommand in
+    // runtime/timelineanimator.js). The skew angles are in radians.
+    struct TWEEN_TRANSFORM
+    {
+        FCM::Double x;
+
+        FCM::Double y;
+
+        FCM::Double scaleX;
+
+        FCM::Double scaleY;
+
+        FCM::Double skewX;
+
+        FCM::Double skewY;
+    };
+}
+
+
+/* -------------------------------------------------- Class Decl */
+
+namespace CreateJS
+{
+    // A tween interpolates the properties of the start and the end matrix with one
+    // eased time, f(t) = t + ease * t * (1 - t), ease being -1 (in) to 1 (out) as the
+    // ease of a classic tween. The skew angles take the shorter way round. Must match
+    // the TimelineDecoder in runtime/timelineanimator.js.
+    class TweenFitter
+    {
+    public:
+
+        static void Decompose(const DOM::Utils::MATRIX2D& matrix, TWEEN_TRANSFORM& transform);
+
+        static void Compose(const TWEEN_TRANSFORM& transform, DOM::Utils::MATRIX2D& matrix);
+
+        // Matrix of the tween at time t (0 to 1)
+        static void Interpolate(
+            const TWEEN_TRANSFORM& start,
+            const TWEEN_TRANSFORM& end,
+            FCM::Double t,
+            FCM::Double ease,
+            DOM::Utils::MATRIX2D& matrix);
+
+        // Returns the length of the longest run of pMatrices (one per frame, following
+        // "start") that a tween reproduces within the tolerances, or 0 if it is shorter
+        // than TWEEN_MIN_FRAMES
+        static FCM::U_Int32 Fit(
+            const DOM::Utils::MATRIX2D& start,
+            const DOM::Utils::MATRIX2D* pMatrices,
+            FCM::U_Int32 count,
+            FCM::Double& ease);
+
+    private:
+
+        // Least squares ease of the first "count" matrices for a tween ending at the
+        // last of them, or false if they are not reproduced
+        static FCM::Boolean FitEase(
+            const TWEEN_TRANSFORM& start,
+            const TWEEN_TRANSFORM* pTransforms,
+            const DOM::Utils::MATRIX2D* pMatrices,
+            FCM::U_Int32 count,
+            FCM::Double& ease);
+
+        static FCM::Double GetAngleDelta(FCM::Double from, FCM::Double to);
+    };
+};
+
+#endif // TWEEN_FITTER_H_
@@ -61,6 +61,13 @@
 #define LOG(x) 
 #endif
 
+// Number of fractional digits used for numbers written to the output
+#define DEFAULT_NUMBER_PRECISION        6
+#define MAX_NUMBER_PRECISION            9
+
+// Large enough for any number produced by Utils::FormatNumber()
+#define NUMBER_BUFFER_SIZE              32
+
 #ifdef USE_HTTP_SERVER
     #ifdef _WINDOWS
         #define CLOSE_SOCKET(sock) closesocket(sock)
@@ -90,15 +97,17 @@ namespace CreateJS
 
         static std::string ToString(const FCM::FCMGUID& in);
 
-        static std::string ToString(const double& in);
+        static std::string ToString(const double& in, FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
 
-        static std::string ToString(const float& in);
+        static std::string ToString(const float& in, FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
 
         static std::string ToString(const FCM::U_Int32& in);
 
         static std::string ToString(const FCM::S_Int32& in);
 
-        static std::string ToString(const DOM::Utils::MATRIX2D& matrix);
+        static std::string ToString(
+            const DOM::Utils::MATRIX2D& matrix, 
+            FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
 
         static std::string ToString(const DOM::Utils::CapType& capType);
 
@@ -114,6 +123,29 @@ namespace CreateJS
 
         static std::string ToString(const DOM::Utils::COLOR& color);
 
+        // Formats a number into pBuffer (at least NUMBER_BUFFER_SIZE long) with at most 
+        // "precision" fractional digits and no trailing zeros. Returns the length written.
+        static FCM::U_Int32 FormatNumber(
+            char* pBuffer, 
+            double in, 
+            FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
+
+        // The Append* functions format straight into the end of "out" and do not 
+        // allocate once "out" has grown to its working size.
+        static void AppendNumber(
+            std::string& out, 
+            double in, 
+            FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
+
+        static void AppendNumber(std::string& out, FCM::U_Int32 in);
+
+        static void AppendMatrix(
+            std::string& out, 
+            const DOM::Utils::MATRIX2D& matrix, 
+            FCM::U_Int32 precision = DEFAULT_NUMBER_PRECISION);
+
+        static void AppendColor(std::string& out, const DOM::Utils::COLOR& color);
+
         static void TransformPoint(
             const DOM::Utils::MATRIX2D& matrix, 
             DOM::Utils::POINT2D& inPoint,
@@ -149,6 +181,8 @@ namespace CreateJS
 
         static FCM::Result Remove(const std::string& folder, FCM::PIFCMCallback pCallback);
 
+        static FCM::Result GetModificationTime(const std::string& path, FCM::U_Int64& time, FCM::PIFCMCallback pCallback);
+
 #ifdef USE_HTTP_SERVER
 
         static void LaunchBrowser(const std::string& outputFileName, int port, FCM::PIFCMCallback pCallback);
@@ -129,7 +129,7 @@
  *  pool.  With this option turned on, the default behavior is still done internally unless
  *  a callback is registered.  So you can have this option on and not use it.
  */
-//#define JSON_MEMORY_CALLBACKS
+#define JSON_MEMORY_CALLBACKS
 
 
 /*
@@ -302,6 +302,11 @@
  */
 //#define JSON_STRING_HEADER "../TestSuite/StringTest.h"
 
+// JSON_MEMORY_CALLBACKS would otherwise give json_string its own allocator type. Keeping it
+// a std::string lets the plugin exchange strings with libjson without copies, while nodes
+// and child arrays still go through the registered callbacks.
+#define JSON_STRING_HEADER "JSONStdString.h"
+
 
 /*
  *  JSON_UNIT_TEST is used to maintain and debug the libjson.  It makes all private
@@ -0,0 +1,13 @@
+#ifndef JSON_STD_STRING_H
+#define JSON_STD_STRING_H
+
+/*
+ *  Used as JSON_STRING_HEADER (see JSONOptions.h). libjson strings stay std::string
+ *  when JSON_MEMORY_CALLBACKS is defined.
+ */
+
+#include <string>
+
+typedef std::string json_string;
+
+#endif
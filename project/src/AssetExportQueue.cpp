@@ -0,0 +1,264 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "AssetExportQueue.h"
+
+#include "ApplicationFCMPublicIDs.h"
+#include "PublishProfiler.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+
+/* -------------------------------------------------- AssetExportQueue */
+
+namespace CreateJS
+{
+    AssetExportQueue::AssetExportQueue(
+        FCM::PIFCMCallback pCallback, 
+        FCM::U_Int32 threadCount, 
+        FCM::U_Int32 bitmapQuality)
+        : m_pCallback(pCallback),
+          m_nextJob(0),
+          m_completedJobs(0),
+          m_maxPendingJobs(0),
+          m_bitmapQuality(bitmapQuality),
+          m_result(FCM_SUCCESS),
+          m_stop(false)
+    {
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+        FCM::Result res;
+
+        // Services are resolved here so that the workers never call into the host for them
+        res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        m_pBitmapExportService = pUnk;
+        pUnk.Reset();
+
+        res = m_pCallback->GetService(DOM::FLA_SOUND_SERVICE, pUnk.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        m_pSoundExportService = pUnk;
+        pUnk.Reset();
+
+        if (threadCount > MAX_ASSET_EXPORT_THREADS)
+        {
+            threadCount = MAX_ASSET_EXPORT_THREADS;
+        }
+
+        m_maxPendingJobs = threadCount * ASSET_EXPORT_JOBS_PER_THREAD;
+
+        for (FCM::U_Int32 i = 0; i < threadCount; i++)
+        {
+            m_workers.push_back(std::thread(&AssetExportQueue::WorkerProc, this));
+        }
+    }
+
+
+    AssetExportQueue::~AssetExportQueue()
+    {
+        Join();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_jobAvailable.notify_all();
+
+        for (size_t i = 0; i < m_workers.size(); i++)
+        {
+            m_workers[i].join();
+        }
+    }
+
+
+    FCM::Result AssetExportQueue::ExportBitmap(
+        DOM::LibraryItem::PIMediaItem pMediaItem,
+        const std::string& filePath)
+    {
+        return Enqueue(BITMAP_ASSET, pMediaItem, filePath);
+    }
+
+
+    FCM::Result AssetExportQueue::ExportSound(
+        DOM::LibraryItem::PIMediaItem pMediaItem,
+        const std::string& filePath)
+    {
+        return Enqueue(SOUND_ASSET, pMediaItem, filePath);
+    }
+
+
+    FCM::Result AssetExportQueue::Join()
+    {
+        FCM::Result res;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (m_completedJobs < m_jobs.size())
+        {
+            m_jobCompleted.wait(lock);
+        }
+
+        if (PublishProfiler::IsRunning())
+        {
+            for (size_t i = 0; i < m_jobs.size(); i++)
+            {
+                ProfileExportedFile(m_jobs[i]);
+            }
+        }
+
+        // Release the media items on the publish thread
+        m_jobs.clear();
+        m_nextJob = 0;
+        m_completedJobs = 0;
+
+        res = m_result;
+        m_result = FCM_SUCCESS;
+
+        return res;
+    }
+
+
+    FCM::Result AssetExportQueue::Enqueue(
+        AssetType type,
+        DOM::LibraryItem::PIMediaItem pMediaItem,
+        const std::string& filePath)
+    {
+        ASSET_EXPORT_JOB job;
+        FCM::StringRep16 pFilePath;
+
+        job.type = type;
+        job.pMediaItem = pMediaItem;
+        job.filePath8 = filePath;
+
+        // Take a private copy of the path so that the host allocation is freed right away
+        pFilePath = Utils::ToString16(filePath, m_pCallback);
+        for (FCM::StringRep16 pChar = pFilePath; *pChar != 0; pChar++)
+        {
+            job.filePath.push_back(*pChar);
+        }
+        job.filePath.push_back(0);
+
+        FCM::AutoPtr<FCM::IFCMCalloc> pCalloc = Utils::GetCallocService(m_pCallback);
+        ASSERT(pCalloc.m_Ptr != NULL);
+        pCalloc->Free(pFilePath);
+
+        if (m_workers.empty())
+        {
+            // Serial mode
+            FCM::Result res = Export(job);
+
+            if (PublishProfiler::IsRunning())
+            {
+                ProfileExportedFile(job);
+            }
+
+            return res;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // Apply backpressure once enough jobs are waiting
+            while ((m_jobs.size() - m_completedJobs) >= m_maxPendingJobs)
+            {
+                m_jobCompleted.wait(lock);
+            }
+
+            m_jobs.push_back(job);
+        }
+        m_jobAvailable.notify_one();
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result AssetExportQueue::Export(ASSET_EXPORT_JOB& job)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        PROFILE_SCOPE((job.type == BITMAP_ASSET) ? PROFILE_PHASE_EXPORT_BITMAP : PROFILE_PHASE_EXPORT_SOUND);
+
+        switch (job.type)
+        {
+            case BITMAP_ASSET:
+                if (m_pBitmapExportService)
+                {
+                    res = m_pBitmapExportService->ExportToFile(
+                        job.pMediaItem,
+                        &job.filePath[0],
+                        m_bitmapQuality);
+                }
+                break;
+
+            case SOUND_ASSET:
+                if (m_pSoundExportService)
+                {
+                    res = m_pSoundExportService->ExportToFile(job.pMediaItem, &job.filePath[0]);
+                }
+                break;
+        }
+
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return res;
+    }
+
+
+    void AssetExportQueue::ProfileExportedFile(const ASSET_EXPORT_JOB& job)
+    {
+        std::fstream file;
+
+        Utils::OpenFStream(job.filePath8, file, std::ios_base::in|std::ios_base::binary|std::ios_base::ate, m_pCallback);
+        if (file.is_open())
+        {
+            PublishProfiler::AddBytes(
+                (job.type == BITMAP_ASSET) ? PROFILE_PHASE_EXPORT_BITMAP : PROFILE_PHASE_EXPORT_SOUND,
+                (FCM::U_Int64)file.tellg());
+            file.close();
+        }
+    }
+
+
+    void AssetExportQueue::WorkerProc()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            while (!m_stop && (m_nextJob >= m_jobs.size()))
+            {
+                m_jobAvailable.wait(lock);
+            }
+
+            if (m_nextJob >= m_jobs.size())
+            {
+                // Stopped and nothing left to do
+                break;
+            }
+
+            ASSET_EXPORT_JOB& job = m_jobs[m_nextJob++];
+
+            lock.unlock();
+            FCM::Result res = Export(job);
+            lock.lock();
+
+            if (FCM_FAILURE_CODE(res) && FCM_SUCCESS_CODE(m_result))
+            {
+                m_result = res;
+            }
+
+            m_completedJobs++;
+            m_jobCompleted.notify_all();
+        }
+    }
+};
@@ -0,0 +1,196 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "AssetStore.h"
+
+#include <fstream>
+#include <string.h>
+
+#include "PublishProfiler.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+
+/* -------------------------------------------------- AssetStore */
+
+namespace CreateJS
+{
+    AssetStore::AssetStore(FCM::PIFCMCallback pCallback) :
+        m_pCallback(pCallback)
+    {
+    }
+
+
+    AssetStore::~AssetStore()
+    {
+    }
+
+
+    void AssetStore::Add(
+        AssetType type,
+        const std::string& libPathName,
+        const std::string& fileName,
+        const std::string& filePath,
+        const std::string& relPath)
+    {
+        ASSET_STORE_FILE file;
+
+        file.type = type;
+        file.libPathName = libPathName;
+        file.fileName = fileName;
+        file.filePath = filePath;
+        file.relPath = relPath;
+
+        m_files.push_back(file);
+    }
+
+
+    FCM::Result AssetStore::Deduplicate(AssetAliasMap& aliases)
+    {
+        // Files kept so far by hash of their content
+        std::multimap<FCM::U_Int64, FCM::U_Int32> kept;
+        std::vector<FCM::U_Int64> sizes(m_files.size(), 0);
+        FCM::U_Int64 removedBytes = 0;
+        FCM::U_Int32 removedCount = 0;
+
+        aliases.clear();
+
+        for (FCM::U_Int32 i = 0; i < m_files.size(); i++)
+        {
+            const ASSET_STORE_FILE& file = m_files[i];
+            FCM::U_Int64 hash;
+            FCM::S_Int32 original = -1;
+
+            if (!GetContentHash(file.filePath, sizes[i], hash))
+            {
+                continue;
+            }
+
+            typedef std::multimap<FCM::U_Int64, FCM::U_Int32>::const_iterator Iterator;
+            std::pair<Iterator, Iterator> range = kept.equal_range(hash);
+
+            for (Iterator it = range.first; it != range.second; ++it)
+            {
+                const ASSET_STORE_FILE& candidate = m_files[it->second];
+
+                // A matching hash is not taken as proof that the files are the same
+                if ((candidate.type == file.type) && (sizes[it->second] == sizes[i]) &&
+                    IsContentEqual(candidate.filePath, file.filePath))
+                {
+                    original = (FCM::S_Int32)it->second;
+                    break;
+                }
+            }
+
+            if (original < 0)
+            {
+                kept.insert(std::make_pair(hash, i));
+                continue;
+            }
+
+            const ASSET_STORE_FILE& originalFile = m_files[original];
+
+            aliases[file.relPath] = originalFile.relPath;
+
+            Utils::Remove(file.filePath, m_pCallback);
+
+            removedBytes += sizes[i];
+            removedCount++;
+
+            LOG(("[DeduplicateAssets] %s (%s) is the same as %s (%s)\n", 
+                file.fileName.c_str(), file.libPathName.c_str(), 
+                originalFile.fileName.c_str(), originalFile.libPathName.c_str()));
+        }
+
+        if (removedCount > 0)
+        {
+            Utils::Trace(m_pCallback, "%u duplicate bitmaps/sounds (%llu bytes) were removed from the output\n",
+                removedCount, removedBytes);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    // FNV-1a over the content of the file
+    FCM::Boolean AssetStore::GetContentHash(const std::string& filePath, FCM::U_Int64& size, FCM::U_Int64& hash)
+    {
+        std::fstream file;
+        std::vector<char> block(ASSET_STORE_READ_BLOCK_SIZE);
+
+        size = 0;
+        hash = 14695981039346656037ULL;
+
+        Utils::OpenFStream(filePath, file, std::ios_base::in|std::ios_base::binary, m_pCallback);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        while (file)
+        {
+            file.read(&block[0], block.size());
+
+            std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; i++)
+            {
+                hash ^= (FCM::U_Int8)block[i];
+                hash *= 1099511628211ULL;
+            }
+
+            size += (FCM::U_Int64)count;
+        }
+
+        file.close();
+
+        PublishProfiler::AddBytes(PROFILE_PHASE_DEDUPLICATE_ASSETS, size);
+
+        return true;
+    }
+
+
+    FCM::Boolean AssetStore::IsContentEqual(const std::string& filePath1, const std::string& filePath2)
+    {
+        std::fstream file1;
+        std::fstream file2;
+        std::vector<char> block1(ASSET_STORE_READ_BLOCK_SIZE);
+        std::vector<char> block2(ASSET_STORE_READ_BLOCK_SIZE);
+        FCM::Boolean equal = true;
+
+        Utils::OpenFStream(filePath1, file1, std::ios_base::in|std::ios_base::binary, m_pCallback);
+        Utils::OpenFStream(filePath2, file2, std::ios_base::in|std::ios_base::binary, m_pCallback);
+        if (!file1.is_open() || !file2.is_open())
+        {
+            return false;
+        }
+
+        while (equal && file1 && file2)
+        {
+            file1.read(&block1[0], block1.size());
+            file2.read(&block2[0], block2.size());
+
+            equal = (file1.gcount() == file2.gcount()) &&
+                (memcmp(&block1[0], &block2[0], (size_t)file1.gcount()) == 0);
+        }
+
+        // Both files have to end at the same point
+        equal = equal && !file1 && !file2;
+
+        file1.close();
+        file2.close();
+
+        return equal;
+    }
+};
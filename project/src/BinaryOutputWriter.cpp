@@ -0,0 +1,1094 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "BinaryOutputWriter.h"
+
+#include <cstring>
+#include <math.h>
+#include "FCMPluginInterface.h"
+#include "Utils.h"
+#include "PublishProfiler.h"
+#include "BitmapAtlas.h"
+#include "FrameElement/ISound.h"
+
+/* -------------------------------------------------- Constants */
+
+namespace CreateJS
+{
+    static const FCM::Float GRADIENT_VECTOR_CONSTANT = 16384.0;
+}
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    // The codes below are part of the file format (see binaryloader.js)
+
+    static FCM::U_Int32 GetCapCode(DOM::Utils::CapType capType)
+    {
+        switch (capType)
+        {
+            case DOM::Utils::ROUND_CAP:
+                return 1;
+
+            case DOM::Utils::SQUARE_CAP:
+                return 2;
+
+            default:
+                return 0;
+        }
+    }
+
+
+    static FCM::U_Int32 GetJoinCode(DOM::Utils::JoinType joinType)
+    {
+        switch (joinType)
+        {
+            case DOM::Utils::ROUND_JOIN:
+                return 1;
+
+            case DOM::Utils::BEVEL_JOIN:
+                return 2;
+
+            default:
+                return 0;
+        }
+    }
+
+
+    static FCM::U_Int32 GetSpreadCode(DOM::FillStyle::GradientSpread spread)
+    {
+        switch (spread)
+        {
+            case DOM::FillStyle::GRADIENT_SPREAD_EXTEND:
+                return 0;
+
+            case DOM::FillStyle::GRADIENT_SPREAD_REFLECT:
+                return 1;
+
+            case DOM::FillStyle::GRADIENT_SPREAD_REPEAT:
+                return 2;
+
+            default:
+                return 3;
+        }
+    }
+}
+
+
+/* -------------------------------------------------- BinaryBuffer */
+
+namespace CreateJS
+{
+    void BinaryBuffer::WriteU32(FCM::U_Int32 value)
+    {
+        char bytes[4];
+
+        bytes[0] = (char)(value & 0xFF);
+        bytes[1] = (char)((value >> 8) & 0xFF);
+        bytes[2] = (char)((value >> 16) & 0xFF);
+        bytes[3] = (char)((value >> 24) & 0xFF);
+
+        m_data.append(bytes, 4);
+    }
+
+
+    void BinaryBuffer::WriteF32(FCM::Float value)
+    {
+        FCM::U_Int32 bits;
+
+        memcpy(&bits, &value, sizeof(bits));
+        WriteU32(bits);
+    }
+
+
+    void BinaryBuffer::WriteMatrix(const DOM::Utils::MATRIX2D& matrix)
+    {
+        WriteF32((FCM::Float)matrix.a);
+        WriteF32((FCM::Float)matrix.b);
+        WriteF32((FCM::Float)matrix.c);
+        WriteF32((FCM::Float)matrix.d);
+        WriteF32((FCM::Float)matrix.tx);
+        WriteF32((FCM::Float)matrix.ty);
+    }
+
+
+    void BinaryBuffer::WriteColor(const DOM::Utils::COLOR& color)
+    {
+        WriteU32((color.red << 24) | (color.green << 16) | (color.blue << 8) | color.alpha);
+    }
+
+
+    void BinaryBuffer::WriteString(const std::string& str)
+    {
+        WriteU32((FCM::U_Int32)str.size());
+        m_data.append(str);
+        Align();
+    }
+
+
+    void BinaryBuffer::WriteBytes(const void* pData, FCM::U_Int32 size)
+    {
+        m_data.append((const char*)pData, size);
+    }
+
+
+    void BinaryBuffer::WriteBuffer(const BinaryBuffer& buffer)
+    {
+        m_data.append(buffer.m_data);
+    }
+
+
+    void BinaryBuffer::Align()
+    {
+        while (m_data.size() & 3)
+        {
+            m_data.push_back('\0');
+        }
+    }
+
+
+    void BinaryBuffer::Clear()
+    {
+        m_data.clear();
+    }
+
+
+    FCM::U_Int32 BinaryBuffer::GetSize() const
+    {
+        return (FCM::U_Int32)m_data.size();
+    }
+
+
+    const char* BinaryBuffer::GetData() const
+    {
+        return m_data.data();
+    }
+
+
+    /* -------------------------------------------------- BinaryOutputWriter */
+
+    FCM::Result BinaryOutputWriter::StartDocument(
+        const DOM::Utils::COLOR& background,
+        FCM::U_Int32 stageHeight,
+        FCM::U_Int32 stageWidth,
+        FCM::U_Int32 fps)
+    {
+        FCM::Result res;
+        BinaryBuffer header;
+
+        res = CreateHTMLOutput(background, stageHeight, stageWidth, fps);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return res;
+        }
+
+        // Resources are written as soon as they are defined
+        Utils::OpenFStream(
+            m_outputDataFilePath,
+            m_file,
+            std::ios_base::trunc|std::ios_base::out|std::ios_base::binary,
+            m_pCallback);
+        if (!m_file.is_open())
+        {
+            Utils::Trace(m_pCallback, "Output file (%s) could not be opened\n", m_outputDataFilePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        header.WriteBytes(BINARY_FILE_MAGIC, 4);
+        header.WriteU32(BINARY_FILE_VERSION);
+
+        m_file.write(header.GetData(), header.GetSize());
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryOutputWriter::EndDocument()
+    {
+        FCM::Result res;
+
+        res = FinishAssetExport();
+
+        if (!m_assetAliases.empty())
+        {
+            std::map<std::string, std::string>::const_iterator it;
+
+            m_chunkBuffer.Clear();
+            m_chunkBuffer.WriteU32((FCM::U_Int32)m_assetAliases.size());
+            for (it = m_assetAliases.begin(); it != m_assetAliases.end(); ++it)
+            {
+                m_chunkBuffer.WriteString(it->first);
+                m_chunkBuffer.WriteString(it->second);
+            }
+
+            WriteChunk(BINARY_CHUNK_ALIASES, m_chunkBuffer);
+        }
+
+        if (!m_resampledBitmaps.empty())
+        {
+            std::map<std::string, RESAMPLED_SIZE>::const_iterator it;
+
+            m_chunkBuffer.Clear();
+            m_chunkBuffer.WriteU32((FCM::U_Int32)m_resampledBitmaps.size());
+            for (it = m_resampledBitmaps.begin(); it != m_resampledBitmaps.end(); ++it)
+            {
+                m_chunkBuffer.WriteString(it->first);
+                m_chunkBuffer.WriteU32(it->second.width);
+                m_chunkBuffer.WriteU32(it->second.height);
+            }
+
+            WriteChunk(BINARY_CHUNK_RESAMPLED, m_chunkBuffer);
+        }
+
+        m_file.flush();
+        if (m_file.fail())
+        {
+            Utils::Trace(m_pCallback, "Output file (%s) could not be written\n", m_outputDataFilePath.c_str());
+            res = FCM_GENERAL_ERROR;
+        }
+        else
+        {
+            PublishProfiler::AddBytes(PROFILE_PHASE_SERIALIZE, (FCM::U_Int64)m_file.tellp());
+        }
+        m_file.close();
+
+        WriteHTMLOutput();
+
+        return res;
+    }
+
+
+    ITimelineWriter* BinaryOutputWriter::CreateTimelineWriter()
+    {
+        return AddTimelineWriter(new BinaryTimelineWriter(m_pCallback));
+    }
+
+
+    FCM::Result BinaryOutputWriter::StartDefineTimeline()
+    {
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryOutputWriter::EndDefineTimeline(
+        FCM::U_Int32 resId,
+        FCM::StringRep16 pName,
+        ITimelineWriter* pTimelineWriter)
+    {
+        BinaryTimelineWriter* pWriter = static_cast<BinaryTimelineWriter*> (pTimelineWriter);
+
+        m_chunkBuffer.Clear();
+        pWriter->Finish(resId, m_chunkBuffer);
+
+        return WriteChunk(BINARY_CHUNK_TIMELINE, m_chunkBuffer);
+    }
+
+
+    FCM::Result BinaryOutputWriter::StartDefineShape()
+    {
+        m_shapeBuffer.Clear();
+        m_pathCount = 0;
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Marks the end of a shape
+    FCM::Result BinaryOutputWriter::EndDefineShape(FCM::U_Int32 resId)
+    {
+        m_chunkBuffer.Clear();
+        m_chunkBuffer.WriteU32(resId);
+        m_chunkBuffer.WriteU32(m_pathCount);
+        m_chunkBuffer.WriteBuffer(m_shapeBuffer);
+
+        m_shapeSizes[resId] = m_chunkBuffer.GetSize() + 8;
+
+        return WriteChunk(BINARY_CHUNK_SHAPE, m_chunkBuffer);
+    }
+
+
+    FCM::U_Int32 BinaryOutputWriter::GetShapeSize(FCM::U_Int32 resId)
+    {
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32>::iterator it = m_shapeSizes.find(resId);
+
+        return (it != m_shapeSizes.end()) ? it->second : 0;
+    }
+
+
+    // Start of fill region definition
+    FCM::Result BinaryOutputWriter::StartDefineFill()
+    {
+        m_styleBuffer.Clear();
+        m_pathCmds.clear();
+        m_pathCoords.clear();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Solid fill style definition
+    FCM::Result BinaryOutputWriter::DefineSolidFillStyle(const DOM::Utils::COLOR& color)
+    {
+        m_styleBuffer.WriteU32(BINARY_FILL_SOLID);
+        m_styleBuffer.WriteColor(color);
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Bitmap fill style definition
+    FCM::Result BinaryOutputWriter::DefineBitmapFillStyle(
+        FCM::Boolean clipped,
+        const DOM::Utils::MATRIX2D& matrix,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        FCM::Result res;
+        std::string bitmapRelPath;
+        FCM::Boolean packed;
+        ATLAS_REGION region;
+
+        res = ExportBitmap(libPathName, pMediaItem, height, width, bitmapRelPath, packed, region);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return res;
+        }
+
+        DOM::Utils::MATRIX2D matrix1 = matrix;
+        matrix1.a /= 20.0;
+        matrix1.b /= 20.0;
+        matrix1.c /= 20.0;
+        matrix1.d /= 20.0;
+
+        m_styleBuffer.WriteU32(packed ? BINARY_FILL_ATLAS_BITMAP : BINARY_FILL_BITMAP);
+        m_styleBuffer.WriteU32((FCM::U_Int32)height);
+        m_styleBuffer.WriteU32((FCM::U_Int32)width);
+        m_styleBuffer.WriteString(bitmapRelPath);
+        m_styleBuffer.WriteMatrix(matrix1);
+
+        if (packed)
+        {
+            m_styleBuffer.WriteU32(region.x);
+            m_styleBuffer.WriteU32(region.y);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Start Linear Gradient fill style definition
+    FCM::Result BinaryOutputWriter::StartDefineLinearGradientFillStyle(
+        DOM::FillStyle::GradientSpread spread,
+        const DOM::Utils::MATRIX2D& matrix)
+    {
+        DOM::Utils::POINT2D point;
+
+        m_styleBuffer.WriteU32(BINARY_FILL_LINEAR_GRADIENT);
+
+        point.x = -GRADIENT_VECTOR_CONSTANT / 20;
+        point.y = 0;
+        Utils::TransformPoint(matrix, point, point);
+
+        m_styleBuffer.WriteF32(point.x);
+        m_styleBuffer.WriteF32(point.y);
+
+        point.x = GRADIENT_VECTOR_CONSTANT / 20;
+        point.y = 0;
+        Utils::TransformPoint(matrix, point, point);
+
+        m_styleBuffer.WriteF32(point.x);
+        m_styleBuffer.WriteF32(point.y);
+
+        m_styleBuffer.WriteU32(GetSpreadCode(spread));
+
+        m_stopBuffer.Clear();
+        m_stopCount = 0;
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Sets a specific key point in a color ramp (for both radial and linear gradient)
+    FCM::Result BinaryOutputWriter::SetKeyColorPoint(
+        const DOM::Utils::GRADIENT_COLOR_POINT& colorPoint)
+    {
+        // Offset is in the range [0, 100] as in the JSON output
+        m_stopBuffer.WriteF32((FCM::Float)((colorPoint.pos * 100) / 255.0));
+        m_stopBuffer.WriteColor(colorPoint.color);
+        m_stopCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End Linear Gradient fill style definition
+    FCM::Result BinaryOutputWriter::EndDefineLinearGradientFillStyle()
+    {
+        EndGradientFillStyle();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Start Radial Gradient fill style definition
+    FCM::Result BinaryOutputWriter::StartDefineRadialGradientFillStyle(
+        DOM::FillStyle::GradientSpread spread,
+        const DOM::Utils::MATRIX2D& matrix,
+        FCM::S_Int32 focalPoint)
+    {
+        DOM::Utils::POINT2D point;
+        DOM::Utils::POINT2D point1;
+        DOM::Utils::POINT2D point2;
+
+        m_styleBuffer.WriteU32(BINARY_FILL_RADIAL_GRADIENT);
+
+        point.x = 0;
+        point.y = 0;
+        Utils::TransformPoint(matrix, point, point1);
+
+        point.x = GRADIENT_VECTOR_CONSTANT / 20;
+        point.y = 0;
+        Utils::TransformPoint(matrix, point, point2);
+
+        FCM::Float xd = point1.x - point2.x;
+        FCM::Float yd = point1.y - point2.y;
+        FCM::Float r = sqrt(xd * xd + yd * yd);
+
+        FCM::Float angle = atan2(yd, xd);
+        double focusPointRatio = focalPoint / 255.0;
+        double fx = -r * focusPointRatio * cos(angle);
+        double fy = -r * focusPointRatio * sin(angle);
+
+        // cx, cy are always 0
+        m_styleBuffer.WriteF32(r);
+        m_styleBuffer.WriteF32((FCM::Float)fx);
+        m_styleBuffer.WriteF32((FCM::Float)fy);
+
+        FCM::Float scaleFactor = (GRADIENT_VECTOR_CONSTANT / 20) / r;
+        DOM::Utils::MATRIX2D matrix1 = {};
+        matrix1.a = matrix.a * scaleFactor;
+        matrix1.b = matrix.b * scaleFactor;
+        matrix1.c = matrix.c * scaleFactor;
+        matrix1.d = matrix.d * scaleFactor;
+        matrix1.tx = matrix.tx;
+        matrix1.ty = matrix.ty;
+
+        m_styleBuffer.WriteMatrix(matrix1);
+        m_styleBuffer.WriteU32(GetSpreadCode(spread));
+
+        m_stopBuffer.Clear();
+        m_stopCount = 0;
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End Radial Gradient fill style definition
+    FCM::Result BinaryOutputWriter::EndDefineRadialGradientFillStyle()
+    {
+        EndGradientFillStyle();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Start of fill region boundary
+    FCM::Result BinaryOutputWriter::StartDefineBoundary()
+    {
+        StartDefinePath();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Sets a segment of a path (Used for boundary, holes)
+    FCM::Result BinaryOutputWriter::SetSegment(const DOM::Utils::SEGMENT& segment)
+    {
+        if (m_firstSegment)
+        {
+            if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
+            {
+                AppendPoint(segment.line.endPoint1);
+            }
+            else
+            {
+                AppendPoint(segment.quadBezierCurve.anchor1);
+            }
+            m_firstSegment = false;
+        }
+
+        if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
+        {
+            m_pathCmds.push_back(BINARY_PATH_LINE_TO);
+            AppendPoint(segment.line.endPoint2);
+        }
+        else
+        {
+            m_pathCmds.push_back(BINARY_PATH_QUAD_CURVE_TO);
+            AppendPoint(segment.quadBezierCurve.control);
+            AppendPoint(segment.quadBezierCurve.anchor2);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End of fill region boundary
+    FCM::Result BinaryOutputWriter::EndDefineBoundary()
+    {
+        return FCM_SUCCESS;
+    }
+
+
+    // Start of fill region hole
+    FCM::Result BinaryOutputWriter::StartDefineHole()
+    {
+        StartDefinePath();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End of fill region hole
+    FCM::Result BinaryOutputWriter::EndDefineHole()
+    {
+        return FCM_SUCCESS;
+    }
+
+
+    // Start of stroke group
+    FCM::Result BinaryOutputWriter::StartDefineStrokeGroup()
+    {
+        // No need to do anything
+        return FCM_SUCCESS;
+    }
+
+
+    // Start solid stroke style definition
+    FCM::Result BinaryOutputWriter::StartDefineSolidStrokeStyle(
+        FCM::Double thickness,
+        const DOM::StrokeStyle::JOIN_STYLE& joinStyle,
+        const DOM::StrokeStyle::CAP_STYLE& capStyle,
+        DOM::Utils::ScaleType scaleType,
+        FCM::Boolean strokeHinting)
+    {
+        m_strokeStyle.type = SOLID_STROKE_STYLE_TYPE;
+        m_strokeStyle.solidStrokeStyle.capStyle = capStyle;
+        m_strokeStyle.solidStrokeStyle.joinStyle = joinStyle;
+        m_strokeStyle.solidStrokeStyle.thickness = thickness;
+        m_strokeStyle.solidStrokeStyle.scaleType = scaleType;
+        m_strokeStyle.solidStrokeStyle.strokeHinting = strokeHinting;
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End of solid stroke style
+    FCM::Result BinaryOutputWriter::EndDefineSolidStrokeStyle()
+    {
+        // No need to do anything
+        return FCM_SUCCESS;
+    }
+
+
+    // Start of stroke
+    FCM::Result BinaryOutputWriter::StartDefineStroke()
+    {
+        m_styleBuffer.Clear();
+        m_pathCmds.clear();
+        m_pathCoords.clear();
+        StartDefinePath();
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End of a stroke
+    FCM::Result BinaryOutputWriter::EndDefineStroke()
+    {
+        if (m_strokeStyle.type == SOLID_STROKE_STYLE_TYPE)
+        {
+            EndPath(BINARY_PATH_STROKE);
+        }
+        else
+        {
+            EndPath(BINARY_PATH_UNSTYLED_STROKE);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    // End of stroke group
+    FCM::Result BinaryOutputWriter::EndDefineStrokeGroup()
+    {
+        // No need to do anything
+        return FCM_SUCCESS;
+    }
+
+
+    // End of fill style definition
+    FCM::Result BinaryOutputWriter::EndDefineFill()
+    {
+        EndPath(BINARY_PATH_FILL);
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Define a bitmap
+    FCM::Result BinaryOutputWriter::DefineBitmap(
+        FCM::U_Int32 resId,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        FCM::Result res;
+        std::string bitmapRelPath;
+        FCM::Boolean packed;
+        ATLAS_REGION region;
+
+        res = ExportBitmap(libPathName, pMediaItem, height, width, bitmapRelPath, packed, region);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return res;
+        }
+
+        m_chunkBuffer.Clear();
+        m_chunkBuffer.WriteU32(resId);
+        m_chunkBuffer.WriteU32((FCM::U_Int32)height);
+        m_chunkBuffer.WriteU32((FCM::U_Int32)width);
+        m_chunkBuffer.WriteString(bitmapRelPath);
+
+        // Position on the atlas page, if the bitmap was packed
+        if (packed)
+        {
+            m_chunkBuffer.WriteU32(region.x);
+            m_chunkBuffer.WriteU32(region.y);
+        }
+
+        return WriteChunk(BINARY_CHUNK_BITMAP, m_chunkBuffer);
+    }
+
+
+    FCM::Result BinaryOutputWriter::DefineText(
+        FCM::U_Int32 resId,
+        const std::string& name,
+        const DOM::Utils::COLOR& color,
+        const std::string& displayText,
+        DOM::FrameElement::PIClassicText pTextItem)
+    {
+        // The text is stored as is. Unlike JSON, "\r" does not need to be escaped.
+        m_chunkBuffer.Clear();
+        m_chunkBuffer.WriteU32(resId);
+        m_chunkBuffer.WriteString(displayText);
+        m_chunkBuffer.WriteString(name);
+        m_chunkBuffer.WriteColor(color);
+
+        return WriteChunk(BINARY_CHUNK_TEXT, m_chunkBuffer);
+    }
+
+
+    FCM::Result BinaryOutputWriter::DefineSound(
+        FCM::U_Int32 resId,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        FCM::Result res;
+        std::string soundRelPath;
+
+        res = ExportSound(libPathName, pMediaItem, soundRelPath);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return res;
+        }
+
+        m_chunkBuffer.Clear();
+        m_chunkBuffer.WriteU32(resId);
+        m_chunkBuffer.WriteString(soundRelPath);
+
+        return WriteChunk(BINARY_CHUNK_SOUND, m_chunkBuffer);
+    }
+
+
+    BinaryOutputWriter::BinaryOutputWriter(FCM::PIFCMCallback pCallback, const OUTPUT_SETTINGS& settings)
+        : BaseOutputWriter(pCallback, settings, ".bin"),
+          m_pathCount(0),
+          m_stopCount(0),
+          m_firstSegment(false)
+    {
+        m_strokeStyle.type = INVALID_STROKE_STYLE_TYPE;
+    }
+
+
+    BinaryOutputWriter::~BinaryOutputWriter()
+    {
+        if (m_file.is_open())
+        {
+            // Publish did not reach EndDocument()
+            m_file.close();
+        }
+    }
+
+
+    void BinaryOutputWriter::StartDefinePath()
+    {
+        m_pathCmds.push_back(BINARY_PATH_MOVE_TO);
+        m_firstSegment = true;
+    }
+
+
+    void BinaryOutputWriter::AppendPoint(const DOM::Utils::POINT2D& point)
+    {
+        m_pathCoords.push_back(point.x);
+        m_pathCoords.push_back(point.y);
+    }
+
+
+    void BinaryOutputWriter::EndPath(BinaryPathType pathType)
+    {
+        m_shapeBuffer.WriteU32(pathType);
+
+        if (m_styleBuffer.GetSize() == 0)
+        {
+            m_shapeBuffer.WriteU32(BINARY_FILL_NONE);
+        }
+        else
+        {
+            m_shapeBuffer.WriteBuffer(m_styleBuffer);
+        }
+
+        if (pathType == BINARY_PATH_STROKE)
+        {
+            const SOLID_STROKE_STYLE& strokeStyle = m_strokeStyle.solidStrokeStyle;
+
+            m_shapeBuffer.WriteF32((FCM::Float)strokeStyle.thickness);
+            m_shapeBuffer.WriteU32(GetCapCode(strokeStyle.capStyle.type));
+            m_shapeBuffer.WriteU32(GetJoinCode(strokeStyle.joinStyle.type));
+
+            if (strokeStyle.joinStyle.type == DOM::Utils::MITER_JOIN)
+            {
+                m_shapeBuffer.WriteF32((FCM::Float)strokeStyle.joinStyle.miterJoinProp.miterLimit);
+            }
+            else
+            {
+                m_shapeBuffer.WriteF32(0);
+            }
+        }
+
+        m_shapeBuffer.WriteU32((FCM::U_Int32)m_pathCmds.size());
+        if (!m_pathCmds.empty())
+        {
+            m_shapeBuffer.WriteBytes(&m_pathCmds[0], (FCM::U_Int32)m_pathCmds.size());
+            m_shapeBuffer.Align();
+        }
+
+        m_shapeBuffer.WriteU32((FCM::U_Int32)m_pathCoords.size());
+        for (size_t i = 0; i < m_pathCoords.size(); i++)
+        {
+            m_shapeBuffer.WriteF32(m_pathCoords[i]);
+        }
+
+        m_styleBuffer.Clear();
+        m_pathCmds.clear();
+        m_pathCoords.clear();
+        m_pathCount++;
+    }
+
+
+    void BinaryOutputWriter::EndGradientFillStyle()
+    {
+        m_styleBuffer.WriteU32(m_stopCount);
+        m_styleBuffer.WriteBuffer(m_stopBuffer);
+
+        m_stopBuffer.Clear();
+        m_stopCount = 0;
+    }
+
+
+    FCM::Result BinaryOutputWriter::WriteChunk(const char* pTag, const BinaryBuffer& payload)
+    {
+        BinaryBuffer chunkHeader;
+
+        ASSERT((payload.GetSize() & 3) == 0);
+
+        chunkHeader.WriteBytes(pTag, 4);
+        chunkHeader.WriteU32(payload.GetSize());
+
+        m_file.write(chunkHeader.GetData(), chunkHeader.GetSize());
+        m_file.write(payload.GetData(), payload.GetSize());
+
+        return FCM_SUCCESS;
+    }
+
+
+    /* -------------------------------------------------- BinaryTimelineWriter */
+
+    FCM::Result BinaryTimelineWriter::PlaceObject(
+        FCM::U_Int32 resId,
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 placeAfterObjectId,
+        const DOM::Utils::MATRIX2D* pMatrix,
+        FCM::PIFCMUnknown pUnknown /* = NULL*/)
+    {
+        FCM::U_Int32 flags = BINARY_PLACE_HAS_PLACE_AFTER;
+
+        if (pMatrix)
+        {
+            flags |= BINARY_PLACE_HAS_MATRIX;
+        }
+
+        m_commands.WriteU32(BINARY_CMD_PLACE);
+        m_commands.WriteU32(flags);
+        m_commands.WriteU32(resId);
+        m_commands.WriteU32(objectId);
+        m_commands.WriteU32(placeAfterObjectId);
+
+        if (pMatrix)
+        {
+            m_commands.WriteMatrix(*pMatrix);
+        }
+
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::PlaceObject(
+        FCM::U_Int32 resId,
+        FCM::U_Int32 objectId,
+        FCM::PIFCMUnknown pUnknown /* = NULL*/)
+    {
+        FCM::Result res = FCM_SUCCESS;
+        FCM::AutoPtr<DOM::FrameElement::ISound> pSound;
+
+        pSound = pUnknown;
+
+        m_commands.WriteU32(BINARY_CMD_PLACE);
+        m_commands.WriteU32(pSound ? BINARY_PLACE_HAS_SOUND : 0);
+        m_commands.WriteU32(resId);
+        m_commands.WriteU32(objectId);
+
+        if (pSound)
+        {
+            DOM::FrameElement::SOUND_LOOP_MODE lMode;
+            DOM::FrameElement::SOUND_LIMIT soundLimit;
+            DOM::FrameElement::SoundSyncMode syncMode;
+
+            soundLimit.structSize = sizeof(DOM::FrameElement::SOUND_LIMIT);
+            lMode.structSize = sizeof(DOM::FrameElement::SOUND_LOOP_MODE);
+
+            res = pSound->GetLoopMode(lMode);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = pSound->GetSyncMode(syncMode);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            // We should not get SOUND_SYNC_STOP as for stop, "RemoveObject" command will
+            // be generated by Exporter Service.
+            ASSERT(syncMode != DOM::FrameElement::SOUND_SYNC_STOP);
+
+            res = pSound->GetSoundLimit(soundLimit);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            m_commands.WriteU32(lMode.loopMode);
+            m_commands.WriteU32(lMode.repeatCount);
+            m_commands.WriteU32(syncMode);
+            m_commands.WriteU32(soundLimit.inPos44);
+            m_commands.WriteU32(soundLimit.outPos44);
+        }
+
+        m_commandCount++;
+
+        return res;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::RemoveObject(
+        FCM::U_Int32 objectId)
+    {
+        m_commands.WriteU32(BINARY_CMD_REMOVE);
+        m_commands.WriteU32(objectId);
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateZOrder(
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 placeAfterObjectId)
+    {
+        m_commands.WriteU32(BINARY_CMD_UPDATE_Z_ORDER);
+        m_commands.WriteU32(objectId);
+        m_commands.WriteU32(placeAfterObjectId);
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateMask(
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 maskTillObjectId)
+    {
+        // The runtime does not support masking
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateBlendMode(
+        FCM::U_Int32 objectId,
+        DOM::FrameElement::BlendMode blendMode)
+    {
+        m_commands.WriteU32(BINARY_CMD_UPDATE_BLEND_MODE);
+        m_commands.WriteU32(objectId);
+        m_commands.WriteU32(blendMode);
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateVisibility(
+        FCM::U_Int32 objectId,
+        FCM::Boolean visible)
+    {
+        m_commands.WriteU32(BINARY_CMD_UPDATE_VISIBILITY);
+        m_commands.WriteU32(objectId);
+        m_commands.WriteU32(visible ? 1 : 0);
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::AddGraphicFilter(
+        FCM::U_Int32 objectId,
+        FCM::PIFCMUnknown pFilter)
+    {
+        // Filters are not part of the binary format yet (the runtime ignores them)
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateDisplayTransform(
+        FCM::U_Int32 objectId,
+        const DOM::Utils::MATRIX2D& matrix)
+    {
+        m_commands.WriteU32(BINARY_CMD_MOVE);
+        m_commands.WriteU32(objectId);
+        m_commands.WriteMatrix(matrix);
+        m_commandCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::UpdateColorTransform(
+        FCM::U_Int32 objectId,
+        const DOM::Utils::COLOR_MATRIX& colorMatrix)
+    {
+        // add code to write the color transform
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::ShowFrame(FCM::U_Int32 frameNum)
+    {
+        m_frames.WriteU32(frameNum);
+
+        m_frames.WriteU32(m_commandCount);
+        m_frames.WriteBuffer(m_commands);
+
+        m_frames.WriteU32(m_scriptCount);
+        m_frames.WriteBuffer(m_scripts);
+
+        m_frames.WriteU32(m_labelCount);
+        m_frames.WriteBuffer(m_labels);
+
+        m_frameCount++;
+
+        m_commands.Clear();
+        m_commandCount = 0;
+        m_scripts.Clear();
+        m_scriptCount = 0;
+        m_labels.Clear();
+        m_labelCount = 0;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum)
+    {
+        std::string script = Utils::ToString(pScript, m_pCallback);
+
+        Utils::Trace(m_pCallback, "[AddFrameScript] (Layer: %d): %s\n", layerNum, script.c_str());
+
+        m_scripts.WriteU32(layerNum);
+        m_scripts.WriteString(script);
+        m_scriptCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::RemoveFrameScript(FCM::U_Int32 layerNum)
+    {
+        Utils::Trace(m_pCallback, "[RemoveFrameScript] (Layer: %d)\n", layerNum);
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BinaryTimelineWriter::SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType)
+    {
+        std::string label = Utils::ToString(pLabel, m_pCallback);
+        Utils::Trace(m_pCallback, "[SetFrameLabel] (Type: %d): %s\n", labelType, label.c_str());
+
+        m_labels.WriteU32(labelType);
+        m_labels.WriteString(label);
+        m_labelCount++;
+
+        return FCM_SUCCESS;
+    }
+
+
+    BinaryTimelineWriter::BinaryTimelineWriter(FCM::PIFCMCallback pCallback) :
+        m_pCallback(pCallback),
+        m_frameCount(0),
+        m_commandCount(0),
+        m_scriptCount(0),
+        m_labelCount(0)
+    {
+    }
+
+
+    BinaryTimelineWriter::~BinaryTimelineWriter()
+    {
+    }
+
+
+    void BinaryTimelineWriter::Finish(FCM::U_Int32 resId, BinaryBuffer& payload)
+    {
+        // resId is 0 for the main timeline
+        payload.WriteU32(resId);
+        payload.WriteU32(m_frameCount);
+        payload.WriteBuffer(m_frames);
+    }
+};
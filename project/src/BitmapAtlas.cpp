@@ -0,0 +1,337 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "BitmapAtlas.h"
+
+#include <algorithm>
+
+#include "FCMErrors.h"
+#include "PngImage.h"
+#include "PublishProfiler.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    static inline FCM::Boolean Contains(const ATLAS_RECT& outer, const ATLAS_RECT& inner)
+    {
+        return (inner.x >= outer.x) && (inner.y >= outer.y) &&
+            (inner.x + inner.width <= outer.x + outer.width) &&
+            (inner.y + inner.height <= outer.y + outer.height);
+    }
+
+    static inline FCM::Boolean Intersects(const ATLAS_RECT& a, const ATLAS_RECT& b)
+    {
+        return (a.x < b.x + b.width) && (b.x < a.x + a.width) &&
+            (a.y < b.y + b.height) && (b.y < a.y + a.height);
+    }
+}
+
+
+/* -------------------------------------------------- BitmapAtlas */
+
+namespace CreateJS
+{
+    BitmapAtlas::BitmapAtlas(FCM::PIFCMCallback pCallback) :
+        m_pCallback(pCallback)
+    {
+    }
+
+
+    BitmapAtlas::~BitmapAtlas()
+    {
+    }
+
+
+    FCM::Boolean BitmapAtlas::CanPack(FCM::S_Int32 width, FCM::S_Int32 height)
+    {
+        return (width > 0) && (height > 0) &&
+            (width <= BITMAP_ATLAS_MAX_BITMAP_SIZE) && (height <= BITMAP_ATLAS_MAX_BITMAP_SIZE);
+    }
+
+
+    void BitmapAtlas::Add(
+        const std::string& name,
+        const std::string& sourcePath,
+        FCM::U_Int32 width,
+        FCM::U_Int32 height,
+        ATLAS_REGION& region)
+    {
+        ATLAS_ENTRY entry;
+        ATLAS_RECT bestRect;
+        FCM::U_Int32 bestPage = (FCM::U_Int32)m_pages.size();
+        FCM::U_Int64 bestScore = 0;
+        FCM::U_Int32 paddedWidth = width + 2 * BITMAP_ATLAS_PADDING;
+        FCM::U_Int32 paddedHeight = height + 2 * BITMAP_ATLAS_PADDING;
+
+        ASSERT(CanPack(width, height));
+
+        if (Find(name, region))
+        {
+            return;
+        }
+
+        // The bitmap goes where it fits best on any page, so that later pages do
+        // not take the bitmaps that would fill the gaps in earlier ones
+        for (FCM::U_Int32 i = 0; i < m_pages.size(); i++)
+        {
+            ATLAS_RECT rect;
+            FCM::U_Int64 score;
+
+            if (FindPosition(m_pages[i], paddedWidth, paddedHeight, rect, score) &&
+                ((bestPage == m_pages.size()) || (score < bestScore)))
+            {
+                bestPage = i;
+                bestRect = rect;
+                bestScore = score;
+            }
+        }
+
+        if (bestPage == m_pages.size())
+        {
+            ATLAS_PAGE page;
+            ATLAS_RECT free = { 0, 0, BITMAP_ATLAS_PAGE_SIZE, BITMAP_ATLAS_PAGE_SIZE };
+
+            page.freeRects.push_back(free);
+            page.usedWidth = 0;
+            page.usedHeight = 0;
+            m_pages.push_back(page);
+
+            FindPosition(m_pages[bestPage], paddedWidth, paddedHeight, bestRect, bestScore);
+        }
+
+        PlaceRect(m_pages[bestPage], bestRect);
+
+        region.page = bestPage;
+        region.x = bestRect.x + BITMAP_ATLAS_PADDING;
+        region.y = bestRect.y + BITMAP_ATLAS_PADDING;
+
+        entry.sourcePath = sourcePath;
+        entry.region = region;
+        entry.width = width;
+        entry.height = height;
+
+        m_entryMap[name] = (FCM::U_Int32)m_entries.size();
+        m_entries.push_back(entry);
+    }
+
+
+    FCM::Boolean BitmapAtlas::Find(const std::string& name, ATLAS_REGION& region)
+    {
+        std::map<std::string, FCM::U_Int32>::const_iterator it = m_entryMap.find(name);
+
+        if (it == m_entryMap.end())
+        {
+            return false;
+        }
+
+        region = m_entries[it->second].region;
+
+        return true;
+    }
+
+
+    void BitmapAtlas::GetPageFileName(FCM::U_Int32 page, std::string& name)
+    {
+        name = BITMAP_ATLAS_FILE_PREFIX + Utils::ToString(page) + PNG_FILE_EXT;
+    }
+
+
+    FCM::Result BitmapAtlas::WritePages(const std::string& folder)
+    {
+        FCM::Result result = FCM_SUCCESS;
+
+        for (FCM::U_Int32 i = 0; i < m_pages.size(); i++)
+        {
+            PngImage page;
+            std::string name;
+            FCM::U_Int64 size = 0;
+            FCM::Result res;
+
+            page.Create(m_pages[i].usedWidth, m_pages[i].usedHeight);
+
+            for (size_t j = 0; j < m_entries.size(); j++)
+            {
+                const ATLAS_ENTRY& entry = m_entries[j];
+                PngImage bitmap;
+
+                if (entry.region.page != i)
+                {
+                    continue;
+                }
+
+                res = bitmap.Read(entry.sourcePath, m_pCallback);
+                if (FCM_SUCCESS_CODE(res) &&
+                    ((bitmap.GetWidth() != entry.width) || (bitmap.GetHeight() != entry.height)))
+                {
+                    Utils::Trace(m_pCallback, "Bitmap (%s) is not %ux%u pixels as expected\n",
+                        entry.sourcePath.c_str(), entry.width, entry.height);
+                    res = FCM_GENERAL_ERROR;
+                }
+
+                if (FCM_FAILURE_CODE(res))
+                {
+                    // Its region is left transparent
+                    result = res;
+                    continue;
+                }
+
+                page.Copy(bitmap, entry.region.x, entry.region.y, BITMAP_ATLAS_PADDING);
+
+                Utils::Remove(entry.sourcePath, m_pCallback);
+            }
+
+            GetPageFileName(i, name);
+            res = page.Write(folder + "/" + name, m_pCallback, &size);
+            if (FCM_FAILURE_CODE(res))
+            {
+                result = res;
+            }
+
+            PublishProfiler::AddBytes(PROFILE_PHASE_PACK_BITMAPS, size);
+
+            LOG(("[PackBitmaps] %s: %ux%u, %llu bytes\n", name.c_str(),
+                m_pages[i].usedWidth, m_pages[i].usedHeight, size));
+        }
+
+        return result;
+    }
+
+
+    // Positions that grow the page least come first (the page is cropped to its
+    // bitmaps), then those that leave the shortest side of the free space
+    FCM::Boolean BitmapAtlas::FindPosition(
+        const ATLAS_PAGE& page,
+        FCM::U_Int32 width,
+        FCM::U_Int32 height,
+        ATLAS_RECT& rect,
+        FCM::U_Int64& score)
+    {
+        FCM::Boolean found = false;
+
+        for (size_t i = 0; i < page.freeRects.size(); i++)
+        {
+            const ATLAS_RECT& free = page.freeRects[i];
+
+            if ((free.width < width) || (free.height < height))
+            {
+                continue;
+            }
+
+            FCM::U_Int64 usedWidth = std::max(page.usedWidth, free.x + width);
+            FCM::U_Int64 usedHeight = std::max(page.usedHeight, free.y + height);
+            FCM::U_Int64 growth = usedWidth * usedHeight - (FCM::U_Int64)page.usedWidth * page.usedHeight;
+            FCM::U_Int32 shortSide = std::min(free.width - width, free.height - height);
+            FCM::U_Int64 candidate = (growth << 16) | shortSide;
+
+            if (!found || (candidate < score))
+            {
+                rect.x = free.x;
+                rect.y = free.y;
+                rect.width = width;
+                rect.height = height;
+                score = candidate;
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+
+    // Every free rectangle that overlaps the placed one is replaced by the (up to
+    // four) maximal rectangles around it
+    void BitmapAtlas::PlaceRect(ATLAS_PAGE& page, const ATLAS_RECT& rect)
+    {
+        std::vector<ATLAS_RECT> kept;
+        std::vector<ATLAS_RECT> pieces;
+
+        kept.reserve(page.freeRects.size());
+
+        for (size_t i = 0; i < page.freeRects.size(); i++)
+        {
+            const ATLAS_RECT& free = page.freeRects[i];
+
+            if (!Intersects(free, rect))
+            {
+                kept.push_back(free);
+                continue;
+            }
+
+            if (rect.x > free.x)
+            {
+                ATLAS_RECT left = { free.x, free.y, rect.x - free.x, free.height };
+                pieces.push_back(left);
+            }
+
+            if (rect.x + rect.width < free.x + free.width)
+            {
+                ATLAS_RECT right = { rect.x + rect.width, free.y,
+                    free.x + free.width - (rect.x + rect.width), free.height };
+                pieces.push_back(right);
+            }
+
+            if (rect.y > free.y)
+            {
+                ATLAS_RECT top = { free.x, free.y, free.width, rect.y - free.y };
+                pieces.push_back(top);
+            }
+
+            if (rect.y + rect.height < free.y + free.height)
+            {
+                ATLAS_RECT bottom = { free.x, rect.y + rect.height,
+                    free.width, free.y + free.height - (rect.y + rect.height) };
+                pieces.push_back(bottom);
+            }
+        }
+
+        AddFreeRects(kept, pieces);
+        page.freeRects.swap(kept);
+
+        page.usedWidth = std::max(page.usedWidth, rect.x + rect.width);
+        page.usedHeight = std::max(page.usedHeight, rect.y + rect.height);
+    }
+
+
+    // Adds the pieces that do not lie within another rectangle. The rectangles kept
+    // cannot lie within a piece, as each piece is part of a free rectangle that was
+    // already maximal.
+    void BitmapAtlas::AddFreeRects(std::vector<ATLAS_RECT>& freeRects, const std::vector<ATLAS_RECT>& pieces)
+    {
+        size_t keptCount = freeRects.size();
+
+        for (size_t i = 0; i < pieces.size(); i++)
+        {
+            FCM::Boolean contained = false;
+
+            for (size_t j = 0; !contained && (j < pieces.size()); j++)
+            {
+                // Of two equal pieces, the first one is added
+                contained = (j != i) && Contains(pieces[j], pieces[i]) &&
+                    ((j < i) || !Contains(pieces[i], pieces[j]));
+            }
+
+            for (size_t j = 0; !contained && (j < keptCount); j++)
+            {
+                contained = Contains(freeRects[j], pieces[i]);
+            }
+
+            if (!contained)
+            {
+                freeRects.push_back(pieces[i]);
+            }
+        }
+    }
+};
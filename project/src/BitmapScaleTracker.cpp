@@ -0,0 +1,164 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "BitmapScaleTracker.h"
+
+#include <algorithm>
+#include <math.h>
+#include <set>
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+
+/* -------------------------------------------------- BitmapScaleTracker */
+
+namespace CreateJS
+{
+    BitmapScaleTracker::BitmapScaleTracker()
+    {
+    }
+
+
+    BitmapScaleTracker::~BitmapScaleTracker()
+    {
+    }
+
+
+    void BitmapScaleTracker::Clear()
+    {
+        m_timelines.clear();
+        m_bitmaps.clear();
+        m_bitmapFills.clear();
+    }
+
+
+    // The largest singular value of the 2x2 part
+    FCM::Double BitmapScaleTracker::GetScale(const DOM::Utils::MATRIX2D& matrix)
+    {
+        FCM::Double sum = matrix.a * matrix.a + matrix.b * matrix.b + matrix.c * matrix.c + matrix.d * matrix.d;
+        FCM::Double det = matrix.a * matrix.d - matrix.b * matrix.c;
+        FCM::Double root = sqrt(std::max(sum * sum - 4 * det * det, 0.0));
+
+        return sqrt((sum + root) / 2);
+    }
+
+
+    void BitmapScaleTracker::AddTimeline(FCM::U_Int32 resId, const ResourceScaleMap& childScales)
+    {
+        ResourceScaleMap& timeline = m_timelines[resId];
+
+        for (ResourceScaleMap::const_iterator it = childScales.begin(); it != childScales.end(); ++it)
+        {
+            FCM::Double& scale = timeline[it->first];
+            scale = std::max(scale, it->second);
+        }
+    }
+
+
+    void BitmapScaleTracker::AddBitmap(FCM::U_Int32 resId, const std::string& libPathName)
+    {
+        m_bitmaps[resId] = libPathName;
+    }
+
+
+    void BitmapScaleTracker::AddBitmapFill(FCM::U_Int32 shapeResId, const std::string& libPathName, FCM::Double scale)
+    {
+        KeepLargest(m_bitmapFills[shapeResId], libPathName, scale);
+    }
+
+
+    void BitmapScaleTracker::GetBitmapScales(BitmapScaleMap& scales)
+    {
+        std::set<FCM::U_Int32> children;
+        ResourceScaleMap resourceScales;
+        std::map<FCM::U_Int32, ResourceScaleMap>::const_iterator it;
+
+        scales.clear();
+
+        for (it = m_timelines.begin(); it != m_timelines.end(); ++it)
+        {
+            for (ResourceScaleMap::const_iterator child = it->second.begin(); child != it->second.end(); ++child)
+            {
+                children.insert(child->first);
+            }
+        }
+
+        for (it = m_timelines.begin(); it != m_timelines.end(); ++it)
+        {
+            if (children.find(it->first) == children.end())
+            {
+                Propagate(it->first, 1.0, 0, resourceScales, scales);
+            }
+        }
+    }
+
+
+    // A resource is only visited again if it is reached with a larger scale
+    void BitmapScaleTracker::Propagate(
+        FCM::U_Int32 resId,
+        FCM::Double scale,
+        FCM::U_Int32 depth,
+        ResourceScaleMap& resourceScales,
+        BitmapScaleMap& bitmapScales)
+    {
+        ResourceScaleMap::iterator visited = resourceScales.find(resId);
+
+        if (((visited != resourceScales.end()) && (visited->second >= scale)) ||
+            (depth > BITMAP_SCALE_MAX_NESTING))
+        {
+            return;
+        }
+
+        resourceScales[resId] = scale;
+
+        std::map<FCM::U_Int32, std::string>::const_iterator bitmap = m_bitmaps.find(resId);
+        if (bitmap != m_bitmaps.end())
+        {
+            KeepLargest(bitmapScales, bitmap->second, scale);
+        }
+
+        std::map<FCM::U_Int32, BitmapScaleMap>::const_iterator fills = m_bitmapFills.find(resId);
+        if (fills != m_bitmapFills.end())
+        {
+            for (BitmapScaleMap::const_iterator it = fills->second.begin(); it != fills->second.end(); ++it)
+            {
+                KeepLargest(bitmapScales, it->first, scale * it->second);
+            }
+        }
+
+        std::map<FCM::U_Int32, ResourceScaleMap>::const_iterator timeline = m_timelines.find(resId);
+        if (timeline != m_timelines.end())
+        {
+            for (ResourceScaleMap::const_iterator it = timeline->second.begin(); it != timeline->second.end(); ++it)
+            {
+                Propagate(it->first, scale * it->second, depth + 1, resourceScales, bitmapScales);
+            }
+        }
+    }
+
+
+    void BitmapScaleTracker::KeepLargest(BitmapScaleMap& scales, const std::string& libPathName, FCM::Double scale)
+    {
+        BitmapScaleMap::iterator it = scales.find(libPathName);
+
+        if (it == scales.end())
+        {
+            scales[libPathName] = scale;
+        }
+        else if (scale > it->second)
+        {
+            it->second = scale;
+        }
+    }
+};
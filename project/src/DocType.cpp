@@ -11,8 +11,11 @@
 
 #include "DocType.h"
 #include "Utils.h"
+#include "ServiceRegistry.h"
 #include <fstream>
-#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 
 #include "Application/Service/IOutputConsoleService.h"
 #include "PluginConfiguration.h"
@@ -36,6 +39,124 @@ namespace CreateJS
 
     /* -------------------------------------------------- Static Functions */
 
+    // FNV-1a over the characters of a name. Names in Features.xml are ASCII, so the
+    // UTF-8 and UTF-16 forms of a name hash to the same value.
+    static FCM::U_Int64 HashName(const std::string& name)
+    {
+        FCM::U_Int64 hash = 14695981039346656037ULL;
+
+        for (size_t i = 0; i < name.size(); i++)
+        {
+            hash ^= (FCM::U_Int8)name[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+
+    static FCM::U_Int64 HashName(CStringRep16 pName)
+    {
+        FCM::U_Int64 hash = 14695981039346656037ULL;
+
+        for (; pName && *pName; pName++)
+        {
+            hash ^= *pName;
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+
+    static bool IsSameName(const std::string& name, CStringRep16 pName)
+    {
+        size_t i = 0;
+
+        if (pName == NULL)
+        {
+            return name.empty();
+        }
+
+        for (; i < name.size(); i++)
+        {
+            if (pName[i] != (FCM::U_Int8)name[i])
+            {
+                return false;
+            }
+        }
+
+        return (pName[i] == 0);
+    }
+
+
+    template <class T>
+    static T* FindByName(const std::unordered_map<FCM::U_Int64, T*>& items, const std::string& name)
+    {
+        typename std::unordered_map<FCM::U_Int64, T*>::const_iterator itr = items.find(HashName(name));
+        if ((itr != items.end()) && (itr->second->GetName() == name))
+        {
+            return itr->second;
+        }
+        return NULL;
+    }
+
+
+    // Called by the host for every feature query, so it must not allocate
+    template <class T>
+    static T* FindByName(const std::unordered_map<FCM::U_Int64, T*>& items, CStringRep16 pName)
+    {
+        typename std::unordered_map<FCM::U_Int64, T*>::const_iterator itr = items.find(HashName(pName));
+        if ((itr != items.end()) && IsSameName(itr->second->GetName(), pName))
+        {
+            return itr->second;
+        }
+        return NULL;
+    }
+
+
+    template <class T>
+    static bool AddByName(std::unordered_map<FCM::U_Int64, T*>& items, const std::string& name, T* pItem)
+    {
+        // Two names with the same hash cannot both be stored
+        bool added = items.insert(std::pair<FCM::U_Int64, T*>(HashName(name), pItem)).second;
+        ASSERT(added);
+
+        return added;
+    }
+
+
+    template <class T>
+    static void DeleteAll(std::unordered_map<FCM::U_Int64, T*>& items)
+    {
+        typename std::unordered_map<FCM::U_Int64, T*>::iterator itr = items.begin();
+        for(; itr != items.end(); itr++)
+        {
+            if (itr->second) delete itr->second;
+        }
+        items.clear();
+    }
+
+
+    static const char* SkipSpace(const char* p, const char* pEnd)
+    {
+        while ((p < pEnd) && isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        return p;
+    }
+
+
+    static const char* SkipName(const char* p, const char* pEnd)
+    {
+        while ((p < pEnd) && !isspace((unsigned char)*p) && (*p != '=') && (*p != '/') && (*p != '>'))
+        {
+            p++;
+        }
+        return p;
+    }
+
 
     /* -------------------------------------------------- DocType */
 
@@ -74,10 +195,19 @@ namespace CreateJS
     FeatureMatrix::FeatureMatrix()
     {
         m_bInited = false;
+        mCurrentFeature = NULL;
+        mCurrentProperty = NULL;
+        m_pServiceCallback = NULL;
     }
 
     FeatureMatrix::~FeatureMatrix()
     {
+        DeleteAll(mFeatures);
+
+        if (m_pServiceCallback)
+        {
+            ServiceRegistry::Unregister(m_pServiceCallback);
+        }
     }
 
     void FeatureMatrix::Init(FCM::PIFCMCallback pCallback)
@@ -89,16 +219,18 @@ namespace CreateJS
             return;
         }
 
+        // GetDefaultValue converts strings for the host for the lifetime of the matrix
+        m_pServiceCallback = GetCallback();
+        ServiceRegistry::Register(m_pServiceCallback);
+
         Utils::GetModuleFilePath(featureXMLPath, pCallback);
 
         featureXMLPath += "../res/Features.xml";
 
         // trace
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
-        FCM::Result res = pCallback->GetService(Application::Service::APP_OUTPUT_CONSOLE_SERVICE, pUnk.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        
-        FCM::AutoPtr<Application::Service::IOutputConsoleService> outputConsoleService = pUnk;
+        FCM::AutoPtr<Application::Service::IOutputConsoleService> outputConsoleService =
+            ServiceRegistry::GetOutputConsoleService(pCallback);
+        ASSERT(outputConsoleService);
         FCM::StringRep16 path = Utils::ToString16(featureXMLPath,pCallback);
         FCM::StringRep16 outputString = Utils::ToString16(std::string("\nThe feature settings for the SamplePlugin document type is read from "),GetCallback());
         outputConsoleService->Trace(outputString);
@@ -127,14 +259,156 @@ namespace CreateJS
         }
         xmlFile.close();        
        
+        if (buffer)
+        {
+            Parse(buffer, (size_t)length);
+        }
+
         delete[] buffer;
+
+        m_bInited = true;
+    }
+
+
+    void FeatureMatrix::Parse(const char* pXML, size_t length)
+    {
+        // Only what Features.xml uses is understood: elements with quoted attributes.
+        // Text between the elements, comments and declarations are skipped, and
+        // entities are not expanded.
+        const char* p = pXML;
+        const char* pEnd = pXML + length;
+
+        mCurrentFeature = NULL;
+        mCurrentProperty = NULL;
+
+        while (p < pEnd)
+        {
+            p = (const char*)memchr(p, '<', pEnd - p);
+            if (p == NULL)
+            {
+                break;
+            }
+            p++;
+
+            if ((p < pEnd) && ((*p == '?') || (*p == '!')))
+            {
+                const char* pClose = NULL;
+
+                if ((pEnd - p >= 3) && (p[1] == '-') && (p[2] == '-'))
+                {
+                    // Comment
+                    for (const char* q = p + 3; q + 3 <= pEnd; q++)
+                    {
+                        if ((q[0] == '-') && (q[1] == '-') && (q[2] == '>'))
+                        {
+                            pClose = q + 2;
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    pClose = (const char*)memchr(p, '>', pEnd - p);
+                }
+
+                if (pClose == NULL)
+                {
+                    break;
+                }
+                p = pClose + 1;
+                continue;
+            }
+
+            bool endTag = false;
+            bool emptyTag = false;
+            std::map<std::string, std::string> attrs;
+
+            if ((p < pEnd) && (*p == '/'))
+            {
+                endTag = true;
+                p++;
+            }
+
+            const char* pName = p;
+            p = SkipName(p, pEnd);
+            std::string name(pName, p);
+
+            // Attributes
+            while (p < pEnd)
+            {
+                p = SkipSpace(p, pEnd);
+                if (p >= pEnd)
+                {
+                    break;
+                }
+
+                if (*p == '>')
+                {
+                    p++;
+                    break;
+                }
+
+                if (*p == '/')
+                {
+                    emptyTag = true;
+                    p++;
+                    continue;
+                }
+
+                const char* pAttrName = p;
+                p = SkipName(p, pEnd);
+                std::string attrName(pAttrName, p);
+
+                p = SkipSpace(p, pEnd);
+                if ((p >= pEnd) || (*p != '='))
+                {
+                    if (attrName.empty())
+                    {
+                        // Not a valid attribute; skip the character to make progress
+                        p++;
+                    }
+                    continue;
+                }
+
+                p = SkipSpace(p + 1, pEnd);
+                if ((p >= pEnd) || ((*p != '"') && (*p != '\'')))
+                {
+                    continue;
+                }
+
+                const char* pValue = p + 1;
+                const char* pValueEnd = (const char*)memchr(pValue, *p, pEnd - pValue);
+                if (pValueEnd == NULL)
+                {
+                    p = pEnd;
+                    break;
+                }
+
+                attrs[attrName] = std::string(pValue, pValueEnd);
+                p = pValueEnd + 1;
+            }
+
+            if (endTag)
+            {
+                EndElement(name);
+            }
+            else
+            {
+                StartElement(name, attrs);
+                if (emptyTag)
+                {
+                    EndElement(name);
+                }
+            }
+        }
+
+        mCurrentFeature = NULL;
+        mCurrentProperty = NULL;
     }
 
     FCM::Result FeatureMatrix::IsSupported(CStringRep16 inFeatureName, FCM::Boolean& isSupported)
     {
-        std::string featureLC = Utils::ToString(inFeatureName, GetCallback());
-        
-        Feature* pFeature = FindFeature(featureLC);
+        Feature* pFeature = FindFeature(inFeatureName);
         if (pFeature == NULL)
         {
             /* If a feature is not found, it is supported */
@@ -152,9 +426,7 @@ namespace CreateJS
         CStringRep16 inPropName, 
         FCM::Boolean& isSupported)
     {     
-        std::string featureLC = Utils::ToString(inFeatureName, GetCallback());
-
-        Feature* pFeature = FindFeature(featureLC);
+        Feature* pFeature = FindFeature(inFeatureName);
         if (pFeature == NULL)
         {
             /* If a feature is not found, it is supported */
@@ -170,9 +442,7 @@ namespace CreateJS
             else
             {
                 // Look if sub-features are supported.
-                std::string propertyLC = Utils::ToString(inPropName, GetCallback());
-                
-                Property* pProperty = pFeature->FindProperty(propertyLC);
+                Property* pProperty = pFeature->FindProperty(inPropName);
                 if (pProperty == NULL)
                 {
                     /* If a property is not found, it is supported */
@@ -194,9 +464,7 @@ namespace CreateJS
         CStringRep16 inValName, 
         FCM::Boolean& isSupported)
     {
-        std::string featureLC = Utils::ToString(inFeatureName, GetCallback());
-
-        Feature* pFeature = FindFeature(featureLC);
+        Feature* pFeature = FindFeature(inFeatureName);
         if (pFeature == NULL)
         {
             /* If a feature is not found, it is supported */
@@ -211,9 +479,7 @@ namespace CreateJS
             }
             else
             {
-                std::string propertyLC(Utils::ToString(inPropName, GetCallback()));
-
-                Property* pProperty = pFeature->FindProperty(propertyLC);
+                Property* pProperty = pFeature->FindProperty(inPropName);
                 if (pProperty == NULL)
                 {
                     /* If a property is not found, it is supported */
@@ -228,9 +494,7 @@ namespace CreateJS
                     }
                     else
                     {
-                        std::string valueLC(Utils::ToString(inValName, GetCallback()));
-
-                        Value* pValue = pProperty->FindValue(valueLC);
+                        Value* pValue = pProperty->FindValue(inValName);
                         if (pValue == NULL)
                         {
                             /* If a value is not found, it is supported */
@@ -256,25 +520,22 @@ namespace CreateJS
     {
         // Any boolean value retuened as string should be "true" or "false"
         FCM::Result res = FCM_INVALID_PARAM;
-        std::string featureName = Utils::ToString(inFeatureName, GetCallback());
-        std::string propName = Utils::ToString(inPropName, GetCallback());
         
         Property* pProperty = NULL;
-        Feature* pFeature = FindFeature(featureName);
+        Feature* pFeature = FindFeature(inFeatureName);
         if (pFeature != NULL && pFeature->IsSupported())
         {
-            pProperty = pFeature->FindProperty(propName);
+            pProperty = pFeature->FindProperty(inPropName);
             if (pProperty != NULL /*&& pProperty->IsSupported()*/)
             {
-                std::string strVal = pProperty->GetDefault();
-                std::istringstream iss(strVal);
+                const std::string& strVal = pProperty->GetDefault();
                 res = FCM_SUCCESS;
                 switch (outDefVal.m_type) {
-                    case kFCMVarype_UInt32: iss>>outDefVal.m_value.uVal;break;
-                    case kFCMVarype_Float: iss>>outDefVal.m_value.fVal;break;
+                    case kFCMVarype_UInt32: outDefVal.m_value.uVal = (FCM::U_Int32)strtoul(strVal.c_str(), NULL, 10);break;
+                    case kFCMVarype_Float: outDefVal.m_value.fVal = (FCM::Float)strtod(strVal.c_str(), NULL);break;
                     case kFCMVarype_Bool: outDefVal.m_value.bVal = (kValue_true == strVal); break;
                     case kFCMVarype_CString: outDefVal.m_value.strVal = Utils::ToString16(strVal, GetCallback()); break;
-                    case kFCMVarype_Double: iss>>outDefVal.m_value.dVal;break;
+                    case kFCMVarype_Double: outDefVal.m_value.dVal = strtod(strVal.c_str(), NULL);break;
                     default: 
                     ASSERT(0);
                     res = FCM_INVALID_PARAM;
@@ -333,12 +594,12 @@ namespace CreateJS
 
     Feature* FeatureMatrix::FindFeature(const std::string& inFeatureName)
     {
-        StrFeatureMap::iterator itr = mFeatures.find(inFeatureName);
-        if (itr != mFeatures.end())
-        {
-            return itr->second;
-        }
-        return NULL;
+        return FindByName(mFeatures, inFeatureName);
+    }
+
+    Feature* FeatureMatrix::FindFeature(CStringRep16 inFeatureName)
+    {
+        return FindByName(mFeatures, inFeatureName);
     }
 
     Feature* FeatureMatrix::UpdateFeature(const std::map<std::string, std::string>& inAttrs)
@@ -368,8 +629,12 @@ namespace CreateJS
         Feature * pFeature = FindFeature(name);   
         if (pFeature == NULL)
         {
-            pFeature = new Feature(supported);
-            mFeatures.insert(std::pair<std::string, Feature*>(name, pFeature));
+            pFeature = new Feature(name, supported);
+            if (!AddByName(mFeatures, name, pFeature))
+            {
+                delete pFeature;
+                pFeature = NULL;
+            }
         }
 
         return pFeature;
@@ -419,10 +684,11 @@ namespace CreateJS
         pProperty = inFeature->FindProperty(name);
         if (pProperty == NULL)
         {
-            pProperty = new Property(def, supported);
-            if (pProperty != NULL)
+            pProperty = new Property(name, def, supported);
+            if ((pProperty != NULL) && !inFeature->AddProperty(name, pProperty))
             {
-                inFeature->AddProperty(name, pProperty);
+                delete pProperty;
+                pProperty = NULL;
             }
         }
 
@@ -460,10 +726,11 @@ namespace CreateJS
         Value * pValue = inProperty->FindValue(name);
         if (pValue == NULL)
         {
-            pValue = new Value(supported);
-            if (pValue != NULL)
+            pValue = new Value(name, supported);
+            if ((pValue != NULL) && !inProperty->AddValue(name, pValue))
             {
-                inProperty->AddValue(name, pValue);
+                delete pValue;
+                pValue = NULL;
             }
         }
 
@@ -473,8 +740,9 @@ namespace CreateJS
 
     /* -------------------------------------------------- Value */
 
-    Value::Value(bool supported) 
+    Value::Value(const std::string& name, bool supported) 
     { 
+        mName = name;
         mbSupported = supported;
     }
 
@@ -487,38 +755,39 @@ namespace CreateJS
         return mbSupported;
     }
 
+    const std::string& Value::GetName()
+    {
+        return mName;
+    }
+
 
     /* -------------------------------------------------- Property */
 
-    Property::Property(const std::string& def, bool supported)
+    Property::Property(const std::string& name, const std::string& def, bool supported)
     {
+        mName = name;
         mbSupported = supported;
         mDefault = def;
     }
 
     Property::~Property()
     {
-        StrValueMap::iterator itr = mValues.begin();
-        for(; itr != mValues.end(); itr++)
-        {
-            if (itr->second) delete itr->second;
-        }
-        mValues.clear();        
+        DeleteAll(mValues);
     }
 
     Value* Property::FindValue(const std::string& inValueName)
     {
-        StrValueMap::iterator itr = mValues.find(inValueName);
-        if (itr != mValues.end())
-            return itr->second;
-        return NULL;
+        return FindByName(mValues, inValueName);
     }
 
-    bool Property::AddValue(const std::string& valueName, Value* pValue)
+    Value* Property::FindValue(CStringRep16 inValueName)
     {
-        mValues.insert(std::pair<std::string, Value*>(valueName, pValue));
+        return FindByName(mValues, inValueName);
+    }
 
-        return true;
+    bool Property::AddValue(const std::string& valueName, Value* pValue)
+    {
+        return AddByName(mValues, valueName, pValue);
     }
 
     bool Property::IsSupported()
@@ -527,44 +796,43 @@ namespace CreateJS
     }
 
 
-    std::string Property::GetDefault()
+    const std::string& Property::GetDefault()
     {
         return mDefault;
     }
 
+    const std::string& Property::GetName()
+    {
+        return mName;
+    }
+
 
     /* -------------------------------------------------- Feature */
 
-    Feature::Feature(bool supported)
+    Feature::Feature(const std::string& name, bool supported)
     {
+        mName = name;
         mbSupported = supported;
     }
 
     Feature::~Feature()
     {
-        StrPropertyMap::iterator itr = mProperties.begin();
-        for(; itr != mProperties.end(); itr++)
-        {
-            if (itr->second) delete itr->second;
-        }
-        mProperties.clear();
+        DeleteAll(mProperties);
     }
 
     Property* Feature::FindProperty(const std::string& inPropertyName)
     {
-        StrPropertyMap::iterator itr = mProperties.find(inPropertyName);
-        if (itr != mProperties.end())
-        {
-            return itr->second;
-        }
-        return NULL;
+        return FindByName(mProperties, inPropertyName);
     }
 
-    bool Feature::AddProperty(const std::string& name, Property* pProperty)
+    Property* Feature::FindProperty(CStringRep16 inPropertyName)
     {
-        mProperties.insert(std::pair<std::string, Property*>(name, pProperty));
+        return FindByName(mProperties, inPropertyName);
+    }
 
-        return true;
+    bool Feature::AddProperty(const std::string& name, Property* pProperty)
+    {
+        return AddByName(mProperties, name, pProperty);
     }
 
     bool Feature::IsSupported()
@@ -572,6 +840,11 @@ namespace CreateJS
         return mbSupported;
     }
 
+    const std::string& Feature::GetName()
+    {
+        return mName;
+    }
+
     /* -------------------------------------------------- Public Global Functions */
 
     FCM::Result RegisterDocType(FCM::PIFCMDictionary pPlugins, const std::string& resPath)
@@ -0,0 +1,123 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "GzipWriter.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "zlib.h"
+
+#include "FCMErrors.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+
+/* -------------------------------------------------- GzipWriter */
+
+namespace CreateJS
+{
+    FCM::Result GzipWriter::CompressFile(
+        const std::string& srcPath,
+        const std::string& destPath,
+        FCM::PIFCMCallback pCallback,
+        FCM::U_Int64* pInSize,
+        FCM::U_Int64* pOutSize)
+    {
+        std::fstream file;
+        std::string in;
+        std::string out;
+
+        Utils::OpenFStream(srcPath, file, std::ios_base::in | std::ios_base::binary, pCallback);
+        if (!file.is_open())
+        {
+            Utils::Trace(pCallback, "File (%s) could not be read for compression\n", srcPath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        in.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        file.close();
+
+        Compress(in, out);
+
+        Utils::OpenFStream(destPath, file, std::ios_base::trunc | std::ios_base::out | std::ios_base::binary, pCallback);
+        file.write(out.data(), out.size());
+        file.close();
+
+        if (file.fail())
+        {
+            Utils::Trace(pCallback, "Compressed file (%s) could not be written\n", destPath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        if (pInSize)
+        {
+            *pInSize = in.size();
+        }
+        if (pOutSize)
+        {
+            *pOutSize = out.size();
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    void GzipWriter::Compress(const std::string& in, std::string& out)
+    {
+        Deflate(in, GZIP_WINDOW_BITS, out);
+    }
+
+
+    void GzipWriter::CompressZlib(const std::string& in, std::string& out)
+    {
+        Deflate(in, ZLIB_WINDOW_BITS, out);
+    }
+
+
+    FCM::U_Int32 GzipWriter::GetCRC32(const std::string& in)
+    {
+        return (FCM::U_Int32)crc32(crc32(0, Z_NULL, 0), (const Bytef*)in.data(), (uInt)in.size());
+    }
+
+
+    void GzipWriter::Deflate(const std::string& in, int windowBits, std::string& out)
+    {
+        z_stream stream;
+        int res;
+
+        memset(&stream, 0, sizeof(stream));
+
+        res = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+        ASSERT(res == Z_OK);
+
+        // The bound holds for a single call with Z_FINISH
+        size_t start = out.size();
+        out.resize(start + deflateBound(&stream, (uLong)in.size()));
+
+        stream.next_in = (Bytef*)in.data();
+        stream.avail_in = (uInt)in.size();
+        stream.next_out = (Bytef*)&out[start];
+        stream.avail_out = (uInt)(out.size() - start);
+
+        res = deflate(&stream, Z_FINISH);
+        ASSERT(res == Z_STREAM_END);
+
+        out.resize(start + stream.total_out);
+
+        deflateEnd(&stream);
+    }
+};
@@ -13,14 +13,228 @@
 
 #include "HTTPServer.h"
 #include "Utils.h"
+#include "GzipWriter.h"
+#include "PluginConfiguration.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
 
 namespace CreateJS
 {
 
     /* -------------------------------------------------- Constants */
 
+    #define HTTP_SEND_BUFFER_SIZE       (64 * 1024)
+
     /* -------------------------------------------------- Static Functions */
 
+    // Paths are UTF-8, as mongoose expects
+    static FILE* OpenFile(const std::string& path)
+    {
+#ifdef _WINDOWS
+        wchar_t wPath[MAX_PATH];
+
+        if (MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wPath, MAX_PATH) == 0)
+        {
+            return NULL;
+        }
+        return _wfopen(wPath, L"rb");
+#else
+        return fopen(path.c_str(), "rb");
+#endif
+    }
+
+    static bool GetFileInfo(const std::string& path, FCM::U_Int64& size, time_t& modified)
+    {
+#ifdef _WINDOWS
+        wchar_t wPath[MAX_PATH];
+        struct _stati64 st;
+
+        if ((MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wPath, MAX_PATH) == 0) ||
+            (_wstati64(wPath, &st) != 0))
+        {
+            return false;
+        }
+#else
+        struct stat st;
+
+        if (stat(path.c_str(), &st) != 0)
+        {
+            return false;
+        }
+#endif
+        if ((st.st_mode & S_IFMT) != S_IFREG)
+        {
+            return false;
+        }
+
+        size = st.st_size;
+        modified = st.st_mtime;
+        return true;
+    }
+
+    // True if "gzip" is listed in an Accept-Encoding header without "q=0"
+    static bool AcceptsGzip(const char* pAcceptEncoding)
+    {
+        const char* pToken = pAcceptEncoding;
+
+        while (pToken && *pToken)
+        {
+            const char* pEnd = strchr(pToken, ',');
+            size_t length = pEnd ? (size_t)(pEnd - pToken) : strlen(pToken);
+            std::string token(pToken, length);
+            size_t start = token.find_first_not_of(" \t");
+            size_t nameEnd = token.find(';');
+            std::string name;
+
+            if (start != std::string::npos)
+            {
+                name = token.substr(start, (nameEnd == std::string::npos) ? std::string::npos : nameEnd - start);
+                name = name.substr(0, name.find_last_not_of(" \t") + 1);
+            }
+
+            for (size_t i = 0; i < name.size(); i++)
+            {
+                name[i] = (char)tolower((unsigned char)name[i]);
+            }
+
+            if (name == "gzip")
+            {
+                size_t quality = token.find("q=", (nameEnd == std::string::npos) ? token.size() : nameEnd);
+
+                return (quality == std::string::npos) || (atof(token.c_str() + quality + 2) > 0);
+            }
+
+            pToken = pEnd ? pEnd + 1 : NULL;
+        }
+
+        return false;
+    }
+
+    // Type of the files written by the publish, which may have gzip copies
+    static const char* GetContentType(const std::string& path)
+    {
+        std::string extension;
+
+        Utils::GetFileExtension(path, extension);
+
+        if (extension == "json")
+        {
+            return "application/json";
+        }
+        if ((extension == "html") || (extension == "htm"))
+        {
+            return "text/html; charset=utf-8";
+        }
+        if (extension == "bin")
+        {
+            return "application/octet-stream";
+        }
+
+        return NULL;
+    }
+
+    static std::string JoinPath(const std::string& folder, const std::string& uri)
+    {
+        std::string path = folder;
+
+        if (!path.empty() && ((path[path.size() - 1] == '/') || (path[path.size() - 1] == '\\')))
+        {
+            path.erase(path.size() - 1);
+        }
+
+        return path + uri;
+    }
+
+    static void SendHeaders(
+        struct mg_connection* conn, 
+        const char* pContentType, 
+        FCM::U_Int64 size, 
+        bool compressed)
+    {
+        if (!pContentType)
+        {
+            pContentType = "application/octet-stream";
+        }
+
+        mg_printf(conn,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: %s\r\n"
+            "%s"
+            "Content-Length: %llu\r\n"
+            "Vary: Accept-Encoding\r\n"
+            "Cache-Control: no-cache\r\n"
+            "\r\n",
+            pContentType,
+            compressed ? "Content-Encoding: gzip\r\n" : "",
+            (unsigned long long)size);
+    }
+
+    static void SendData(
+        struct mg_connection* conn, 
+        const std::string& data, 
+        const char* pContentType, 
+        bool compressed, 
+        bool isHead)
+    {
+        SendHeaders(conn, pContentType, data.size(), compressed);
+
+        if (!isHead)
+        {
+            mg_write(conn, data.data(), data.size());
+        }
+    }
+
+    // Sends the gzip copy written next to a file, unless it is missing or older than
+    // the file (left over from an earlier publish)
+    static bool SendCompressedFile(struct mg_connection* conn, const std::string& path, bool isHead)
+    {
+        FCM::U_Int64 size;
+        FCM::U_Int64 compressedSize;
+        time_t modified;
+        time_t compressedModified;
+        FILE* pFile;
+
+        if (!GetContentType(path) ||
+            !GetFileInfo(path, size, modified) ||
+            !GetFileInfo(path + GZIP_FILE_EXT, compressedSize, compressedModified) ||
+            (compressedModified < modified))
+        {
+            return false;
+        }
+
+        pFile = OpenFile(path + GZIP_FILE_EXT);
+        if (!pFile)
+        {
+            return false;
+        }
+
+        SendHeaders(conn, GetContentType(path), compressedSize, true);
+
+        if (!isHead)
+        {
+            char* pBuffer = new char[HTTP_SEND_BUFFER_SIZE];
+            size_t read;
+
+            while ((read = fread(pBuffer, 1, HTTP_SEND_BUFFER_SIZE, pFile)) > 0)
+            {
+                if (mg_write(conn, pBuffer, read) <= 0)
+                {
+                    break;
+                }
+            }
+
+            delete [] pBuffer;
+        }
+
+        fclose(pFile);
+
+        return true;
+    }
+
     /* -------------------------------------------------- HTTPServer */
 
     std::auto_ptr<HTTPServer> HTTPServer::m_instance;
@@ -49,6 +263,40 @@ namespace CreateJS
         m_config = config;
     }
 
+    const ServerConfigParam& HTTPServer::GetConfig() const
+    {
+        return m_config;
+    }
+
+    FCM::Boolean HTTPServer::IsRunning() const
+    {
+        return (m_context != NULL);
+    }
+
+    void HTTPServer::SetContent(
+        const std::string& root, 
+        const std::string& runtimeFolder, 
+        std::map<std::string, std::string>& files)
+    {
+        PREVIEW_CONTENT* pContent = new PREVIEW_CONTENT;
+
+        pContent->root = root;
+        pContent->runtimeFolder = runtimeFolder;
+        pContent->files.swap(files);
+
+        std::shared_ptr<const PREVIEW_CONTENT> content(pContent);
+
+        std::lock_guard<std::mutex> lock(m_contentMutex);
+        m_content.swap(content);
+    }
+
+    std::shared_ptr<const PREVIEW_CONTENT> HTTPServer::GetContent()
+    {
+        std::lock_guard<std::mutex> lock(m_contentMutex);
+
+        return m_content;
+    }
+
     FCM::Result HTTPServer::Start()
     {
         FCM::Result res = FCM_GENERAL_ERROR;
@@ -65,9 +313,15 @@ namespace CreateJS
 
         memset(&callbacks, 0, sizeof(mg_callbacks));
         callbacks.begin_request = BeginRequestHandler;
+#ifdef USE_WEBSOCKET
+        callbacks.websocket_connect = WebSocketConnectHandler;
+        callbacks.websocket_ready = WebSocketReadyHandler;
+        callbacks.websocket_data = WebSocketDataHandler;
+        callbacks.end_request = EndRequestHandler;
+#endif
 
         // Start the server
-        m_context = mg_start(&callbacks, NULL, options);
+        m_context = mg_start(&callbacks, this, options);
 
         if (m_context)
         {
@@ -81,17 +335,210 @@ namespace CreateJS
     {
         if (m_context)
         {
+#ifdef USE_WEBSOCKET
+            {
+                // The pages close their connections, which would otherwise keep
+                // mongoose's threads waiting for them
+                std::lock_guard<std::mutex> lock(m_liveMutex);
+
+                for (std::map<const struct mg_connection*, std::string>::iterator it = m_livePages.begin(); 
+                    it != m_livePages.end(); 
+                    it++)
+                {
+                    mg_websocket_write((struct mg_connection*)it->first, WEBSOCKET_OPCODE_CONNECTION_CLOSE, NULL, 0);
+                }
+            }
+#endif
+
             // Stop the server
             mg_stop(m_context);
             m_context = NULL;
         }
     }
 
+    // Serves a publish: the output files kept in memory, the runtime folder of the
+    // extension and the rest of the output folder from disk. Clients that accept gzip
+    // get the compressed copies (see OUTPUT_SETTINGS::precompressOutput). The document
+    // root mongoose was started with is not used, so that every publish can re-point
+    // the running server.
     int HTTPServer::BeginRequestHandler(struct mg_connection *conn) 
     {
-        // Inform Mongoose that it needs to handle the request
-        return 0;
+        const struct mg_request_info* pRequest = mg_get_request_info(conn);
+        HTTPServer* pServer = (HTTPServer*)pRequest->user_data;
+        bool isHead = (strcmp(pRequest->request_method, "HEAD") == 0);
+        const std::string runtimePrefix = "/" RUNTIME_FOLDER_NAME "/";
+        std::shared_ptr<const PREVIEW_CONTENT> pContent;
+        std::string uri;
+        std::string path;
+        bool acceptsGzip;
+        FCM::U_Int64 size;
+        time_t modified;
+
+        if (!pServer || 
+            (!isHead && (strcmp(pRequest->request_method, "GET") != 0)) ||
+            (strcmp(pRequest->uri, LIVE_RELOAD_URI) == 0))
+        {
+            // Inform Mongoose that it needs to handle the request
+            return 0;
+        }
+
+        pContent = pServer->GetContent();
+        if (!pContent)
+        {
+            return 0;
+        }
+
+        // The URI is decoded and has no ".." left in it
+        uri = pRequest->uri;
+        acceptsGzip = AcceptsGzip(mg_get_header(conn, "Accept-Encoding"));
+
+        // Output files kept in memory are all in the root
+        if ((uri.size() > 1) && (uri.find('/', 1) == std::string::npos))
+        {
+            std::string name = uri.substr(1);
+            std::map<std::string, std::string>::const_iterator it = pContent->files.end();
+
+            if (acceptsGzip)
+            {
+                it = pContent->files.find(name + GZIP_FILE_EXT);
+            }
+            if (it != pContent->files.end())
+            {
+                SendData(conn, it->second, GetContentType(name), true, isHead);
+                return 1;
+            }
+
+            it = pContent->files.find(name);
+            if (it != pContent->files.end())
+            {
+                SendData(conn, it->second, GetContentType(name), false, isHead);
+                return 1;
+            }
+        }
+
+        if (!pContent->runtimeFolder.empty() && (uri.compare(0, runtimePrefix.size(), runtimePrefix) == 0))
+        {
+            path = JoinPath(pContent->runtimeFolder, uri.substr(runtimePrefix.size() - 1));
+        }
+        else
+        {
+            path = JoinPath(pContent->root, uri);
+        }
+
+        if (acceptsGzip && SendCompressedFile(conn, path, isHead))
+        {
+            return 1;
+        }
+
+        if (!GetFileInfo(path, size, modified))
+        {
+            mg_printf(conn,
+                "HTTP/1.1 404 Not Found\r\n"
+                "Content-Length: 0\r\n"
+                "\r\n");
+            return 1;
+        }
+
+        mg_send_file(conn, path.c_str());
+
+        // The request has been handled
+        return 1;
     }
+
+    FCM::Boolean HTTPServer::HasLivePage(const std::string& pageName)
+    {
+        std::lock_guard<std::mutex> lock(m_liveMutex);
+
+        for (std::map<const struct mg_connection*, std::string>::const_iterator it = m_livePages.begin(); 
+            it != m_livePages.end(); 
+            it++)
+        {
+            if (it->second == pageName)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    FCM::U_Int32 HTTPServer::SendLiveMessage(const std::string& pageName, const std::string& message)
+    {
+        FCM::U_Int32 count = 0;
+
+#ifdef USE_WEBSOCKET
+        // Held while writing, so that a connection cannot end meanwhile (see
+        // EndRequestHandler) and no two messages are interleaved
+        std::lock_guard<std::mutex> lock(m_liveMutex);
+
+        for (std::map<const struct mg_connection*, std::string>::const_iterator it = m_livePages.begin(); 
+            it != m_livePages.end(); 
+            it++)
+        {
+            if ((it->second == pageName) && 
+                (mg_websocket_write(
+                    (struct mg_connection*)it->first, 
+                    WEBSOCKET_OPCODE_TEXT, 
+                    message.data(), 
+                    message.size()) > 0))
+            {
+                count++;
+            }
+        }
+#endif
+
+        return count;
+    }
+
+#ifdef USE_WEBSOCKET
+
+    int HTTPServer::WebSocketConnectHandler(const struct mg_connection* conn)
+    {
+        const struct mg_request_info* pRequest = mg_get_request_info((struct mg_connection*)conn);
+
+        // Anything but 0 refuses the connection
+        return (strcmp(pRequest->uri, LIVE_RELOAD_URI) == 0) ? 0 : 1;
+    }
+
+    void HTTPServer::WebSocketReadyHandler(struct mg_connection* conn)
+    {
+        HTTPServer* pServer = (HTTPServer*)mg_get_request_info(conn)->user_data;
+        std::lock_guard<std::mutex> lock(pServer->m_liveMutex);
+
+        pServer->m_livePages[conn] = "";
+    }
+
+    int HTTPServer::WebSocketDataHandler(struct mg_connection* conn, int bits, char* data, size_t dataLength)
+    {
+        HTTPServer* pServer = (HTTPServer*)mg_get_request_info(conn)->user_data;
+        int opcode = bits & 0x0F;
+
+        if (opcode == WEBSOCKET_OPCODE_CONNECTION_CLOSE)
+        {
+            return 0;
+        }
+
+        if (opcode == WEBSOCKET_OPCODE_TEXT)
+        {
+            std::lock_guard<std::mutex> lock(pServer->m_liveMutex);
+
+            pServer->m_livePages[conn].assign(data, dataLength);
+        }
+
+        // Keep the connection open
+        return 1;
+    }
+
+    // Called once a request is over, which for a websocket is once it is closed
+    void HTTPServer::EndRequestHandler(const struct mg_connection* conn, int replyStatusCode)
+    {
+        HTTPServer* pServer = (HTTPServer*)mg_get_request_info((struct mg_connection*)conn)->user_data;
+        std::lock_guard<std::mutex> lock(pServer->m_liveMutex);
+
+        pServer->m_livePages.erase(conn);
+    }
+
+#endif // USE_WEBSOCKET
 };
 
 #endif // USE_HTTP_SERVER
@@ -0,0 +1,347 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "JSONArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "libjson.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+namespace CreateJS
+{
+    // Every block is preceded by its size, padded to keep the block aligned
+    static const size_t kBlockHeaderSize = JSON_ARENA_ALIGNMENT;
+}
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    struct JSON_ARENA_CHUNK
+    {
+        char* pData;
+
+        size_t size;
+
+        size_t used;
+    };
+
+    static bool s_callbacksRegistered = false;
+    static std::atomic<bool> s_open(false);
+    static std::atomic<std::thread::id> s_owner;
+
+    // Only the owner adds or removes chunks. It does so under s_chunkMutex so that
+    // other threads can look at the chunks (to free a block) under the same lock.
+    // The chunks are ordered by address, so that every free can find its chunk by
+    // a binary search.
+    static std::mutex s_chunkMutex;
+    static std::vector<JSON_ARENA_CHUNK> s_chunks;
+    static size_t s_nextChunkSize = JSON_ARENA_MIN_CHUNK_SIZE;
+
+    // Chunk that blocks are allocated from (the latest one)
+    static size_t s_currentChunk = 0;
+
+    // Most recent block; it can grow in place
+    static char* s_pLastBlock = NULL;
+
+    static FCM::U_Int64 s_arenaAllocations = 0;
+    static FCM::U_Int64 s_bytesAllocated = 0;
+    static FCM::U_Int64 s_bytesReserved = 0;
+    static std::atomic<FCM::U_Int64> s_heapAllocations(0);
+    static std::atomic<FCM::U_Int64> s_skippedFrees(0);
+
+    static inline size_t AlignSize(size_t size)
+    {
+        return (size + (JSON_ARENA_ALIGNMENT - 1)) & ~(size_t)(JSON_ARENA_ALIGNMENT - 1);
+    }
+
+    static inline size_t GetBlockSize(void* pBlock)
+    {
+        return *(size_t*)((char*)pBlock - kBlockHeaderSize);
+    }
+
+    static inline bool IsOwner()
+    {
+        return s_open && (std::this_thread::get_id() == s_owner);
+    }
+
+    static bool IsBeforeChunk(const char* pData, const JSON_ARENA_CHUNK& chunk)
+    {
+        return pData < chunk.pData;
+    }
+
+    static bool IsInChunk(const char* pData)
+    {
+        std::vector<JSON_ARENA_CHUNK>::const_iterator it = 
+            std::upper_bound(s_chunks.begin(), s_chunks.end(), pData, IsBeforeChunk);
+
+        if (it == s_chunks.begin())
+        {
+            return false;
+        }
+
+        --it;
+        return (pData < it->pData + it->size);
+    }
+}
+
+
+/* -------------------------------------------------- JSONArena */
+
+namespace CreateJS
+{
+    void JSONArena::Open()
+    {
+        ASSERT(!s_open);
+
+        if (!s_callbacksRegistered)
+        {
+            libjson::register_memory_callbacks(Allocate, Reallocate, Free);
+            s_callbacksRegistered = true;
+        }
+
+        s_nextChunkSize = JSON_ARENA_MIN_CHUNK_SIZE;
+        s_pLastBlock = NULL;
+
+        s_arenaAllocations = 0;
+        s_bytesAllocated = 0;
+        s_bytesReserved = 0;
+        s_heapAllocations = 0;
+        s_skippedFrees = 0;
+
+        s_owner = std::this_thread::get_id();
+        s_open = true;
+    }
+
+
+    void JSONArena::Close()
+    {
+        ASSERT(IsOwner());
+
+        std::lock_guard<std::mutex> lock(s_chunkMutex);
+
+        for (size_t i = 0; i < s_chunks.size(); i++)
+        {
+            std::free(s_chunks[i].pData);
+        }
+        s_chunks.clear();
+        s_currentChunk = 0;
+        s_pLastBlock = NULL;
+
+        s_open = false;
+    }
+
+
+    void JSONArena::SetOwner(std::thread::id owner)
+    {
+        if (s_open)
+        {
+            s_owner = owner;
+        }
+    }
+
+
+    void JSONArena::GetStats(JSON_ARENA_STATS& stats)
+    {
+        std::lock_guard<std::mutex> lock(s_chunkMutex);
+
+        stats.arenaAllocations = s_arenaAllocations;
+        stats.heapAllocations = s_heapAllocations;
+        stats.skippedFrees = s_skippedFrees;
+        stats.bytesAllocated = s_bytesAllocated;
+        stats.bytesReserved = s_bytesReserved;
+        stats.chunkCount = (FCM::U_Int32)s_chunks.size();
+    }
+
+
+    void* JSONArena::Allocate(size_t size)
+    {
+        if (IsOwner())
+        {
+            return AllocateFromChunk(size);
+        }
+
+        s_heapAllocations++;
+
+        return std::malloc(size);
+    }
+
+
+    void* JSONArena::Reallocate(void* pBlock, size_t size)
+    {
+        if (pBlock == NULL)
+        {
+            return Allocate(size);
+        }
+
+        if (!IsArenaBlock(pBlock))
+        {
+            return std::realloc(pBlock, size);
+        }
+
+        size_t oldSize = GetBlockSize(pBlock);
+        void* pNewBlock;
+
+        if (size <= oldSize)
+        {
+            return pBlock;
+        }
+
+        if (IsOwner())
+        {
+            JSON_ARENA_CHUNK& chunk = s_chunks[s_currentChunk];
+
+            // Child arrays grow one element at a time; extend the latest block in place
+            if ((pBlock == s_pLastBlock) &&
+                (chunk.used + AlignSize(size) - AlignSize(oldSize) <= chunk.size))
+            {
+                chunk.used += AlignSize(size) - AlignSize(oldSize);
+                s_bytesAllocated += AlignSize(size) - AlignSize(oldSize);
+                *(size_t*)((char*)pBlock - kBlockHeaderSize) = size;
+                return pBlock;
+            }
+
+            pNewBlock = AllocateFromChunk(size);
+        }
+        else
+        {
+            s_heapAllocations++;
+            pNewBlock = std::malloc(size);
+        }
+
+        if (pNewBlock != NULL)
+        {
+            memcpy(pNewBlock, pBlock, oldSize);
+            s_skippedFrees++;
+        }
+
+        return pNewBlock;
+    }
+
+
+    void JSONArena::Free(void* pBlock)
+    {
+        if (pBlock == NULL)
+        {
+            return;
+        }
+
+        if (IsArenaBlock(pBlock))
+        {
+            // Released with the arena
+            s_skippedFrees++;
+            return;
+        }
+
+        std::free(pBlock);
+    }
+
+
+    void* JSONArena::AllocateFromChunk(size_t size)
+    {
+        size_t blockSize = kBlockHeaderSize + AlignSize(size);
+
+        if (s_chunks.empty() || (s_chunks[s_currentChunk].used + blockSize > s_chunks[s_currentChunk].size))
+        {
+            JSON_ARENA_CHUNK chunk;
+
+            chunk.size = (blockSize > s_nextChunkSize) ? blockSize : s_nextChunkSize;
+            chunk.used = 0;
+            chunk.pData = (char*)std::malloc(chunk.size);
+            if (chunk.pData == NULL)
+            {
+                return NULL;
+            }
+
+            if (s_nextChunkSize < JSON_ARENA_MAX_CHUNK_SIZE)
+            {
+                s_nextChunkSize *= 2;
+            }
+
+            std::lock_guard<std::mutex> lock(s_chunkMutex);
+
+            std::vector<JSON_ARENA_CHUNK>::iterator position = 
+                std::upper_bound(s_chunks.begin(), s_chunks.end(), chunk.pData, IsBeforeChunk);
+
+            s_currentChunk = position - s_chunks.begin();
+            s_chunks.insert(position, chunk);
+            s_bytesReserved += chunk.size;
+        }
+
+        JSON_ARENA_CHUNK& chunk = s_chunks[s_currentChunk];
+        char* pHeader = chunk.pData + chunk.used;
+
+        *(size_t*)pHeader = size;
+        chunk.used += blockSize;
+
+        s_pLastBlock = pHeader + kBlockHeaderSize;
+        s_arenaAllocations++;
+        s_bytesAllocated += AlignSize(size);
+
+        return s_pLastBlock;
+    }
+
+
+    bool JSONArena::IsArenaBlock(void* pBlock)
+    {
+        if (!s_open)
+        {
+            return false;
+        }
+
+        if (IsOwner())
+        {
+            // The owner is the only thread that changes the chunks
+            return IsInChunk((const char*)pBlock);
+        }
+
+        std::lock_guard<std::mutex> lock(s_chunkMutex);
+
+        return IsInChunk((const char*)pBlock);
+    }
+
+
+    /* -------------------------------------------------- ScopedJSONArena */
+
+    ScopedJSONArena::ScopedJSONArena(bool open)
+        : m_open(open)
+    {
+        if (m_open)
+        {
+            JSONArena::Open();
+        }
+    }
+
+
+    ScopedJSONArena::~ScopedJSONArena()
+    {
+        Close();
+    }
+
+
+    void ScopedJSONArena::Close()
+    {
+        if (m_open)
+        {
+            JSONArena::Close();
+            m_open = false;
+        }
+    }
+};
@@ -12,12 +12,21 @@
 #include "OutputWriter.h"
 #include "PluginConfiguration.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include "ApplicationFCMPublicIDs.h"
 #include "FCMPluginInterface.h"
 #include "libjson.h"
 #include "Utils.h"
+#include "AssetExportQueue.h"
+#include "PublishProfiler.h"
+#include "GzipWriter.h"
+#include "BitmapAtlas.h"
+#include "AssetStore.h"
+#include "PngImage.h"
+#include "TweenFitter.h"
+#include "MediaInfo/IBitmapInfo.h"
 #include "FrameElement/ISound.h"
 #include "Service/Image/IBitmapExportService.h"
 #include "Service/TextLayout/ITextLinesGeneratorService.h"
@@ -62,6 +71,7 @@ namespace CreateJS
             <script src=\"%s/runtime/resourcemanager.js\"></script> \r\n \
             <script src=\"%s/runtime/utils.js\"></script>     \r\n\
             <script src=\"%s/runtime/timelineanimator.js\"></script>    \r\n\
+            <script src=\"%s/runtime/binaryloader.js\"></script>     \r\n\
             <script src=\"%s/runtime/player.js\"></script>     \r\n\
             \r\n\
             <script type=\"text/javascript\"> \r\n\
@@ -91,18 +101,18 @@ namespace CreateJS
         </html>";
 
 
-    /* -------------------------------------------------- JSONOutputWriter */
+    /* -------------------------------------------------- BaseOutputWriter */
 
-    FCM::Result JSONOutputWriter::StartOutput(std::string& outputFileName)
+    FCM::Result BaseOutputWriter::StartOutput(std::string& outputFileName)
     {
         std::string parent;
-        std::string jsonFile;
+        std::string dataFile;
 
         Utils::GetParent(outputFileName, parent);
-        Utils::GetFileNameWithoutExtension(outputFileName, jsonFile);
+        Utils::GetFileNameWithoutExtension(outputFileName, dataFile);
         m_outputHTMLFile = outputFileName;
-        m_outputJSONFileName = jsonFile + ".json";
-        m_outputJSONFilePath = parent + jsonFile + ".json";
+        m_outputDataFileName = dataFile + m_dataFileExtension;
+        m_outputDataFilePath = parent + dataFile + m_dataFileExtension;
         m_outputImageFolder = parent + IMAGE_FOLDER;
         m_outputSoundFolder = parent + SOUND_FOLDER;
 
@@ -110,14 +120,158 @@ namespace CreateJS
     }
 
 
-    FCM::Result JSONOutputWriter::EndOutput()
+    FCM::Result BaseOutputWriter::EndOutput()
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        if (m_settings.precompressOutput)
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_COMPRESS);
+
+            res = PrecompressFile(m_outputDataFilePath);
+            if (FCM_SUCCESS_CODE(res))
+            {
+                res = PrecompressFile(m_outputHTMLFile);
+            }
+        }
+        else
+        {
+            // The preview server would otherwise serve the copies left by an earlier publish
+            Utils::Remove(m_outputDataFilePath + GZIP_FILE_EXT, m_pCallback);
+            Utils::Remove(m_outputHTMLFile + GZIP_FILE_EXT, m_pCallback);
+        }
+
+        return res;
+    }
+
+
+    void BaseOutputWriter::TakeOutputFiles(OutputFileMap& files)
+    {
+        files.clear();
+        files.swap(m_outputFiles);
+    }
+
+
+    FCM::Result BaseOutputWriter::SetBitmapScale(const std::string& libPathName, FCM::Double scale)
     {
+        m_bitmapScales[libPathName] = scale;
 
         return FCM_SUCCESS;
     }
 
 
-    FCM::Result JSONOutputWriter::StartDocument(
+    FCM::Result BaseOutputWriter::PrecompressFile(const std::string& filePath)
+    {
+        FCM::Result res;
+        std::string fileName;
+        FCM::U_Int64 inSize = 0;
+        FCM::U_Int64 outSize = 0;
+
+        Utils::GetFileName(filePath, fileName);
+
+        OutputFileMap::const_iterator it = m_outputFiles.find(fileName);
+        if (it != m_outputFiles.end())
+        {
+            // Kept files are compressed from memory, and the copy is kept as well
+            std::string compressed;
+            std::fstream file;
+
+            GzipWriter::Compress(it->second, compressed);
+
+            Utils::OpenFStream(filePath + GZIP_FILE_EXT, file, 
+                std::ios_base::trunc|std::ios_base::out|std::ios_base::binary, m_pCallback);
+            file.write(compressed.data(), compressed.size());
+            file.close();
+
+            if (file.fail())
+            {
+                Utils::Trace(m_pCallback, "Compressed file (%s) could not be written\n", (filePath + GZIP_FILE_EXT).c_str());
+                return FCM_GENERAL_ERROR;
+            }
+
+            inSize = it->second.size();
+            outSize = compressed.size();
+            KeepOutputFile(filePath + GZIP_FILE_EXT, compressed);
+        }
+        else
+        {
+            res = GzipWriter::CompressFile(filePath, filePath + GZIP_FILE_EXT, m_pCallback, &inSize, &outSize);
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+        }
+
+        PublishProfiler::AddBytes(PROFILE_PHASE_COMPRESS, outSize);
+
+        LOG(("[Precompress] %s: %llu -> %llu bytes\n", filePath.c_str(), inSize, outSize));
+
+        return FCM_SUCCESS;
+    }
+
+
+    BaseOutputWriter::BaseOutputWriter(
+        FCM::PIFCMCallback pCallback, 
+        const OUTPUT_SETTINGS& settings, 
+        const std::string& dataFileExtension)
+        : m_pCallback(pCallback),
+          m_settings(settings),
+          m_dataFileExtension(dataFileExtension),
+          m_HTMLOutput(NULL),
+          m_imageFileNameLabel(0),
+          m_soundFileNameLabel(0),
+          m_imageFolderCreated(false),
+          m_soundFolderCreated(false),
+          m_pAssetExportQueue(NULL),
+          m_pBitmapAtlas(NULL),
+          m_pAssetStore(NULL)
+    {
+        m_pAssetExportQueue = new AssetExportQueue(
+            m_pCallback, 
+            m_settings.assetExportThreads, 
+            m_settings.bitmapQuality);
+        ASSERT(m_pAssetExportQueue);
+
+        m_pAssetStore = new AssetStore(m_pCallback);
+        ASSERT(m_pAssetStore);
+
+        if (m_settings.packBitmaps)
+        {
+            m_pBitmapAtlas = new BitmapAtlas(m_pCallback);
+            ASSERT(m_pBitmapAtlas);
+        }
+    }
+
+
+    BaseOutputWriter::~BaseOutputWriter()
+    {
+        for (size_t i = 0; i < m_timelineWriters.size(); i++)
+        {
+            delete m_timelineWriters[i];
+        }
+
+        // Waits for any export still in flight
+        delete m_pAssetExportQueue;
+
+        delete m_pBitmapAtlas;
+
+        delete m_pAssetStore;
+
+        delete [] m_HTMLOutput;
+    }
+
+
+    ITimelineWriter* BaseOutputWriter::AddTimelineWriter(ITimelineWriter* pTimelineWriter)
+    {
+        ASSERT(pTimelineWriter);
+
+        m_timelineWriters.push_back(pTimelineWriter);
+
+        return pTimelineWriter;
+    }
+
+
+    FCM::Result BaseOutputWriter::CreateHTMLOutput(
         const DOM::Utils::COLOR& background,
         FCM::U_Int32 stageHeight, 
         FCM::U_Int32 stageWidth,
@@ -125,7 +279,7 @@ namespace CreateJS
     {
         FCM::U_Int32 backColor;
 
-        m_HTMLOutput = new char[strlen(htmlOutput) + FILENAME_MAX + (11 * strlen(RUNTIME_FOLDER_NAME)) + 50];
+        m_HTMLOutput = new char[strlen(htmlOutput) + FILENAME_MAX + (12 * strlen(RUNTIME_FOLDER_NAME)) + 50];
         if (m_HTMLOutput == NULL)
         {
             return FCM_MEM_NOT_AVAILABLE;
@@ -144,29 +298,18 @@ namespace CreateJS
             RUNTIME_FOLDER_NAME,
             RUNTIME_FOLDER_NAME,
             RUNTIME_FOLDER_NAME,
-            m_outputJSONFileName.c_str(), fps, stageWidth, stageHeight, backColor);
+            RUNTIME_FOLDER_NAME,
+            m_outputDataFileName.c_str(), fps, stageWidth, stageHeight, backColor);
 
         return FCM_SUCCESS;
     }
 
 
-    FCM::Result JSONOutputWriter::EndDocument()
+    FCM::Result BaseOutputWriter::WriteHTMLOutput()
     {
         std::fstream file;
-        m_pRootNode->push_back(*m_pShapeArray);
-        m_pRootNode->push_back(*m_pBitmapArray);
-        m_pRootNode->push_back(*m_pSoundArray);
-        m_pRootNode->push_back(*m_pTextArray);
-        m_pRootNode->push_back(*m_pTimelineArray);        
-
-        // Write the JSON file (overwrite file if it already exists)
-        Utils::OpenFStream(m_outputJSONFilePath, file, std::ios_base::trunc|std::ios_base::out, m_pCallback);
 
-        JSONNode firstNode(JSON_NODE);
-        firstNode.push_back(*m_pRootNode);
-
-        file << firstNode.write_formatted();
-        file.close();
+        ASSERT(m_HTMLOutput);
 
         // Write the HTML file (overwrite file if it already exists)
         Utils::OpenFStream(m_outputHTMLFile, file, std::ios_base::trunc|std::ios_base::out, m_pCallback);
@@ -174,12 +317,648 @@ namespace CreateJS
         file << m_HTMLOutput;
         file.close();
 
+        PublishProfiler::AddBytes(PROFILE_PHASE_SERIALIZE, strlen(m_HTMLOutput));
+
+        KeepOutputFile(m_outputHTMLFile, m_HTMLOutput);
+
         delete [] m_HTMLOutput;
+        m_HTMLOutput = NULL;
 
         return FCM_SUCCESS;
     }
 
 
+    void BaseOutputWriter::KeepOutputFile(const std::string& filePath, const std::string& content)
+    {
+        std::string fileName;
+
+        if (!m_settings.keepOutputFiles)
+        {
+            return;
+        }
+
+        Utils::GetFileName(filePath, fileName);
+        m_outputFiles[fileName] = content;
+    }
+
+
+    FCM::Result BaseOutputWriter::ExportBitmap(
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width,
+        std::string& bitmapRelPath,
+        FCM::Boolean& packed,
+        ATLAS_REGION& region)
+    {
+        FCM::Result res;
+        std::string name;
+        std::string bitmapExportPath = m_outputImageFolder + "/";
+        FCM::Boolean exportNeeded = false;
+
+        packed = false;
+
+        if (IsPackable(libPathName, height, width))
+        {
+            if (!m_pBitmapAtlas->Find(libPathName, region))
+            {
+                res = CreateImageFolder();
+                if (FCM_FAILURE_CODE(res))
+                {
+                    return res;
+                }
+
+                // The bitmap is exported as usual and drawn on its page once all
+                // the exports have completed
+                CreateImageFileName(libPathName, name);
+                SetImageExportFileName(libPathName, name);
+                bitmapExportPath += name;
+
+                m_pBitmapAtlas->Add(libPathName, bitmapExportPath, width, height, region);
+
+                res = m_pAssetExportQueue->ExportBitmap(pMediaItem, bitmapExportPath);
+                ASSERT(FCM_SUCCESS_CODE(res));
+            }
+
+            BitmapAtlas::GetPageFileName(region.page, name);
+
+            bitmapRelPath = "./";
+            bitmapRelPath += IMAGE_FOLDER;
+            bitmapRelPath += "/";
+            bitmapRelPath += name;
+
+            packed = true;
+
+            return FCM_SUCCESS;
+        }
+            
+        FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name);
+        if (!alreadyExported)
+        {
+            res = CreateImageFolder();
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+            CreateImageFileName(libPathName, name);
+            SetImageExportFileName(libPathName, name);
+            exportNeeded = true;
+        }
+
+        bitmapExportPath += name;
+            
+        bitmapRelPath = "./";
+        bitmapRelPath += IMAGE_FOLDER;
+        bitmapRelPath += "/";
+        bitmapRelPath += name;
+
+        if (exportNeeded)
+        {
+            // The file name is already decided, so the encoding can finish later
+            res = m_pAssetExportQueue->ExportBitmap(pMediaItem, bitmapExportPath);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            // JPEG files are left as they are (see IsPackable())
+            if (m_settings.resampleBitmaps && 
+                (name.compare(name.size() - strlen(PNG_FILE_EXT), std::string::npos, PNG_FILE_EXT) == 0))
+            {
+                RESAMPLE_CANDIDATE candidate;
+
+                candidate.libPathName = libPathName;
+                candidate.filePath = bitmapExportPath;
+                candidate.relPath = bitmapRelPath;
+
+                m_resampleCandidates.push_back(candidate);
+            }
+
+            m_pAssetStore->Add(BITMAP_ASSET, libPathName, name, bitmapExportPath, bitmapRelPath);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BaseOutputWriter::ExportSound(
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem,
+        std::string& soundRelPath)
+    {
+        FCM::Result res;
+        std::string name;
+        std::string soundExportPath = m_outputSoundFolder + "/";
+        FCM::Boolean exportNeeded = false;
+
+        FCM::Boolean alreadyExported = GetSoundExportFileName(libPathName, name);
+
+        if (!alreadyExported)
+        {
+            if (!m_soundFolderCreated)
+            {
+                res = Utils::CreateDir(m_outputSoundFolder, m_pCallback);
+                if (!(FCM_SUCCESS_CODE(res)))
+                {
+                    Utils::Trace(m_pCallback, "Output sound folder (%s) could not be created\n", m_outputSoundFolder.c_str());
+                    return res;
+                }
+                m_soundFolderCreated = true;
+            }
+
+            CreateSoundFileName(libPathName, name);
+            SetSoundExportFileName(libPathName, name);
+            exportNeeded = true;
+        }
+
+        soundExportPath += name;
+
+        soundRelPath = "./";
+        soundRelPath += SOUND_FOLDER;
+        soundRelPath += "/";
+        soundRelPath += name;
+
+        if (exportNeeded)
+        {
+            res = m_pAssetExportQueue->ExportSound(pMediaItem, soundExportPath);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            m_pAssetStore->Add(SOUND_ASSET, libPathName, name, soundExportPath, soundRelPath);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BaseOutputWriter::FinishAssetExport()
+    {
+        FCM::Result res;
+
+        // All the assets referenced by the document have to be on disk before it is complete
+        res = m_pAssetExportQueue->Join();
+        if (FCM_FAILURE_CODE(res))
+        {
+            Utils::Trace(m_pCallback, "One or more bitmaps/sounds could not be exported\n");
+        }
+
+        if (m_pBitmapAtlas)
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_PACK_BITMAPS);
+
+            FCM::Result atlasRes = m_pBitmapAtlas->WritePages(m_outputImageFolder);
+            if (FCM_FAILURE_CODE(atlasRes))
+            {
+                Utils::Trace(m_pCallback, "One or more bitmaps could not be drawn on their atlas page\n");
+                if (FCM_SUCCESS_CODE(res))
+                {
+                    res = atlasRes;
+                }
+            }
+        }
+
+        if (!m_resampleCandidates.empty())
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_RESAMPLE_BITMAPS);
+
+            FCM::Result resampleRes = ResampleBitmaps();
+            if (FCM_SUCCESS_CODE(res))
+            {
+                res = resampleRes;
+            }
+        }
+
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_DEDUPLICATE_ASSETS);
+
+            // Bitmaps and sounds imported under several names are kept only once
+            m_pAssetStore->Deduplicate(m_assetAliases);
+        }
+
+        return res;
+    }
+
+
+    FCM::Result BaseOutputWriter::ResampleBitmaps()
+    {
+        FCM::Result res = FCM_SUCCESS;
+        FCM::U_Int32 resampledCount = 0;
+
+        for (size_t i = 0; i < m_resampleCandidates.size(); i++)
+        {
+            const RESAMPLE_CANDIDATE& candidate = m_resampleCandidates[i];
+            std::map<std::string, FCM::Double>::const_iterator it = m_bitmapScales.find(candidate.libPathName);
+            PngImage image;
+            FCM::U_Int64 size = 0;
+
+            // Bitmaps that are not drawn on stage (e.g. only used by scripts) keep their size
+            if (it == m_bitmapScales.end())
+            {
+                continue;
+            }
+
+            FCM::Double factor = it->second * m_settings.resampleHeadroom;
+            if (factor >= 1)
+            {
+                continue;
+            }
+
+            if (FCM_FAILURE_CODE(image.Read(candidate.filePath, m_pCallback)))
+            {
+                // Its export failed, which has already been reported
+                continue;
+            }
+
+            FCM::U_Int32 width = (FCM::U_Int32)ceil(image.GetWidth() * factor);
+            FCM::U_Int32 height = (FCM::U_Int32)ceil(image.GetHeight() * factor);
+
+            width = (width > 0) ? width : 1;
+            height = (height > 0) ? height : 1;
+
+            if ((width == image.GetWidth()) && (height == image.GetHeight()))
+            {
+                continue;
+            }
+
+            LOG(("[ResampleBitmaps] %s from %ux%u to %ux%u\n", candidate.libPathName.c_str(), 
+                image.GetWidth(), image.GetHeight(), width, height));
+
+            image.Resize(width, height);
+
+            FCM::Result writeRes = image.Write(candidate.filePath, m_pCallback, &size);
+            if (FCM_FAILURE_CODE(writeRes))
+            {
+                Utils::Trace(m_pCallback, "Bitmap (%s) could not be resampled\n", candidate.filePath.c_str());
+                if (FCM_SUCCESS_CODE(res))
+                {
+                    res = writeRes;
+                }
+                continue;
+            }
+
+            PublishProfiler::AddBytes(PROFILE_PHASE_RESAMPLE_BITMAPS, size);
+
+            RESAMPLED_SIZE& resampled = m_resampledBitmaps[candidate.relPath];
+
+            resampled.width = width;
+            resampled.height = height;
+
+            resampledCount++;
+        }
+
+        if (resampledCount > 0)
+        {
+            Utils::Trace(m_pCallback, "%u bitmaps were written at the size they are drawn at\n", resampledCount);
+        }
+
+        return res;
+    }
+
+
+    FCM::Result BaseOutputWriter::CreateImageFolder()
+    {
+        FCM::Result res;
+
+        if (!m_imageFolderCreated)
+        {
+            res = Utils::CreateDir(m_outputImageFolder, m_pCallback);
+            if (!(FCM_SUCCESS_CODE(res)))
+            {
+                Utils::Trace(m_pCallback, "Output image folder (%s) could not be created\n", m_outputImageFolder.c_str());
+                return res;
+            }
+            m_imageFolderCreated = true;
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Boolean BaseOutputWriter::IsPackable(
+        const std::string& libPathName,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width)
+    {
+        size_t pos = libPathName.rfind(".");
+
+        if (!m_pBitmapAtlas || !BitmapAtlas::CanPack(width, height))
+        {
+            return false;
+        }
+
+        // JPEG bitmaps are exported as they are, as there is no decoder for them here
+        // (see CreateImageFileName())
+        return (pos == std::string::npos) || (libPathName.substr(pos + 1) != "jpg");
+    }
+
+
+    FCM::Result BaseOutputWriter::CreateImageFileName(const std::string& libPathName, std::string& name)
+    {
+        std::string str;
+        size_t pos;
+        std::string fileLabel;
+
+        fileLabel = Utils::ToString(m_imageFileNameLabel);
+        name = "Image" + fileLabel;
+        m_imageFileNameLabel++;
+
+        str = libPathName;
+
+        // DOM APIs do not provide a way to get the compression of the image.
+        // For time being, we will use the extension of the library item name.
+        pos = str.rfind(".");
+        if (pos != std::string::npos)
+        {
+            if (str.substr(pos + 1) == "jpg")
+            {
+                name += ".jpg";
+            }
+            else if (str.substr(pos + 1) == "png")
+            {
+                name += ".png";
+            }
+            else
+            {
+                name += ".png";
+            }
+        }
+        else
+        {
+            name += ".png";
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result BaseOutputWriter::CreateSoundFileName(const std::string& libPathName, std::string& name)
+    {
+        std::string str;
+        size_t pos;
+        std::string fileLabel;
+
+        fileLabel = Utils::ToString(m_soundFileNameLabel);
+        name = "Sound" + fileLabel;
+        m_soundFileNameLabel++;
+
+        str = libPathName;
+
+        // DOM APIs do not provide a way to get the compression of the sound.
+        // For time being, we will use the extension of the library item name.
+        pos = str.rfind(".");
+        if (pos != std::string::npos)
+        {
+            if (str.substr(pos + 1) == "wav")
+            {
+                name += ".WAV";
+            }
+            else if (str.substr(pos + 1) == "mp3")
+            {
+                name += ".MP3";
+            }
+            else
+            {
+                name += ".MP3";
+            }
+        }
+        else
+        {
+            name += ".MP3";
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Boolean BaseOutputWriter::GetImageExportFileName(const std::string& libPathName, std::string& name)
+    {
+        std::map<std::string, std::string>::iterator it = m_imageMap.find(libPathName);
+
+        name = "";
+
+        if (it != m_imageMap.end())
+        {
+            // Image already exported
+            name = it->second;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    void BaseOutputWriter::SetImageExportFileName(const std::string& libPathName, const std::string& name)
+    {
+        // Assumption: Name is not already present in the map
+        ASSERT(m_imageMap.find(libPathName) == m_imageMap.end());
+
+        m_imageMap.insert(std::pair<std::string, std::string>(libPathName, name));
+    }
+
+
+    FCM::Boolean BaseOutputWriter::GetSoundExportFileName(const std::string& libPathName, std::string& name)
+    {
+        std::map<std::string, std::string>::iterator it = m_soundMap.find(libPathName);
+
+        name = "";
+
+        if (it != m_soundMap.end())
+        {
+            // Sound already exported
+            name = it->second;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    void BaseOutputWriter::SetSoundExportFileName(const std::string& libPathName, const std::string& name)
+    {
+        ASSERT(m_soundMap.find(libPathName) == m_soundMap.end());
+
+        m_soundMap.insert(std::pair<std::string, std::string>(libPathName, name));
+    }
+
+
+    /* -------------------------------------------------- JSONOutputWriter */
+
+    static const char* kBase64Digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Encodes a path for Graphics.decodePath(): each instruction is one base64 digit
+    // (command << 3, bit 2 set for three-digit values) followed by its values, each a
+    // sign bit and magnitude. Moves are absolute; every other value is a delta from the
+    // previous x or y. Fails if a value is out of range.
+    static bool EncodeCompactPath(
+        const std::vector<FCM::Byte>& cmds, 
+        const std::vector<FCM::S_Int32>& coords, 
+        std::string& encoded)
+    {
+        FCM::S_Int32 deltas[4];
+        FCM::S_Int32 x = 0;
+        FCM::S_Int32 y = 0;
+        size_t c = 0;
+
+        encoded.clear();
+        encoded.reserve(cmds.size() + coords.size() * 2);
+
+        for (size_t i = 0; i < cmds.size(); i++)
+        {
+            FCM::U_Int32 count = (cmds[i] == COMPACT_PATH_QUAD_CURVE_TO) ? 4 : 2;
+            bool wide = false;
+
+            if (cmds[i] == COMPACT_PATH_MOVE_TO)
+            {
+                x = y = 0;
+            }
+
+            for (FCM::U_Int32 k = 0; k < count; k++)
+            {
+                FCM::S_Int32& last = (k % 2 == 0) ? x : y;
+                FCM::S_Int32 value = coords[c + k];
+                FCM::S_Int32 magnitude;
+
+                deltas[k] = value - last;
+                last = value;
+
+                magnitude = (deltas[k] < 0) ? -deltas[k] : deltas[k];
+                if (magnitude > MAX_COMPACT_PATH_VALUE)
+                {
+                    return false;
+                }
+                if (magnitude > MAX_SHORT_COMPACT_PATH_VALUE)
+                {
+                    wide = true;
+                }
+            }
+
+            encoded += kBase64Digits[(cmds[i] << 3) | (wide ? 4 : 0)];
+
+            for (FCM::U_Int32 k = 0; k < count; k++)
+            {
+                FCM::U_Int32 sign = (deltas[k] < 0) ? 32 : 0;
+                FCM::U_Int32 magnitude = (FCM::U_Int32)((deltas[k] < 0) ? -deltas[k] : deltas[k]);
+
+                if (wide)
+                {
+                    encoded += kBase64Digits[sign | (magnitude >> 12)];
+                    encoded += kBase64Digits[(magnitude >> 6) & 63];
+                }
+                else
+                {
+                    encoded += kBase64Digits[sign | (magnitude >> 6)];
+                }
+                encoded += kBase64Digits[magnitude & 63];
+            }
+
+            c += count;
+        }
+
+        return true;
+    }
+
+
+    FCM::Result JSONOutputWriter::StartDocument(
+        const DOM::Utils::COLOR& background,
+        FCM::U_Int32 stageHeight, 
+        FCM::U_Int32 stageWidth,
+        FCM::U_Int32 fps)
+    {
+        FCM::Result res;
+
+        res = CreateHTMLOutput(background, stageHeight, stageWidth, fps);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return res;
+        }
+
+        if (m_settings.streamOutput)
+        {
+            // Write the document prologue now. Shapes follow as soon as they are defined.
+            res = OpenStream(
+                m_outputDataFilePath, 
+                m_jsonStream, 
+                m_pJsonStreamBuffer, 
+                std::ios_base::trunc|std::ios_base::out);
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+
+            m_jsonStream << "{\"DOMDocument\":{\"Shape\":[";
+
+            // Timelines must come after all the resources in the document, so they 
+            // are parked in a spill file until EndDocument().
+            m_timelineSpillFilePath = m_outputDataFilePath + TIMELINE_SPILL_FILE_EXT;
+            res = OpenStream(
+                m_timelineSpillFilePath, 
+                m_timelineStream, 
+                m_pTimelineStreamBuffer, 
+                std::ios_base::trunc|std::ios_base::in|std::ios_base::out|std::ios_base::binary);
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result JSONOutputWriter::EndDocument()
+    {
+        FCM::Result res = FCM_SUCCESS;
+        std::fstream file;
+
+        res = FinishAssetExport();
+
+        if (m_settings.streamOutput)
+        {
+            FCM::Result streamRes = EndStreamedDocument();
+            if (FCM_SUCCESS_CODE(res))
+            {
+                res = streamRes;
+            }
+        }
+        else
+        {
+            if (m_morphShapes)
+            {
+                WriteMorphs();
+            }
+
+            m_pRootNode->push_back(*m_pShapeArray);
+            m_pRootNode->push_back(*m_pBitmapArray);
+            m_pRootNode->push_back(*m_pSoundArray);
+            m_pRootNode->push_back(*m_pTextArray);
+
+            JSONNode aliases(JSON_NODE);
+            CreateAliasNode(aliases);
+            m_pRootNode->push_back(aliases);
+
+            JSONNode resampled(JSON_NODE);
+            CreateResampledNode(resampled);
+            m_pRootNode->push_back(resampled);
+
+            m_pRootNode->push_back(*m_pTimelineArray);        
+
+            // Write the JSON file (overwrite file if it already exists)
+            Utils::OpenFStream(m_outputDataFilePath, file, std::ios_base::trunc|std::ios_base::out, m_pCallback);
+
+            JSONNode firstNode(JSON_NODE);
+            firstNode.push_back(*m_pRootNode);
+
+            std::string output = firstNode.write_formatted();
+            file << output;
+            file.close();
+
+            PublishProfiler::AddBytes(PROFILE_PHASE_SERIALIZE, output.size());
+
+            KeepOutputFile(m_outputDataFilePath, output);
+        }
+
+        WriteHTMLOutput();
+
+        return res;
+    }
+
+
     FCM::Result JSONOutputWriter::StartDefineTimeline()
     {
         return FCM_SUCCESS;
@@ -195,7 +974,19 @@ namespace CreateJS
 
         pWriter->Finish(resId, pName);
 
-        m_pTimelineArray->push_back(*(pWriter->GetRoot()));
+        if (m_settings.streamOutput)
+        {
+            if (m_streamedTimelineCount > 0)
+            {
+                m_timelineStream << comma;
+            }
+            m_timelineStream << pWriter->GetRoot()->write();
+            m_streamedTimelineCount++;
+        }
+        else
+        {
+            m_pTimelineArray->push_back(*(pWriter->GetRoot()));
+        }
 
         return FCM_SUCCESS;
     }
@@ -210,6 +1001,11 @@ namespace CreateJS
         ASSERT(m_pathArray);
         m_pathArray->set_name("path");
 
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.StartShape();
+        }
+
         return FCM_SUCCESS;
     }
 
@@ -220,7 +1016,32 @@ namespace CreateJS
         m_shapeElem->push_back(JSONNode(("charid"), CreateJS::Utils::ToString(resId)));
         m_shapeElem->push_back(*m_pathArray);
 
-        m_pShapeArray->push_back(*m_shapeElem);
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.EndShape(resId);
+        }
+
+        if (m_settings.streamOutput)
+        {
+            if (m_streamedShapeCount > 0)
+            {
+                m_jsonStream << comma;
+            }
+            std::string shape = m_shapeElem->write();
+            m_jsonStream << shape;
+            m_streamedShapeCount++;
+
+            m_shapeSizes[resId] = (FCM::U_Int32)shape.size();
+        }
+        else
+        {
+            // Written out only if the dedup report asks for the size
+            m_shapeIndexes[resId] = (FCM::U_Int32)m_pShapeArray->size();
+
+            m_pShapeArray->push_back(*m_shapeElem);
+
+            PublishProfiler::RecordPeak(PROFILE_COUNTER_SHAPES_HELD, m_pShapeArray->size());
+        }
 
         delete m_pathArray;
         delete m_shapeElem;
@@ -229,6 +1050,28 @@ namespace CreateJS
     }
 
 
+    FCM::U_Int32 JSONOutputWriter::GetShapeSize(FCM::U_Int32 resId)
+    {
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32>::iterator it = m_shapeSizes.find(resId);
+
+        if (it != m_shapeSizes.end())
+        {
+            return it->second;
+        }
+
+        it = m_shapeIndexes.find(resId);
+        if (it == m_shapeIndexes.end())
+        {
+            return 0;
+        }
+
+        FCM::U_Int32 size = (FCM::U_Int32)(*m_pShapeArray)[it->second].write().size();
+        m_shapeSizes[resId] = size;
+
+        return size;
+    }
+
+
     // Start of fill region definition
     FCM::Result JSONOutputWriter::StartDefineFill()
     {
@@ -236,6 +1079,13 @@ namespace CreateJS
         ASSERT(m_pathElem);
 
         m_pathCmdStr.clear();
+        m_pathCmds.clear();
+        m_pathCoords.clear();
+
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.AddCommand('F');
+        }
 
         return FCM_SUCCESS;
     }
@@ -250,6 +1100,11 @@ namespace CreateJS
         m_pathElem->push_back(JSONNode("color", colorStr.c_str()));
         m_pathElem->push_back(JSONNode("colorOpacity", colorOpacityStr.c_str()));
 
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.AddColor(color);
+        }
+
         return FCM_SUCCESS;
     }
 
@@ -264,63 +1119,36 @@ namespace CreateJS
         DOM::LibraryItem::PIMediaItem pMediaItem)
     {
         FCM::Result res;
-        std::string name;
         JSONNode bitmapElem(JSON_NODE);
-        std::string bitmapPath;
-        std::string bitmapName;
 
         bitmapElem.set_name("image");
+
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.SetNotMorphable();
+        }
         
         bitmapElem.push_back(JSONNode(("height"), CreateJS::Utils::ToString(height)));
         bitmapElem.push_back(JSONNode(("width"), CreateJS::Utils::ToString(width)));
 
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
         std::string bitmapRelPath;
-        std::string bitmapExportPath = m_outputImageFolder + "/";
-            
-        FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name);
-        if (!alreadyExported)
+        FCM::Boolean packed;
+        ATLAS_REGION region;
+
+        res = ExportBitmap(libPathName, pMediaItem, height, width, bitmapRelPath, packed, region);
+        if (FCM_FAILURE_CODE(res))
         {
-            if (!m_imageFolderCreated)
-            {
-                res = Utils::CreateDir(m_outputImageFolder, m_pCallback);
-                if (!(FCM_SUCCESS_CODE(res)))
-                {
-                    Utils::Trace(m_pCallback, "Output image folder (%s) could not be created\n", m_outputImageFolder.c_str());
-                    return res;
-                }
-                m_imageFolderCreated = true;
-            }
-            CreateImageFileName(libPathName, name);
-            SetImageExportFileName(libPathName, name);
+            return res;
         }
 
-        bitmapExportPath += name;
-            
-        bitmapRelPath = "./";
-        bitmapRelPath += IMAGE_FOLDER;
-        bitmapRelPath += "/";
-        bitmapRelPath += name;
-
-        res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
+        bitmapElem.push_back(JSONNode(("bitmapPath"), bitmapRelPath)); 
 
-        FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> bitmapExportService = pUnk;
-        if (bitmapExportService)
+        if (packed)
         {
-            FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
-            FCM::StringRep16 pFilePath = Utils::ToString16(bitmapExportPath, m_pCallback);
-            res = bitmapExportService->ExportToFile(pMediaItem, pFilePath, 100);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            pCalloc = CreateJS::Utils::GetCallocService(m_pCallback);
-            ASSERT(pCalloc.m_Ptr != NULL);
-
-            pCalloc->Free(pFilePath);
+            bitmapElem.push_back(JSONNode(("atlasX"), CreateJS::Utils::ToString(region.x)));
+            bitmapElem.push_back(JSONNode(("atlasY"), CreateJS::Utils::ToString(region.y)));
         }
 
-        bitmapElem.push_back(JSONNode(("bitmapPath"), bitmapRelPath)); 
-
         DOM::Utils::MATRIX2D matrix1 = matrix;
         matrix1.a /= 20.0;
         matrix1.b /= 20.0;
@@ -328,7 +1156,7 @@ namespace CreateJS
         matrix1.d /= 20.0;
 
         bitmapElem.push_back(JSONNode(("patternUnits"), "userSpaceOnUse"));
-        bitmapElem.push_back(JSONNode(("patternTransform"), Utils::ToString(matrix1).c_str()));
+        bitmapElem.push_back(JSONNode(("patternTransform"), Utils::ToString(matrix1, m_settings.numberPrecision).c_str()));
 
         m_pathElem->push_back(bitmapElem);
 
@@ -347,19 +1175,24 @@ namespace CreateJS
         ASSERT(m_gradientColor);
         m_gradientColor->set_name("linearGradient");
 
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.SetNotMorphable();
+        }
+
         point.x = -GRADIENT_VECTOR_CONSTANT / 20;
         point.y = 0;
         Utils::TransformPoint(matrix, point, point);
 
-        m_gradientColor->push_back(JSONNode("x1", Utils::ToString((double) (point.x))));
-        m_gradientColor->push_back(JSONNode("y1", Utils::ToString((double) (point.y))));
+        m_gradientColor->push_back(JSONNode("x1", Utils::ToString((double) (point.x), m_settings.numberPrecision)));
+        m_gradientColor->push_back(JSONNode("y1", Utils::ToString((double) (point.y), m_settings.numberPrecision)));
 
         point.x = GRADIENT_VECTOR_CONSTANT / 20;
         point.y = 0;
         Utils::TransformPoint(matrix, point, point);
 
-        m_gradientColor->push_back(JSONNode("x2", Utils::ToString((double) (point.x))));
-        m_gradientColor->push_back(JSONNode("y2", Utils::ToString((double) (point.y))));
+        m_gradientColor->push_back(JSONNode("x2", Utils::ToString((double) (point.x), m_settings.numberPrecision)));
+        m_gradientColor->push_back(JSONNode("y2", Utils::ToString((double) (point.y), m_settings.numberPrecision)));
 
         m_gradientColor->push_back(JSONNode("spreadMethod", Utils::ToString(spread)));
 
@@ -380,7 +1213,7 @@ namespace CreateJS
         
         offset = (float)((colorPoint.pos * 100) / 255.0);
 
-        stopEntry.push_back(JSONNode("offset", Utils::ToString((double) offset)));
+        stopEntry.push_back(JSONNode("offset", Utils::ToString((double) offset, m_settings.numberPrecision)));
         stopEntry.push_back(JSONNode("stopColor", Utils::ToString(colorPoint.color)));
         stopEntry.push_back(JSONNode("stopOpacity", Utils::ToString((double)(colorPoint.color.alpha / 255.0))));
 
@@ -417,6 +1250,11 @@ namespace CreateJS
         ASSERT(m_gradientColor);
         m_gradientColor->set_name("radialGradient");
 
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.SetNotMorphable();
+        }
+
         point.x = 0;
         point.y = 0;
         Utils::TransformPoint(matrix, point, point1);
@@ -436,9 +1274,9 @@ namespace CreateJS
 
         m_gradientColor->push_back(JSONNode("cx", "0"));
         m_gradientColor->push_back(JSONNode("cy", "0"));
-        m_gradientColor->push_back(JSONNode("r", Utils::ToString((double) r)));
-        m_gradientColor->push_back(JSONNode("fx", Utils::ToString((double) fx)));
-        m_gradientColor->push_back(JSONNode("fy", Utils::ToString((double) fy)));
+        m_gradientColor->push_back(JSONNode("r", Utils::ToString((double) r, m_settings.numberPrecision)));
+        m_gradientColor->push_back(JSONNode("fx", Utils::ToString((double) fx, m_settings.numberPrecision)));
+        m_gradientColor->push_back(JSONNode("fy", Utils::ToString((double) fy, m_settings.numberPrecision)));
 
         FCM::Float scaleFactor = (GRADIENT_VECTOR_CONSTANT / 20) / r;
         DOM::Utils::MATRIX2D matrix1 = {};
@@ -449,7 +1287,7 @@ namespace CreateJS
         matrix1.tx = matrix.tx;
         matrix1.ty = matrix.ty;
 
-        m_gradientColor->push_back(JSONNode("gradientTransform", Utils::ToString(matrix1)));
+        m_gradientColor->push_back(JSONNode("gradientTransform", Utils::ToString(matrix1, m_settings.numberPrecision)));
         m_gradientColor->push_back(JSONNode("spreadMethod", Utils::ToString(spread)));
 
         m_stopPointArray = new JSONNode(JSON_ARRAY);
@@ -485,44 +1323,33 @@ namespace CreateJS
     {
         if (m_firstSegment)
         {
+            if (m_settings.compactPaths)
+            {
+                // Text paths write their move in StartDefinePath()
+                AppendCommand(COMPACT_PATH_MOVE_TO);
+            }
+
             if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
             {
-                m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.line.endPoint1.x)));
-                m_pathCmdStr.append(space);
-                m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.line.endPoint1.y)));
-                m_pathCmdStr.append(space);
+                AppendPoint(segment.line.endPoint1);
             }
             else
             {
-                m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.anchor1.x)));
-                m_pathCmdStr.append(space);
-                m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.anchor1.y)));
-                m_pathCmdStr.append(space);
+                AppendPoint(segment.quadBezierCurve.anchor1);
             }
             m_firstSegment = false;
         }
 
         if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
         {
-            m_pathCmdStr.append(lineTo);
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.line.endPoint2.x)));
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.line.endPoint2.y)));
-            m_pathCmdStr.append(space);
+            AppendCommand(COMPACT_PATH_LINE_TO);
+            AppendPoint(segment.line.endPoint2);
         }
         else
         {
-            m_pathCmdStr.append(bezierCurveTo);
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.control.x)));
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.control.y)));
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.anchor2.x)));
-            m_pathCmdStr.append(space);
-            m_pathCmdStr.append(CreateJS::Utils::ToString((double)(segment.quadBezierCurve.anchor2.y)));
-            m_pathCmdStr.append(space);
+            AppendCommand(COMPACT_PATH_QUAD_CURVE_TO);
+            AppendPoint(segment.quadBezierCurve.control);
+            AppendPoint(segment.quadBezierCurve.anchor2);
         }
 
         return FCM_SUCCESS;
@@ -592,6 +1419,13 @@ namespace CreateJS
         ASSERT(m_pathElem);
 
         m_pathCmdStr.clear();
+        m_pathCmds.clear();
+        m_pathCoords.clear();
+
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.AddCommand('S');
+        }
         StartDefinePath();
 
         return FCM_SUCCESS;
@@ -601,11 +1435,11 @@ namespace CreateJS
     // End of a stroke 
     FCM::Result JSONOutputWriter::EndDefineStroke()
     {
-        m_pathElem->push_back(JSONNode("d", m_pathCmdStr));
+        WritePathData();
 
         if (m_strokeStyle.type == SOLID_STROKE_STYLE_TYPE)
         {
-            m_pathElem->push_back(JSONNode("strokeWidth", CreateJS::Utils::ToString((double)m_strokeStyle.solidStrokeStyle.thickness).c_str()));
+            m_pathElem->push_back(JSONNode("strokeWidth", CreateJS::Utils::ToString((double)m_strokeStyle.solidStrokeStyle.thickness, m_settings.numberPrecision).c_str()));
             m_pathElem->push_back(JSONNode("fill", "none"));
             m_pathElem->push_back(JSONNode("strokeLinecap", Utils::ToString(m_strokeStyle.solidStrokeStyle.capStyle.type).c_str()));
             m_pathElem->push_back(JSONNode("strokeLinejoin", Utils::ToString(m_strokeStyle.solidStrokeStyle.joinStyle.type).c_str()));
@@ -614,9 +1448,25 @@ namespace CreateJS
             {
                 m_pathElem->push_back(JSONNode(
                     "stroke-miterlimit", 
-                    CreateJS::Utils::ToString((double)m_strokeStyle.solidStrokeStyle.joinStyle.miterJoinProp.miterLimit).c_str()));
+                    CreateJS::Utils::ToString((double)m_strokeStyle.solidStrokeStyle.joinStyle.miterJoinProp.miterLimit, m_settings.numberPrecision).c_str()));
             }
             m_pathElem->push_back(JSONNode("pathType", "Stroke"));
+
+            if (m_morphShapes)
+            {
+                // The caps and joins are copied from the first key
+                m_shapeMorpher.AddCommand((char)('0' + m_strokeStyle.solidStrokeStyle.capStyle.type));
+                m_shapeMorpher.AddCommand((char)('0' + m_strokeStyle.solidStrokeStyle.joinStyle.type));
+                m_shapeMorpher.AddValue(m_strokeStyle.solidStrokeStyle.thickness);
+                if (m_strokeStyle.solidStrokeStyle.joinStyle.type == DOM::Utils::MITER_JOIN)
+                {
+                    m_shapeMorpher.AddValue(m_strokeStyle.solidStrokeStyle.joinStyle.miterJoinProp.miterLimit);
+                }
+            }
+        }
+        else if (m_morphShapes)
+        {
+            m_shapeMorpher.SetNotMorphable();
         }
         m_pathArray->push_back(*m_pathElem);
 
@@ -639,7 +1489,7 @@ namespace CreateJS
     // End of fill style definition
     FCM::Result JSONOutputWriter::EndDefineFill()
     {
-        m_pathElem->push_back(JSONNode("d", m_pathCmdStr));
+        WritePathData();
         m_pathElem->push_back(JSONNode("pathType", JSON_TEXT("Fill")));
         m_pathElem->push_back(JSONNode("stroke", JSON_TEXT("none")));
 
@@ -663,9 +1513,6 @@ namespace CreateJS
     {
         FCM::Result res;
         JSONNode bitmapElem(JSON_NODE);
-        std::string bitmapPath;
-        std::string bitmapName;
-        std::string name;
 
         bitmapElem.set_name("image");
         
@@ -673,53 +1520,25 @@ namespace CreateJS
         bitmapElem.push_back(JSONNode(("height"), CreateJS::Utils::ToString(height)));
         bitmapElem.push_back(JSONNode(("width"), CreateJS::Utils::ToString(width)));
 
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
         std::string bitmapRelPath;
-        std::string bitmapExportPath = m_outputImageFolder + "/";
-            
-        FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name);
-        if (!alreadyExported)
+        FCM::Boolean packed;
+        ATLAS_REGION region;
+
+        res = ExportBitmap(libPathName, pMediaItem, height, width, bitmapRelPath, packed, region);
+        if (FCM_FAILURE_CODE(res))
         {
-            if (!m_imageFolderCreated)
-            {
-                res = Utils::CreateDir(m_outputImageFolder, m_pCallback);
-                if (!(FCM_SUCCESS_CODE(res)))
-                {
-                    Utils::Trace(m_pCallback, "Output image folder (%s) could not be created\n", m_outputImageFolder.c_str());
-                    return res;
-                }
-                m_imageFolderCreated = true;
-            }
-            CreateImageFileName(libPathName, name);
-            SetImageExportFileName(libPathName, name);
+            return res;
         }
-        
-        bitmapExportPath += name;
-            
-        bitmapRelPath = "./";
-        bitmapRelPath += IMAGE_FOLDER;
-        bitmapRelPath += "/";
-        bitmapRelPath += name;
 
-        res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
+        bitmapElem.push_back(JSONNode(("bitmapPath"), bitmapRelPath)); 
 
-        FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> bitmapExportService = pUnk;
-        if (bitmapExportService)
+        // The bitmap is the rectangle of its size at (atlasX, atlasY) on the page
+        if (packed)
         {
-            FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
-            FCM::StringRep16 pFilePath = Utils::ToString16(bitmapExportPath, m_pCallback);
-            res = bitmapExportService->ExportToFile(pMediaItem, pFilePath, 100);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            pCalloc = CreateJS::Utils::GetCallocService(m_pCallback);
-            ASSERT(pCalloc.m_Ptr != NULL);
-
-            pCalloc->Free(pFilePath);
+            bitmapElem.push_back(JSONNode(("atlasX"), CreateJS::Utils::ToString(region.x)));
+            bitmapElem.push_back(JSONNode(("atlasY"), CreateJS::Utils::ToString(region.y)));
         }
 
-        bitmapElem.push_back(JSONNode(("bitmapPath"), bitmapRelPath)); 
-
         m_pBitmapArray->push_back(bitmapElem);
 
         return FCM_SUCCESS;
@@ -769,67 +1588,37 @@ namespace CreateJS
     {
         FCM::Result res;
         JSONNode soundElem(JSON_NODE);
-        std::string soundPath;
-        std::string soundName;
-        std::string name;
 
         soundElem.set_name("sound");
         soundElem.push_back(JSONNode(("charid"), CreateJS::Utils::ToString(resId)));
         
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
         std::string soundRelPath;
-        std::string soundExportPath = m_outputSoundFolder + "/";
 
-        if (!m_soundFolderCreated)
+        res = ExportSound(libPathName, pMediaItem, soundRelPath);
+        if (FCM_FAILURE_CODE(res))
         {
-            res = Utils::CreateDir(m_outputSoundFolder, m_pCallback);
-            if (!(FCM_SUCCESS_CODE(res)))
-            {
-                Utils::Trace(m_pCallback, "Output sound folder (%s) could not be created\n", m_outputSoundFolder.c_str());
-                return res;
-            }
-            m_soundFolderCreated = true;
+            return res;
         }
-        
-        CreateSoundFileName(libPathName, name);
-        soundExportPath += name;
 
-        soundRelPath = "./";
-        soundRelPath += SOUND_FOLDER;
-        soundRelPath += "/";
-        soundRelPath += name;
-
-        res = m_pCallback->GetService(DOM::FLA_SOUND_SERVICE, pUnk.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        FCM::AutoPtr<DOM::Service::Sound::ISoundExportService> soundExportService = pUnk;
-        if (soundExportService)
-        {
-            FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
-            FCM::StringRep16 pFilePath = Utils::ToString16(soundExportPath, m_pCallback);
-            res = soundExportService->ExportToFile(pMediaItem, pFilePath);
-            ASSERT(FCM_SUCCESS_CODE(res));
-            pCalloc = CreateJS::Utils::GetCallocService(m_pCallback);
-            ASSERT(pCalloc.m_Ptr != NULL);
-            pCalloc->Free(pFilePath);
-        }
-        
         soundElem.push_back(JSONNode(("soundPath"), soundRelPath)); 
         m_pSoundArray->push_back(soundElem);
         
         return FCM_SUCCESS;
     }
 
-    JSONOutputWriter::JSONOutputWriter(FCM::PIFCMCallback pCallback)
-        : m_pCallback(pCallback),
+    JSONOutputWriter::JSONOutputWriter(
+        FCM::PIFCMCallback pCallback, 
+        const OUTPUT_SETTINGS& settings)
+        : BaseOutputWriter(pCallback, settings, ".json"),
           m_shapeElem(NULL),
           m_pathArray(NULL),
           m_pathElem(NULL),
           m_firstSegment(false),
-          m_HTMLOutput(NULL),
-          m_imageFileNameLabel(0),
-          m_soundFileNameLabel(0),
-          m_imageFolderCreated(false),
-          m_soundFolderCreated(false)
+          m_pJsonStreamBuffer(NULL),
+          m_pTimelineStreamBuffer(NULL),
+          m_streamedShapeCount(0),
+          m_streamedTimelineCount(0),
+          m_morphShapes(settings.morphShapes && !settings.streamOutput && !settings.compactPaths)
     {
         m_pRootNode = new JSONNode(JSON_NODE);
         ASSERT(m_pRootNode);
@@ -855,6 +1644,15 @@ namespace CreateJS
         ASSERT(m_pSoundArray);
         m_pSoundArray->set_name("Sounds");
         m_strokeStyle.type = INVALID_STROKE_STYLE_TYPE;
+
+        if (m_settings.streamOutput)
+        {
+            m_pJsonStreamBuffer = new char[JSON_STREAM_BUFFER_SIZE];
+            ASSERT(m_pJsonStreamBuffer);
+
+            m_pTimelineStreamBuffer = new char[JSON_STREAM_BUFFER_SIZE];
+            ASSERT(m_pTimelineStreamBuffer);
+        }
     }
 
 
@@ -870,13 +1668,40 @@ namespace CreateJS
         delete m_pTextArray;
 
         delete m_pRootNode;
+
+        // Streams have to be closed before their buffers are released
+        if (m_jsonStream.is_open())
+        {
+            m_jsonStream.close();
+        }
+
+        if (m_timelineStream.is_open())
+        {
+            // Publish did not reach EndDocument()
+            m_timelineStream.close();
+            Utils::Remove(m_timelineSpillFilePath, m_pCallback);
+        }
+
+        delete [] m_pJsonStreamBuffer;
+        delete [] m_pTimelineStreamBuffer;
+    }
+
+
+    ITimelineWriter* JSONOutputWriter::CreateTimelineWriter()
+    {
+        return AddTimelineWriter(new JSONTimelineWriter(
+            m_pCallback, 
+            m_settings.compressTimeline, 
+            m_settings.writeTweens));
     }
 
 
     FCM::Result JSONOutputWriter::StartDefinePath()
     {
-        m_pathCmdStr.append(moveTo);
-        m_pathCmdStr.append(space);
+        if (!m_settings.compactPaths)
+        {
+            AppendCommand(COMPACT_PATH_MOVE_TO);
+        }
         m_firstSegment = true;
 
         return FCM_SUCCESS;
@@ -888,109 +1713,260 @@ namespace CreateJS
         return FCM_SUCCESS;
     }
 
-    FCM::Result JSONOutputWriter::CreateImageFileName(const std::string& libPathName, std::string& name)
+    void JSONOutputWriter::AppendCommand(CompactPathCommand command)
     {
-        std::string str;
-        size_t pos;
-        std::string fileLabel;
+        if (m_morphShapes)
+        {
+            m_shapeMorpher.AddCommand("MLQ"[command]);
+        }
 
-        fileLabel = Utils::ToString(m_imageFileNameLabel);
-        name = "Image" + fileLabel;
-        m_imageFileNameLabel++;
+        if (m_settings.compactPaths)
+        {
+            m_pathCmds.push_back((FCM::Byte)command);
+            return;
+        }
 
-        str = libPathName;
+        switch (command)
+        {
+            case COMPACT_PATH_MOVE_TO:
+                m_pathCmdStr.append(moveTo);
+                break;
 
-        // DOM APIs do not provide a way to get the compression of the image.
-        // For time being, we will use the extension of the library item name.
-        pos = str.rfind(".");
-        if (pos != std::string::npos)
+            case COMPACT_PATH_LINE_TO:
+                m_pathCmdStr.append(lineTo);
+                break;
+
+            default:
+                m_pathCmdStr.append(bezierCurveTo);
+                break;
+        }
+        m_pathCmdStr.append(space);
+    }
+
+
+    void JSONOutputWriter::AppendPoint(const DOM::Utils::POINT2D& point)
+    {
+        if (m_morphShapes)
         {
-            if (str.substr(pos + 1) == "jpg")
-            {
-                name += ".jpg";
-            }
-            else if (str.substr(pos + 1) == "png")
+            m_shapeMorpher.AddValue(point.x);
+            m_shapeMorpher.AddValue(point.y);
+        }
+
+        if (m_settings.compactPaths)
+        {
+            m_pathCoords.push_back((FCM::S_Int32)floor(point.x * COMPACT_PATH_SCALE + 0.5));
+            m_pathCoords.push_back((FCM::S_Int32)floor(point.y * COMPACT_PATH_SCALE + 0.5));
+            return;
+        }
+
+        Utils::AppendNumber(m_pathCmdStr, point.x, m_settings.numberPrecision);
+        m_pathCmdStr.append(space);
+        Utils::AppendNumber(m_pathCmdStr, point.y, m_settings.numberPrecision);
+        m_pathCmdStr.append(space);
+    }
+
+
+    void JSONOutputWriter::WritePathData()
+    {
+        if (m_settings.compactPaths)
+        {
+            if (EncodeCompactPath(m_pathCmds, m_pathCoords, m_pathCmdStr))
             {
-                name += ".png";
+                m_pathElem->push_back(JSONNode("compactPath", m_pathCmdStr));
+                return;
             }
-            else
+
+            // Out of range for the encoding: the rounded points are written as text
+            Utils::Trace(m_pCallback, "A path is too large for the compact encoding and is written as text\n");
+
+            size_t c = 0;
+
+            m_pathCmdStr.clear();
+            for (size_t i = 0; i < m_pathCmds.size(); i++)
             {
-                name += ".png";
+                FCM::U_Int32 count = (m_pathCmds[i] == COMPACT_PATH_QUAD_CURVE_TO) ? 4 : 2;
+
+                m_pathCmdStr.append((m_pathCmds[i] == COMPACT_PATH_MOVE_TO) ? moveTo : 
+                    (m_pathCmds[i] == COMPACT_PATH_LINE_TO) ? lineTo : bezierCurveTo);
+                m_pathCmdStr.append(space);
+
+                for (FCM::U_Int32 k = 0; k < count; k++)
+                {
+                    Utils::AppendNumber(m_pathCmdStr, (double)m_pathCoords[c++] / COMPACT_PATH_SCALE, 1);
+                    m_pathCmdStr.append(space);
+                }
             }
         }
+
+        m_pathElem->push_back(JSONNode("d", m_pathCmdStr));
+    }
+
+
+    FCM::Result JSONOutputWriter::OpenStream(
+        const std::string& fileName, 
+        std::fstream& file, 
+        char* pBuffer, 
+        std::ios_base::openmode mode)
+    {
+        // The buffer has to be installed before the file is opened
+        file.rdbuf()->pubsetbuf(pBuffer, JSON_STREAM_BUFFER_SIZE);
+
+        Utils::OpenFStream(fileName, file, mode, m_pCallback);
+        if (!file.is_open())
+        {
+            Utils::Trace(m_pCallback, "Output file (%s) could not be opened\n", fileName.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result JSONOutputWriter::EndStreamedDocument()
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        // All the shapes have already been written. Close the shape array and append 
+        // the remaining resources (which are small) followed by the spilled timelines.
+        // Keys are written in the same order as the in-memory tree.
+        m_jsonStream << "],\"Bitmaps\":" << m_pBitmapArray->write();
+        m_jsonStream << ",\"Sounds\":" << m_pSoundArray->write();
+        m_jsonStream << ",\"Text\":" << m_pTextArray->write();
+
+        JSONNode aliases(JSON_NODE);
+        CreateAliasNode(aliases);
+        m_jsonStream << ",\"Aliases\":" << aliases.write();
+
+        JSONNode resampled(JSON_NODE);
+        CreateResampledNode(resampled);
+        m_jsonStream << ",\"Resampled\":" << resampled.write();
+
+        m_jsonStream << ",\"Timeline\":[";
+
+        if (m_streamedTimelineCount > 0)
+        {
+            m_timelineStream.seekg(0, std::ios_base::beg);
+            m_jsonStream << m_timelineStream.rdbuf();
+        }
+
+        m_jsonStream << "]}}";
+
+        m_jsonStream.flush();
+        if (m_jsonStream.fail())
+        {
+            Utils::Trace(m_pCallback, "Output file (%s) could not be written\n", m_outputDataFilePath.c_str());
+            res = FCM_GENERAL_ERROR;
+        }
         else
         {
-            name += ".png";
+            PublishProfiler::AddBytes(PROFILE_PHASE_SERIALIZE, (FCM::U_Int64)m_jsonStream.tellp());
+        }
+
+        m_jsonStream.close();
+        m_timelineStream.close();
+
+        Utils::Remove(m_timelineSpillFilePath, m_pCallback);
+
+        return res;
+    }
+
+
+    void JSONOutputWriter::CreateAliasNode(JSONNode& node)
+    {
+        std::map<std::string, std::string>::const_iterator it;
+
+        node.set_name("Aliases");
+
+        for (it = m_assetAliases.begin(); it != m_assetAliases.end(); ++it)
+        {
+            node.push_back(JSONNode(it->first, it->second));
         }
+    }
+
+
+    void JSONOutputWriter::CreateResampledNode(JSONNode& node)
+    {
+        std::map<std::string, RESAMPLED_SIZE>::const_iterator it;
+
+        node.set_name("Resampled");
+
+        for (it = m_resampledBitmaps.begin(); it != m_resampledBitmaps.end(); ++it)
+        {
+            JSONNode size(JSON_NODE);
 
-        return FCM_SUCCESS;
+            size.set_name(it->first);
+            size.push_back(JSONNode("width", it->second.width));
+            size.push_back(JSONNode("height", it->second.height));
+
+            node.push_back(size);
+        }
     }
 
 
-    FCM::Result JSONOutputWriter::CreateSoundFileName(const std::string& libPathName, std::string& name)
+    void JSONOutputWriter::WriteMorphs()
     {
-        std::string str;
-        size_t pos;
-        std::string fileLabel;
-
-        fileLabel = Utils::ToString(m_soundFileNameLabel);
-        name = "Sound" + fileLabel;
-        m_soundFileNameLabel++;
+        ShapeMorphMap morphs;
 
-        str = libPathName;
+        m_shapeMorpher.GetMorphs(morphs);
 
-        // DOM APIs do not provide a way to get the compression of the sound.
-        // For time being, we will use the extension of the library item name.
-        pos = str.rfind(".");
-        if (pos != std::string::npos)
+        for (JSONNode::iterator it = m_pShapeArray->begin(); (it != m_pShapeArray->end()) && !morphs.empty(); ++it)
         {
-            if (str.substr(pos + 1) == "wav")
-            {
-                name += ".WAV";
-            }
-            else if (str.substr(pos + 1) == "mp3")
+            JSONNode::iterator idNode = it->find("charid");
+            if (idNode == it->end())
             {
-                name += ".MP3";
+                continue;
             }
-            else
+
+            std::string charId = idNode->as_string();
+            ShapeMorphMap::iterator morph = morphs.find((FCM::U_Int32)strtoul(charId.c_str(), NULL, 10));
+            if (morph == morphs.end())
             {
-                name += ".MP3";
+                continue;
             }
-        }
-        else
-        {
-            name += ".MP3";
-        }
-
-        return FCM_SUCCESS;
-    }
 
+            JSONNode morphNode(JSON_NODE);
 
-    FCM::Boolean JSONOutputWriter::GetImageExportFileName(const std::string& libPathName, std::string& name)
-    {
-        std::map<std::string, std::string>::iterator it = m_imageMap.find(libPathName);
+            morphNode.set_name("morph");
+            morphNode.push_back(JSONNode("from", CreateJS::Utils::ToString(morph->second.fromResId)));
+            morphNode.push_back(JSONNode("to", CreateJS::Utils::ToString(morph->second.toResId)));
+            morphNode.push_back(JSONNode("ratio", CreateJS::Utils::ToString(morph->second.ratio, MORPH_RATIO_PRECISION)));
 
-        name = "";
+            it->clear();
+            it->push_back(JSONNode("charid", charId));
+            it->push_back(morphNode);
 
-        if (it != m_imageMap.end())
-        {
-            // Image already exported
-            name = it->second;
-            return true;
+            morphs.erase(morph);
         }
+    }
+    /* -------------------------------------------------- JSONTimelineWriter */
 
-        return false;
+    static void QuantizeMatrix(const DOM::Utils::MATRIX2D& matrix, QUANTIZED_MATRIX& quantized)
+    {
+        quantized.value[0] = (FCM::S_Int32)floor(matrix.a * TIMELINE_SCALE_QUANTUM + 0.5);
+        quantized.value[1] = (FCM::S_Int32)floor(matrix.b * TIMELINE_SCALE_QUANTUM + 0.5);
+        quantized.value[2] = (FCM::S_Int32)floor(matrix.c * TIMELINE_SCALE_QUANTUM + 0.5);
+        quantized.value[3] = (FCM::S_Int32)floor(matrix.d * TIMELINE_SCALE_QUANTUM + 0.5);
+        quantized.value[4] = (FCM::S_Int32)floor(matrix.tx * TIMELINE_TRANSLATE_QUANTUM + 0.5);
+        quantized.value[5] = (FCM::S_Int32)floor(matrix.ty * TIMELINE_TRANSLATE_QUANTUM + 0.5);
     }
 
 
-    void JSONOutputWriter::SetImageExportFileName(const std::string& libPathName, const std::string& name)
+    static std::string ToQuantizedString(const FCM::S_Int32* pValues, FCM::U_Int32 count)
     {
-        // Assumption: Name is not already present in the map
-        ASSERT(m_imageMap.find(libPathName) == m_imageMap.end());
+        std::string str;
 
-        m_imageMap.insert(std::pair<std::string, std::string>(libPathName, name));
+        for (FCM::U_Int32 i = 0; i < count; i++)
+        {
+            if (i != 0)
+            {
+                str += comma;
+            }
+            str += Utils::ToString(pValues[i]);
+        }
+
+        return str;
     }
-    /* -------------------------------------------------- JSONTimelineWriter */
+
 
     FCM::Result JSONTimelineWriter::PlaceObject(
         FCM::U_Int32 resId,
@@ -1008,7 +1984,16 @@ namespace CreateJS
 
         if (pMatrix)
         {
-            commandElement.push_back(JSONNode("transformMatrix", Utils::ToString(*pMatrix).c_str()));
+            AddMatrix(commandElement, objectId, *pMatrix, true);
+        }
+        else
+        {
+            m_matrices.erase(objectId);
+        }
+
+        if (m_writeTweens)
+        {
+            AddSample(pMatrix ? TIMELINE_SAMPLE_PLACE : TIMELINE_SAMPLE_RESET, objectId, pMatrix);
         }
 
         m_pCommandArray->push_back(commandElement);
@@ -1031,6 +2016,13 @@ namespace CreateJS
         commandElement.push_back(JSONNode("charid", CreateJS::Utils::ToString(resId)));
         commandElement.push_back(JSONNode("objectId", CreateJS::Utils::ToString(objectId)));
 
+        m_matrices.erase(objectId);
+
+        if (m_writeTweens)
+        {
+            AddSample(TIMELINE_SAMPLE_RESET, objectId, NULL);
+        }
+
         pSound = pUnknown;
         if (pSound)
         {
@@ -1082,8 +2074,15 @@ namespace CreateJS
         commandElement.push_back(JSONNode("cmdType", "Remove"));
         commandElement.push_back(JSONNode("objectId", CreateJS::Utils::ToString(objectId)));
 
+        if (m_writeTweens)
+        {
+            AddSample(TIMELINE_SAMPLE_RESET, objectId, NULL);
+        }
+
         m_pCommandArray->push_back(commandElement);
 
+        m_matrices.erase(objectId);
+
         return FCM_SUCCESS;
     }
 
@@ -1772,14 +2771,21 @@ namespace CreateJS
         const DOM::Utils::MATRIX2D& matrix)
     {
         JSONNode commandElement(JSON_NODE);
-        std::string transformMat;
+
+        if (m_writeTweens)
+        {
+            // Written once the tweens of the timeline are known
+            AddSample(TIMELINE_SAMPLE_MOVE, objectId, &matrix);
+            return FCM_SUCCESS;
+        }
 
         commandElement.push_back(JSONNode("cmdType", "Move"));
         commandElement.push_back(JSONNode("objectId", CreateJS::Utils::ToString(objectId)));
-        transformMat = CreateJS::Utils::ToString(matrix);
-        commandElement.push_back(JSONNode("transformMatrix", transformMat.c_str()));
 
-        m_pCommandArray->push_back(commandElement);
+        if (AddMatrix(commandElement, objectId, matrix, false))
+        {
+            m_pCommandArray->push_back(commandElement);
+        }
 
         return FCM_SUCCESS;
     }
@@ -1796,21 +2802,64 @@ namespace CreateJS
 
     FCM::Result JSONTimelineWriter::ShowFrame(FCM::U_Int32 frameNum)
     {
+        if (m_writeTweens)
+        {
+            TIMELINE_FRAME frame;
+
+            frame.frameNum = frameNum;
+            frame.pFrameElement = m_pFrameElement;
+            frame.pCommandArray = m_pCommandArray;
+
+            m_frames.push_back(frame);
+
+            m_pCommandArray = new JSONNode(JSON_ARRAY);
+            m_pCommandArray->set_name("Command");
+
+            m_pFrameElement = new JSONNode(JSON_NODE);
+            ASSERT(m_pFrameElement);
+
+            return FCM_SUCCESS;
+        }
+
+        WriteFrame(frameNum);
+
+        return FCM_SUCCESS;
+    }
+
+
+    void JSONTimelineWriter::WriteFrame(FCM::U_Int32 frameNum)
+    {
+        if (m_compress && m_pHeldFrameElement && m_pCommandArray->empty() && m_pFrameElement->empty())
+        {
+            // Nothing changes in this frame
+            m_holdCount++;
+            return;
+        }
+
+        PublishProfiler::RecordPeak(PROFILE_COUNTER_FRAME_COMMANDS, m_pCommandArray->size());
+
         m_pFrameElement->push_back(JSONNode(("num"), CreateJS::Utils::ToString(frameNum)));
         m_pFrameElement->push_back(*m_pCommandArray);
-        m_pFrameArray->push_back(*m_pFrameElement);
+
+        if (m_compress)
+        {
+            // The frame is written once the number of empty frames after it is known
+            FlushFrame();
+            m_pHeldFrameElement = m_pFrameElement;
+        }
+        else
+        {
+            m_pFrameArray->push_back(*m_pFrameElement);
+            delete m_pFrameElement;
+        }
 
         delete m_pCommandArray;
-        delete m_pFrameElement;
 
         m_pCommandArray = new JSONNode(JSON_ARRAY);
         m_pCommandArray->set_name("Command");
 
         m_pFrameElement = new JSONNode(JSON_NODE);
         ASSERT(m_pFrameElement);
-
-        
-        return FCM_SUCCESS;
     }
 
 
@@ -1871,8 +2920,16 @@ namespace CreateJS
     }
 
 
-    JSONTimelineWriter::JSONTimelineWriter(FCM::PIFCMCallback pCallback) :
-        m_pCallback(pCallback)
+    JSONTimelineWriter::JSONTimelineWriter(
+        FCM::PIFCMCallback pCallback, 
+        FCM::Boolean compress, 
+        FCM::Boolean writeTweens) :
+        m_pCallback(pCallback),
+        m_compress(compress),
+        m_pHeldFrameElement(NULL),
+        m_holdCount(0),
+        m_writeTweens(writeTweens),
+        m_tweenCount(0)
     {
         m_pCommandArray = new JSONNode(JSON_ARRAY);
         ASSERT(m_pCommandArray);
@@ -1901,6 +2958,14 @@ namespace CreateJS
         delete m_pTimelineElement;
         
         delete m_pFrameElement;
+
+        delete m_pHeldFrameElement;
+
+        for (size_t i = 0; i < m_frames.size(); i++)
+        {
+            delete m_frames[i].pFrameElement;
+            delete m_frames[i].pCommandArray;
+        }
     }
 
 
@@ -1919,7 +2984,332 @@ namespace CreateJS
                 CreateJS::Utils::ToString(resId)));
         }
 
+        if (m_writeTweens)
+        {
+            WriteTweens();
+
+            if (m_tweenCount > 0)
+            {
+                m_pTimelineElement->push_back(JSONNode("tweens", CreateJS::Utils::ToString(m_tweenCount)));
+            }
+        }
+
+        if (m_compress)
+        {
+            FlushFrame();
+            m_pTimelineElement->push_back(JSONNode("encoding", "delta"));
+        }
+
         m_pTimelineElement->push_back(*m_pFrameArray);
     }
 
+
+    FCM::Boolean JSONTimelineWriter::AddMatrix(
+        JSONNode& commandElement, 
+        FCM::U_Int32 objectId, 
+        const DOM::Utils::MATRIX2D& matrix,
+        FCM::Boolean keyframe)
+    {
+        QUANTIZED_MATRIX quantized;
+        FCM::S_Int32 delta[6];
+        FCM::U_Int32 count = 0;
+
+        if (!m_compress)
+        {
+            commandElement.push_back(JSONNode("transformMatrix", Utils::ToString(matrix)));
+            return true;
+        }
+
+        QuantizeMatrix(matrix, quantized);
+
+        std::unordered_map<FCM::U_Int32, QUANTIZED_MATRIX>::iterator it = m_matrices.find(objectId);
+        if (keyframe || (it == m_matrices.end()))
+        {
+            m_matrices[objectId] = quantized;
+            commandElement.push_back(JSONNode("matrix", ToQuantizedString(quantized.value, 6)));
+            return true;
+        }
+
+        // Tweens usually change only a few components, so trailing zeros are left out
+        for (FCM::U_Int32 i = 0; i < 6; i++)
+        {
+            delta[i] = quantized.value[i] - it->second.value[i];
+            if (delta[i] != 0)
+            {
+                count = i + 1;
+            }
+        }
+
+        if (count == 0)
+        {
+            return false;
+        }
+
+        it->second = quantized;
+        commandElement.push_back(JSONNode("delta", ToQuantizedString(delta, count)));
+
+        return true;
+    }
+
+
+    void JSONTimelineWriter::FlushFrame()
+    {
+        if (m_pHeldFrameElement == NULL)
+        {
+            return;
+        }
+
+        if (m_holdCount > 0)
+        {
+            m_pHeldFrameElement->push_back(JSONNode("hold", CreateJS::Utils::ToString(m_holdCount)));
+        }
+
+        m_pFrameArray->push_back(*m_pHeldFrameElement);
+
+        delete m_pHeldFrameElement;
+        m_pHeldFrameElement = NULL;
+        m_holdCount = 0;
+    }
+
+
+    void JSONTimelineWriter::AddSample(
+        TimelineSampleType type, 
+        FCM::U_Int32 objectId, 
+        const DOM::Utils::MATRIX2D* pMatrix)
+    {
+        TIMELINE_SAMPLE sample;
+
+        sample.type = type;
+        sample.frameIndex = (FCM::U_Int32)m_frames.size();
+        sample.position = (FCM::U_Int32)m_pCommandArray->size();
+        sample.objectId = objectId;
+        sample.tweenFrames = 0;
+        sample.tweenEase = 0;
+        sample.inTween = false;
+
+        if (pMatrix)
+        {
+            sample.matrix = *pMatrix;
+        }
+
+        m_samples.push_back(sample);
+    }
+
+
+    void JSONTimelineWriter::WriteTweens()
+    {
+        // Move commands of each object in consecutive frames, the matrix the object
+        // had before them and the last matrix of each object
+        std::unordered_map<FCM::U_Int32, std::vector<FCM::U_Int32> > runs;
+        std::unordered_map<FCM::U_Int32, DOM::Utils::MATRIX2D> runStarts;
+        std::unordered_map<FCM::U_Int32, DOM::Utils::MATRIX2D> matrices;
+        FCM::U_Int32 next = 0;
+
+        for (FCM::U_Int32 i = 0; i < m_samples.size(); i++)
+        {
+            const TIMELINE_SAMPLE& sample = m_samples[i];
+            std::vector<FCM::U_Int32>& run = runs[sample.objectId];
+
+            if ((sample.type == TIMELINE_SAMPLE_MOVE) && !run.empty() &&
+                (m_samples[run.back()].frameIndex + 1 == sample.frameIndex))
+            {
+                run.push_back(i);
+                matrices[sample.objectId] = sample.matrix;
+                continue;
+            }
+
+            if (!run.empty())
+            {
+                FitTweens(runStarts[sample.objectId], run);
+                run.clear();
+            }
+
+            if (sample.type == TIMELINE_SAMPLE_RESET)
+            {
+                matrices.erase(sample.objectId);
+                continue;
+            }
+
+            if (sample.type == TIMELINE_SAMPLE_MOVE)
+            {
+                // A tween cannot start from an object placed without a matrix
+                std::unordered_map<FCM::U_Int32, DOM::Utils::MATRIX2D>::const_iterator it =
+                    matrices.find(sample.objectId);
+                if (it != matrices.end())
+                {
+                    runStarts[sample.objectId] = it->second;
+                    run.push_back(i);
+                }
+            }
+
+            matrices[sample.objectId] = sample.matrix;
+        }
+
+        std::unordered_map<FCM::U_Int32, std::vector<FCM::U_Int32> >::const_iterator it;
+        for (it = runs.begin(); it != runs.end(); ++it)
+        {
+            if (!it->second.empty())
+            {
+                FitTweens(runStarts[it->first], it->second);
+            }
+        }
+
+        // The commands are written in the order they were added, so the matrices of
+        // the compressed timeline are replayed from the start
+        m_matrices.clear();
+
+        for (FCM::U_Int32 i = 0; i < m_frames.size(); i++)
+        {
+            TIMELINE_FRAME& frame = m_frames[i];
+            JSONNode* pCommandArray = new JSONNode(JSON_ARRAY);
+            FCM::U_Int32 position = 0;
+
+            pCommandArray->set_name("Command");
+
+            for (JSONNode::iterator command = frame.pCommandArray->begin(); ; ++command, ++position)
+            {
+                FCM::Boolean end = (command == frame.pCommandArray->end());
+
+                while ((next < m_samples.size()) && (m_samples[next].frameIndex == i) &&
+                    (end || (m_samples[next].position <= position)))
+                {
+                    WriteSample(*pCommandArray, m_samples[next++]);
+                }
+
+                if (end)
+                {
+                    break;
+                }
+
+                pCommandArray->push_back(*command);
+            }
+
+            delete frame.pCommandArray;
+            delete m_pCommandArray;
+            delete m_pFrameElement;
+
+            m_pCommandArray = pCommandArray;
+            m_pFrameElement = frame.pFrameElement;
+
+            WriteFrame(frame.frameNum);
+        }
+
+        m_frames.clear();
+        m_samples.clear();
+    }
+
+
+    void JSONTimelineWriter::FitTweens(
+        const DOM::Utils::MATRIX2D& start, 
+        const std::vector<FCM::U_Int32>& run)
+    {
+        std::vector<DOM::Utils::MATRIX2D> matrices(run.size());
+        DOM::Utils::MATRIX2D tweenStart = start;
+        FCM::U_Int32 position = 0;
+
+        for (FCM::U_Int32 i = 0; i < run.size(); i++)
+        {
+            matrices[i] = m_samples[run[i]].matrix;
+        }
+
+        while (position < run.size())
+        {
+            FCM::Double ease = 0;
+            FCM::U_Int32 length = TweenFitter::Fit(
+                tweenStart, 
+                &matrices[position], 
+                (FCM::U_Int32)run.size() - position, 
+                ease);
+
+            if (length == 0)
+            {
+                tweenStart = matrices[position];
+                position++;
+                continue;
+            }
+
+            TIMELINE_SAMPLE& first = m_samples[run[position]];
+
+            first.tweenFrames = length;
+            first.tweenEase = ease;
+            first.tweenStart = tweenStart;
+            first.tweenEnd = matrices[position + length - 1];
+
+            for (FCM::U_Int32 i = 1; i < length; i++)
+            {
+                m_samples[run[position + i]].inTween = true;
+            }
+
+            m_tweenCount++;
+
+            tweenStart = first.tweenEnd;
+            position += length;
+        }
+    }
+
+
+    void JSONTimelineWriter::WriteSample(JSONNode& commandArray, const TIMELINE_SAMPLE& sample)
+    {
+        JSONNode commandElement(JSON_NODE);
+
+        switch (sample.type)
+        {
+            case TIMELINE_SAMPLE_PLACE:
+                QuantizeMatrix(sample.matrix, m_matrices[sample.objectId]);
+                return;
+
+            case TIMELINE_SAMPLE_RESET:
+                m_matrices.erase(sample.objectId);
+                return;
+
+            default:
+                break;
+        }
+
+        if (sample.inTween)
+        {
+            return;
+        }
+
+        if (sample.tweenFrames == 0)
+        {
+            commandElement.push_back(JSONNode("cmdType", "Move"));
+            commandElement.push_back(JSONNode("objectId", CreateJS::Utils::ToString(sample.objectId)));
+
+            if (AddMatrix(commandElement, sample.objectId, sample.matrix, false))
+            {
+                commandArray.push_back(commandElement);
+            }
+            return;
+        }
+
+        // Expanded to the Move commands of the next "frames" frames by the runtime
+        commandElement.push_back(JSONNode("cmdType", "Tween"));
+        commandElement.push_back(JSONNode("objectId", CreateJS::Utils::ToString(sample.objectId)));
+        commandElement.push_back(JSONNode("frames", CreateJS::Utils::ToString(sample.tweenFrames)));
+        commandElement.push_back(JSONNode("ease", CreateJS::Utils::ToString(sample.tweenEase)));
+
+        if (m_compress)
+        {
+            QUANTIZED_MATRIX start;
+            QUANTIZED_MATRIX end;
+
+            QuantizeMatrix(sample.tweenStart, start);
+            QuantizeMatrix(sample.tweenEnd, end);
+
+            commandElement.push_back(JSONNode("from", ToQuantizedString(start.value, 6)));
+            commandElement.push_back(JSONNode("to", ToQuantizedString(end.value, 6)));
+
+            // Later deltas are against the end of the tween
+            m_matrices[sample.objectId] = end;
+        }
+        else
+        {
+            commandElement.push_back(JSONNode("from", Utils::ToString(sample.tweenStart)));
+            commandElement.push_back(JSONNode("to", Utils::ToString(sample.tweenEnd)));
+        }
+
+        commandArray.push_back(commandElement);
+    }
+
 };
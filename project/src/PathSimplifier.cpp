@@ -0,0 +1,261 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "PathSimplifier.h"
+
+#include <math.h>
+#include <utility>
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    static inline bool IsLine(const DOM::Utils::SEGMENT& segment)
+    {
+        return (segment.segmentType == DOM::Utils::LINE_SEGMENT);
+    }
+
+    static inline const DOM::Utils::POINT2D& GetStart(const DOM::Utils::SEGMENT& segment)
+    {
+        return IsLine(segment) ? segment.line.endPoint1 : segment.quadBezierCurve.anchor1;
+    }
+
+    static inline const DOM::Utils::POINT2D& GetEnd(const DOM::Utils::SEGMENT& segment)
+    {
+        return IsLine(segment) ? segment.line.endPoint2 : segment.quadBezierCurve.anchor2;
+    }
+
+    static inline void SetStart(DOM::Utils::SEGMENT& segment, const DOM::Utils::POINT2D& point)
+    {
+        if (IsLine(segment))
+        {
+            segment.line.endPoint1 = point;
+        }
+        else
+        {
+            segment.quadBezierCurve.anchor1 = point;
+        }
+    }
+
+    static DOM::Utils::SEGMENT MakeLine(const DOM::Utils::POINT2D& start, const DOM::Utils::POINT2D& end)
+    {
+        DOM::Utils::SEGMENT segment;
+
+        segment.structSize = sizeof(DOM::Utils::SEGMENT);
+        segment.segmentType = DOM::Utils::LINE_SEGMENT;
+        segment.line.endPoint1 = start;
+        segment.line.endPoint2 = end;
+
+        return segment;
+    }
+
+    static inline FCM::Double GetDistance(const DOM::Utils::POINT2D& a, const DOM::Utils::POINT2D& b)
+    {
+        FCM::Double dx = (FCM::Double)b.x - a.x;
+        FCM::Double dy = (FCM::Double)b.y - a.y;
+
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    // Distance of "point" to the line segment from "a" to "b"
+    static FCM::Double GetDistanceToLine(
+        const DOM::Utils::POINT2D& point,
+        const DOM::Utils::POINT2D& a,
+        const DOM::Utils::POINT2D& b)
+    {
+        FCM::Double dx = (FCM::Double)b.x - a.x;
+        FCM::Double dy = (FCM::Double)b.y - a.y;
+        FCM::Double lengthSquared = dx * dx + dy * dy;
+
+        if (lengthSquared == 0)
+        {
+            return GetDistance(point, a);
+        }
+
+        FCM::Double t = (((FCM::Double)point.x - a.x) * dx + ((FCM::Double)point.y - a.y) * dy) / lengthSquared;
+        if (t <= 0)
+        {
+            return GetDistance(point, a);
+        }
+        if (t >= 1)
+        {
+            return GetDistance(point, b);
+        }
+
+        FCM::Double px = a.x + t * dx - point.x;
+        FCM::Double py = a.y + t * dy - point.y;
+
+        return sqrt(px * px + py * py);
+    }
+}
+
+
+/* -------------------------------------------------- PathSimplifier */
+
+namespace CreateJS
+{
+    void PathSimplifier::Simplify(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance)
+    {
+        if ((tolerance <= 0) || segments.empty())
+        {
+            return;
+        }
+
+        // Each step may move the path by half the tolerance. The steps are arranged
+        // so that no part of the path is moved by more than two of them.
+        FlattenCurves(segments, tolerance / 2);
+        MergeLines(segments, tolerance / 2);
+        DropShortLines(segments, tolerance / 2);
+    }
+
+
+    void PathSimplifier::FlattenCurves(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance)
+    {
+        for (size_t i = 0; i < segments.size(); i++)
+        {
+            DOM::Utils::SEGMENT& segment = segments[i];
+
+            if (IsLine(segment))
+            {
+                continue;
+            }
+
+            const DOM::Utils::QUAD_BEZIER_CURVE& curve = segment.quadBezierCurve;
+            DOM::Utils::POINT2D middle;
+
+            // The curve is at most half as far from its chord as the control point is
+            // from the middle of the chord
+            middle.x = (curve.anchor1.x + curve.anchor2.x) / 2;
+            middle.y = (curve.anchor1.y + curve.anchor2.y) / 2;
+
+            if (GetDistance(curve.control, middle) / 2 <= tolerance)
+            {
+                segment = MakeLine(curve.anchor1, curve.anchor2);
+            }
+        }
+    }
+
+
+    void PathSimplifier::MergeLines(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance)
+    {
+        std::vector<DOM::Utils::SEGMENT> merged;
+        std::vector<DOM::Utils::POINT2D> points;
+        std::vector<bool> keep;
+        std::vector<std::pair<size_t, size_t> > ranges;
+        size_t i = 0;
+
+        merged.reserve(segments.size());
+
+        while (i < segments.size())
+        {
+            if (!IsLine(segments[i]))
+            {
+                merged.push_back(segments[i++]);
+                continue;
+            }
+
+            // Points of the run of lines starting here
+            points.clear();
+            points.push_back(GetStart(segments[i]));
+            while ((i < segments.size()) && IsLine(segments[i]))
+            {
+                points.push_back(GetEnd(segments[i++]));
+            }
+
+            if (points.size() == 2)
+            {
+                merged.push_back(MakeLine(points[0], points[1]));
+                continue;
+            }
+
+            // Douglas-Peucker: keep the point farthest from the chord of a range until
+            // every point is within the tolerance of it
+            keep.assign(points.size(), false);
+            keep.front() = true;
+            keep.back() = true;
+
+            ranges.clear();
+            ranges.push_back(std::make_pair((size_t)0, points.size() - 1));
+
+            while (!ranges.empty())
+            {
+                size_t first = ranges.back().first;
+                size_t last = ranges.back().second;
+                size_t farthest = first;
+                FCM::Double maxDistance = 0;
+
+                ranges.pop_back();
+
+                for (size_t j = first + 1; j < last; j++)
+                {
+                    FCM::Double distance = GetDistanceToLine(points[j], points[first], points[last]);
+                    if (distance > maxDistance)
+                    {
+                        maxDistance = distance;
+                        farthest = j;
+                    }
+                }
+
+                if (maxDistance > tolerance)
+                {
+                    keep[farthest] = true;
+                    ranges.push_back(std::make_pair(first, farthest));
+                    ranges.push_back(std::make_pair(farthest, last));
+                }
+            }
+
+            size_t previous = 0;
+            for (size_t j = 1; j < points.size(); j++)
+            {
+                if (keep[j])
+                {
+                    merged.push_back(MakeLine(points[previous], points[j]));
+                    previous = j;
+                }
+            }
+        }
+
+        segments.swap(merged);
+    }
+
+
+    void PathSimplifier::DropShortLines(std::vector<DOM::Utils::SEGMENT>& segments, FCM::Double tolerance)
+    {
+        std::vector<DOM::Utils::SEGMENT> kept;
+        DOM::Utils::POINT2D pen = GetStart(segments.front());
+
+        kept.reserve(segments.size());
+
+        for (size_t i = 0; i < segments.size(); i++)
+        {
+            DOM::Utils::SEGMENT segment = segments[i];
+
+            // Only lines between curves are left to drop; runs of lines were merged.
+            // The curve that follows then starts where the line started.
+            if (IsLine(segment) &&
+                ((i == 0) || !IsLine(segments[i - 1])) &&
+                (i + 1 < segments.size()) && !IsLine(segments[i + 1]) &&
+                (GetDistance(pen, GetEnd(segment)) <= tolerance))
+            {
+                continue;
+            }
+
+            SetStart(segment, pen);
+            kept.push_back(segment);
+            pen = GetEnd(segment);
+        }
+
+        segments.swap(kept);
+    }
+};
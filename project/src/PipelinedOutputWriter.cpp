@@ -0,0 +1,937 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "PipelinedOutputWriter.h"
+
+#include <cstring>
+#include "JSONArena.h"
+#include "PublishProfiler.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    static void InitEvent(
+        PIPELINED_EVENT& event,
+        PipelinedEventType type,
+        PipelinedTimelineWriter* pTimelineWriter = NULL,
+        FCM::U_Int32 objectId = 0)
+    {
+        event.type = type;
+        event.pTimelineWriter = pTimelineWriter;
+        event.resId = 0;
+        event.objectId = objectId;
+        event.value = 0;
+        event.hasMatrix = false;
+        event.pText = NULL;
+    }
+
+    // Copies a string the host may release once the call returns
+    static FCM::U_Int16* CopyText(FCM::CStringRep16 pText)
+    {
+        size_t length = 0;
+
+        if (pText == NULL)
+        {
+            return NULL;
+        }
+
+        while (pText[length] != 0)
+        {
+            length++;
+        }
+
+        FCM::U_Int16* pCopy = new FCM::U_Int16[length + 1];
+        memcpy(pCopy, pText, (length + 1) * sizeof(FCM::U_Int16));
+
+        return pCopy;
+    }
+}
+
+
+/* -------------------------------------------------- PipelinedOutputWriter */
+
+namespace CreateJS
+{
+    PipelinedOutputWriter::PipelinedOutputWriter(IOutputWriter* pOutputWriter)
+        : m_pOutputWriter(pOutputWriter),
+          m_queue(PIPELINED_QUEUE_SIZE),
+          m_head(0),
+          m_tail(0),
+          m_result(FCM_SUCCESS),
+          m_sleeping(false)
+    {
+        ASSERT(m_pOutputWriter);
+
+        StartThread();
+    }
+
+
+    PipelinedOutputWriter::~PipelinedOutputWriter()
+    {
+        StopThread(true);
+
+        for (size_t i = 0; i < m_timelineWriters.size(); i++)
+        {
+            delete m_timelineWriters[i];
+        }
+
+        delete m_pOutputWriter;
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartOutput(std::string& outputFileName)
+    {
+        Drain();
+
+        return m_pOutputWriter->StartOutput(outputFileName);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndOutput()
+    {
+        StopThread(true);
+
+        return m_pOutputWriter->EndOutput();
+    }
+
+
+    void PipelinedOutputWriter::TakeOutputFiles(OutputFileMap& files)
+    {
+        StopThread(true);
+
+        m_pOutputWriter->TakeOutputFiles(files);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDocument(
+        const DOM::Utils::COLOR& background,
+        FCM::U_Int32 stageHeight,
+        FCM::U_Int32 stageWidth,
+        FCM::U_Int32 fps)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_START_DOCUMENT);
+        event.document.background = background;
+        event.document.stageHeight = stageHeight;
+        event.document.stageWidth = stageWidth;
+        event.document.fps = fps;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDocument()
+    {
+        if (!m_thread.joinable())
+        {
+            return m_pOutputWriter->EndDocument();
+        }
+
+        Post(PIPELINED_END_DOCUMENT);
+
+        // The writer thread ends after the document
+        StopThread(false);
+
+        return m_result;
+    }
+
+
+    ITimelineWriter* PipelinedOutputWriter::CreateTimelineWriter()
+    {
+        PIPELINED_EVENT event;
+        PipelinedTimelineWriter* pTimelineWriter = new PipelinedTimelineWriter(this);
+
+        m_timelineWriters.push_back(pTimelineWriter);
+
+        // The writer it wraps is created in turn on the writer thread
+        InitEvent(event, PIPELINED_CREATE_TIMELINE_WRITER, pTimelineWriter);
+        Post(event);
+
+        return pTimelineWriter;
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineTimeline()
+    {
+        return Post(PIPELINED_START_DEFINE_TIMELINE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineTimeline(
+        FCM::U_Int32 resId,
+        FCM::StringRep16 pName,
+        ITimelineWriter* pTimelineWriter)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_END_DEFINE_TIMELINE, static_cast<PipelinedTimelineWriter*>(pTimelineWriter));
+        event.resId = resId;
+        event.pText = CopyText(pName);
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineShape()
+    {
+        return Post(PIPELINED_START_DEFINE_SHAPE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineFill()
+    {
+        return Post(PIPELINED_START_DEFINE_FILL);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::DefineSolidFillStyle(const DOM::Utils::COLOR& color)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_DEFINE_SOLID_FILL_STYLE);
+        event.color = color;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::DefineBitmapFillStyle(
+        FCM::Boolean clipped,
+        const DOM::Utils::MATRIX2D& matrix,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        Drain();
+
+        return m_pOutputWriter->DefineBitmapFillStyle(clipped, matrix, height, width, libPathName, pMediaItem);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineLinearGradientFillStyle(
+        DOM::FillStyle::GradientSpread spread,
+        const DOM::Utils::MATRIX2D& matrix)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_START_DEFINE_LINEAR_GRADIENT_FILL_STYLE);
+        event.gradient.spread = spread;
+        event.gradient.matrix = matrix;
+        event.gradient.focalPoint = 0;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::SetKeyColorPoint(
+        const DOM::Utils::GRADIENT_COLOR_POINT& colorPoint)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_SET_KEY_COLOR_POINT);
+        event.colorPoint = colorPoint;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineLinearGradientFillStyle()
+    {
+        return Post(PIPELINED_END_DEFINE_LINEAR_GRADIENT_FILL_STYLE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineRadialGradientFillStyle(
+        DOM::FillStyle::GradientSpread spread,
+        const DOM::Utils::MATRIX2D& matrix,
+        FCM::S_Int32 focalPoint)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_START_DEFINE_RADIAL_GRADIENT_FILL_STYLE);
+        event.gradient.spread = spread;
+        event.gradient.matrix = matrix;
+        event.gradient.focalPoint = focalPoint;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineRadialGradientFillStyle()
+    {
+        return Post(PIPELINED_END_DEFINE_RADIAL_GRADIENT_FILL_STYLE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineBoundary()
+    {
+        return Post(PIPELINED_START_DEFINE_BOUNDARY);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::SetSegment(const DOM::Utils::SEGMENT& segment)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_SET_SEGMENT);
+        event.segment = segment;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineBoundary()
+    {
+        return Post(PIPELINED_END_DEFINE_BOUNDARY);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineHole()
+    {
+        return Post(PIPELINED_START_DEFINE_HOLE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineHole()
+    {
+        return Post(PIPELINED_END_DEFINE_HOLE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineStrokeGroup()
+    {
+        return Post(PIPELINED_START_DEFINE_STROKE_GROUP);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineSolidStrokeStyle(
+        FCM::Double thickness,
+        const DOM::StrokeStyle::JOIN_STYLE& joinStyle,
+        const DOM::StrokeStyle::CAP_STYLE& capStyle,
+        DOM::Utils::ScaleType scaleType,
+        FCM::Boolean strokeHinting)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_START_DEFINE_SOLID_STROKE_STYLE);
+        event.strokeStyle.thickness = thickness;
+        event.strokeStyle.joinStyle = joinStyle;
+        event.strokeStyle.capStyle = capStyle;
+        event.strokeStyle.scaleType = scaleType;
+        event.strokeStyle.strokeHinting = strokeHinting;
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineSolidStrokeStyle()
+    {
+        return Post(PIPELINED_END_DEFINE_SOLID_STROKE_STYLE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::StartDefineStroke()
+    {
+        return Post(PIPELINED_START_DEFINE_STROKE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineStroke()
+    {
+        return Post(PIPELINED_END_DEFINE_STROKE);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineStrokeGroup()
+    {
+        return Post(PIPELINED_END_DEFINE_STROKE_GROUP);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineFill()
+    {
+        return Post(PIPELINED_END_DEFINE_FILL);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::EndDefineShape(FCM::U_Int32 resId)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_END_DEFINE_SHAPE);
+        event.resId = resId;
+
+        return Post(event);
+    }
+
+
+    FCM::U_Int32 PipelinedOutputWriter::GetShapeSize(FCM::U_Int32 resId)
+    {
+        Drain();
+
+        return m_pOutputWriter->GetShapeSize(resId);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::DefineBitmap(
+        FCM::U_Int32 resId,
+        FCM::S_Int32 height,
+        FCM::S_Int32 width,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        Drain();
+
+        return m_pOutputWriter->DefineBitmap(resId, height, width, libPathName, pMediaItem);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::DefineText(
+        FCM::U_Int32 resId,
+        const std::string& name,
+        const DOM::Utils::COLOR& color,
+        const std::string& displayText,
+        DOM::FrameElement::PIClassicText pTextItem)
+    {
+        Drain();
+
+        return m_pOutputWriter->DefineText(resId, name, color, displayText, pTextItem);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::DefineSound(
+        FCM::U_Int32 resId,
+        const std::string& libPathName,
+        DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        Drain();
+
+        return m_pOutputWriter->DefineSound(resId, libPathName, pMediaItem);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::SetBitmapScale(const std::string& libPathName, FCM::Double scale)
+    {
+        Drain();
+
+        return m_pOutputWriter->SetBitmapScale(libPathName, scale);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::Post(const PIPELINED_EVENT& event)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        ASSERT(m_thread.joinable());
+
+        // Backpressure: wait for the writer thread to make room
+        if (tail - m_head.load(std::memory_order_acquire) == PIPELINED_QUEUE_SIZE)
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_WRITER_WAIT);
+
+            while (tail - m_head.load(std::memory_order_acquire) == PIPELINED_QUEUE_SIZE)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        m_queue[tail & (PIPELINED_QUEUE_SIZE - 1)] = event;
+
+        // Sequentially consistent with the check of m_sleeping below and its update in
+        // WorkerProc(), so that either the writer thread sees the event before it
+        // sleeps or it is woken up
+        m_tail.store(tail + 1);
+
+        if (m_sleeping.load())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_eventPosted.notify_one();
+        }
+
+        return m_result.load(std::memory_order_relaxed);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::Post(PipelinedEventType type)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, type);
+
+        return Post(event);
+    }
+
+
+    FCM::Result PipelinedOutputWriter::Drain()
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (m_head.load(std::memory_order_acquire) != tail)
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_WRITER_WAIT);
+
+            while (m_head.load(std::memory_order_acquire) != tail)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        return m_result;
+    }
+
+
+    void PipelinedOutputWriter::StartThread()
+    {
+        m_thread = std::thread(&PipelinedOutputWriter::WorkerProc, this);
+
+        // The JSON tree is now built on the writer thread
+        JSONArena::SetOwner(m_thread.get_id());
+    }
+
+
+    void PipelinedOutputWriter::StopThread(FCM::Boolean post)
+    {
+        if (!m_thread.joinable())
+        {
+            return;
+        }
+
+        if (post)
+        {
+            Post(PIPELINED_STOP);
+        }
+
+        m_thread.join();
+
+        JSONArena::SetOwner(std::this_thread::get_id());
+    }
+
+
+    void PipelinedOutputWriter::WorkerProc()
+    {
+        FCM::Boolean done = false;
+
+        while (!done)
+        {
+            size_t head = m_head.load(std::memory_order_relaxed);
+
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                // The publish thread is busy in the host; poll for a while before sleeping
+                for (FCM::U_Int32 i = 0; (i < PIPELINED_SPIN_COUNT) && (head == m_tail.load(std::memory_order_acquire)); i++)
+                {
+                    std::this_thread::yield();
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                m_sleeping = true;
+                while (head == m_tail.load())
+                {
+                    m_eventPosted.wait(lock);
+                }
+                m_sleeping = false;
+            }
+
+            PIPELINED_EVENT& event = m_queue[head & (PIPELINED_QUEUE_SIZE - 1)];
+
+            FCM::Result res = Replay(event);
+            if (FCM_FAILURE_CODE(res) && FCM_SUCCESS_CODE(m_result.load(std::memory_order_relaxed)))
+            {
+                m_result = res;
+            }
+
+            done = (event.type == PIPELINED_END_DOCUMENT) || (event.type == PIPELINED_STOP);
+
+            delete [] event.pText;
+            event.pText = NULL;
+
+            // Releases the slot and everything the event wrote to the publish thread
+            m_head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+
+    FCM::Result PipelinedOutputWriter::Replay(const PIPELINED_EVENT& event)
+    {
+        ITimelineWriter* pTimelineWriter = NULL;
+
+        if (event.pTimelineWriter)
+        {
+            pTimelineWriter = event.pTimelineWriter->GetTimelineWriter();
+        }
+
+        switch (event.type)
+        {
+            case PIPELINED_START_DOCUMENT:
+                return m_pOutputWriter->StartDocument(
+                    event.document.background,
+                    event.document.stageHeight,
+                    event.document.stageWidth,
+                    event.document.fps);
+
+            case PIPELINED_END_DOCUMENT:
+                return m_pOutputWriter->EndDocument();
+
+            case PIPELINED_CREATE_TIMELINE_WRITER:
+                event.pTimelineWriter->SetTimelineWriter(m_pOutputWriter->CreateTimelineWriter());
+                return FCM_SUCCESS;
+
+            case PIPELINED_START_DEFINE_TIMELINE:
+                return m_pOutputWriter->StartDefineTimeline();
+
+            case PIPELINED_END_DEFINE_TIMELINE:
+                return m_pOutputWriter->EndDefineTimeline(event.resId, event.pText, pTimelineWriter);
+
+            case PIPELINED_START_DEFINE_SHAPE:
+                return m_pOutputWriter->StartDefineShape();
+
+            case PIPELINED_START_DEFINE_FILL:
+                return m_pOutputWriter->StartDefineFill();
+
+            case PIPELINED_DEFINE_SOLID_FILL_STYLE:
+                return m_pOutputWriter->DefineSolidFillStyle(event.color);
+
+            case PIPELINED_START_DEFINE_LINEAR_GRADIENT_FILL_STYLE:
+                return m_pOutputWriter->StartDefineLinearGradientFillStyle(
+                    event.gradient.spread,
+                    event.gradient.matrix);
+
+            case PIPELINED_SET_KEY_COLOR_POINT:
+                return m_pOutputWriter->SetKeyColorPoint(event.colorPoint);
+
+            case PIPELINED_END_DEFINE_LINEAR_GRADIENT_FILL_STYLE:
+                return m_pOutputWriter->EndDefineLinearGradientFillStyle();
+
+            case PIPELINED_START_DEFINE_RADIAL_GRADIENT_FILL_STYLE:
+                return m_pOutputWriter->StartDefineRadialGradientFillStyle(
+                    event.gradient.spread,
+                    event.gradient.matrix,
+                    event.gradient.focalPoint);
+
+            case PIPELINED_END_DEFINE_RADIAL_GRADIENT_FILL_STYLE:
+                return m_pOutputWriter->EndDefineRadialGradientFillStyle();
+
+            case PIPELINED_START_DEFINE_BOUNDARY:
+                return m_pOutputWriter->StartDefineBoundary();
+
+            case PIPELINED_SET_SEGMENT:
+                return m_pOutputWriter->SetSegment(event.segment);
+
+            case PIPELINED_END_DEFINE_BOUNDARY:
+                return m_pOutputWriter->EndDefineBoundary();
+
+            case PIPELINED_START_DEFINE_HOLE:
+                return m_pOutputWriter->StartDefineHole();
+
+            case PIPELINED_END_DEFINE_HOLE:
+                return m_pOutputWriter->EndDefineHole();
+
+            case PIPELINED_START_DEFINE_STROKE_GROUP:
+                return m_pOutputWriter->StartDefineStrokeGroup();
+
+            case PIPELINED_START_DEFINE_SOLID_STROKE_STYLE:
+                return m_pOutputWriter->StartDefineSolidStrokeStyle(
+                    event.strokeStyle.thickness,
+                    event.strokeStyle.joinStyle,
+                    event.strokeStyle.capStyle,
+                    event.strokeStyle.scaleType,
+                    event.strokeStyle.strokeHinting);
+
+            case PIPELINED_END_DEFINE_SOLID_STROKE_STYLE:
+                return m_pOutputWriter->EndDefineSolidStrokeStyle();
+
+            case PIPELINED_START_DEFINE_STROKE:
+                return m_pOutputWriter->StartDefineStroke();
+
+            case PIPELINED_END_DEFINE_STROKE:
+                return m_pOutputWriter->EndDefineStroke();
+
+            case PIPELINED_END_DEFINE_STROKE_GROUP:
+                return m_pOutputWriter->EndDefineStrokeGroup();
+
+            case PIPELINED_END_DEFINE_FILL:
+                return m_pOutputWriter->EndDefineFill();
+
+            case PIPELINED_END_DEFINE_SHAPE:
+                return m_pOutputWriter->EndDefineShape(event.resId);
+
+            case PIPELINED_PLACE_OBJECT:
+                return pTimelineWriter->PlaceObject(
+                    event.resId,
+                    event.objectId,
+                    event.value,
+                    event.hasMatrix ? &event.matrix : NULL);
+
+            case PIPELINED_REMOVE_OBJECT:
+                return pTimelineWriter->RemoveObject(event.objectId);
+
+            case PIPELINED_UPDATE_Z_ORDER:
+                return pTimelineWriter->UpdateZOrder(event.objectId, event.value);
+
+            case PIPELINED_UPDATE_MASK:
+                return pTimelineWriter->UpdateMask(event.objectId, event.value);
+
+            case PIPELINED_UPDATE_BLEND_MODE:
+                return pTimelineWriter->UpdateBlendMode(
+                    event.objectId, 
+                    (DOM::FrameElement::BlendMode)event.value);
+
+            case PIPELINED_UPDATE_VISIBILITY:
+                return pTimelineWriter->UpdateVisibility(event.objectId, (FCM::Boolean)event.value);
+
+            case PIPELINED_UPDATE_DISPLAY_TRANSFORM:
+                return pTimelineWriter->UpdateDisplayTransform(event.objectId, event.matrix);
+
+            case PIPELINED_UPDATE_COLOR_TRANSFORM:
+                return pTimelineWriter->UpdateColorTransform(event.objectId, event.colorMatrix);
+
+            case PIPELINED_SHOW_FRAME:
+                return pTimelineWriter->ShowFrame(event.value);
+
+            case PIPELINED_ADD_FRAME_SCRIPT:
+                return pTimelineWriter->AddFrameScript(event.pText, event.value);
+
+            case PIPELINED_REMOVE_FRAME_SCRIPT:
+                return pTimelineWriter->RemoveFrameScript(event.value);
+
+            case PIPELINED_SET_FRAME_LABEL:
+                return pTimelineWriter->SetFrameLabel(event.pText, (DOM::KeyFrameLabelType)event.value);
+
+            case PIPELINED_STOP:
+                return FCM_SUCCESS;
+
+            default:
+                ASSERT(0);
+                break;
+        }
+
+        return FCM_SUCCESS;
+    }
+}
+
+
+/* -------------------------------------------------- PipelinedTimelineWriter */
+
+namespace CreateJS
+{
+    PipelinedTimelineWriter::PipelinedTimelineWriter(PipelinedOutputWriter* pOutputWriter)
+        : m_pOutputWriter(pOutputWriter),
+          m_pTimelineWriter(NULL)
+    {
+    }
+
+
+    PipelinedTimelineWriter::~PipelinedTimelineWriter()
+    {
+        // The wrapped writer is owned by the wrapped output writer
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::PlaceObject(
+        FCM::U_Int32 resId,
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 placeAfterObjectId,
+        const DOM::Utils::MATRIX2D* pMatrix,
+        FCM::PIFCMUnknown pUnknown /* = NULL*/)
+    {
+        PIPELINED_EVENT event;
+
+        // The placed element (a movie clip) is not queued; neither writer reads it
+        InitEvent(event, PIPELINED_PLACE_OBJECT, this, objectId);
+        event.resId = resId;
+        event.value = placeAfterObjectId;
+
+        if (pMatrix)
+        {
+            event.hasMatrix = true;
+            event.matrix = *pMatrix;
+        }
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::PlaceObject(
+        FCM::U_Int32 resId,
+        FCM::U_Int32 objectId,
+        FCM::PIFCMUnknown pUnknown /* = NULL*/)
+    {
+        // Sounds are placed with the host's sound element, which is read right away
+        m_pOutputWriter->Drain();
+
+        return m_pTimelineWriter->PlaceObject(resId, objectId, pUnknown);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::RemoveObject(
+        FCM::U_Int32 objectId)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_REMOVE_OBJECT, this, objectId);
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateZOrder(
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 placeAfterObjectId)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_Z_ORDER, this, objectId);
+        event.value = placeAfterObjectId;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateMask(
+        FCM::U_Int32 objectId,
+        FCM::U_Int32 maskTillObjectId)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_MASK, this, objectId);
+        event.value = maskTillObjectId;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateBlendMode(
+        FCM::U_Int32 objectId,
+        DOM::FrameElement::BlendMode blendMode)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_BLEND_MODE, this, objectId);
+        event.value = (FCM::U_Int32)blendMode;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateVisibility(
+        FCM::U_Int32 objectId,
+        FCM::Boolean visible)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_VISIBILITY, this, objectId);
+        event.value = (FCM::U_Int32)visible;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::AddGraphicFilter(
+        FCM::U_Int32 objectId,
+        FCM::PIFCMUnknown pFilter)
+    {
+        m_pOutputWriter->Drain();
+
+        return m_pTimelineWriter->AddGraphicFilter(objectId, pFilter);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateDisplayTransform(
+        FCM::U_Int32 objectId,
+        const DOM::Utils::MATRIX2D& matrix)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_DISPLAY_TRANSFORM, this, objectId);
+        event.matrix = matrix;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::UpdateColorTransform(
+        FCM::U_Int32 objectId,
+        const DOM::Utils::COLOR_MATRIX& colorMatrix)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_UPDATE_COLOR_TRANSFORM, this, objectId);
+        event.colorMatrix = colorMatrix;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::ShowFrame(FCM::U_Int32 frameNum)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_SHOW_FRAME, this);
+        event.value = frameNum;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_ADD_FRAME_SCRIPT, this);
+        event.value = layerNum;
+        event.pText = CopyText(pScript);
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::RemoveFrameScript(FCM::U_Int32 layerNum)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_REMOVE_FRAME_SCRIPT, this);
+        event.value = layerNum;
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    FCM::Result PipelinedTimelineWriter::SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType)
+    {
+        PIPELINED_EVENT event;
+
+        InitEvent(event, PIPELINED_SET_FRAME_LABEL, this);
+        event.value = (FCM::U_Int32)labelType;
+        event.pText = CopyText(pLabel);
+
+        return m_pOutputWriter->Post(event);
+    }
+
+
+    ITimelineWriter* PipelinedTimelineWriter::GetTimelineWriter() const
+    {
+        return m_pTimelineWriter;
+    }
+
+
+    void PipelinedTimelineWriter::SetTimelineWriter(ITimelineWriter* pTimelineWriter)
+    {
+        m_pTimelineWriter = pTimelineWriter;
+    }
+};
@@ -0,0 +1,771 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "PngImage.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "zlib.h"
+
+#include "FCMErrors.h"
+#include "GzipWriter.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+namespace CreateJS
+{
+    #define PNG_SIGNATURE_SIZE          8
+
+    #define PNG_HEADER_SIZE             13
+
+    #define PNG_COLOR_GRAY              0
+    #define PNG_COLOR_RGB               2
+    #define PNG_COLOR_PALETTE           3
+    #define PNG_COLOR_GRAY_ALPHA        4
+    #define PNG_COLOR_RGBA              6
+
+    #define PNG_FILTER_NONE             0
+    #define PNG_FILTER_SUB              1
+    #define PNG_FILTER_UP               2
+    #define PNG_FILTER_AVERAGE          3
+    #define PNG_FILTER_PAETH            4
+    #define PNG_FILTER_COUNT            5
+
+    #define PNG_ADAM7_PASSES            7
+
+    // Inflated image data is collected in steps of this size
+    #define PNG_INFLATE_BUFFER_SIZE     (64 * 1024)
+
+    static const FCM::Byte kPngSignature[PNG_SIGNATURE_SIZE] =
+    {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+
+    // First column, first row, column step and row step of each Adam7 pass
+    static const FCM::U_Int32 kAdam7[PNG_ADAM7_PASSES][4] =
+    {
+        { 0, 0, 8, 8 },
+        { 4, 0, 8, 8 },
+        { 0, 4, 4, 8 },
+        { 2, 0, 4, 4 },
+        { 0, 2, 2, 4 },
+        { 1, 0, 2, 2 },
+        { 0, 1, 1, 2 }
+    };
+}
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    static FCM::U_Int32 ReadU32(const std::string& data, size_t pos)
+    {
+        return ((FCM::U_Int32)(FCM::Byte)data[pos] << 24) |
+            ((FCM::U_Int32)(FCM::Byte)data[pos + 1] << 16) |
+            ((FCM::U_Int32)(FCM::Byte)data[pos + 2] << 8) |
+            (FCM::U_Int32)(FCM::Byte)data[pos + 3];
+    }
+
+    static FCM::U_Int32 ReadU16(const std::string& data, size_t pos)
+    {
+        return ((FCM::U_Int32)(FCM::Byte)data[pos] << 8) | (FCM::U_Int32)(FCM::Byte)data[pos + 1];
+    }
+
+    static void AppendU32(std::string& out, FCM::U_Int32 value)
+    {
+        for (FCM::S_Int32 i = 3; i >= 0; i--)
+        {
+            out.push_back((char)((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static void AppendChunk(std::string& out, const char* pType, const std::string& data)
+    {
+        std::string chunk(pType, 4);
+
+        chunk += data;
+
+        AppendU32(out, (FCM::U_Int32)data.size());
+        out += chunk;
+        AppendU32(out, GzipWriter::GetCRC32(chunk));
+    }
+
+    static inline FCM::Byte PaethPredictor(FCM::Byte a, FCM::Byte b, FCM::Byte c)
+    {
+        FCM::S_Int32 p = (FCM::S_Int32)a + b - c;
+        FCM::S_Int32 pa = abs(p - a);
+        FCM::S_Int32 pb = abs(p - b);
+        FCM::S_Int32 pc = abs(p - c);
+
+        if ((pa <= pb) && (pa <= pc))
+        {
+            return a;
+        }
+
+        return (pb <= pc) ? b : c;
+    }
+
+    // Reverses the filter of a row in place. "pPrior" is the previous row of the
+    // same pass after unfiltering (all zeros for the first row).
+    static bool Unfilter(
+        FCM::Byte filter,
+        FCM::Byte* pRow,
+        const FCM::Byte* pPrior,
+        size_t rowBytes,
+        size_t pixelBytes)
+    {
+        for (size_t i = 0; i < rowBytes; i++)
+        {
+            FCM::Byte left = (i >= pixelBytes) ? pRow[i - pixelBytes] : 0;
+            FCM::Byte upLeft = (i >= pixelBytes) ? pPrior[i - pixelBytes] : 0;
+
+            switch (filter)
+            {
+                case PNG_FILTER_NONE:
+                    break;
+
+                case PNG_FILTER_SUB:
+                    pRow[i] += left;
+                    break;
+
+                case PNG_FILTER_UP:
+                    pRow[i] += pPrior[i];
+                    break;
+
+                case PNG_FILTER_AVERAGE:
+                    pRow[i] += (FCM::Byte)(((FCM::U_Int32)left + pPrior[i]) >> 1);
+                    break;
+
+                case PNG_FILTER_PAETH:
+                    pRow[i] += PaethPredictor(left, pPrior[i], upLeft);
+                    break;
+
+                default:
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Applies "filter" to a row. Returns the sum of the filtered bytes taken as
+    // signed values, the usual estimate of how well the row will compress.
+    static FCM::U_Int32 Filter(
+        FCM::Byte filter,
+        const FCM::Byte* pRow,
+        const FCM::Byte* pPrior,
+        size_t rowBytes,
+        size_t pixelBytes,
+        FCM::Byte* pOut)
+    {
+        FCM::U_Int32 cost = 0;
+
+        for (size_t i = 0; i < rowBytes; i++)
+        {
+            FCM::Byte left = (i >= pixelBytes) ? pRow[i - pixelBytes] : 0;
+            FCM::Byte up = pPrior ? pPrior[i] : 0;
+            FCM::Byte upLeft = (pPrior && (i >= pixelBytes)) ? pPrior[i - pixelBytes] : 0;
+            FCM::Byte value = pRow[i];
+
+            switch (filter)
+            {
+                case PNG_FILTER_SUB:
+                    value -= left;
+                    break;
+
+                case PNG_FILTER_UP:
+                    value -= up;
+                    break;
+
+                case PNG_FILTER_AVERAGE:
+                    value -= (FCM::Byte)(((FCM::U_Int32)left + up) >> 1);
+                    break;
+
+                case PNG_FILTER_PAETH:
+                    value -= PaethPredictor(left, up, upLeft);
+                    break;
+            }
+
+            pOut[i] = value;
+            cost += (value < 128) ? value : (256 - value);
+        }
+
+        return cost;
+    }
+
+    // Sample "index" of a row (16-bit samples are returned in full)
+    static inline FCM::U_Int32 GetSample(const FCM::Byte* pRow, FCM::U_Int32 index, FCM::U_Int32 bitDepth)
+    {
+        if (bitDepth == 8)
+        {
+            return pRow[index];
+        }
+
+        if (bitDepth == 16)
+        {
+            return (pRow[2 * index] << 8) | pRow[2 * index + 1];
+        }
+
+        FCM::U_Int32 bit = index * bitDepth;
+        FCM::U_Int32 shift = 8 - bitDepth - (bit & 7);
+
+        return (pRow[bit >> 3] >> shift) & ((1 << bitDepth) - 1);
+    }
+
+
+    // Averages a row of RGBA pixels down to "destWidth" pixels, each the mean of the
+    // source pixels (or parts of them) it covers. Colors are premultiplied by alpha
+    // so that transparent pixels do not darken their neighbours.
+    static void ResampleRow(
+        const FCM::Byte* pSrc,
+        FCM::U_Int32 srcWidth,
+        FCM::Double* pDest,
+        FCM::U_Int32 destWidth)
+    {
+        FCM::Double scale = (FCM::Double)srcWidth / destWidth;
+
+        for (FCM::U_Int32 x = 0; x < destWidth; x++)
+        {
+            FCM::Double left = x * scale;
+            FCM::Double right = (x + 1) * scale;
+            FCM::Double* pPixel = &pDest[(size_t)x * 4];
+
+            pPixel[0] = pPixel[1] = pPixel[2] = pPixel[3] = 0;
+
+            for (FCM::U_Int32 srcX = (FCM::U_Int32)left; (srcX < srcWidth) && (srcX < right); srcX++)
+            {
+                const FCM::Byte* pSrcPixel = &pSrc[(size_t)srcX * 4];
+                FCM::Double weight = (std::min(right, srcX + 1.0) - std::max(left, (FCM::Double)srcX)) / scale;
+                FCM::Double alpha = pSrcPixel[3] * weight;
+
+                pPixel[0] += pSrcPixel[0] * alpha / 255;
+                pPixel[1] += pSrcPixel[1] * alpha / 255;
+                pPixel[2] += pSrcPixel[2] * alpha / 255;
+                pPixel[3] += alpha;
+            }
+        }
+    }
+}
+
+
+/* -------------------------------------------------- PngImage */
+
+namespace CreateJS
+{
+    PngImage::PngImage() :
+        m_width(0),
+        m_height(0)
+    {
+    }
+
+
+    void PngImage::Create(FCM::U_Int32 width, FCM::U_Int32 height)
+    {
+        m_width = width;
+        m_height = height;
+        m_pixels.assign((size_t)width * height * 4, 0);
+    }
+
+
+    FCM::Result PngImage::Read(const std::string& filePath, FCM::PIFCMCallback pCallback)
+    {
+        std::fstream file;
+        std::string content;
+        std::string header;
+        std::string palette;
+        std::string transparency;
+        std::string data;
+        size_t pos = PNG_SIGNATURE_SIZE;
+        bool ended = false;
+
+        Utils::OpenFStream(filePath, file, std::ios_base::in | std::ios_base::binary, pCallback);
+        if (!file.is_open())
+        {
+            Utils::Trace(pCallback, "Image (%s) could not be read\n", filePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        file.close();
+
+        if ((content.size() < PNG_SIGNATURE_SIZE) ||
+            (content.compare(0, PNG_SIGNATURE_SIZE, (const char*)kPngSignature, PNG_SIGNATURE_SIZE) != 0))
+        {
+            Utils::Trace(pCallback, "Image (%s) is not a PNG file\n", filePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        while (!ended && (pos + 12 <= content.size()))
+        {
+            FCM::U_Int32 length = ReadU32(content, pos);
+            std::string type = content.substr(pos + 4, 4);
+
+            if (length > content.size() - pos - 12)
+            {
+                break;
+            }
+
+            if (GzipWriter::GetCRC32(content.substr(pos + 4, length + 4)) != ReadU32(content, pos + 8 + length))
+            {
+                Utils::Trace(pCallback, "Image (%s) is damaged\n", filePath.c_str());
+                return FCM_GENERAL_ERROR;
+            }
+
+            if (type == "IHDR")
+            {
+                header = content.substr(pos + 8, length);
+            }
+            else if (type == "PLTE")
+            {
+                palette = content.substr(pos + 8, length);
+            }
+            else if (type == "tRNS")
+            {
+                transparency = content.substr(pos + 8, length);
+            }
+            else if (type == "IDAT")
+            {
+                data.append(content, pos + 8, length);
+            }
+            else if (type == "IEND")
+            {
+                ended = true;
+            }
+
+            pos += 12 + length;
+        }
+
+        if (!ended || !Decode(header, palette, transparency, data))
+        {
+            Utils::Trace(pCallback, "Image (%s) could not be decoded\n", filePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result PngImage::Write(
+        const std::string& filePath,
+        FCM::PIFCMCallback pCallback,
+        FCM::U_Int64* pSize) const
+    {
+        std::fstream file;
+        std::string out((const char*)kPngSignature, PNG_SIGNATURE_SIZE);
+        std::string header;
+        std::string raw;
+        std::string data;
+        size_t rowBytes = (size_t)m_width * 4;
+        std::vector<FCM::Byte> filtered(rowBytes);
+        std::vector<FCM::Byte> best(rowBytes);
+
+        AppendU32(header, m_width);
+        AppendU32(header, m_height);
+        header.push_back(8);
+        header.push_back(PNG_COLOR_RGBA);
+        header.push_back(0);        // Deflate
+        header.push_back(0);        // Adaptive filtering
+        header.push_back(0);        // Not interlaced
+        AppendChunk(out, "IHDR", header);
+
+        // Every row gets the filter that leaves the smallest values
+        raw.reserve(m_height * (rowBytes + 1));
+        for (FCM::U_Int32 y = 0; y < m_height; y++)
+        {
+            const FCM::Byte* pRow = &m_pixels[y * rowBytes];
+            const FCM::Byte* pPrior = (y > 0) ? pRow - rowBytes : NULL;
+            FCM::Byte bestFilter = PNG_FILTER_NONE;
+            FCM::U_Int32 bestCost = 0;
+
+            for (FCM::Byte filter = PNG_FILTER_NONE; filter < PNG_FILTER_COUNT; filter++)
+            {
+                FCM::U_Int32 cost = Filter(filter, pRow, pPrior, rowBytes, 4, &filtered[0]);
+
+                if ((filter == PNG_FILTER_NONE) || (cost < bestCost))
+                {
+                    bestFilter = filter;
+                    bestCost = cost;
+                    best.swap(filtered);
+                }
+            }
+
+            raw.push_back((char)bestFilter);
+            raw.append((const char*)&best[0], rowBytes);
+        }
+
+        GzipWriter::CompressZlib(raw, data);
+        AppendChunk(out, "IDAT", data);
+        AppendChunk(out, "IEND", "");
+
+        Utils::OpenFStream(filePath, file, std::ios_base::trunc | std::ios_base::out | std::ios_base::binary, pCallback);
+        file.write(out.data(), out.size());
+        file.close();
+
+        if (file.fail())
+        {
+            Utils::Trace(pCallback, "Image (%s) could not be written\n", filePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        if (pSize)
+        {
+            *pSize = out.size();
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    void PngImage::Copy(const PngImage& src, FCM::U_Int32 x, FCM::U_Int32 y, FCM::U_Int32 border)
+    {
+        if ((src.m_width == 0) || (src.m_height == 0))
+        {
+            return;
+        }
+
+        for (FCM::S_Int32 row = -(FCM::S_Int32)border; row < (FCM::S_Int32)(src.m_height + border); row++)
+        {
+            FCM::S_Int32 destY = (FCM::S_Int32)y + row;
+            FCM::S_Int32 srcY = std::min(std::max(row, 0), (FCM::S_Int32)src.m_height - 1);
+
+            if ((destY < 0) || (destY >= (FCM::S_Int32)m_height))
+            {
+                continue;
+            }
+
+            for (FCM::S_Int32 column = -(FCM::S_Int32)border; column < (FCM::S_Int32)(src.m_width + border); column++)
+            {
+                FCM::S_Int32 destX = (FCM::S_Int32)x + column;
+                FCM::S_Int32 srcX = std::min(std::max(column, 0), (FCM::S_Int32)src.m_width - 1);
+
+                if ((destX < 0) || (destX >= (FCM::S_Int32)m_width))
+                {
+                    continue;
+                }
+
+                const FCM::Byte* pSrc = &src.m_pixels[((size_t)srcY * src.m_width + srcX) * 4];
+                FCM::Byte* pDest = &m_pixels[((size_t)destY * m_width + destX) * 4];
+
+                std::copy(pSrc, pSrc + 4, pDest);
+            }
+        }
+    }
+
+
+    void PngImage::Resize(FCM::U_Int32 width, FCM::U_Int32 height)
+    {
+        std::vector<FCM::Byte> pixels((size_t)width * height * 4);
+        std::vector<FCM::Double> row((size_t)width * 4);
+        std::vector<FCM::Double> sum((size_t)width * 4);
+        FCM::Double scale = (FCM::Double)m_height / height;
+
+        ASSERT((width > 0) && (width <= m_width));
+        ASSERT((height > 0) && (height <= m_height));
+
+        for (FCM::U_Int32 y = 0; y < height; y++)
+        {
+            FCM::Double top = y * scale;
+            FCM::Double bottom = (y + 1) * scale;
+
+            std::fill(sum.begin(), sum.end(), 0.0);
+
+            for (FCM::U_Int32 srcY = (FCM::U_Int32)top; (srcY < m_height) && (srcY < bottom); srcY++)
+            {
+                FCM::Double weight = (std::min(bottom, srcY + 1.0) - std::max(top, (FCM::Double)srcY)) / scale;
+
+                ResampleRow(&m_pixels[(size_t)srcY * m_width * 4], m_width, &row[0], width);
+
+                for (size_t i = 0; i < sum.size(); i++)
+                {
+                    sum[i] += row[i] * weight;
+                }
+            }
+
+            for (FCM::U_Int32 x = 0; x < width; x++)
+            {
+                const FCM::Double* pSum = &sum[(size_t)x * 4];
+                FCM::Byte* pDest = &pixels[((size_t)y * width + x) * 4];
+                FCM::Double alpha = pSum[3];
+
+                if (alpha < 0.5)
+                {
+                    pDest[0] = pDest[1] = pDest[2] = pDest[3] = 0;
+                    continue;
+                }
+
+                for (FCM::U_Int32 c = 0; c < 3; c++)
+                {
+                    pDest[c] = (FCM::Byte)std::min(pSum[c] * 255 / alpha + 0.5, 255.0);
+                }
+                pDest[3] = (FCM::Byte)std::min(alpha + 0.5, 255.0);
+            }
+        }
+
+        m_width = width;
+        m_height = height;
+        m_pixels.swap(pixels);
+    }
+
+
+    FCM::Boolean PngImage::Decode(
+        const std::string& header,
+        const std::string& palette,
+        const std::string& transparency,
+        const std::string& data)
+    {
+        std::string raw;
+        FCM::U_Int32 width;
+        FCM::U_Int32 height;
+        FCM::U_Int32 bitDepth;
+        FCM::U_Int32 colorType;
+        FCM::U_Int32 channels;
+        FCM::U_Int32 passCount;
+        size_t pos = 0;
+
+        if (header.size() != PNG_HEADER_SIZE)
+        {
+            return false;
+        }
+
+        width = ReadU32(header, 0);
+        height = ReadU32(header, 4);
+        bitDepth = (FCM::Byte)header[8];
+        colorType = (FCM::Byte)header[9];
+        passCount = ((FCM::Byte)header[12] == 1) ? PNG_ADAM7_PASSES : 1;
+
+        if ((width == 0) || (height == 0) || (width > PNG_MAX_DIMENSION) || (height > PNG_MAX_DIMENSION) ||
+            (header[10] != 0) || (header[11] != 0) || ((FCM::Byte)header[12] > 1))
+        {
+            return false;
+        }
+
+        switch (colorType)
+        {
+            case PNG_COLOR_GRAY:
+                channels = 1;
+                break;
+
+            case PNG_COLOR_RGB:
+                channels = 3;
+                break;
+
+            case PNG_COLOR_PALETTE:
+                channels = 1;
+                break;
+
+            case PNG_COLOR_GRAY_ALPHA:
+                channels = 2;
+                break;
+
+            case PNG_COLOR_RGBA:
+                channels = 4;
+                break;
+
+            default:
+                return false;
+        }
+
+        switch (bitDepth)
+        {
+            case 1:
+            case 2:
+            case 4:
+                if ((colorType != PNG_COLOR_GRAY) && (colorType != PNG_COLOR_PALETTE))
+                {
+                    return false;
+                }
+                break;
+
+            case 8:
+                break;
+
+            case 16:
+                if (colorType == PNG_COLOR_PALETTE)
+                {
+                    return false;
+                }
+                break;
+
+            default:
+                return false;
+        }
+
+        if ((colorType == PNG_COLOR_PALETTE) && ((palette.size() == 0) || (palette.size() % 3 != 0)))
+        {
+            return false;
+        }
+
+        if (!Inflate(data, raw))
+        {
+            return false;
+        }
+
+        Create(width, height);
+
+        for (FCM::U_Int32 pass = 0; pass < passCount; pass++)
+        {
+            FCM::U_Int32 startX = (passCount > 1) ? kAdam7[pass][0] : 0;
+            FCM::U_Int32 startY = (passCount > 1) ? kAdam7[pass][1] : 0;
+            FCM::U_Int32 stepX = (passCount > 1) ? kAdam7[pass][2] : 1;
+            FCM::U_Int32 stepY = (passCount > 1) ? kAdam7[pass][3] : 1;
+            FCM::U_Int32 passWidth = (width > startX) ? (width - startX + stepX - 1) / stepX : 0;
+            FCM::U_Int32 passHeight = (height > startY) ? (height - startY + stepY - 1) / stepY : 0;
+            size_t rowBytes = ((size_t)passWidth * channels * bitDepth + 7) / 8;
+            size_t pixelBytes = std::max<size_t>(1, channels * bitDepth / 8);
+
+            // Empty passes have no rows at all
+            if ((passWidth == 0) || (passHeight == 0))
+            {
+                continue;
+            }
+
+            std::vector<FCM::Byte> prior(rowBytes, 0);
+
+            for (FCM::U_Int32 row = 0; row < passHeight; row++)
+            {
+                if (pos + 1 + rowBytes > raw.size())
+                {
+                    return false;
+                }
+
+                FCM::Byte filter = (FCM::Byte)raw[pos];
+                FCM::Byte* pRow = (FCM::Byte*)&raw[pos + 1];
+
+                if (!Unfilter(filter, pRow, &prior[0], rowBytes, pixelBytes))
+                {
+                    return false;
+                }
+
+                for (FCM::U_Int32 column = 0; column < passWidth; column++)
+                {
+                    FCM::U_Int32 x = startX + column * stepX;
+                    FCM::U_Int32 y = startY + row * stepY;
+                    FCM::Byte* pPixel = &m_pixels[((size_t)y * width + x) * 4];
+                    FCM::U_Int32 sample = GetSample(pRow, column * channels, bitDepth);
+                    FCM::U_Int32 gray;
+
+                    pPixel[3] = 255;
+
+                    switch (colorType)
+                    {
+                        case PNG_COLOR_GRAY:
+                            gray = (bitDepth == 16) ? (sample >> 8) : (sample * 255 / ((1 << bitDepth) - 1));
+                            pPixel[0] = pPixel[1] = pPixel[2] = (FCM::Byte)gray;
+                            if ((transparency.size() >= 2) && (sample == ReadU16(transparency, 0)))
+                            {
+                                pPixel[3] = 0;
+                            }
+                            break;
+
+                        case PNG_COLOR_PALETTE:
+                            if (sample * 3 >= palette.size())
+                            {
+                                return false;
+                            }
+                            pPixel[0] = palette[sample * 3];
+                            pPixel[1] = palette[sample * 3 + 1];
+                            pPixel[2] = palette[sample * 3 + 2];
+                            if (sample < transparency.size())
+                            {
+                                pPixel[3] = transparency[sample];
+                            }
+                            break;
+
+                        case PNG_COLOR_GRAY_ALPHA:
+                        case PNG_COLOR_RGB:
+                        case PNG_COLOR_RGBA:
+                        {
+                            FCM::U_Int32 samples[4];
+                            FCM::U_Int32 shift = (bitDepth == 16) ? 8 : 0;
+
+                            samples[0] = sample;
+                            for (FCM::U_Int32 i = 1; i < channels; i++)
+                            {
+                                samples[i] = GetSample(pRow, column * channels + i, bitDepth);
+                            }
+
+                            if (colorType == PNG_COLOR_GRAY_ALPHA)
+                            {
+                                pPixel[0] = pPixel[1] = pPixel[2] = (FCM::Byte)(samples[0] >> shift);
+                                pPixel[3] = (FCM::Byte)(samples[1] >> shift);
+                                break;
+                            }
+
+                            for (FCM::U_Int32 i = 0; i < channels; i++)
+                            {
+                                pPixel[i] = (FCM::Byte)(samples[i] >> shift);
+                            }
+
+                            // A single RGB value may be transparent
+                            if ((colorType == PNG_COLOR_RGB) && (transparency.size() >= 6))
+                            {
+                                if ((samples[0] == ReadU16(transparency, 0)) &&
+                                    (samples[1] == ReadU16(transparency, 2)) &&
+                                    (samples[2] == ReadU16(transparency, 4)))
+                                {
+                                    pPixel[3] = 0;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                }
+
+                std::copy(pRow, pRow + rowBytes, prior.begin());
+                pos += 1 + rowBytes;
+            }
+        }
+
+        return true;
+    }
+
+
+    FCM::Boolean PngImage::Inflate(const std::string& in, std::string& out)
+    {
+        z_stream stream;
+        char buffer[PNG_INFLATE_BUFFER_SIZE];
+        int res;
+
+        memset(&stream, 0, sizeof(stream));
+
+        if (inflateInit(&stream) != Z_OK)
+        {
+            return false;
+        }
+
+        stream.next_in = (Bytef*)in.data();
+        stream.avail_in = (uInt)in.size();
+
+        out.clear();
+
+        do
+        {
+            stream.next_out = (Bytef*)buffer;
+            stream.avail_out = sizeof(buffer);
+
+            res = inflate(&stream, Z_NO_FLUSH);
+
+            out.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        while (res == Z_OK);
+
+        inflateEnd(&stream);
+
+        // Truncated data ends with Z_BUF_ERROR, as no more input is available
+        return (res == Z_STREAM_END);
+    }
+};
@@ -0,0 +1,166 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "PreviewUpdate.h"
+
+#include <map>
+
+#include "libjson.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+
+/* -------------------------------------------------- PreviewUpdate */
+
+namespace CreateJS
+{
+    void PreviewUpdate::Create(
+        const OutputFileMap& previous,
+        const OutputFileMap& current,
+        const std::string& pageName,
+        std::string& message)
+    {
+        JSONNode root(JSON_NODE);
+        JSONNode update(JSON_NODE);
+        std::string dataFileName;
+
+        // The page loads <page name>.json
+        Utils::GetFileNameWithoutExtension(pageName, dataFileName);
+        dataFileName += ".json";
+
+        OutputFileMap::const_iterator previousPage = previous.find(pageName);
+        OutputFileMap::const_iterator currentPage = current.find(pageName);
+        OutputFileMap::const_iterator previousData = previous.find(dataFileName);
+        OutputFileMap::const_iterator currentData = current.find(dataFileName);
+
+        update.set_name("DOMDocument");
+
+        if ((previousPage != previous.end()) && (currentPage != current.end()) &&
+            (previousPage->second == currentPage->second) &&
+            (previousData != previous.end()) && (currentData != current.end()) &&
+            CreateUpdate(previousData->second, currentData->second, update))
+        {
+            root.push_back(JSONNode("type", "update"));
+            root.push_back(update);
+        }
+        else
+        {
+            root.push_back(JSONNode("type", "reload"));
+        }
+
+        message = root.write();
+    }
+
+
+    FCM::Boolean PreviewUpdate::CreateUpdate(
+        const std::string& previousJSON,
+        const std::string& currentJSON,
+        JSONNode& update)
+    {
+        if (!libjson::is_valid(previousJSON) || !libjson::is_valid(currentJSON))
+        {
+            return false;
+        }
+
+        JSONNode previousRoot = libjson::parse(previousJSON);
+        JSONNode currentRoot = libjson::parse(currentJSON);
+
+        JSONNode::const_iterator previousDoc = previousRoot.find("DOMDocument");
+        JSONNode::const_iterator currentDoc = currentRoot.find("DOMDocument");
+
+        if ((previousDoc == previousRoot.end()) || (currentDoc == currentRoot.end()) ||
+            (previousDoc->size() != currentDoc->size()))
+        {
+            return false;
+        }
+
+        for (JSONNode::const_iterator it = currentDoc->begin(); it != currentDoc->end(); it++)
+        {
+            JSONNode::const_iterator previousChild = previousDoc->find(it->name());
+            std::map<std::string, std::string> previousElements;
+            FCM::U_Int32 unnamedCount = 0;
+
+            if (previousChild == previousDoc->end())
+            {
+                return false;
+            }
+
+            // Only the elements of the arrays are replaced by the page
+            if (it->type() != JSON_ARRAY)
+            {
+                if (it->write() != previousChild->write())
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            for (JSONNode::const_iterator element = previousChild->begin(); element != previousChild->end(); element++)
+            {
+                previousElements[GetKey(*element, unnamedCount)] = element->write();
+            }
+
+            JSONNode changed(JSON_ARRAY);
+            changed.set_name(it->name());
+
+            unnamedCount = 0;
+            for (JSONNode::const_iterator element = it->begin(); element != it->end(); element++)
+            {
+                std::map<std::string, std::string>::const_iterator previousElement =
+                    previousElements.find(GetKey(*element, unnamedCount));
+
+                if (previousElement == previousElements.end())
+                {
+                    changed.push_back(*element);
+                    continue;
+                }
+
+                if (previousElement->second != element->write())
+                {
+                    changed.push_back(*element);
+                }
+                previousElements.erase(previousElement);
+            }
+
+            // The page never removes elements. Ids are handed out in traversal order,
+            // so an id that left this array may now be a resource of another kind.
+            if (!previousElements.empty())
+            {
+                return false;
+            }
+
+            if (!changed.empty())
+            {
+                update.push_back(changed);
+            }
+        }
+
+        return true;
+    }
+
+
+    // Elements without an id (the main timeline) are told apart by their order
+    std::string PreviewUpdate::GetKey(const JSONNode& element, FCM::U_Int32& unnamedCount)
+    {
+        JSONNode::const_iterator id = element.find(PREVIEW_UPDATE_ID_KEY);
+
+        if (id != element.end())
+        {
+            return id->as_string();
+        }
+
+        return "#" + Utils::ToString(unnamedCount++);
+    }
+};
@@ -0,0 +1,395 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "PublishProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Utils.h"
+
+#ifdef _WINDOWS
+    #include "Windows.h"
+    #include "Psapi.h"
+    #pragma comment(lib, "psapi.lib")
+#else
+    #include <sys/resource.h>
+#endif
+
+/* -------------------------------------------------- Constants */
+
+namespace CreateJS
+{
+    static const char* kPhaseNames[PROFILE_PHASE_COUNT] =
+    {
+        "Publish",
+        "GenerateFrameCommands",
+        "ExportFill",
+        "ExportStroke",
+        "ExportBitmap",
+        "ExportSound",
+        "Serialize",
+        "WriterWait",
+        "CopyRuntime",
+        "Compress",
+        "PackBitmaps",
+        "DeduplicateAssets",
+        "ResampleBitmaps"
+    };
+
+    static const char* kCounterNames[PROFILE_COUNTER_COUNT] =
+    {
+        "Shapes held in memory",
+        "Commands in a frame"
+    };
+}
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    struct PROFILE_PHASE_STATS
+    {
+        FCM::U_Int64 calls;
+
+        FCM::U_Int64 totalTime;
+
+        FCM::U_Int64 maxTime;
+
+        FCM::U_Int64 bytes;
+    };
+
+    struct PROFILE_TRACE_EVENT
+    {
+        ProfilePhase phase;
+
+        FCM::U_Int32 threadIndex;
+
+        FCM::U_Int64 startTime;
+
+        FCM::U_Int64 duration;
+    };
+
+    static std::atomic<bool> s_running(false);
+    static bool s_recordTrace = false;
+    static std::chrono::steady_clock::time_point s_startTime;
+
+    // Everything below is guarded by s_mutex
+    static std::mutex s_mutex;
+    static PROFILE_PHASE_STATS s_phases[PROFILE_PHASE_COUNT];
+    static FCM::U_Int64 s_peaks[PROFILE_COUNTER_COUNT];
+    static std::vector<PROFILE_TRACE_EVENT> s_events;
+    static std::map<std::thread::id, FCM::U_Int32> s_threadIndices;
+
+    // Peak resident memory of the process (not only of this publish), 0 if unknown
+    static FCM::U_Int64 GetPeakResidentMemory()
+    {
+#ifdef _WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return (FCM::U_Int64)counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        struct rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return (FCM::U_Int64)usage.ru_maxrss;
+#else
+        return (FCM::U_Int64)usage.ru_maxrss * 1024;
+#endif
+#endif
+    }
+}
+
+
+/* -------------------------------------------------- PublishProfiler */
+
+namespace CreateJS
+{
+    void PublishProfiler::Start(FCM::Boolean recordTrace)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        for (FCM::U_Int32 i = 0; i < PROFILE_PHASE_COUNT; i++)
+        {
+            s_phases[i].calls = 0;
+            s_phases[i].totalTime = 0;
+            s_phases[i].maxTime = 0;
+            s_phases[i].bytes = 0;
+        }
+
+        for (FCM::U_Int32 i = 0; i < PROFILE_COUNTER_COUNT; i++)
+        {
+            s_peaks[i] = 0;
+        }
+
+        s_events.clear();
+        s_threadIndices.clear();
+
+        s_recordTrace = recordTrace;
+        s_startTime = std::chrono::steady_clock::now();
+        s_running = true;
+    }
+
+
+    void PublishProfiler::Stop(FCM::PIFCMCallback pCallback, const std::string& traceFilePath)
+    {
+        if (!s_running)
+        {
+            return;
+        }
+
+        s_running = false;
+
+        TraceSummary(pCallback);
+
+        if (s_recordTrace && !traceFilePath.empty())
+        {
+            WriteTrace(pCallback, traceFilePath);
+        }
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        // Release the events right away; they can be large
+        std::vector<PROFILE_TRACE_EVENT>().swap(s_events);
+    }
+
+
+    FCM::Boolean PublishProfiler::IsRunning()
+    {
+        return s_running;
+    }
+
+
+    FCM::U_Int64 PublishProfiler::Now()
+    {
+        return (FCM::U_Int64)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - s_startTime).count();
+    }
+
+
+    void PublishProfiler::AddSample(ProfilePhase phase, FCM::U_Int64 startTime, FCM::U_Int64 endTime)
+    {
+        FCM::U_Int64 duration = (endTime > startTime) ? (endTime - startTime) : 0;
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        PROFILE_PHASE_STATS& stats = s_phases[phase];
+
+        stats.calls++;
+        stats.totalTime += duration;
+        if (duration > stats.maxTime)
+        {
+            stats.maxTime = duration;
+        }
+
+        if (s_recordTrace && (s_events.size() < MAX_PROFILE_TRACE_EVENTS))
+        {
+            PROFILE_TRACE_EVENT event;
+
+            std::map<std::thread::id, FCM::U_Int32>::iterator it =
+                s_threadIndices.find(std::this_thread::get_id());
+            if (it == s_threadIndices.end())
+            {
+                FCM::U_Int32 index = (FCM::U_Int32)s_threadIndices.size() + 1;
+                it = s_threadIndices.insert(std::make_pair(std::this_thread::get_id(), index)).first;
+            }
+
+            event.phase = phase;
+            event.threadIndex = it->second;
+            event.startTime = startTime;
+            event.duration = duration;
+
+            s_events.push_back(event);
+        }
+    }
+
+
+    void PublishProfiler::AddBytes(ProfilePhase phase, FCM::U_Int64 bytes)
+    {
+        if (!s_running)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        s_phases[phase].bytes += bytes;
+    }
+
+
+    void PublishProfiler::RecordPeak(ProfileCounter counter, FCM::U_Int64 value)
+    {
+        if (!s_running)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        if (value > s_peaks[counter])
+        {
+            s_peaks[counter] = value;
+        }
+    }
+
+
+    void PublishProfiler::TraceSummary(FCM::PIFCMCallback pCallback)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        Utils::Trace(pCallback, "Publish profile (phases nest, times are inclusive):\n");
+        Utils::Trace(pCallback, "  %-24s %8s %12s %10s %12s\n", "Phase", "Calls", "Total ms", "Max ms", "Bytes");
+
+        for (FCM::U_Int32 i = 0; i < PROFILE_PHASE_COUNT; i++)
+        {
+            const PROFILE_PHASE_STATS& stats = s_phases[i];
+
+            if (stats.calls == 0)
+            {
+                continue;
+            }
+
+            Utils::Trace(
+                pCallback,
+                "  %-24s %8llu %12.2f %10.2f %12llu\n",
+                kPhaseNames[i],
+                (unsigned long long)stats.calls,
+                stats.totalTime / 1000.0,
+                stats.maxTime / 1000.0,
+                (unsigned long long)stats.bytes);
+        }
+
+        for (FCM::U_Int32 i = 0; i < PROFILE_COUNTER_COUNT; i++)
+        {
+            Utils::Trace(pCallback, "  Peak %s: %llu\n", kCounterNames[i], (unsigned long long)s_peaks[i]);
+        }
+
+        Utils::Trace(pCallback, "  Peak resident memory (process): %llu KB\n",
+            (unsigned long long)(GetPeakResidentMemory() / 1024));
+
+        if (s_recordTrace && (s_events.size() >= MAX_PROFILE_TRACE_EVENTS))
+        {
+            Utils::Trace(pCallback, "  Trace truncated to the first %u events\n", MAX_PROFILE_TRACE_EVENTS);
+        }
+    }
+
+
+    FCM::Result PublishProfiler::WriteTrace(FCM::PIFCMCallback pCallback, const std::string& traceFilePath)
+    {
+        std::fstream file;
+
+        Utils::OpenFStream(traceFilePath, file, std::ios_base::trunc|std::ios_base::out, pCallback);
+        if (!file.is_open())
+        {
+            Utils::Trace(pCallback, "Publish trace (%s) could not be written\n", traceFilePath.c_str());
+            return FCM_GENERAL_ERROR;
+        }
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        // Chrome trace event format ("X" is a complete event; times are in microseconds)
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        for (size_t i = 0; i < s_events.size(); i++)
+        {
+            const PROFILE_TRACE_EVENT& event = s_events[i];
+
+            if (i > 0)
+            {
+                file << ",";
+            }
+
+            file << "{\"name\":\"" << kPhaseNames[event.phase] << "\""
+                 << ",\"cat\":\"publish\",\"ph\":\"X\",\"pid\":1"
+                 << ",\"tid\":" << event.threadIndex
+                 << ",\"ts\":" << event.startTime
+                 << ",\"dur\":" << event.duration << "}";
+        }
+
+        file << "]}";
+        file.close();
+
+        Utils::Trace(pCallback, "Publish trace written to %s\n", traceFilePath.c_str());
+
+        return FCM_SUCCESS;
+    }
+
+
+    /* -------------------------------------------------- ScopedProfileTimer */
+
+    ScopedProfileTimer::ScopedProfileTimer(ProfilePhase phase)
+        : m_phase(phase),
+          m_startTime(0),
+          m_running(PublishProfiler::IsRunning())
+    {
+        if (m_running)
+        {
+            m_startTime = PublishProfiler::Now();
+        }
+    }
+
+
+    ScopedProfileTimer::~ScopedProfileTimer()
+    {
+        // The profiler may have been stopped in the meantime; the sample is then dropped
+        if (m_running && PublishProfiler::IsRunning())
+        {
+            PublishProfiler::AddSample(m_phase, m_startTime, PublishProfiler::Now());
+        }
+    }
+
+
+    /* -------------------------------------------------- ScopedPublishProfiler */
+
+    ScopedPublishProfiler::ScopedPublishProfiler(
+        FCM::PIFCMCallback pCallback, 
+        FCM::Boolean enabled, 
+        FCM::Boolean recordTrace)
+        : m_pCallback(pCallback),
+          m_started(enabled)
+    {
+        if (m_started)
+        {
+            PublishProfiler::Start(recordTrace);
+        }
+    }
+
+
+    ScopedPublishProfiler::~ScopedPublishProfiler()
+    {
+        // A publish that failed part way still reports what it measured, but writes
+        // no trace
+        Stop("");
+    }
+
+
+    void ScopedPublishProfiler::Stop(const std::string& traceFilePath)
+    {
+        if (m_started)
+        {
+            m_started = false;
+            PublishProfiler::Stop(m_pCallback, traceFilePath);
+        }
+    }
+};
@@ -12,54 +12,23 @@
 #include "Publisher.h"
 #include "Utils.h"
 #include "HTTPServer.h"
+#include "PreviewUpdate.h"
+#include "AssetExportQueue.h"
 #include "ApplicationFCMPublicIDs.h"
 
-#include "FrameElement/IShape.h"
-
-#include "StrokeStyle/IDashedStrokeStyle.h"
-#include "StrokeStyle/IDottedStrokeStyle.h"
-#include "StrokeStyle/IHatchedStrokeStyle.h"
-#include "StrokeStyle/IRaggedStrokeStyle.h"
-#include "StrokeStyle/ISolidStrokeStyle.h"
-#include "StrokeStyle/IStippleStrokeStyle.h"
-#include "StrokeStyle/IStrokeWidth.h"
-
-#include "FillStyle/ISolidFillStyle.h"
-#include "FillStyle/IGradientFillStyle.h"
-#include "FillStyle/IBitmapFillStyle.h"
-
-
-#include "MediaInfo/IBitmapInfo.h"
-#include "FrameElement/IBitmapInstance.h"
-#include "FrameElement/ISound.h"
-#include "MediaInfo/ISoundInfo.h"
 #include "LibraryItem/IMediaItem.h"
 #include "LibraryItem/IFolderItem.h"
 #include "LibraryItem/IFontItem.h"
 #include "LibraryItem/ISymbolItem.h"
 #include "ILibraryItem.h"
 
-#include "FrameElement/IButton.h"
-#include "FrameElement/IClassicText.h"
-#include "FrameElement/ITextStyle.h"
-#include "FrameElement/IParagraph.h"
-#include "FrameElement/ITextRun.h"
-#include "FrameElement/ITextBehaviour.h"
-
-#include "Service/Shape/IRegionGeneratorService.h"
-#include "Service/Shape/IFilledRegion.h"
-#include "Service/Shape/IStrokeGroup.h"
-#include "Service/Shape/IPath.h"
-#include "Service/Shape/IEdge.h"
-#include "Service/Shape/IShapeService.h"
-#include "Service/Image/IBitmapExportService.h"
-
-
-#include "Utils/DOMTypes.h"
-#include "Utils/ILinearColorGradient.h"
-#include "Utils/IRadialColorGradient.h"
-
 #include "OutputWriter.h"
+#include "BinaryOutputWriter.h"
+#include "PublishProfiler.h"
+#include "ServiceRegistry.h"
+#include "JSONArena.h"
+#include "PathSimplifier.h"
+#include "PipelinedOutputWriter.h"
 
 #include "Exporter/Service/IResourcePalette.h"
 #include "Exporter/Service/ITimelineBuilder2.h"
@@ -75,13 +44,17 @@ namespace CreateJS
     /* ----------------------------------------------------- CPublisher */
     
     CPublisher::CPublisher()
+        : m_pServiceCallback(NULL)
     {
 
     }
 
     CPublisher::~CPublisher()
     {
-
+        if (m_pServiceCallback)
+        {
+            ServiceRegistry::Unregister(m_pServiceCallback);
+        }
     }
 
 
@@ -90,7 +63,11 @@ namespace CreateJS
         const PIFCMDictionary pDictPublishSettings, 
         const PIFCMDictionary pDictConfig)
     {
-        return Export(pFlaDocument, NULL, NULL, pDictPublishSettings, pDictConfig);
+        FCM::Result res = Export(pFlaDocument, NULL, NULL, pDictPublishSettings, pDictConfig);
+
+        EndExport();
+
+        return res;
     }
 
     // This function will be currently called in "Test-Scene" workflow. 
@@ -102,7 +79,23 @@ namespace CreateJS
         const PIFCMDictionary pDictPublishSettings, 
         const PIFCMDictionary pDictConfig)
     {
-        return Export(pFlaDocument, pTimeline, &frameRange, pDictPublishSettings, pDictConfig);
+        FCM::Result res = Export(pFlaDocument, pTimeline, &frameRange, pDictPublishSettings, pDictConfig);
+
+        EndExport();
+
+        return res;
+    }
+
+
+    // The palette lives until the next publish, the host objects it holds must not
+    void CPublisher::EndExport()
+    {
+        if (m_pResourcePalette)
+        {
+            ResourcePalette* pResPalette = static_cast<ResourcePalette*>(m_pResourcePalette.m_Ptr);
+
+            pResPalette->EndExport();
+        }
     }
 
 
@@ -183,13 +176,54 @@ namespace CreateJS
         AutoPtr<ITimelineBuilderFactory> pTimelineBuilderFactory;
         FCM::FCMListPtr pTimelineList;
         FCM::U_Int32 timelineCount;
+        OUTPUT_SETTINGS outputSettings;
+        OutputFileMap outputFiles;
+        FCM::Boolean previewNeeded = IsPreviewNeeded(pDictConfig);
+        FCM::U_Int64 publishStartTime = 0;
+
+        ScopedPublishProfiler profiler(
+            GetCallback(), 
+            ReadBoolean(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_Profile, false), 
+            ReadBoolean(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_ProfileTrace, false));
+
+        if (PublishProfiler::IsRunning())
+        {
+            publishStartTime = PublishProfiler::Now();
+            ServiceRegistry::ResetStats();
+        }
+
+        ReadOutputSettings(pDictPublishSettings, outputSettings);
+
+#ifdef USE_HTTP_SERVER
+        // The preview server serves the data file and the page from memory
+        outputSettings.keepOutputFiles = previewNeeded;
+#endif
+
+        // The JSON tree is built on an arena that is released when the writer is gone.
+        // Streamed output releases each shape once written, which the arena would undo.
+        ScopedJSONArena jsonArena(
+            (outputSettings.outputFormat == JSON_OUTPUT_FORMAT) && !outputSettings.streamOutput);
 
         // Create a output writer
-        std::auto_ptr<IOutputWriter> pOutputWriter(new JSONOutputWriter(GetCallback()));
+        std::auto_ptr<IOutputWriter> pOutputWriter;
+        if (outputSettings.outputFormat == BINARY_OUTPUT_FORMAT)
+        {
+            pOutputWriter.reset(new BinaryOutputWriter(GetCallback(), outputSettings));
+        }
+        else
+        {
+            pOutputWriter.reset(new JSONOutputWriter(GetCallback(), outputSettings));
+        }
+
         if (pOutputWriter.get() == NULL)
         {
             return FCM_MEM_NOT_AVAILABLE;
         }
+
+        if (outputSettings.pipelinedOutput)
+        {
+            pOutputWriter.reset(new PipelinedOutputWriter(pOutputWriter.release()));
+        }
         
         // Start output
         pOutputWriter->StartOutput(outFile);
@@ -205,12 +239,13 @@ namespace CreateJS
             return res;
         }
 
-        (static_cast<TimelineBuilderFactory*>(pTimelineBuilderFactory.m_Ptr))->Init(
-            pOutputWriter.get());
-
         ResourcePalette* pResPalette = static_cast<ResourcePalette*>(m_pResourcePalette.m_Ptr);
         pResPalette->Clear();
-        pResPalette->Init(pOutputWriter.get());
+        pResPalette->Init(pOutputWriter.get(), outputSettings.dedupShapes, outputSettings.simplifyTolerance);
+
+        (static_cast<TimelineBuilderFactory*>(pTimelineBuilderFactory.m_Ptr))->Init(
+            pOutputWriter.get(), 
+            pResPalette);
 
         res = pFlaDocument->GetBackgroundColor(color);
         ASSERT(FCM_SUCCESS_CODE(res));
@@ -246,25 +281,21 @@ namespace CreateJS
             }
 
             /*
-             * IMPORTANT NOTE: 
-             *  
-             * For the current sample plugin, multiple scene export is not supported.
-             * Supporting export of multiple scene is little tricky. This is due to
-             * the fact that IFrameCommandGenerator::GenerateFrameCommands() expects
-             * that a new empty resource palette is passed for each timeline.
+             * IFrameCommandGenerator::GenerateFrameCommands() expects a new empty 
+             * resource palette for each timeline (scene), and numbers the resources 
+             * of every scene from the start. The palette is therefore restarted for 
+             * each scene and maps the ids of a scene to ids that are unique in the 
+             * document. Library items (matched by name) and identical shapes that are 
+             * used by several scenes are defined only once. So are the shapes inside 
+             * the symbols shared by several scenes: the generator sends them again for 
+             * each scene, and the palette holds the shapes of a scene until the end of 
+             * it to map those to their first definition.
              *
-             * In other words, for each timeline (scene), a resource palette is exported.
-             * So, if a resource is present in 2 scenes, its definition will be replicated 
-             * in both the resource palettes. Plugin can choose to optimize by comparing the
-             * resource names to find the common resources and put it in a global resource 
-             * palette and also modifying the timeline builder commands to use the new 
-             * resource ids.
-             *
-             * For our current implementation, we chosen to keep it simple and not support
-             * multiple scenes. For this plugin to work, the feature "Scene" must be disabled 
-             * by the corresponding DocType.
+             * Each scene is written as a movie clip. The main timeline places them 
+             * one after the other, each for as many frames as the scene has.
              */
-            ASSERT(timelineCount == 1);
+            std::vector<FCM::U_Int32> sceneResourceIds;
+            std::vector<FCM::U_Int32> sceneFrameCounts;
 
             // Generate frame commands for each timeline
             for (FCM::U_Int32 i = 0; i < timelineCount; i++)
@@ -284,28 +315,60 @@ namespace CreateJS
 
                 range.max--;
 
+                if (timelineCount > 1)
+                {
+                    pResPalette->StartScene();
+                }
+
                 // Generate frame commands
-                res = m_frameCmdGeneratorService->GenerateFrameCommands(
-                    timeline, 
-                    range, 
-                    pDictPublishSettings,
-                    m_pResourcePalette, 
-                    pTimelineBuilderFactory, 
-                    pTimelineBuilder.m_Ptr);
+                {
+                    PROFILE_SCOPE(PROFILE_PHASE_GENERATE_FRAME_COMMANDS);
+
+                    res = m_frameCmdGeneratorService->GenerateFrameCommands(
+                        timeline, 
+                        range, 
+                        pDictPublishSettings,
+                        m_pResourcePalette, 
+                        pTimelineBuilderFactory, 
+                        pTimelineBuilder.m_Ptr);
+                }
 
                 if (FCM_FAILURE_CODE(res))
                 {
                     return res;
                 }
 
-                ((TimelineBuilder*)pTimelineBuilder.m_Ptr)->Build(0, NULL, &pTimelineWriter);
+                if (timelineCount > 1)
+                {
+                    pResPalette->EndScene();
+
+                    FCM::U_Int32 sceneResourceId = pResPalette->AllocateResourceId();
+
+                    ((TimelineBuilder*)pTimelineBuilder.m_Ptr)->Build(sceneResourceId, NULL, &pTimelineWriter);
+
+                    sceneResourceIds.push_back(sceneResourceId);
+                    sceneFrameCounts.push_back(range.max + 1);
+                }
+                else
+                {
+                    ((TimelineBuilder*)pTimelineBuilder.m_Ptr)->Build(0, NULL, &pTimelineWriter);
+                }
+            }
+
+            if (timelineCount > 1)
+            {
+                res = ExportSceneTimeline(pOutputWriter.get(), sceneResourceIds, sceneFrameCounts);
+                if (FCM_FAILURE_CODE(res))
+                {
+                    return res;
+                }
             }
 
-            res = pOutputWriter->EndDocument();
-            ASSERT(FCM_SUCCESS_CODE(res));
+            pResPalette->TraceShapeDedupReport();
+            pResPalette->TraceSimplifyReport();
+            pResPalette->TraceSharedResourceReport();
 
-            res = pOutputWriter->EndOutput();
-            ASSERT(FCM_SUCCESS_CODE(res));
+            res = FinishOutput(pOutputWriter.get());
 
             // Export the library items with linkages
             FCM::FCMListPtr pLibraryItemList;
@@ -324,13 +387,17 @@ namespace CreateJS
             ITimelineWriter* pTimelineWriter;
 
             // Generate frame commands
-            res = m_frameCmdGeneratorService->GenerateFrameCommands(
-                pTimeline, 
-                *pFrameRange, 
-                pDictPublishSettings,
-                m_pResourcePalette, 
-                pTimelineBuilderFactory, 
-                pTimelineBuilder.m_Ptr);
+            {
+                PROFILE_SCOPE(PROFILE_PHASE_GENERATE_FRAME_COMMANDS);
+
+                res = m_frameCmdGeneratorService->GenerateFrameCommands(
+                    pTimeline, 
+                    *pFrameRange, 
+                    pDictPublishSettings,
+                    m_pResourcePalette, 
+                    pTimelineBuilderFactory, 
+                    pTimelineBuilder.m_Ptr);
+            }
 
             if (FCM_FAILURE_CODE(res))
             {
@@ -339,26 +406,70 @@ namespace CreateJS
 
             ((TimelineBuilder*)pTimelineBuilder.m_Ptr)->Build(0, NULL, &pTimelineWriter);
 
-            res = pOutputWriter->EndDocument();
-            ASSERT(FCM_SUCCESS_CODE(res));
+            pResPalette->TraceShapeDedupReport();
+            pResPalette->TraceSimplifyReport();
 
-            res = pOutputWriter->EndOutput();
-            ASSERT(FCM_SUCCESS_CODE(res));
+            res = FinishOutput(pOutputWriter.get());
         }
 
+        pOutputWriter->TakeOutputFiles(outputFiles);
+
+        JSON_ARENA_STATS arenaStats;
+        JSONArena::GetStats(arenaStats);
+
+        // No JSON node may outlive the arena
+        pOutputWriter.reset();
+        jsonArena.Close();
+
 #ifdef USE_RUNTIME
 
         // We are now going to copy the runtime from the zxp package to the output folder.
+        // Previews are served the package copy, but the published folder must still be
+        // complete for anyone who opens or deploys it afterwards. The copy is skipped
+        // when the folder already has the runtime of this package.
         std::string outFolder;
         
         Utils::GetParent(outFile, outFolder);
 
-        CopyRuntime(outFolder);
+        {
+            PROFILE_SCOPE(PROFILE_PHASE_COPY_RUNTIME);
+
+            CopyRuntime(outFolder);
+        }
 
 #endif
-        if (IsPreviewNeeded(pDictConfig))
+        if (PublishProfiler::IsRunning())
+        {
+            std::string traceFolder;
+            std::string traceName;
+
+            FCM::U_Int64 cachedLookups;
+            FCM::U_Int64 hostLookups;
+
+            PublishProfiler::AddSample(PROFILE_PHASE_PUBLISH, publishStartTime, PublishProfiler::Now());
+
+            ServiceRegistry::GetStats(cachedLookups, hostLookups);
+            Utils::Trace(GetCallback(), "Core service lookups: %llu cached, %llu sent to the host\n",
+                (unsigned long long)cachedLookups, (unsigned long long)hostLookups);
+
+            if (arenaStats.chunkCount > 0)
+            {
+                Utils::Trace(GetCallback(), "JSON arena: %llu allocations (%llu KB in %u chunks), %llu on the heap\n",
+                    (unsigned long long)arenaStats.arenaAllocations,
+                    (unsigned long long)(arenaStats.bytesReserved / 1024),
+                    arenaStats.chunkCount,
+                    (unsigned long long)arenaStats.heapAllocations);
+            }
+
+            Utils::GetParent(outFile, traceFolder);
+            Utils::GetFileNameWithoutExtension(outFile, traceName);
+            profiler.Stop(traceFolder + traceName + PROFILE_TRACE_FILE_EXT);
+        }
+
+
+        if (previewNeeded)
         {
-            ShowPreview(outFile);
+            ShowPreview(outFile, outputFiles);
         }
 
 #endif
@@ -487,6 +598,232 @@ namespace CreateJS
     }
 
 
+    FCM::Boolean CPublisher::ReadBoolean(
+        const FCM::PIFCMDictionary pDict,
+        FCM::StringRep8 key, 
+        FCM::Boolean defaultValue)
+    {
+        std::string value;
+
+        if (!ReadString(pDict, key, value))
+        {
+            return defaultValue;
+        }
+
+        return (value == "true");
+    }
+
+
+    void CPublisher::ReadOutputSettings(
+        const PIFCMDictionary pDictPublishSettings, 
+        OUTPUT_SETTINGS& settings)
+    {
+        settings.streamOutput = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_StreamOutput, 
+            false);
+
+        settings.numberPrecision = DEFAULT_NUMBER_PRECISION;
+
+        std::string precision;
+        if (ReadString(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_NumberPrecision, precision))
+        {
+            int value = atoi(precision.c_str());
+            if ((value >= 0) && (value <= MAX_NUMBER_PRECISION))
+            {
+                settings.numberPrecision = (FCM::U_Int32)value;
+            }
+        }
+
+        settings.assetExportThreads = 0;
+        if (!ReadBoolean(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_SerialAssetExport, false))
+        {
+            // hardware_concurrency() may return 0, in which case export stays serial
+            settings.assetExportThreads = std::thread::hardware_concurrency();
+            if (settings.assetExportThreads > MAX_ASSET_EXPORT_THREADS)
+            {
+                settings.assetExportThreads = MAX_ASSET_EXPORT_THREADS;
+            }
+        }
+
+        settings.compressTimeline = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_CompressTimeline, 
+            false);
+
+        settings.writeTweens = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_WriteTweens, 
+            false);
+
+        settings.morphShapes = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_MorphShapes, 
+            false);
+
+        settings.dedupShapes = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_DedupShapes, 
+            true);
+
+        settings.compactPaths = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_CompactPaths, 
+            false);
+
+        settings.pipelinedOutput = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_PipelinedOutput, 
+            false);
+
+        settings.precompressOutput = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_PrecompressOutput, 
+            false);
+
+        settings.packBitmaps = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_PackBitmaps, 
+            false);
+
+        settings.resampleBitmaps = ReadBoolean(
+            pDictPublishSettings, 
+            (FCM::StringRep8)kPublishSettingsKey_ResampleBitmaps, 
+            false);
+
+        settings.resampleHeadroom = 1;
+
+        std::string headroom;
+        if (ReadString(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_ResampleHeadroom, headroom))
+        {
+            double value = atof(headroom.c_str());
+            if ((value >= 1) && (value <= MAX_RESAMPLE_HEADROOM))
+            {
+                settings.resampleHeadroom = value;
+            }
+        }
+
+        settings.bitmapQuality = BITMAP_EXPORT_QUALITY;
+
+        std::string quality;
+        if (ReadString(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_BitmapQuality, quality))
+        {
+            int value = atoi(quality.c_str());
+            if ((value >= 1) && (value <= 100))
+            {
+                settings.bitmapQuality = (FCM::U_Int32)value;
+            }
+        }
+
+        settings.simplifyTolerance = 0;
+
+        std::string tolerance;
+        if (ReadString(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_SimplifyTolerance, tolerance))
+        {
+            double value = atof(tolerance.c_str());
+            if ((value > 0) && (value <= MAX_SIMPLIFY_TOLERANCE))
+            {
+                settings.simplifyTolerance = value;
+            }
+        }
+
+        settings.outputFormat = JSON_OUTPUT_FORMAT;
+
+        std::string format;
+        if (ReadString(pDictPublishSettings, (FCM::StringRep8)kPublishSettingsKey_OutputFormat, format))
+        {
+            if (format == "binary")
+            {
+                settings.outputFormat = BINARY_OUTPUT_FORMAT;
+            }
+        }
+    }
+
+
+    FCM::Result CPublisher::FinishOutput(IOutputWriter* pOutputWriter)
+    {
+        FCM::Result res;
+
+        PROFILE_SCOPE(PROFILE_PHASE_SERIALIZE);
+
+        // The scales are only known once every timeline has been built
+        ResourcePalette* pResPalette = static_cast<ResourcePalette*>(m_pResourcePalette.m_Ptr);
+        BitmapScaleMap bitmapScales;
+
+        pResPalette->GetBitmapScaleTracker().GetBitmapScales(bitmapScales);
+
+        for (BitmapScaleMap::const_iterator it = bitmapScales.begin(); it != bitmapScales.end(); ++it)
+        {
+            res = pOutputWriter->SetBitmapScale(it->first, it->second);
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        res = pOutputWriter->EndDocument();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pOutputWriter->EndOutput();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return res;
+    }
+
+
+    FCM::Result CPublisher::ExportSceneTimeline(
+        IOutputWriter* pOutputWriter, 
+        const std::vector<FCM::U_Int32>& sceneResourceIds, 
+        const std::vector<FCM::U_Int32>& sceneFrameCounts)
+    {
+        FCM::Result res;
+        FCM::U_Int32 frameNum = 0;
+        DOM::Utils::MATRIX2D matrix;
+
+        ASSERT(sceneResourceIds.size() == sceneFrameCounts.size());
+
+        matrix.a = 1;
+        matrix.b = 0;
+        matrix.c = 0;
+        matrix.d = 1;
+        matrix.tx = 0;
+        matrix.ty = 0;
+
+        res = pOutputWriter->StartDefineTimeline();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        ITimelineWriter* pTimelineWriter = pOutputWriter->CreateTimelineWriter();
+        ASSERT(pTimelineWriter);
+
+        for (size_t i = 0; i < sceneResourceIds.size(); i++)
+        {
+            // The scene i is object i + 1; it replaces the scene before it
+            if (i > 0)
+            {
+                res = pTimelineWriter->RemoveObject((FCM::U_Int32)i);
+                if (FCM_FAILURE_CODE(res))
+                {
+                    return res;
+                }
+            }
+
+            res = pTimelineWriter->PlaceObject(sceneResourceIds[i], (FCM::U_Int32)(i + 1), 0, &matrix);
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+
+            for (FCM::U_Int32 j = 0; j < sceneFrameCounts[i]; j++)
+            {
+                res = pTimelineWriter->ShowFrame(frameNum++);
+                if (FCM_FAILURE_CODE(res))
+                {
+                    return res;
+                }
+            }
+        }
+
+        return pOutputWriter->EndDefineTimeline(0, NULL, pTimelineWriter);
+    }
+
+
     FCM::Boolean CPublisher::IsPreviewNeeded(const PIFCMDictionary pDictConfig)
     {
         FCM::Boolean found;
@@ -511,32 +848,58 @@ namespace CreateJS
     }
 
 
-    FCM::Result CPublisher::ShowPreview(const std::string& outFile)
+    // The server is started by the first preview and re-pointed by the later ones,
+    // so that a preview costs neither a restart nor a new port. Pages of the document
+    // that are still open are updated in place instead of opening a new one.
+    FCM::Result CPublisher::ShowPreview(const std::string& outFile, OutputFileMap& outputFiles)
     {
         FCM::Result res = FCM_SUCCESS;
 
 #ifdef USE_HTTP_SERVER
 
-        // We are now about to start a web server
         std::string fileName;
+        std::string outFolder;
+        std::string runtimeFolder;
         HTTPServer* server;
         ServerConfigParam config;
 
         Utils::GetFileName(outFile, fileName);
+        Utils::GetParent(outFile, outFolder);
+
+#ifdef USE_RUNTIME
+        GetRuntimeFolder(runtimeFolder);
+#endif
 
         server = HTTPServer::GetInstance();
-        if (server)
+
+        if (server->IsRunning())
         {
-            // Stop the web server just in case it is running
-            server->Stop();
+            std::shared_ptr<const PREVIEW_CONTENT> pPrevious = server->GetContent();
+            std::string message;
+
+            if (pPrevious && server->HasLivePage(fileName))
+            {
+                PreviewUpdate::Create(pPrevious->files, outputFiles, fileName, message);
+            }
+
+            server->SetContent(outFolder, runtimeFolder, outputFiles);
+
+            if (message.empty() || (server->SendLiveMessage(fileName, message) == 0))
+            {
+                Utils::LaunchBrowser(fileName, server->GetConfig().port, GetCallback());
+            }
+            return FCM_SUCCESS;
         }
 
+        server->SetContent(outFolder, runtimeFolder, outputFiles);
+
+        // We are now about to start a web server
         int numTries = 0;
         while (numTries < MAX_RETRY_ATTEMPT)
         {
             // Configure the web server
             config.port = Utils::GetUnusedLocalPort();
-            Utils::GetParent(outFile, config.root);
+            config.root = outFolder;
             server->SetConfig(config);
 
             // Start the web server
@@ -567,6 +930,13 @@ namespace CreateJS
         FCM::Result res = FCM_SUCCESS;;
         FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
 
+        if (m_pServiceCallback == NULL)
+        {
+            // Resolve the services used by the Utils helpers once for the publisher
+            m_pServiceCallback = GetCallback();
+            ServiceRegistry::Register(m_pServiceCallback);
+        }
+
         if (!m_frameCmdGeneratorService)
         {
             // Get the frame command generator service
@@ -600,9 +970,7 @@ namespace CreateJS
         res = pLibraryItemList->Count(count);
         ASSERT(FCM_SUCCESS_CODE(res));
 
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-        res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-        AutoPtr<FCM::IFCMCalloc> callocService  = pUnkCalloc;
+        AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
 
         for (FCM::U_Int32 index = 0; index < count ; index++)
         {
@@ -694,1292 +1062,72 @@ namespace CreateJS
     FCM::Result CPublisher::CopyRuntime(const std::string& outputFolder)
     {
         FCM::Result res;
-        std::string sourceFolder;
+        std::string runtimeFolder;
+        std::string stamp;
+        std::string outputStamp;
+        std::fstream stampFile;
+        FCM::U_Int64 modificationTime = 0;
 
-        // Get the source folder
-        Utils::GetModuleFilePath(sourceFolder, GetCallback());
-        Utils::GetParent(sourceFolder, sourceFolder);
-        Utils::GetParent(sourceFolder, sourceFolder);
-        Utils::GetParent(sourceFolder, sourceFolder);
+        GetRuntimeFolder(runtimeFolder);
 
-        // First let us remove the existing runtime folder (if any)
-        Utils::Remove(outputFolder + RUNTIME_FOLDER_NAME, GetCallback());
-
-        // Copy the runtime folder
-        res = Utils::CopyDir(sourceFolder + RUNTIME_FOLDER_NAME, outputFolder, GetCallback());
+        // The runtime of the package changes with the plugin version, or when its
+        // folder is updated
+        Utils::GetModificationTime(runtimeFolder, modificationTime, GetCallback());
 
-        return res;
-    }
+        stamp = Utils::ToString((FCM::U_Int32)SAMPLE_PLUGIN_VERSION) + " " + 
+            Utils::ToString((FCM::U_Int32)(modificationTime >> 32)) + " " + 
+            Utils::ToString((FCM::U_Int32)modificationTime);
 
-    /* ----------------------------------------------------- Resource Palette */
+        std::string stampPath = outputFolder + RUNTIME_FOLDER_NAME + "/" + RUNTIME_STAMP_FILE_NAME;
 
-    FCM::Result ResourcePalette::AddSymbol(
-        FCM::U_Int32 resourceId, 
-        FCM::StringRep16 pName, 
-        Exporter::Service::PITimelineBuilder pTimelineBuilder)
-    {
-        FCM::Result res;
-        ITimelineWriter* pTimelineWriter;
+        Utils::OpenFStream(stampPath, stampFile, std::ios_base::in, GetCallback());
+        if (stampFile.is_open())
+        {
+            std::getline(stampFile, outputStamp);
+            stampFile.close();
 
-        LOG(("[EndSymbol] ResId: %d\n", resourceId));
+            if (outputStamp == stamp)
+            {
+                // Already copied by an earlier publish or preview
+                return FCM_SUCCESS;
+            }
+        }
 
-        m_resourceList.push_back(resourceId);
+        // First let us remove the existing runtime folder (if any)
+        Utils::Remove(outputFolder + RUNTIME_FOLDER_NAME, GetCallback());
 
-        if (pName != NULL)
+        // Copy the runtime folder
+        res = Utils::CopyDir(runtimeFolder, outputFolder, GetCallback());
+        if (FCM_FAILURE_CODE(res))
         {
-            m_resourceNames.push_back(Utils::ToString(pName, GetCallback()));
+            return res;
         }
 
-        TimelineBuilder* pTimeline = static_cast<TimelineBuilder*>(pTimelineBuilder);
-
-        res = pTimeline->Build(resourceId, pName, &pTimelineWriter);
+        Utils::OpenFStream(stampPath, stampFile, std::ios_base::out | std::ios_base::trunc, GetCallback());
+        if (stampFile.is_open())
+        {
+            stampFile << stamp << std::endl;
+            stampFile.close();
+        }
 
-        return res;
+        return FCM_SUCCESS;
     }
 
 
-    FCM::Result ResourcePalette::AddShape(
-        FCM::U_Int32 resourceId, 
-        DOM::FrameElement::PIShape pShape)
+    // Runtime folder in the extension package
+    void CPublisher::GetRuntimeFolder(std::string& runtimeFolder)
     {
-        FCM::Result res;
-        FCM::Boolean hasFancy;
-        FCM::AutoPtr<DOM::FrameElement::IShape> pNewShape;
+        std::string sourceFolder;
 
-        LOG(("[DefineShape] ResId: %d\n", resourceId));
+        Utils::GetModuleFilePath(sourceFolder, GetCallback());
+        Utils::GetParent(sourceFolder, sourceFolder);
+        Utils::GetParent(sourceFolder, sourceFolder);
+        Utils::GetParent(sourceFolder, sourceFolder);
 
-        m_resourceList.push_back(resourceId);
-        m_pOutputWriter->StartDefineShape();
-
-        if (pShape)
-        {
-            ExportFill(pShape);
-
-            res = HasFancyStrokes(pShape, hasFancy);
-            if (hasFancy)
-            {
-                res = ConvertStrokeToFill(pShape, pNewShape.m_Ptr);
-                ASSERT(FCM_SUCCESS_CODE(res));
-
-                ExportFill(pNewShape);
-            }
-            else
-            {
-                
-                ExportStroke(pShape);
-            }
-        }
-
-        m_pOutputWriter->EndDefineShape(resourceId);
-
-        return FCM_SUCCESS;
-    }
-
-
-    FCM::Result ResourcePalette::AddSound(FCM::U_Int32 resourceId, DOM::LibraryItem::PIMediaItem pMediaItem)
-    {
-        FCM::Result res;
-        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown;
-        FCM::StringRep16 pName;
-        std::string libName;
-
-        LOG(("[DefineSound] ResId: %d\n", resourceId));
-
-        m_resourceList.push_back(resourceId);
-
-        // Store the resource name
-        pLibItem = pMediaItem;
-
-        res = pLibItem->GetName(&pName);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        libName = Utils::ToString(pName, GetCallback());
-        m_resourceNames.push_back(libName);
-
-        res = pMediaItem->GetMediaInfo(pUnknown.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        AutoPtr<DOM::MediaInfo::ISoundInfo> pSoundInfo = pUnknown;
-        ASSERT(pSoundInfo);
-        
-        m_pOutputWriter->DefineSound(resourceId, libName, pMediaItem);
-
-        // Free the name
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-        res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-        AutoPtr<FCM::IFCMCalloc> callocService  = pUnkCalloc;
-
-        callocService->Free((FCM::PVoid)pName);
-
-        return FCM_SUCCESS;
-    }
-
-
-    FCM::Result ResourcePalette::AddBitmap(FCM::U_Int32 resourceId, DOM::LibraryItem::PIMediaItem pMediaItem)
-    {
-        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
-        FCM::Result res;
-        FCM::StringRep16 pName;
-
-        LOG(("[DefineBitmap] ResId: %d\n", resourceId));
-
-        m_resourceList.push_back(resourceId);
-
-        pLibItem = pMediaItem;
-
-        // Store the resource name
-        res = pLibItem->GetName(&pName);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        std::string libItemName = Utils::ToString(pName, GetCallback());
-        m_resourceNames.push_back(libItemName);
-
-        AutoPtr<FCM::IFCMUnknown> medInfo;
-        pMediaItem->GetMediaInfo(medInfo.m_Ptr);
-
-        AutoPtr<DOM::MediaInfo::IBitmapInfo> bitsInfo = medInfo;
-        ASSERT(bitsInfo);
-
-        // Get image height
-        FCM::S_Int32 height;
-        res = bitsInfo->GetHeight(height);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Get image width
-        FCM::S_Int32 width;
-        res = bitsInfo->GetWidth(width);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Dump the definition of a bitmap
-        res = m_pOutputWriter->DefineBitmap(resourceId, height, width, libItemName, pMediaItem);
-
-        // Free the name
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-        res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-        AutoPtr<FCM::IFCMCalloc> callocService  = pUnkCalloc;
-
-        callocService->Free((FCM::PVoid)pName);
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::AddClassicText(FCM::U_Int32 resourceId, DOM::FrameElement::PIClassicText pClassicText)
-    {
-        DOM::AutoPtr<DOM::FrameElement::IClassicText> pTextItem;
-        FCMListPtr pParagraphsList;
-        FCM::StringRep16 textDisplay;
-        FCM::U_Int32 count = 0;
-        FCM::U_Int16 fontSize;
-        std::string fName; 
-        std::string displayText; 
-        DOM::Utils::COLOR fontColor;
-        FCM::Result res;
-     
-        LOG(("[DefineClassicText] ResId: %d\n", resourceId));
-
-        m_resourceList.push_back(resourceId);
-
-        pTextItem = pClassicText;
-        AutoPtr<DOM::FrameElement::ITextBehaviour> textBehaviour;
-        pTextItem->GetTextBehaviour(textBehaviour.m_Ptr);
-        AutoPtr<DOM::FrameElement::IDynamicTextBehaviour> dynamicTextBehaviour = textBehaviour.m_Ptr;
-
-        if(dynamicTextBehaviour)
-        {
-            pTextItem->GetParagraphs(pParagraphsList.m_Ptr);
-            res = pParagraphsList->Count(count);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = pTextItem->GetText(&textDisplay);
-            ASSERT(FCM_SUCCESS_CODE(res));
-            displayText = Utils::ToString(textDisplay, GetCallback());
-
-            // Free the textDisplay
-            FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-            res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-            AutoPtr<FCM::IFCMCalloc> callocService = pUnkCalloc;
-
-            callocService->Free((FCM::PVoid)textDisplay);
-        }
-    
-        for (FCM::U_Int32 pIndex = 0; pIndex < count; pIndex++)
-        {
-            AutoPtr<DOM::FrameElement::IParagraph> pParagraph = pParagraphsList[pIndex];
-
-            if (pParagraph)
-            {
-                FCMListPtr pTextRunList;
-                pParagraph->GetTextRuns(pTextRunList.m_Ptr);
-
-                FCM::U_Int32 trCount;
-                pTextRunList->Count(trCount);
-
-                for (FCM::U_Int32 trIndex = 0; trIndex < trCount; trIndex++)
-                {
-                    AutoPtr<DOM::FrameElement::ITextRun> pTextRun = pTextRunList[trIndex];
-                    AutoPtr<DOM::FrameElement::ITextStyle> trStyle;
-
-                    pTextRun->GetTextStyle(trStyle.m_Ptr);
-                    
-                    res = trStyle->GetFontSize(fontSize);
-                    ASSERT(FCM_SUCCESS_CODE(res));
-
-                    res = trStyle->GetFontColor(fontColor);
-                    ASSERT(FCM_SUCCESS_CODE(res));
-
-                    // Form font info in required format
-                    GetFontInfo(trStyle, fName, fontSize);
-                }
-            }
-        }
-    
-        //Define Text Element
-        res = m_pOutputWriter->DefineText(resourceId, fName, fontColor,displayText,pTextItem);
-
-        return FCM_SUCCESS;
-    }
-
-
-
-    FCM::Result ResourcePalette::HasResource(FCM::U_Int32 resourceId, FCM::Boolean& hasResource)
-    {
-        hasResource = false;
-
-        for (std::vector<FCM::U_Int32>::iterator listIter = m_resourceList.begin();
-                listIter != m_resourceList.end(); listIter++)
-        {
-            if (*listIter == resourceId)
-            {
-                hasResource = true;
-                break;
-            }
-        }
-
-        //LOG(("[HasResource] ResId: %d HasResource: %d\n", resourceId, hasResource));
-
-        return FCM_SUCCESS;
-    }
-
-
-    ResourcePalette::ResourcePalette()
-    {
-        m_pOutputWriter = NULL;
-    }
-
-
-    ResourcePalette::~ResourcePalette()
-    {
-    }
-
-
-    void ResourcePalette::Init(IOutputWriter* pOutputWriter)
-    {
-        m_pOutputWriter = pOutputWriter;
-    }
-
-    void ResourcePalette::Clear()
-    {
-        m_resourceList.clear();
-    }
-
-    FCM::Result ResourcePalette::HasResource(
-            const std::string& name, 
-            FCM::Boolean& hasResource)
-    {
-        hasResource = false;
-        for (FCM::U_Int32 index = 0; index < m_resourceNames.size(); index++)
-        {
-            if (m_resourceNames[index] == name)
-            {
-                hasResource = true;
-                break;
-            }
-        }
-
-        return FCM_SUCCESS;
-    }
-
-
-    FCM::Result ResourcePalette::ExportFill(DOM::FrameElement::PIShape pIShape)
-    {
-        FCM::Result res;
-        FCM::FCMListPtr pFilledRegionList;
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-        FCM::U_Int32 regionCount;
-
-        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
-        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-        ASSERT(pIRegionGeneratorService);
-
-        res = pIRegionGeneratorService->GetFilledRegions(pIShape, pFilledRegionList.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        pFilledRegionList->Count(regionCount);
-
-        for (FCM::U_Int32 j = 0; j < regionCount; j++)
-        {
-            FCM::AutoPtr<DOM::Service::Shape::IFilledRegion> pFilledRegion = pFilledRegionList[j];
-            FCM::AutoPtr<DOM::Service::Shape::IPath> pPath;
-
-            m_pOutputWriter->StartDefineFill();
-
-            // Fill Style
-            FCM::AutoPtr<DOM::IFCMUnknown> fillStyle;
-
-            res = pFilledRegion->GetFillStyle(fillStyle.m_Ptr);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            ExportFillStyle(fillStyle);
-
-            // Boundary
-            res = pFilledRegion->GetBoundary(pPath.m_Ptr);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = ExportFillBoundary(pPath);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            // Hole List
-            FCMListPtr pHoleList;
-            FCM::U_Int32 holeCount;
-
-            res = pFilledRegion->GetHoles(pHoleList.m_Ptr);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = pHoleList->Count(holeCount);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            for (FCM::U_Int32 k = 0; k < holeCount; k++)
-            {
-                FCM::FCMListPtr pEdgeList;
-                FCM::AutoPtr<DOM::Service::Shape::IPath> pPath = pHoleList[k];
-
-                res = ExportHole(pPath);
-            }
-
-            m_pOutputWriter->EndDefineFill();
-        }
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportFillBoundary(DOM::Service::Shape::PIPath pPath)
-    {
-        FCM::Result res;
-
-        m_pOutputWriter->StartDefineBoundary();
-
-        res = ExportPath(pPath);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        m_pOutputWriter->EndDefineBoundary();
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportHole(DOM::Service::Shape::PIPath pPath)
-    {
-        FCM::Result res;
-
-        m_pOutputWriter->StartDefineHole();
-
-        res = ExportPath(pPath);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        m_pOutputWriter->EndDefineHole();
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportPath(DOM::Service::Shape::PIPath pPath)
-    {
-        FCM::Result res;
-        FCM::U_Int32 edgeCount;
-        FCM::FCMListPtr pEdgeList;
-
-        res = pPath->GetEdges(pEdgeList.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pEdgeList->Count(edgeCount);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        for (FCM::U_Int32 l = 0; l < edgeCount; l++)
-        {
-            DOM::Utils::SEGMENT segment;
-
-            segment.structSize = sizeof(DOM::Utils::SEGMENT);
-
-            FCM::AutoPtr<DOM::Service::Shape::IEdge> pEdge = pEdgeList[l];
-
-            res = pEdge->GetSegment(segment);
-
-            m_pOutputWriter->SetSegment(segment);
-        }
-
-        return res;
-    }
-
-    FCM::Result ResourcePalette::ExportFillStyle(FCM::PIFCMUnknown pFillStyle)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        AutoPtr<DOM::FillStyle::ISolidFillStyle> pSolidFillStyle;
-        AutoPtr<DOM::FillStyle::IGradientFillStyle> pGradientFillStyle;
-        AutoPtr<DOM::FillStyle::IBitmapFillStyle> pBitmapFillStyle;
-
-        // Check for solid fill color
-        pSolidFillStyle = pFillStyle;
-        if (pSolidFillStyle)
-        {
-            res = ExportSolidFillStyle(pSolidFillStyle);
-            ASSERT(FCM_SUCCESS_CODE(res));
-        }
-
-        // Check for Gradient Fill
-        pGradientFillStyle = pFillStyle;
-        AutoPtr<FCM::IFCMUnknown> pGrad;
-
-        if (pGradientFillStyle)
-        {
-            pGradientFillStyle->GetColorGradient(pGrad.m_Ptr);
-
-            if (AutoPtr<DOM::Utils::IRadialColorGradient>(pGrad))
-            {
-                res = ExportRadialGradientFillStyle(pGradientFillStyle);
-                ASSERT(FCM_SUCCESS_CODE(res));
-            }
-            else if (AutoPtr<DOM::Utils::ILinearColorGradient>(pGrad))
-            {
-                res = ExportLinearGradientFillStyle(pGradientFillStyle);
-                ASSERT(FCM_SUCCESS_CODE(res));
-            }
-        }
-
-        pBitmapFillStyle = pFillStyle;
-        if (pBitmapFillStyle)
-        {
-            res = ExportBitmapFillStyle(pBitmapFillStyle);
-            ASSERT(FCM_SUCCESS_CODE(res));
-        }
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportStroke(DOM::FrameElement::PIShape pIShape)
-    {
-        FCM::FCMListPtr pStrokeGroupList;
-        FCM::U_Int32 strokeStyleCount;
-        FCM::Result res;
-
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
-        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-        ASSERT(pIRegionGeneratorService);
-
-        res = pIRegionGeneratorService->GetStrokeGroups(pIShape, pStrokeGroupList.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pStrokeGroupList->Count(strokeStyleCount);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        AutoPtr<DOM::FillStyle::ISolidFillStyle> pSolidFillStyle = NULL;
-        AutoPtr<DOM::FillStyle::IGradientFillStyle> pGradientFillStyle = NULL;
-        AutoPtr<DOM::FillStyle::IBitmapFillStyle> pBitmapFillStyle = NULL;
-
-        AutoPtr<FCM::IFCMUnknown> pGrad;
-        for (FCM::U_Int32 j = 0; j < strokeStyleCount; j++)
-        {
-            AutoPtr<DOM::Service::Shape::IStrokeGroup> pStrokeGroup = pStrokeGroupList[j];
-            ASSERT(pStrokeGroup);
-
-            res = m_pOutputWriter->StartDefineStrokeGroup();
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            AutoPtr<FCM::IFCMUnknown> pStrokeStyle;
-            pStrokeGroup->GetStrokeStyle(pStrokeStyle.m_Ptr);
-
-            DOM::Utils::COLOR color = {};
-
-            FCMListPtr pPathList;
-            FCM::U_Int32 pathCount;
-
-            res = pStrokeGroup->GetPaths(pPathList.m_Ptr);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = pPathList->Count(pathCount);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            for (FCM::U_Int32 k = 0; k < pathCount; k++)
-            {
-                FCM::AutoPtr<DOM::Service::Shape::IPath> pPath;
-
-                pPath = pPathList[k];
-                ASSERT(pPath);
-
-                res = m_pOutputWriter->StartDefineStroke();
-                ASSERT(FCM_SUCCESS_CODE(res));
-
-                res = ExportStrokeStyle(pStrokeStyle);
-                ASSERT(FCM_SUCCESS_CODE(res));
-
-                res = ExportPath(pPath);
-                ASSERT(FCM_SUCCESS_CODE(res));
-
-                res = m_pOutputWriter->EndDefineStroke();
-                ASSERT(FCM_SUCCESS_CODE(res));
-            }
-
-            res = m_pOutputWriter->EndDefineStrokeGroup();
-            ASSERT(FCM_SUCCESS_CODE(res));
-        }
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::HasFancyStrokes(DOM::FrameElement::PIShape pShape, FCM::Boolean& hasFancy)
-    {
-        FCM::Result res;
-        FCM::FCMListPtr pStrokeGroupList;
-        FCM::U_Int32 strokeStyleCount;
-
-        hasFancy = false;
-
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
-        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-        ASSERT(pIRegionGeneratorService);
-
-        res = pIRegionGeneratorService->GetStrokeGroups(pShape, pStrokeGroupList.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pStrokeGroupList->Count(strokeStyleCount);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        for (FCM::U_Int32 j = 0; j < strokeStyleCount; j++)
-        {
-            
-            AutoPtr<DOM::StrokeStyle::ISolidStrokeStyle> pSolidStrokeStyle;
-            AutoPtr<DOM::Service::Shape::IStrokeGroup> pStrokeGroup = pStrokeGroupList[j];
-            ASSERT(pStrokeGroup);
-
-            AutoPtr<FCM::IFCMUnknown> pStrokeStyle;
-            pStrokeGroup->GetStrokeStyle(pStrokeStyle.m_Ptr);
-
-            pSolidStrokeStyle = pStrokeStyle;
-
-            if (pSolidStrokeStyle)
-            {
-                FCM::AutoPtr<DOM::StrokeStyle::IStrokeWidth> pStrokeWidth;
-
-                pSolidStrokeStyle->GetStrokeWidth(pStrokeWidth.m_Ptr);
-
-                if (pStrokeWidth.m_Ptr)
-                {
-                    // Variable width stroke
-                    hasFancy = true;
-                    break;
-                }            
-            }
-            else
-            {
-                // Not a solid stroke (may be dashed, dotted etc..)
-                hasFancy = true;
-                break;
-            }
-        }
-
-        return FCM_SUCCESS;
-    }
-
-
-    // Convert strokes to fills
-    FCM::Result ResourcePalette::ConvertStrokeToFill(
-        DOM::FrameElement::PIShape pShape,
-        DOM::FrameElement::PIShape& pNewShape)
-    {
-        FCM::Result res;
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg; 
-
-        GetCallback()->GetService(DOM::FLA_SHAPE_SERVICE, pUnkSRVReg.m_Ptr);
-
-        AutoPtr<DOM::Service::Shape::IShapeService> pIShapeService(pUnkSRVReg);
-        ASSERT(pIShapeService);
-
-        res = pIShapeService->ConvertStrokeToFill(pShape, pNewShape);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        return FCM_SUCCESS;
-    }
-
-    FCM::Result ResourcePalette::ExportStrokeStyle(FCM::PIFCMUnknown pStrokeStyle)
-    {
-        FCM::Result res = FCM_SUCCESS;
-        AutoPtr<DOM::StrokeStyle::ISolidStrokeStyle> pSolidStrokeStyle;
-
-        pSolidStrokeStyle = pStrokeStyle;
-
-        if (pSolidStrokeStyle)
-        {
-            res = ExportSolidStrokeStyle(pSolidStrokeStyle);
-        }
-        else
-        {
-            // Other stroke styles are not tested yet.
-        }
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportSolidStrokeStyle(DOM::StrokeStyle::ISolidStrokeStyle* pSolidStrokeStyle)
-    {
-        FCM::Result res;
-        FCM::Double thickness;
-        AutoPtr<DOM::IFCMUnknown> pFillStyle;
-        DOM::StrokeStyle::CAP_STYLE capStyle;
-        DOM::StrokeStyle::JOIN_STYLE joinStyle;
-        DOM::Utils::ScaleType scaleType;
-        FCM::Boolean strokeHinting;
-
-
-        capStyle.structSize = sizeof(DOM::StrokeStyle::CAP_STYLE);
-        res = pSolidStrokeStyle->GetCapStyle(capStyle);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        joinStyle.structSize = sizeof(DOM::StrokeStyle::JOIN_STYLE);
-        res = pSolidStrokeStyle->GetJoinStyle(joinStyle);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pSolidStrokeStyle->GetThickness(thickness);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        if (thickness < 0.1)
-        {
-            thickness = 0.1;
-        }
-
-        res = pSolidStrokeStyle->GetScaleType(scaleType);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pSolidStrokeStyle->GetStrokeHinting(strokeHinting);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = m_pOutputWriter->StartDefineSolidStrokeStyle(
-            thickness, 
-            joinStyle, 
-            capStyle, 
-            scaleType, 
-            strokeHinting);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Stroke fill styles
-        res = pSolidStrokeStyle->GetFillStyle(pFillStyle.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = ExportFillStyle(pFillStyle);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = m_pOutputWriter->EndDefineSolidStrokeStyle();
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportSolidFillStyle(DOM::FillStyle::ISolidFillStyle* pSolidFillStyle)
-    {
-        FCM::Result res;
-        DOM::Utils::COLOR color;
-
-        AutoPtr<DOM::FillStyle::ISolidFillStyle> solidFill = pSolidFillStyle;
-        ASSERT(solidFill);
-
-        res = solidFill->GetColor(color);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        m_pOutputWriter->DefineSolidFillStyle(color);
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportRadialGradientFillStyle(DOM::FillStyle::IGradientFillStyle* pGradientFillStyle)
-    {
-        DOM::FillStyle::GradientSpread spread;
-
-        AutoPtr<FCM::IFCMUnknown> pGrad;
-
-        AutoPtr<DOM::FillStyle::IGradientFillStyle> gradientFill = pGradientFillStyle;
-        FCM::Result res = gradientFill->GetSpread(spread);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = gradientFill->GetColorGradient(pGrad.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        AutoPtr<DOM::Utils::IRadialColorGradient> radialColorGradient = pGrad;
-        ASSERT(radialColorGradient);
-
-        DOM::Utils::MATRIX2D matrix;
-        res = gradientFill->GetMatrix(matrix);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        FCM::S_Int32 focalPoint = 0;
-        res = radialColorGradient->GetFocalPoint(focalPoint);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = m_pOutputWriter->StartDefineRadialGradientFillStyle(spread, matrix, focalPoint);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        FCM::U_Int8 nColors;
-        res = radialColorGradient->GetKeyColorCount(nColors);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        for (FCM::U_Int8 i = 0; i < nColors; i++)
-        {
-            DOM::Utils::GRADIENT_COLOR_POINT point;
-
-            res = radialColorGradient->GetKeyColorAtIndex(i, point);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = m_pOutputWriter->SetKeyColorPoint(point);
-            ASSERT(FCM_SUCCESS_CODE(res));
-        }
-
-        res = m_pOutputWriter->EndDefineRadialGradientFillStyle();
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::ExportLinearGradientFillStyle(DOM::FillStyle::IGradientFillStyle* pGradientFillStyle)
-    {
-        DOM::FillStyle::GradientSpread spread;
-        AutoPtr<FCM::IFCMUnknown> pGrad;
-
-        AutoPtr<DOM::FillStyle::IGradientFillStyle> gradientFill = pGradientFillStyle;
-        FCM::Result res = gradientFill->GetSpread(spread);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = gradientFill->GetColorGradient(pGrad.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        AutoPtr<DOM::Utils::ILinearColorGradient> linearColorGradient = pGrad;
-        ASSERT(linearColorGradient);
-
-        DOM::Utils::MATRIX2D matrix;
-        res = gradientFill->GetMatrix(matrix);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = m_pOutputWriter->StartDefineLinearGradientFillStyle(spread, matrix);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        FCM::U_Int8 nColors;
-        res = linearColorGradient->GetKeyColorCount(nColors);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        for (FCM::U_Int8 i = 0; i < nColors; i++)
-        {
-            DOM::Utils::GRADIENT_COLOR_POINT point;
-
-            res = linearColorGradient->GetKeyColorAtIndex(i, point);
-            ASSERT(FCM_SUCCESS_CODE(res));
-
-            res = m_pOutputWriter->SetKeyColorPoint(point);
-            ASSERT(FCM_SUCCESS_CODE(res));
-        }
-
-        res = m_pOutputWriter->EndDefineLinearGradientFillStyle();
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        return res;
+        runtimeFolder = sourceFolder + RUNTIME_FOLDER_NAME;
     }
 
 
-    FCM::Result ResourcePalette::ExportBitmapFillStyle(DOM::FillStyle::IBitmapFillStyle* pBitmapFillStyle)
-    {
-        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
-        DOM::AutoPtr<DOM::LibraryItem::IMediaItem> pMediaItem;
-        FCM::Result res;
-        FCM::Boolean isClipped;
-        DOM::Utils::MATRIX2D matrix;
-        std::string name;
-        FCM::StringRep16 pName;
-
-        // IsClipped ?
-        res = pBitmapFillStyle->IsClipped(isClipped);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Matrix
-        res = pBitmapFillStyle->GetMatrix(matrix);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Get name
-        res = pBitmapFillStyle->GetBitmap(pMediaItem.m_Ptr);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        pLibItem = pMediaItem;
-
-        AutoPtr<FCM::IFCMUnknown> medInfo;
-        pMediaItem->GetMediaInfo(medInfo.m_Ptr);
-
-        AutoPtr<DOM::MediaInfo::IBitmapInfo> bitsInfo = medInfo;
-        ASSERT(bitsInfo);
-
-        // Get image height
-        FCM::S_Int32 height;
-        res = bitsInfo->GetHeight(height);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Store the resource name
-        res = pLibItem->GetName(&pName);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        std::string libItemName = Utils::ToString(pName, GetCallback());
-        m_resourceNames.push_back(libItemName);
-
-        // Get image width
-        FCM::S_Int32 width;
-        res = bitsInfo->GetWidth(width);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Dump the definition of a bitmap fill style
-        res = m_pOutputWriter->DefineBitmapFillStyle(
-            isClipped, 
-            matrix, 
-            height, 
-            width, 
-            libItemName, 
-            pMediaItem);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        // Free the name
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-        res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-        AutoPtr<FCM::IFCMCalloc> callocService = pUnkCalloc;
-
-        callocService->Free((FCM::PVoid)pName);
-
-        return res;
-    }
-
-
-    FCM::Result ResourcePalette::GetFontInfo(DOM::FrameElement::ITextStyle* pTextStyleItem, std::string& name, FCM::U_Int16 fontSize)
-    {
-        FCM::StringRep16 pFontName;
-        FCM::StringRep8 pFontStyle;
-        FCM::Result res;
-        std::string str;
-        std::string sizeStr;
-        std::string styleStr;
-
-        res = pTextStyleItem->GetFontName(&pFontName);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        res = pTextStyleItem->GetFontStyle(&pFontStyle);
-        ASSERT(FCM_SUCCESS_CODE(res));
-
-        styleStr = pFontStyle;
-        if(styleStr == "BoldItalicStyle")
-            styleStr = "italic bold";
-        else if(styleStr == "BoldStyle")
-            styleStr = "bold";
-        else if(styleStr == "ItalicStyle")
-            styleStr = "italic";
-        else if(styleStr == "RegularStyle")
-            styleStr = "";
-
-        sizeStr = Utils::ToString(fontSize);
-        str = Utils::ToString(pFontName,GetCallback());
-        name = styleStr+" "+sizeStr + "px" + " " + "'" + str + "'" ;
-
-        // Free the name and style
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnkCalloc;
-        res = GetCallback()->GetService(SRVCID_Core_Memory, pUnkCalloc.m_Ptr);
-        AutoPtr<FCM::IFCMCalloc> callocService  = pUnkCalloc;
-
-        callocService->Free((FCM::PVoid)pFontName);
-        callocService->Free((FCM::PVoid)pFontStyle);
-
-        return res;
-    }
-
-
-    /* ----------------------------------------------------- TimelineBuilder */
-
-    FCM::Result TimelineBuilder::AddShape(FCM::U_Int32 objectId, SHAPE_INFO* pShapeInfo)
-    {
-        FCM::Result res;
-
-        ASSERT(pShapeInfo);
-        ASSERT(pShapeInfo->structSize >= sizeof(SHAPE_INFO));
-
-        LOG(("[AddShape] ObjId: %d ResId: %d PlaceAfter: %d\n", 
-            objectId, pShapeInfo->resourceId, pShapeInfo->placeAfterObjectId));
-
-        res = m_pTimelineWriter->PlaceObject(
-            pShapeInfo->resourceId, 
-            objectId, 
-            pShapeInfo->placeAfterObjectId, 
-            &pShapeInfo->matrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddClassicText(FCM::U_Int32 objectId, CLASSIC_TEXT_INFO* pClassicTextInfo)
-    {
-        FCM::Result res;
-
-        ASSERT(pClassicTextInfo);
-        ASSERT(pClassicTextInfo->structSize >= sizeof(CLASSIC_TEXT_INFO));
-
-        LOG(("[AddClassicText] ObjId: %d ResId: %d PlaceAfter: %d\n", 
-            objectId, pClassicTextInfo->resourceId, pClassicTextInfo->placeAfterObjectId));
-        
-        //To get the bounding rect of the text
-        if(pClassicTextInfo->structSize >= sizeof(DISPLAY_OBJECT_INFO_2))
-        {
-            DOM::Utils::RECT rect;
-            DISPLAY_OBJECT_INFO_2 *ptr = static_cast<DISPLAY_OBJECT_INFO_2*>(pClassicTextInfo);
-            if(ptr)
-            {
-                rect = ptr->bounds;
-                // This rect object gives the bound of the text filed.
-                // This will have to be transformed using the pClassicTextInfo->matrix
-                // to map it to its parent's co-orinate space to render it.
-            }
-        }
-        
-        res = m_pTimelineWriter->PlaceObject(
-            pClassicTextInfo->resourceId, 
-            objectId, 
-            pClassicTextInfo->placeAfterObjectId, 
-            &pClassicTextInfo->matrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddBitmap(FCM::U_Int32 objectId, BITMAP_INFO* pBitmapInfo)
-    {
-        FCM::Result res;
-
-        ASSERT(pBitmapInfo);
-        ASSERT(pBitmapInfo->structSize >= sizeof(BITMAP_INFO));
-
-        LOG(("[AddBitmap] ObjId: %d ResId: %d PlaceAfter: %d\n", 
-            objectId, pBitmapInfo->resourceId, pBitmapInfo->placeAfterObjectId));
-
-        res = m_pTimelineWriter->PlaceObject(
-            pBitmapInfo->resourceId, 
-            objectId, 
-            pBitmapInfo->placeAfterObjectId, 
-            &pBitmapInfo->matrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddMovieClip(FCM::U_Int32 objectId, MOVIE_CLIP_INFO* pMovieClipInfo, DOM::FrameElement::PIMovieClip pMovieClip)
-    {
-        FCM::Result res;
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = pMovieClip;
-
-        ASSERT(pMovieClipInfo);
-        ASSERT(pMovieClipInfo->structSize >= sizeof(MOVIE_CLIP_INFO));
-      
-        LOG(("[AddMovieClip] ObjId: %d ResId: %d PlaceAfter: %d\n", 
-            objectId, pMovieClipInfo->resourceId, pMovieClipInfo->placeAfterObjectId));
-
-        AutoPtr<DOM::FrameElement::IButton> pButton = pMovieClip;
-        if(pButton.m_Ptr)
-        {
-            DOM::FrameElement::ButtonTrackMode trackMode;
-            pButton->GetTrackingMode(trackMode);
-            if(trackMode == DOM::FrameElement::TRACK_AS_BUTTON)
-            {
-                LOG(("[AddMovieClip] ObjId: %d, is a button with TrackingMode set to TRACK_AS_BUTTON\n",
-                     objectId));
-                
-            }else
-            {
-                LOG(("[AddMovieClip] ObjId: %d, is a button with TrackingMode set to TRACK_AS_MENU_ITEM\n",
-                     objectId));
-            }
-        }
-        
-        res = m_pTimelineWriter->PlaceObject(
-            pMovieClipInfo->resourceId, 
-            objectId, 
-            pMovieClipInfo->placeAfterObjectId, 
-            &pMovieClipInfo->matrix,
-            pUnknown);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddGraphic(FCM::U_Int32 objectId, GRAPHIC_INFO* pGraphicInfo)
-    {
-        FCM::Result res;
-
-        ASSERT(pGraphicInfo);
-        ASSERT(pGraphicInfo->structSize >= sizeof(GRAPHIC_INFO));
-
-        LOG(("[AddGraphic] ObjId: %d ResId: %d PlaceAfter: %d\n", 
-            objectId, pGraphicInfo->resourceId, pGraphicInfo->placeAfterObjectId));
-
-        res = m_pTimelineWriter->PlaceObject(
-            pGraphicInfo->resourceId, 
-            objectId, 
-            pGraphicInfo->placeAfterObjectId, 
-            &pGraphicInfo->matrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddSound(
-        FCM::U_Int32 objectId, 
-        SOUND_INFO* pSoundInfo, 
-        DOM::FrameElement::PISound pSound)
-    {
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = pSound;
-        FCM::Result res;
-
-        ASSERT(pSoundInfo);
-        ASSERT(pSoundInfo->structSize == sizeof(SOUND_INFO));
-
-        LOG(("[AddSound] ObjId: %d ResId: %d\n", 
-            objectId, pSoundInfo->resourceId));
-
-        res = m_pTimelineWriter->PlaceObject(
-            pSoundInfo->resourceId, 
-            objectId, 
-            pUnknown);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::UpdateZOrder(FCM::U_Int32 objectId, FCM::U_Int32 placeAfterObjectId)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        LOG(("[UpdateZOrder] ObjId: %d PlaceAfter: %d\n", 
-            objectId, placeAfterObjectId));
-
-        res = m_pTimelineWriter->UpdateZOrder(objectId, placeAfterObjectId);
-
-        return res;
-    }
-
-     FCM::Result TimelineBuilder::UpdateMask(FCM::U_Int32 objectId, FCM::U_Int32 maskTillObjectId)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        LOG(("[UpdateMask] ObjId: %d MaskTill: %d\n", 
-            objectId, maskTillObjectId));
-
-        res = m_pTimelineWriter->UpdateMask(objectId, maskTillObjectId);
-
-        return res;
-    }
-     
-     FCM::Result TimelineBuilder::Remove(FCM::U_Int32 objectId)
-    {
-        FCM::Result res;
-
-        LOG(("[Remove] ObjId: %d\n", objectId));
-
-        res = m_pTimelineWriter->RemoveObject(objectId);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::UpdateBlendMode(FCM::U_Int32 objectId, DOM::FrameElement::BlendMode blendMode)
-    {
-        FCM::Result res;
-
-        LOG(("[UpdateBlendMode] ObjId: %d BlendMode: %d\n", objectId, blendMode));
-
-        res = m_pTimelineWriter->UpdateBlendMode(objectId, blendMode);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::UpdateVisibility(FCM::U_Int32 objectId, FCM::Boolean visible)
-    {
-        FCM::Result res;
-
-        LOG(("[UpdateVisibility] ObjId: %d Visible: %d\n", objectId, visible));
-
-        res = m_pTimelineWriter->UpdateVisibility(objectId, visible);
-
-        return res;
-    }
-
-
-    FCM::Result TimelineBuilder::UpdateGraphicFilter(FCM::U_Int32 objectId, PIFCMList pFilterable)
-    {
-        FCM::U_Int32 count;
-        FCM::Result res;
-        FCM::FCMListPtr pFilterList;
-
-        LOG(("[UpdateGraphicFilter] ObjId: %d\n", objectId));
-
-        res = pFilterable->Count(count);
-        ASSERT(FCM_SUCCESS_CODE(res));
-        
-        for (FCM::U_Int32 i = 0; i < count; i++)
-        {
-            FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = (*pFilterable)[i];
-            res = m_pTimelineWriter->AddGraphicFilter(objectId, pUnknown.m_Ptr);
-
-            if (FCM_FAILURE_CODE(res))
-            {
-                return res;
-            }
-        }
-
-        return FCM_SUCCESS;
-    }
-
-
-    FCM::Result TimelineBuilder::UpdateDisplayTransform(FCM::U_Int32 objectId, const DOM::Utils::MATRIX2D& matrix)
-    {
-        FCM::Result res;
-
-        LOG(("[UpdateDisplayTransform] ObjId: %d\n", objectId));
-
-        res = m_pTimelineWriter->UpdateDisplayTransform(objectId, matrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::UpdateColorTransform(FCM::U_Int32 objectId, const DOM::Utils::COLOR_MATRIX& colorMatrix)
-    {
-        FCM::Result res;
-
-        LOG(("[UpdateColorTransform] ObjId: %d\n", objectId));
-
-        res = m_pTimelineWriter->UpdateColorTransform(objectId, colorMatrix);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::ShowFrame()        
-    {
-        FCM::Result res;
-
-        LOG(("[ShowFrame] Frame: %d\n", m_frameIndex));
-
-        res = m_pTimelineWriter->ShowFrame(m_frameIndex);
-
-        m_frameIndex++;
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        LOG(("[AddFrameScript] LayerNum: %d\n", layerNum));
-
-        if (pScript != NULL)
-        {
-            res = m_pTimelineWriter->AddFrameScript(pScript, layerNum);
-        }
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::RemoveFrameScript(FCM::U_Int32 layerNum)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        LOG(("[RemoveFrameScript] LayerNum: %d\n", layerNum));
-
-        res = m_pTimelineWriter->RemoveFrameScript(layerNum);
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType)
-    {
-        FCM::Result res = FCM_SUCCESS;
-
-        LOG(("[SetFrameLabel]\n"));
-
-        if (pLabel != NULL)
-        {
-            res = m_pTimelineWriter->SetFrameLabel(pLabel, labelType);
-        }
-
-        return res;
-    }
-
-    FCM::Result TimelineBuilder::Build(
-        FCM::U_Int32 resourceId, 
-        FCM::StringRep16 pName,
-        ITimelineWriter** ppTimelineWriter)
-    {
-        FCM::Result res;
-
-        res = m_pOutputWriter->EndDefineTimeline(resourceId, pName, m_pTimelineWriter);
-
-        *ppTimelineWriter = m_pTimelineWriter;
-
-        return res;
-    }
-
-
-    TimelineBuilder::TimelineBuilder() :
-        m_pOutputWriter(NULL),
-        m_frameIndex(0)
-    {
-        //LOG(("[CreateTimeline]\n"));
-    }
-
-    TimelineBuilder::~TimelineBuilder()
-    {
-    }
-
-    void TimelineBuilder::Init(IOutputWriter* pOutputWriter)
-    {
-        m_pOutputWriter = pOutputWriter;
-
-        m_pOutputWriter->StartDefineTimeline();
-
-        m_pTimelineWriter = new JSONTimelineWriter(GetCallback());
-        ASSERT(m_pTimelineWriter);
-    }
-
-    /* ----------------------------------------------------- TimelineBuilderFactory */
-
-    TimelineBuilderFactory::TimelineBuilderFactory()
-    {
-    }
-
-    TimelineBuilderFactory::~TimelineBuilderFactory()
-    {
-    }
-
-    FCM::Result TimelineBuilderFactory::CreateTimelineBuilder(PITimelineBuilder& pTimelineBuilder)
-    {
-        FCM::Result res = GetCallback()->CreateInstance(NULL, CLSID_TimelineBuilder, IID_ITIMELINE_BUILDER_2, (void**)&pTimelineBuilder);
-
-        TimelineBuilder* pTimeline = static_cast<TimelineBuilder*>(pTimelineBuilder);
-        
-        pTimeline->Init(m_pOutputWriter);
-
-        return res;
-    }
-
-    void TimelineBuilderFactory::Init(IOutputWriter* pOutputWriter)
-    {
-        m_pOutputWriter = pOutputWriter;
-    }
-
     FCM::Result RegisterPublisher(PIFCMDictionary pPlugins, FCM::FCMCLSID docId)
     {
         FCM::Result res;
@@ -0,0 +1,1890 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "Publisher.h"
+#include "Utils.h"
+#include "ApplicationFCMPublicIDs.h"
+
+#include "FrameElement/IShape.h"
+#include "FrameElement/IFrameDisplayElement.h"
+
+#include "StrokeStyle/IDashedStrokeStyle.h"
+#include "StrokeStyle/IDottedStrokeStyle.h"
+#include "StrokeStyle/IHatchedStrokeStyle.h"
+#include "StrokeStyle/IRaggedStrokeStyle.h"
+#include "StrokeStyle/ISolidStrokeStyle.h"
+#include "StrokeStyle/IStippleStrokeStyle.h"
+#include "StrokeStyle/IStrokeWidth.h"
+
+#include "FillStyle/ISolidFillStyle.h"
+#include "FillStyle/IGradientFillStyle.h"
+#include "FillStyle/IBitmapFillStyle.h"
+
+#include "MediaInfo/IBitmapInfo.h"
+#include "FrameElement/IBitmapInstance.h"
+#include "FrameElement/ISound.h"
+#include "MediaInfo/ISoundInfo.h"
+#include "LibraryItem/IMediaItem.h"
+#include "ILibraryItem.h"
+
+#include "FrameElement/IButton.h"
+#include "FrameElement/IClassicText.h"
+#include "FrameElement/ITextStyle.h"
+#include "FrameElement/IParagraph.h"
+#include "FrameElement/ITextRun.h"
+#include "FrameElement/ITextBehaviour.h"
+
+#include "Service/Shape/IRegionGeneratorService.h"
+#include "Service/Shape/IFilledRegion.h"
+#include "Service/Shape/IStrokeGroup.h"
+#include "Service/Shape/IPath.h"
+#include "Service/Shape/IEdge.h"
+#include "Service/Shape/IShapeService.h"
+
+#include "Utils/DOMTypes.h"
+#include "Utils/ILinearColorGradient.h"
+#include "Utils/IRadialColorGradient.h"
+
+#include "PublishProfiler.h"
+#include "PathSimplifier.h"
+
+#include "Exporter/Service/IResourcePalette.h"
+#include "Exporter/Service/ITimelineBuilder2.h"
+#include "Exporter/Service/ITimelineBuilderFactory.h"
+
+#include <algorithm>
+#include <math.h>
+#include "PluginConfiguration.h"
+
+namespace CreateJS
+{
+
+    /* ----------------------------------------------------- Resource Palette */
+
+    // Orders the shapes that lost the most segments to simplification first
+    static bool HasMoreSegmentsRemoved(const SIMPLIFIED_SHAPE& a, const SIMPLIFIED_SHAPE& b)
+    {
+        return (a.segmentCount - a.simplifiedCount) > (b.segmentCount - b.simplifiedCount);
+    }
+
+
+    FCM::Result ResourcePalette::AddSymbol(
+        FCM::U_Int32 resourceId, 
+        FCM::StringRep16 pName, 
+        Exporter::Service::PITimelineBuilder pTimelineBuilder)
+    {
+        FCM::Result res;
+        ITimelineWriter* pTimelineWriter;
+        TimelineBuilder* pTimeline = static_cast<TimelineBuilder*>(pTimelineBuilder);
+        std::string name;
+
+        LOG(("[EndSymbol] ResId: %d\n", resourceId));
+
+        m_resourceIds.insert(resourceId);
+
+        if (pName != NULL)
+        {
+            name = Utils::ToString(pName, GetCallback());
+
+            m_resourceNames.insert(name);
+
+            if (FindLibraryResource(resourceId, name))
+            {
+                // Its timeline was written for an earlier scene, and so were the
+                // shapes it places
+                MapLibraryShapes(name, pTimeline);
+                return FCM_SUCCESS;
+            }
+        }
+
+        res = pTimeline->Build(GetResourceId(resourceId), pName, &pTimelineWriter);
+
+        if ((pName != NULL) && (m_sceneCount > 0))
+        {
+            const std::vector<FCM::U_Int32>& shapeIds = pTimeline->GetShapeResourceIds();
+            std::vector<FCM::U_Int32>& libraryShapeIds = m_libraryShapeIds[name];
+
+            for (size_t i = 0; i < shapeIds.size(); i++)
+            {
+                libraryShapeIds.push_back(GetResourceId(shapeIds[i]));
+            }
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::AddShape(
+        FCM::U_Int32 resourceId, 
+        DOM::FrameElement::PIShape pShape)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[DefineShape] ResId: %d\n", resourceId));
+
+        m_resourceIds.insert(resourceId);
+
+        FCM::U_Int64 geometryHash = 0;
+        if (m_dedupShapes && pShape)
+        {
+            geometryHash = GetGeometryHash(pShape);
+
+            // Duplicated artwork is placed using the definition of the first copy
+            DEFINED_SHAPE* pDefinedShape = FindIdenticalShape(pShape, geometryHash);
+            if (pDefinedShape)
+            {
+                LOG(("[DefineShape] ResId: %d is identical to ResId: %d\n", 
+                    resourceId, pDefinedShape->resourceId));
+
+                m_sceneResourceIds[resourceId] = pDefinedShape->resourceId;
+                m_aliasedShapeCount++;
+                pDefinedShape->aliasCount++;
+                return FCM_SUCCESS;
+            }
+        }
+
+        if (m_sceneCount > 1)
+        {
+            PENDING_SHAPE pendingShape;
+
+            // Written by EndScene(), unless only symbols written for an earlier scene
+            // place it
+            pendingShape.pShape = pShape;
+            pendingShape.geometryHash = geometryHash;
+
+            m_pendingShapes[resourceId] = pendingShape;
+        }
+        else
+        {
+            res = DefineShape(resourceId, pShape);
+        }
+
+        if (m_dedupShapes && pShape)
+        {
+            DEFINED_SHAPE definedShape;
+
+            // Shapes of all scenes are compared, under the id they are written with
+            definedShape.pShape = pShape;
+            definedShape.resourceId = GetResourceId(resourceId);
+            definedShape.aliasCount = 0;
+
+            m_definedShapes.insert(std::make_pair(geometryHash, definedShape));
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::DefineShape(
+        FCM::U_Int32 resourceId, 
+        DOM::FrameElement::PIShape pShape)
+    {
+        FCM::Result res;
+        FCM::Boolean hasFancy;
+        FCM::AutoPtr<DOM::FrameElement::IShape> pNewShape;
+
+        resourceId = GetResourceId(resourceId);
+
+        m_shapeSegments.resourceId = resourceId;
+        m_shapeSegments.segmentCount = 0;
+        m_shapeSegments.simplifiedCount = 0;
+
+        m_pOutputWriter->StartDefineShape();
+
+        if (pShape)
+        {
+            ExportFill(pShape);
+
+            res = HasFancyStrokes(pShape, hasFancy);
+            if (hasFancy)
+            {
+                res = ConvertStrokeToFill(pShape, pNewShape.m_Ptr);
+                ASSERT(FCM_SUCCESS_CODE(res));
+
+                ExportFill(pNewShape);
+            }
+            else
+            {
+                
+                ExportStroke(pShape);
+            }
+        }
+
+        m_pOutputWriter->EndDefineShape(resourceId);
+
+        if (m_shapeSegments.simplifiedCount < m_shapeSegments.segmentCount)
+        {
+            LOG(("[DefineShape] ResId: %d simplified from %u to %u segments\n", 
+                resourceId, m_shapeSegments.segmentCount, m_shapeSegments.simplifiedCount));
+
+            m_simplifiedShapes.push_back(m_shapeSegments);
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result ResourcePalette::AddSound(FCM::U_Int32 resourceId, DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        FCM::Result res;
+        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown;
+        FCM::StringRep16 pName;
+        std::string libName;
+
+        LOG(("[DefineSound] ResId: %d\n", resourceId));
+
+        m_resourceIds.insert(resourceId);
+
+        // Store the resource name
+        pLibItem = pMediaItem;
+
+        res = pLibItem->GetName(&pName);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        libName = Utils::ToString(pName, GetCallback());
+        m_resourceNames.insert(libName);
+
+        // Free the name
+        AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
+
+        callocService->Free((FCM::PVoid)pName);
+
+        if (FindLibraryResource(resourceId, libName))
+        {
+            // Defined for an earlier scene
+            return FCM_SUCCESS;
+        }
+
+        res = pMediaItem->GetMediaInfo(pUnknown.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        AutoPtr<DOM::MediaInfo::ISoundInfo> pSoundInfo = pUnknown;
+        ASSERT(pSoundInfo);
+        
+        m_pOutputWriter->DefineSound(GetResourceId(resourceId), libName, pMediaItem);
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result ResourcePalette::AddBitmap(FCM::U_Int32 resourceId, DOM::LibraryItem::PIMediaItem pMediaItem)
+    {
+        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
+        FCM::Result res;
+        FCM::StringRep16 pName;
+
+        LOG(("[DefineBitmap] ResId: %d\n", resourceId));
+
+        m_resourceIds.insert(resourceId);
+
+        pLibItem = pMediaItem;
+
+        // Store the resource name
+        res = pLibItem->GetName(&pName);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        std::string libItemName = Utils::ToString(pName, GetCallback());
+        m_resourceNames.insert(libItemName);
+
+        // Free the name
+        AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
+
+        callocService->Free((FCM::PVoid)pName);
+
+        if (FindLibraryResource(resourceId, libItemName))
+        {
+            // Defined (and its image exported) for an earlier scene
+            return FCM_SUCCESS;
+        }
+
+        AutoPtr<FCM::IFCMUnknown> medInfo;
+        pMediaItem->GetMediaInfo(medInfo.m_Ptr);
+
+        AutoPtr<DOM::MediaInfo::IBitmapInfo> bitsInfo = medInfo;
+        ASSERT(bitsInfo);
+
+        // Get image height
+        FCM::S_Int32 height;
+        res = bitsInfo->GetHeight(height);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Get image width
+        FCM::S_Int32 width;
+        res = bitsInfo->GetWidth(width);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        m_bitmapScaleTracker.AddBitmap(GetResourceId(resourceId), libItemName);
+
+        // Dump the definition of a bitmap
+        res = m_pOutputWriter->DefineBitmap(GetResourceId(resourceId), height, width, libItemName, pMediaItem);
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::AddClassicText(FCM::U_Int32 resourceId, DOM::FrameElement::PIClassicText pClassicText)
+    {
+        DOM::AutoPtr<DOM::FrameElement::IClassicText> pTextItem;
+        FCMListPtr pParagraphsList;
+        FCM::StringRep16 textDisplay;
+        FCM::U_Int32 count = 0;
+        FCM::U_Int16 fontSize;
+        std::string fName; 
+        std::string displayText; 
+        DOM::Utils::COLOR fontColor;
+        FCM::Result res;
+     
+        LOG(("[DefineClassicText] ResId: %d\n", resourceId));
+
+        m_resourceIds.insert(resourceId);
+
+        pTextItem = pClassicText;
+        AutoPtr<DOM::FrameElement::ITextBehaviour> textBehaviour;
+        pTextItem->GetTextBehaviour(textBehaviour.m_Ptr);
+        AutoPtr<DOM::FrameElement::IDynamicTextBehaviour> dynamicTextBehaviour = textBehaviour.m_Ptr;
+
+        if(dynamicTextBehaviour)
+        {
+            pTextItem->GetParagraphs(pParagraphsList.m_Ptr);
+            res = pParagraphsList->Count(count);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = pTextItem->GetText(&textDisplay);
+            ASSERT(FCM_SUCCESS_CODE(res));
+            displayText = Utils::ToString(textDisplay, GetCallback());
+
+            // Free the textDisplay
+            AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
+
+            callocService->Free((FCM::PVoid)textDisplay);
+        }
+    
+        for (FCM::U_Int32 pIndex = 0; pIndex < count; pIndex++)
+        {
+            AutoPtr<DOM::FrameElement::IParagraph> pParagraph = pParagraphsList[pIndex];
+
+            if (pParagraph)
+            {
+                FCMListPtr pTextRunList;
+                pParagraph->GetTextRuns(pTextRunList.m_Ptr);
+
+                FCM::U_Int32 trCount;
+                pTextRunList->Count(trCount);
+
+                for (FCM::U_Int32 trIndex = 0; trIndex < trCount; trIndex++)
+                {
+                    AutoPtr<DOM::FrameElement::ITextRun> pTextRun = pTextRunList[trIndex];
+                    AutoPtr<DOM::FrameElement::ITextStyle> trStyle;
+
+                    pTextRun->GetTextStyle(trStyle.m_Ptr);
+                    
+                    res = trStyle->GetFontSize(fontSize);
+                    ASSERT(FCM_SUCCESS_CODE(res));
+
+                    res = trStyle->GetFontColor(fontColor);
+                    ASSERT(FCM_SUCCESS_CODE(res));
+
+                    // Form font info in required format
+                    GetFontInfo(trStyle, fName, fontSize);
+                }
+            }
+        }
+    
+        //Define Text Element
+        res = m_pOutputWriter->DefineText(GetResourceId(resourceId), fName, fontColor,displayText,pTextItem);
+
+        return FCM_SUCCESS;
+    }
+
+
+
+    FCM::Result ResourcePalette::HasResource(FCM::U_Int32 resourceId, FCM::Boolean& hasResource)
+    {
+        hasResource = (m_resourceIds.find(resourceId) != m_resourceIds.end());
+
+        //LOG(("[HasResource] ResId: %d HasResource: %d\n", resourceId, hasResource));
+
+        return FCM_SUCCESS;
+    }
+
+
+    ResourcePalette::ResourcePalette()
+    {
+        m_pOutputWriter = NULL;
+        m_dedupShapes = false;
+        m_simplifyTolerance = 0;
+        m_sceneCount = 0;
+        m_nextResourceId = 1;
+        m_aliasedShapeCount = 0;
+        m_sharedResourceCount = 0;
+        m_shapeSegments.resourceId = 0;
+        m_shapeSegments.segmentCount = 0;
+        m_shapeSegments.simplifiedCount = 0;
+    }
+
+
+    ResourcePalette::~ResourcePalette()
+    {
+    }
+
+
+    void ResourcePalette::Init(
+        IOutputWriter* pOutputWriter, 
+        FCM::Boolean dedupShapes, 
+        FCM::Double simplifyTolerance)
+    {
+        m_pOutputWriter = pOutputWriter;
+        m_dedupShapes = dedupShapes;
+        m_simplifyTolerance = simplifyTolerance;
+
+        if (m_dedupShapes && !m_pShapeService)
+        {
+            FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+            GetCallback()->GetService(DOM::FLA_SHAPE_SERVICE, pUnk.m_Ptr);
+            m_pShapeService = pUnk;
+            if (!m_pShapeService)
+            {
+                // Shapes are then written as they come
+                m_dedupShapes = false;
+            }
+        }
+    }
+
+    void ResourcePalette::Clear()
+    {
+        m_resourceIds.clear();
+        m_resourceNames.clear();
+        m_definedShapes.clear();
+        m_sceneResourceIds.clear();
+        m_libraryResourceIds.clear();
+        m_libraryShapeIds.clear();
+        m_pendingShapes.clear();
+        m_shapeUserCounts.clear();
+        m_simplifiedShapes.clear();
+        m_bitmapScaleTracker.Clear();
+
+        m_sceneCount = 0;
+        m_nextResourceId = 1;
+        m_aliasedShapeCount = 0;
+        m_sharedResourceCount = 0;
+    }
+
+
+    void ResourcePalette::EndExport()
+    {
+        m_definedShapes.clear();
+        m_pendingShapes.clear();
+    }
+
+
+    void ResourcePalette::StartScene()
+    {
+        m_sceneCount++;
+
+        // The frame command generator starts each scene with an empty palette
+        m_resourceIds.clear();
+        m_sceneResourceIds.clear();
+    }
+
+
+    void ResourcePalette::EndScene()
+    {
+        std::map<FCM::U_Int32, PENDING_SHAPE>::iterator it;
+
+        for (it = m_pendingShapes.begin(); it != m_pendingShapes.end(); ++it)
+        {
+            DefineShape(it->first, it->second.pShape);
+        }
+
+        m_pendingShapes.clear();
+        m_shapeUserCounts.clear();
+    }
+
+
+    void ResourcePalette::AddShapeUser(FCM::U_Int32 resourceId)
+    {
+        if (m_sceneCount > 1)
+        {
+            m_shapeUserCounts[resourceId]++;
+        }
+    }
+
+
+    FCM::U_Int32 ResourcePalette::GetResourceId(FCM::U_Int32 resourceId)
+    {
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32>::iterator it = m_sceneResourceIds.find(resourceId);
+
+        if (it != m_sceneResourceIds.end())
+        {
+            return it->second;
+        }
+
+        // The first scene keeps its ids; the resources of the others are numbered on
+        if (m_sceneCount > 1)
+        {
+            FCM::U_Int32 id = AllocateResourceId();
+
+            m_sceneResourceIds[resourceId] = id;
+            return id;
+        }
+
+        if (resourceId >= m_nextResourceId)
+        {
+            m_nextResourceId = resourceId + 1;
+        }
+
+        return resourceId;
+    }
+
+
+    FCM::U_Int32 ResourcePalette::AllocateResourceId()
+    {
+        return m_nextResourceId++;
+    }
+
+
+    BitmapScaleTracker& ResourcePalette::GetBitmapScaleTracker()
+    {
+        return m_bitmapScaleTracker;
+    }
+
+
+    FCM::Boolean ResourcePalette::FindLibraryResource(FCM::U_Int32 resourceId, const std::string& name)
+    {
+        std::unordered_map<std::string, FCM::U_Int32>::iterator it = m_libraryResourceIds.find(name);
+
+        if (it != m_libraryResourceIds.end())
+        {
+            m_sceneResourceIds[resourceId] = it->second;
+            m_sharedResourceCount++;
+            return true;
+        }
+
+        m_libraryResourceIds[name] = GetResourceId(resourceId);
+
+        return false;
+    }
+
+
+    void ResourcePalette::MapLibraryShapes(const std::string& name, TimelineBuilder* pTimeline)
+    {
+        const std::vector<FCM::U_Int32>& shapeIds = pTimeline->GetShapeResourceIds();
+
+        // The symbol places the same shapes as when it was written, in the same order
+        std::unordered_map<std::string, std::vector<FCM::U_Int32> >::iterator libIt = 
+            m_libraryShapeIds.find(name);
+        FCM::Boolean mapped = (libIt != m_libraryShapeIds.end()) && 
+            (libIt->second.size() == shapeIds.size());
+
+        for (size_t i = 0; i < shapeIds.size(); i++)
+        {
+            FCM::U_Int32 resourceId = shapeIds[i];
+
+            FCM::U_Int32& userCount = m_shapeUserCounts[resourceId];
+            ASSERT(userCount > 0);
+            userCount--;
+
+            if (!mapped || (userCount > 0))
+            {
+                // Also placed by another timeline, under the id of this scene
+                continue;
+            }
+
+            std::map<FCM::U_Int32, PENDING_SHAPE>::iterator it = m_pendingShapes.find(resourceId);
+            if (it == m_pendingShapes.end())
+            {
+                // Identical to a shape defined before
+                continue;
+            }
+
+            FCM::U_Int32 definedId = libIt->second[i];
+
+            if (!RemapDefinedShape(GetResourceId(resourceId), it->second.geometryHash, definedId))
+            {
+                continue;
+            }
+
+            LOG(("[DefineShape] ResId: %d was defined as ResId: %d\n", resourceId, definedId));
+
+            m_sceneResourceIds[resourceId] = definedId;
+            m_pendingShapes.erase(it);
+            m_sharedResourceCount++;
+        }
+    }
+
+
+    FCM::Boolean ResourcePalette::RemapDefinedShape(
+        FCM::U_Int32 resourceId, 
+        FCM::U_Int64 geometryHash, 
+        FCM::U_Int32 definedId)
+    {
+        typedef std::unordered_multimap<FCM::U_Int64, DEFINED_SHAPE>::iterator Iterator;
+
+        if (!m_dedupShapes)
+        {
+            return true;
+        }
+
+        std::pair<Iterator, Iterator> range = m_definedShapes.equal_range(geometryHash);
+        for (Iterator it = range.first; it != range.second; ++it)
+        {
+            if (it->second.resourceId != resourceId)
+            {
+                continue;
+            }
+
+            if (it->second.aliasCount > 0)
+            {
+                return false;
+            }
+
+            it->second.resourceId = definedId;
+            return true;
+        }
+
+        return true;
+    }
+
+
+    void ResourcePalette::TraceShapeDedupReport()
+    {
+        FCM::U_Int32 bytesSaved = 0;
+
+        if (m_aliasedShapeCount == 0)
+        {
+            return;
+        }
+
+        std::unordered_multimap<FCM::U_Int64, DEFINED_SHAPE>::iterator it;
+        for (it = m_definedShapes.begin(); it != m_definedShapes.end(); ++it)
+        {
+            if (it->second.aliasCount > 0)
+            {
+                bytesSaved += it->second.aliasCount * m_pOutputWriter->GetShapeSize(it->second.resourceId);
+            }
+        }
+
+        Utils::Trace(GetCallback(), "%u of %u shapes were identical to another shape (%u bytes saved)\n", 
+            m_aliasedShapeCount, 
+            (FCM::U_Int32)(m_aliasedShapeCount + m_definedShapes.size()),
+            bytesSaved);
+    }
+
+
+    void ResourcePalette::TraceSimplifyReport()
+    {
+        FCM::U_Int64 segmentCount = 0;
+        FCM::U_Int64 simplifiedCount = 0;
+
+        if (m_simplifiedShapes.empty())
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < m_simplifiedShapes.size(); i++)
+        {
+            segmentCount += m_simplifiedShapes[i].segmentCount;
+            simplifiedCount += m_simplifiedShapes[i].simplifiedCount;
+        }
+
+        Utils::Trace(GetCallback(), "Path simplification removed %llu of %llu segments in %u shapes\n", 
+            (unsigned long long)(segmentCount - simplifiedCount), 
+            (unsigned long long)segmentCount,
+            (FCM::U_Int32)m_simplifiedShapes.size());
+
+        size_t reportCount = std::min(m_simplifiedShapes.size(), (size_t)MAX_SIMPLIFY_REPORT_SHAPES);
+
+        std::partial_sort(
+            m_simplifiedShapes.begin(), 
+            m_simplifiedShapes.begin() + reportCount, 
+            m_simplifiedShapes.end(),
+            HasMoreSegmentsRemoved);
+
+        for (size_t i = 0; i < reportCount; i++)
+        {
+            const SIMPLIFIED_SHAPE& shape = m_simplifiedShapes[i];
+
+            Utils::Trace(GetCallback(), "  Shape %u: %u -> %u segments\n", 
+                shape.resourceId, shape.segmentCount, shape.simplifiedCount);
+        }
+    }
+
+
+    void ResourcePalette::TraceSharedResourceReport()
+    {
+        if (m_sharedResourceCount == 0)
+        {
+            return;
+        }
+
+        Utils::Trace(GetCallback(), "%u resources are shared between scenes and defined once\n", 
+            m_sharedResourceCount);
+    }
+
+
+    FCM::U_Int64 ResourcePalette::GetGeometryHash(DOM::FrameElement::PIShape pShape)
+    {
+        FCM::Result res;
+        DOM::Utils::RECT bounds;
+        FCM::S_Int32 values[4];
+        FCM::U_Int64 hash = 14695981039346656037ULL;
+
+        // Identical shapes have the same bounds, so only shapes that share them
+        // need to be compared
+        FCM::AutoPtr<DOM::FrameElement::IFrameDisplayElement> pElement = pShape;
+        if (!pElement)
+        {
+            return 0;
+        }
+
+        res = pElement->GetObjectSpaceBounds(bounds);
+        if (FCM_FAILURE_CODE(res))
+        {
+            return 0;
+        }
+
+        values[0] = (FCM::S_Int32)floor(bounds.topLeft.x * SHAPE_BOUNDS_QUANTUM + 0.5);
+        values[1] = (FCM::S_Int32)floor(bounds.topLeft.y * SHAPE_BOUNDS_QUANTUM + 0.5);
+        values[2] = (FCM::S_Int32)floor(bounds.bottomRight.x * SHAPE_BOUNDS_QUANTUM + 0.5);
+        values[3] = (FCM::S_Int32)floor(bounds.bottomRight.y * SHAPE_BOUNDS_QUANTUM + 0.5);
+
+        // FNV-1a
+        const FCM::U_Int8* pBytes = (const FCM::U_Int8*)values;
+        for (size_t i = 0; i < sizeof(values); i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+
+    DEFINED_SHAPE* ResourcePalette::FindIdenticalShape(
+        DOM::FrameElement::PIShape pShape, 
+        FCM::U_Int64 geometryHash)
+    {
+        typedef std::unordered_multimap<FCM::U_Int64, DEFINED_SHAPE>::iterator Iterator;
+
+        std::pair<Iterator, Iterator> range = m_definedShapes.equal_range(geometryHash);
+        for (Iterator it = range.first; it != range.second; ++it)
+        {
+            FCM::Result res;
+            FCM::Boolean similar = false;
+            DOM::Utils::MATRIX2D mapAtoB;
+
+            res = m_pShapeService->TestShapeSimilarity(it->second.pShape, pShape, similar, mapAtoB);
+            if (FCM_FAILURE_CODE(res) || !similar)
+            {
+                continue;
+            }
+
+            // Similar shapes may still differ by a transform, which the placement
+            // matrix does not account for
+            if ((fabs(mapAtoB.a - 1.0) < SHAPE_IDENTITY_TOLERANCE) &&
+                (fabs(mapAtoB.b) < SHAPE_IDENTITY_TOLERANCE) &&
+                (fabs(mapAtoB.c) < SHAPE_IDENTITY_TOLERANCE) &&
+                (fabs(mapAtoB.d - 1.0) < SHAPE_IDENTITY_TOLERANCE) &&
+                (fabs(mapAtoB.tx) < SHAPE_IDENTITY_TOLERANCE) &&
+                (fabs(mapAtoB.ty) < SHAPE_IDENTITY_TOLERANCE))
+            {
+                return &it->second;
+            }
+        }
+
+        return NULL;
+    }
+
+    FCM::Result ResourcePalette::HasResource(
+            const std::string& name, 
+            FCM::Boolean& hasResource)
+    {
+        hasResource = (m_resourceNames.find(name) != m_resourceNames.end());
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result ResourcePalette::ExportFill(DOM::FrameElement::PIShape pIShape)
+    {
+        FCM::Result res;
+        FCM::FCMListPtr pFilledRegionList;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
+        FCM::U_Int32 regionCount;
+
+        PROFILE_SCOPE(PROFILE_PHASE_EXPORT_FILL);
+
+        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
+        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
+        ASSERT(pIRegionGeneratorService);
+
+        res = pIRegionGeneratorService->GetFilledRegions(pIShape, pFilledRegionList.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        pFilledRegionList->Count(regionCount);
+
+        for (FCM::U_Int32 j = 0; j < regionCount; j++)
+        {
+            FCM::AutoPtr<DOM::Service::Shape::IFilledRegion> pFilledRegion = pFilledRegionList[j];
+            FCM::AutoPtr<DOM::Service::Shape::IPath> pPath;
+
+            m_pOutputWriter->StartDefineFill();
+
+            // Fill Style
+            FCM::AutoPtr<DOM::IFCMUnknown> fillStyle;
+
+            res = pFilledRegion->GetFillStyle(fillStyle.m_Ptr);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            ExportFillStyle(fillStyle);
+
+            // Boundary
+            res = pFilledRegion->GetBoundary(pPath.m_Ptr);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = ExportFillBoundary(pPath);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            // Hole List
+            FCMListPtr pHoleList;
+            FCM::U_Int32 holeCount;
+
+            res = pFilledRegion->GetHoles(pHoleList.m_Ptr);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = pHoleList->Count(holeCount);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            for (FCM::U_Int32 k = 0; k < holeCount; k++)
+            {
+                FCM::FCMListPtr pEdgeList;
+                FCM::AutoPtr<DOM::Service::Shape::IPath> pPath = pHoleList[k];
+
+                res = ExportHole(pPath);
+            }
+
+            m_pOutputWriter->EndDefineFill();
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportFillBoundary(DOM::Service::Shape::PIPath pPath)
+    {
+        FCM::Result res;
+
+        m_pOutputWriter->StartDefineBoundary();
+
+        res = ExportPath(pPath);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        m_pOutputWriter->EndDefineBoundary();
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportHole(DOM::Service::Shape::PIPath pPath)
+    {
+        FCM::Result res;
+
+        m_pOutputWriter->StartDefineHole();
+
+        res = ExportPath(pPath);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        m_pOutputWriter->EndDefineHole();
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportPath(DOM::Service::Shape::PIPath pPath)
+    {
+        FCM::Result res;
+        FCM::U_Int32 edgeCount;
+        FCM::FCMListPtr pEdgeList;
+
+        res = pPath->GetEdges(pEdgeList.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pEdgeList->Count(edgeCount);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        if (m_simplifyTolerance <= 0)
+        {
+            for (FCM::U_Int32 l = 0; l < edgeCount; l++)
+            {
+                DOM::Utils::SEGMENT segment;
+
+                segment.structSize = sizeof(DOM::Utils::SEGMENT);
+
+                FCM::AutoPtr<DOM::Service::Shape::IEdge> pEdge = pEdgeList[l];
+
+                res = pEdge->GetSegment(segment);
+
+                m_pOutputWriter->SetSegment(segment);
+            }
+
+            return res;
+        }
+
+        // Simplified paths are collected first, as the simplification looks ahead
+        m_segments.resize(edgeCount);
+
+        for (FCM::U_Int32 l = 0; l < edgeCount; l++)
+        {
+            DOM::Utils::SEGMENT& segment = m_segments[l];
+
+            segment.structSize = sizeof(DOM::Utils::SEGMENT);
+
+            FCM::AutoPtr<DOM::Service::Shape::IEdge> pEdge = pEdgeList[l];
+
+            res = pEdge->GetSegment(segment);
+        }
+
+        PathSimplifier::Simplify(m_segments, m_simplifyTolerance);
+
+        m_shapeSegments.segmentCount += edgeCount;
+        m_shapeSegments.simplifiedCount += (FCM::U_Int32)m_segments.size();
+
+        for (size_t l = 0; l < m_segments.size(); l++)
+        {
+            m_pOutputWriter->SetSegment(m_segments[l]);
+        }
+
+        return res;
+    }
+
+    FCM::Result ResourcePalette::ExportFillStyle(FCM::PIFCMUnknown pFillStyle)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        AutoPtr<DOM::FillStyle::ISolidFillStyle> pSolidFillStyle;
+        AutoPtr<DOM::FillStyle::IGradientFillStyle> pGradientFillStyle;
+        AutoPtr<DOM::FillStyle::IBitmapFillStyle> pBitmapFillStyle;
+
+        // Check for solid fill color
+        pSolidFillStyle = pFillStyle;
+        if (pSolidFillStyle)
+        {
+            res = ExportSolidFillStyle(pSolidFillStyle);
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        // Check for Gradient Fill
+        pGradientFillStyle = pFillStyle;
+        AutoPtr<FCM::IFCMUnknown> pGrad;
+
+        if (pGradientFillStyle)
+        {
+            pGradientFillStyle->GetColorGradient(pGrad.m_Ptr);
+
+            if (AutoPtr<DOM::Utils::IRadialColorGradient>(pGrad))
+            {
+                res = ExportRadialGradientFillStyle(pGradientFillStyle);
+                ASSERT(FCM_SUCCESS_CODE(res));
+            }
+            else if (AutoPtr<DOM::Utils::ILinearColorGradient>(pGrad))
+            {
+                res = ExportLinearGradientFillStyle(pGradientFillStyle);
+                ASSERT(FCM_SUCCESS_CODE(res));
+            }
+        }
+
+        pBitmapFillStyle = pFillStyle;
+        if (pBitmapFillStyle)
+        {
+            res = ExportBitmapFillStyle(pBitmapFillStyle);
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportStroke(DOM::FrameElement::PIShape pIShape)
+    {
+        FCM::FCMListPtr pStrokeGroupList;
+        FCM::U_Int32 strokeStyleCount;
+        FCM::Result res;
+
+        PROFILE_SCOPE(PROFILE_PHASE_EXPORT_STROKE);
+
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
+        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
+        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
+        ASSERT(pIRegionGeneratorService);
+
+        res = pIRegionGeneratorService->GetStrokeGroups(pIShape, pStrokeGroupList.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pStrokeGroupList->Count(strokeStyleCount);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        AutoPtr<DOM::FillStyle::ISolidFillStyle> pSolidFillStyle = NULL;
+        AutoPtr<DOM::FillStyle::IGradientFillStyle> pGradientFillStyle = NULL;
+        AutoPtr<DOM::FillStyle::IBitmapFillStyle> pBitmapFillStyle = NULL;
+
+        AutoPtr<FCM::IFCMUnknown> pGrad;
+        for (FCM::U_Int32 j = 0; j < strokeStyleCount; j++)
+        {
+            AutoPtr<DOM::Service::Shape::IStrokeGroup> pStrokeGroup = pStrokeGroupList[j];
+            ASSERT(pStrokeGroup);
+
+            res = m_pOutputWriter->StartDefineStrokeGroup();
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            AutoPtr<FCM::IFCMUnknown> pStrokeStyle;
+            pStrokeGroup->GetStrokeStyle(pStrokeStyle.m_Ptr);
+
+            DOM::Utils::COLOR color = {};
+
+            FCMListPtr pPathList;
+            FCM::U_Int32 pathCount;
+
+            res = pStrokeGroup->GetPaths(pPathList.m_Ptr);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = pPathList->Count(pathCount);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            for (FCM::U_Int32 k = 0; k < pathCount; k++)
+            {
+                FCM::AutoPtr<DOM::Service::Shape::IPath> pPath;
+
+                pPath = pPathList[k];
+                ASSERT(pPath);
+
+                res = m_pOutputWriter->StartDefineStroke();
+                ASSERT(FCM_SUCCESS_CODE(res));
+
+                res = ExportStrokeStyle(pStrokeStyle);
+                ASSERT(FCM_SUCCESS_CODE(res));
+
+                res = ExportPath(pPath);
+                ASSERT(FCM_SUCCESS_CODE(res));
+
+                res = m_pOutputWriter->EndDefineStroke();
+                ASSERT(FCM_SUCCESS_CODE(res));
+            }
+
+            res = m_pOutputWriter->EndDefineStrokeGroup();
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::HasFancyStrokes(DOM::FrameElement::PIShape pShape, FCM::Boolean& hasFancy)
+    {
+        FCM::Result res;
+        FCM::FCMListPtr pStrokeGroupList;
+        FCM::U_Int32 strokeStyleCount;
+
+        hasFancy = false;
+
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
+        GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE,pUnkSRVReg.m_Ptr);
+        AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
+        ASSERT(pIRegionGeneratorService);
+
+        res = pIRegionGeneratorService->GetStrokeGroups(pShape, pStrokeGroupList.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pStrokeGroupList->Count(strokeStyleCount);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        for (FCM::U_Int32 j = 0; j < strokeStyleCount; j++)
+        {
+            
+            AutoPtr<DOM::StrokeStyle::ISolidStrokeStyle> pSolidStrokeStyle;
+            AutoPtr<DOM::Service::Shape::IStrokeGroup> pStrokeGroup = pStrokeGroupList[j];
+            ASSERT(pStrokeGroup);
+
+            AutoPtr<FCM::IFCMUnknown> pStrokeStyle;
+            pStrokeGroup->GetStrokeStyle(pStrokeStyle.m_Ptr);
+
+            pSolidStrokeStyle = pStrokeStyle;
+
+            if (pSolidStrokeStyle)
+            {
+                FCM::AutoPtr<DOM::StrokeStyle::IStrokeWidth> pStrokeWidth;
+
+                pSolidStrokeStyle->GetStrokeWidth(pStrokeWidth.m_Ptr);
+
+                if (pStrokeWidth.m_Ptr)
+                {
+                    // Variable width stroke
+                    hasFancy = true;
+                    break;
+                }            
+            }
+            else
+            {
+                // Not a solid stroke (may be dashed, dotted etc..)
+                hasFancy = true;
+                break;
+            }
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    // Convert strokes to fills
+    FCM::Result ResourcePalette::ConvertStrokeToFill(
+        DOM::FrameElement::PIShape pShape,
+        DOM::FrameElement::PIShape& pNewShape)
+    {
+        FCM::Result res;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg; 
+
+        GetCallback()->GetService(DOM::FLA_SHAPE_SERVICE, pUnkSRVReg.m_Ptr);
+
+        AutoPtr<DOM::Service::Shape::IShapeService> pIShapeService(pUnkSRVReg);
+        ASSERT(pIShapeService);
+
+        res = pIShapeService->ConvertStrokeToFill(pShape, pNewShape);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return FCM_SUCCESS;
+    }
+
+    FCM::Result ResourcePalette::ExportStrokeStyle(FCM::PIFCMUnknown pStrokeStyle)
+    {
+        FCM::Result res = FCM_SUCCESS;
+        AutoPtr<DOM::StrokeStyle::ISolidStrokeStyle> pSolidStrokeStyle;
+
+        pSolidStrokeStyle = pStrokeStyle;
+
+        if (pSolidStrokeStyle)
+        {
+            res = ExportSolidStrokeStyle(pSolidStrokeStyle);
+        }
+        else
+        {
+            // Other stroke styles are not tested yet.
+        }
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportSolidStrokeStyle(DOM::StrokeStyle::ISolidStrokeStyle* pSolidStrokeStyle)
+    {
+        FCM::Result res;
+        FCM::Double thickness;
+        AutoPtr<DOM::IFCMUnknown> pFillStyle;
+        DOM::StrokeStyle::CAP_STYLE capStyle;
+        DOM::StrokeStyle::JOIN_STYLE joinStyle;
+        DOM::Utils::ScaleType scaleType;
+        FCM::Boolean strokeHinting;
+
+
+        capStyle.structSize = sizeof(DOM::StrokeStyle::CAP_STYLE);
+        res = pSolidStrokeStyle->GetCapStyle(capStyle);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        joinStyle.structSize = sizeof(DOM::StrokeStyle::JOIN_STYLE);
+        res = pSolidStrokeStyle->GetJoinStyle(joinStyle);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pSolidStrokeStyle->GetThickness(thickness);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        if (thickness < 0.1)
+        {
+            thickness = 0.1;
+        }
+
+        res = pSolidStrokeStyle->GetScaleType(scaleType);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pSolidStrokeStyle->GetStrokeHinting(strokeHinting);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = m_pOutputWriter->StartDefineSolidStrokeStyle(
+            thickness, 
+            joinStyle, 
+            capStyle, 
+            scaleType, 
+            strokeHinting);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Stroke fill styles
+        res = pSolidStrokeStyle->GetFillStyle(pFillStyle.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = ExportFillStyle(pFillStyle);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = m_pOutputWriter->EndDefineSolidStrokeStyle();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportSolidFillStyle(DOM::FillStyle::ISolidFillStyle* pSolidFillStyle)
+    {
+        FCM::Result res;
+        DOM::Utils::COLOR color;
+
+        AutoPtr<DOM::FillStyle::ISolidFillStyle> solidFill = pSolidFillStyle;
+        ASSERT(solidFill);
+
+        res = solidFill->GetColor(color);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        m_pOutputWriter->DefineSolidFillStyle(color);
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportRadialGradientFillStyle(DOM::FillStyle::IGradientFillStyle* pGradientFillStyle)
+    {
+        DOM::FillStyle::GradientSpread spread;
+
+        AutoPtr<FCM::IFCMUnknown> pGrad;
+
+        AutoPtr<DOM::FillStyle::IGradientFillStyle> gradientFill = pGradientFillStyle;
+        FCM::Result res = gradientFill->GetSpread(spread);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = gradientFill->GetColorGradient(pGrad.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        AutoPtr<DOM::Utils::IRadialColorGradient> radialColorGradient = pGrad;
+        ASSERT(radialColorGradient);
+
+        DOM::Utils::MATRIX2D matrix;
+        res = gradientFill->GetMatrix(matrix);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        FCM::S_Int32 focalPoint = 0;
+        res = radialColorGradient->GetFocalPoint(focalPoint);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = m_pOutputWriter->StartDefineRadialGradientFillStyle(spread, matrix, focalPoint);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        FCM::U_Int8 nColors;
+        res = radialColorGradient->GetKeyColorCount(nColors);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        for (FCM::U_Int8 i = 0; i < nColors; i++)
+        {
+            DOM::Utils::GRADIENT_COLOR_POINT point;
+
+            res = radialColorGradient->GetKeyColorAtIndex(i, point);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = m_pOutputWriter->SetKeyColorPoint(point);
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        res = m_pOutputWriter->EndDefineRadialGradientFillStyle();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportLinearGradientFillStyle(DOM::FillStyle::IGradientFillStyle* pGradientFillStyle)
+    {
+        DOM::FillStyle::GradientSpread spread;
+        AutoPtr<FCM::IFCMUnknown> pGrad;
+
+        AutoPtr<DOM::FillStyle::IGradientFillStyle> gradientFill = pGradientFillStyle;
+        FCM::Result res = gradientFill->GetSpread(spread);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = gradientFill->GetColorGradient(pGrad.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        AutoPtr<DOM::Utils::ILinearColorGradient> linearColorGradient = pGrad;
+        ASSERT(linearColorGradient);
+
+        DOM::Utils::MATRIX2D matrix;
+        res = gradientFill->GetMatrix(matrix);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = m_pOutputWriter->StartDefineLinearGradientFillStyle(spread, matrix);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        FCM::U_Int8 nColors;
+        res = linearColorGradient->GetKeyColorCount(nColors);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        for (FCM::U_Int8 i = 0; i < nColors; i++)
+        {
+            DOM::Utils::GRADIENT_COLOR_POINT point;
+
+            res = linearColorGradient->GetKeyColorAtIndex(i, point);
+            ASSERT(FCM_SUCCESS_CODE(res));
+
+            res = m_pOutputWriter->SetKeyColorPoint(point);
+            ASSERT(FCM_SUCCESS_CODE(res));
+        }
+
+        res = m_pOutputWriter->EndDefineLinearGradientFillStyle();
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::ExportBitmapFillStyle(DOM::FillStyle::IBitmapFillStyle* pBitmapFillStyle)
+    {
+        DOM::AutoPtr<DOM::ILibraryItem> pLibItem;
+        DOM::AutoPtr<DOM::LibraryItem::IMediaItem> pMediaItem;
+        FCM::Result res;
+        FCM::Boolean isClipped;
+        DOM::Utils::MATRIX2D matrix;
+        std::string name;
+        FCM::StringRep16 pName;
+
+        // IsClipped ?
+        res = pBitmapFillStyle->IsClipped(isClipped);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Matrix
+        res = pBitmapFillStyle->GetMatrix(matrix);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Get name
+        res = pBitmapFillStyle->GetBitmap(pMediaItem.m_Ptr);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        pLibItem = pMediaItem;
+
+        AutoPtr<FCM::IFCMUnknown> medInfo;
+        pMediaItem->GetMediaInfo(medInfo.m_Ptr);
+
+        AutoPtr<DOM::MediaInfo::IBitmapInfo> bitsInfo = medInfo;
+        ASSERT(bitsInfo);
+
+        // Get image height
+        FCM::S_Int32 height;
+        res = bitsInfo->GetHeight(height);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Store the resource name
+        res = pLibItem->GetName(&pName);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        std::string libItemName = Utils::ToString(pName, GetCallback());
+        m_resourceNames.insert(libItemName);
+
+        // Get image width
+        FCM::S_Int32 width;
+        res = bitsInfo->GetWidth(width);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // The fill matrix maps the pixels of the bitmap to twips
+        m_bitmapScaleTracker.AddBitmapFill(
+            m_shapeSegments.resourceId, 
+            libItemName, 
+            BitmapScaleTracker::GetScale(matrix) / 20);
+
+        // Dump the definition of a bitmap fill style
+        res = m_pOutputWriter->DefineBitmapFillStyle(
+            isClipped, 
+            matrix, 
+            height, 
+            width, 
+            libItemName, 
+            pMediaItem);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        // Free the name
+        AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
+
+        callocService->Free((FCM::PVoid)pName);
+
+        return res;
+    }
+
+
+    FCM::Result ResourcePalette::GetFontInfo(DOM::FrameElement::ITextStyle* pTextStyleItem, std::string& name, FCM::U_Int16 fontSize)
+    {
+        FCM::StringRep16 pFontName;
+        FCM::StringRep8 pFontStyle;
+        FCM::Result res;
+        std::string str;
+        std::string sizeStr;
+        std::string styleStr;
+
+        res = pTextStyleItem->GetFontName(&pFontName);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        res = pTextStyleItem->GetFontStyle(&pFontStyle);
+        ASSERT(FCM_SUCCESS_CODE(res));
+
+        styleStr = pFontStyle;
+        if(styleStr == "BoldItalicStyle")
+            styleStr = "italic bold";
+        else if(styleStr == "BoldStyle")
+            styleStr = "bold";
+        else if(styleStr == "ItalicStyle")
+            styleStr = "italic";
+        else if(styleStr == "RegularStyle")
+            styleStr = "";
+
+        sizeStr = Utils::ToString(fontSize);
+        str = Utils::ToString(pFontName,GetCallback());
+        name = styleStr+" "+sizeStr + "px" + " " + "'" + str + "'" ;
+
+        // Free the name and style
+        AutoPtr<FCM::IFCMCalloc> callocService = Utils::GetCallocService(GetCallback());
+
+        callocService->Free((FCM::PVoid)pFontName);
+        callocService->Free((FCM::PVoid)pFontStyle);
+
+        return res;
+    }
+
+
+    /* ----------------------------------------------------- TimelineBuilder */
+
+    FCM::Result TimelineBuilder::AddShape(FCM::U_Int32 objectId, SHAPE_INFO* pShapeInfo)
+    {
+        FCM::Result res;
+
+        ASSERT(pShapeInfo);
+        ASSERT(pShapeInfo->structSize >= sizeof(SHAPE_INFO));
+
+        LOG(("[AddShape] ObjId: %d ResId: %d PlaceAfter: %d\n", 
+            objectId, pShapeInfo->resourceId, pShapeInfo->placeAfterObjectId));
+
+        if (m_placedShapes.insert(pShapeInfo->resourceId).second)
+        {
+            m_shapeResourceIds.push_back(pShapeInfo->resourceId);
+            m_pResourcePalette->AddShapeUser(pShapeInfo->resourceId);
+        }
+
+        // Identical shapes share one definition; later scenes use remapped ids
+        FCM::U_Int32 resourceId = m_pResourcePalette->GetResourceId(pShapeInfo->resourceId);
+
+        AddChildScale(objectId, resourceId, pShapeInfo->matrix);
+
+        res = m_pTimelineWriter->PlaceObject(
+            resourceId, 
+            objectId, 
+            pShapeInfo->placeAfterObjectId, 
+            &pShapeInfo->matrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddClassicText(FCM::U_Int32 objectId, CLASSIC_TEXT_INFO* pClassicTextInfo)
+    {
+        FCM::Result res;
+
+        ASSERT(pClassicTextInfo);
+        ASSERT(pClassicTextInfo->structSize >= sizeof(CLASSIC_TEXT_INFO));
+
+        LOG(("[AddClassicText] ObjId: %d ResId: %d PlaceAfter: %d\n", 
+            objectId, pClassicTextInfo->resourceId, pClassicTextInfo->placeAfterObjectId));
+        
+        //To get the bounding rect of the text
+        if(pClassicTextInfo->structSize >= sizeof(DISPLAY_OBJECT_INFO_2))
+        {
+            DOM::Utils::RECT rect;
+            DISPLAY_OBJECT_INFO_2 *ptr = static_cast<DISPLAY_OBJECT_INFO_2*>(pClassicTextInfo);
+            if(ptr)
+            {
+                rect = ptr->bounds;
+                // This rect object gives the bound of the text filed.
+                // This will have to be transformed using the pClassicTextInfo->matrix
+                // to map it to its parent's co-orinate space to render it.
+            }
+        }
+        
+        res = m_pTimelineWriter->PlaceObject(
+            m_pResourcePalette->GetResourceId(pClassicTextInfo->resourceId), 
+            objectId, 
+            pClassicTextInfo->placeAfterObjectId, 
+            &pClassicTextInfo->matrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddBitmap(FCM::U_Int32 objectId, BITMAP_INFO* pBitmapInfo)
+    {
+        FCM::Result res;
+
+        ASSERT(pBitmapInfo);
+        ASSERT(pBitmapInfo->structSize >= sizeof(BITMAP_INFO));
+
+        LOG(("[AddBitmap] ObjId: %d ResId: %d PlaceAfter: %d\n", 
+            objectId, pBitmapInfo->resourceId, pBitmapInfo->placeAfterObjectId));
+
+        FCM::U_Int32 resourceId = m_pResourcePalette->GetResourceId(pBitmapInfo->resourceId);
+
+        AddChildScale(objectId, resourceId, pBitmapInfo->matrix);
+
+        res = m_pTimelineWriter->PlaceObject(
+            resourceId, 
+            objectId, 
+            pBitmapInfo->placeAfterObjectId, 
+            &pBitmapInfo->matrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddMovieClip(FCM::U_Int32 objectId, MOVIE_CLIP_INFO* pMovieClipInfo, DOM::FrameElement::PIMovieClip pMovieClip)
+    {
+        FCM::Result res;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = pMovieClip;
+
+        ASSERT(pMovieClipInfo);
+        ASSERT(pMovieClipInfo->structSize >= sizeof(MOVIE_CLIP_INFO));
+      
+        LOG(("[AddMovieClip] ObjId: %d ResId: %d PlaceAfter: %d\n", 
+            objectId, pMovieClipInfo->resourceId, pMovieClipInfo->placeAfterObjectId));
+
+        AutoPtr<DOM::FrameElement::IButton> pButton = pMovieClip;
+        if(pButton.m_Ptr)
+        {
+            DOM::FrameElement::ButtonTrackMode trackMode;
+            pButton->GetTrackingMode(trackMode);
+            if(trackMode == DOM::FrameElement::TRACK_AS_BUTTON)
+            {
+                LOG(("[AddMovieClip] ObjId: %d, is a button with TrackingMode set to TRACK_AS_BUTTON\n",
+                     objectId));
+                
+            }else
+            {
+                LOG(("[AddMovieClip] ObjId: %d, is a button with TrackingMode set to TRACK_AS_MENU_ITEM\n",
+                     objectId));
+            }
+        }
+        
+        FCM::U_Int32 resourceId = m_pResourcePalette->GetResourceId(pMovieClipInfo->resourceId);
+
+        AddChildScale(objectId, resourceId, pMovieClipInfo->matrix);
+
+        res = m_pTimelineWriter->PlaceObject(
+            resourceId, 
+            objectId, 
+            pMovieClipInfo->placeAfterObjectId, 
+            &pMovieClipInfo->matrix,
+            pUnknown);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddGraphic(FCM::U_Int32 objectId, GRAPHIC_INFO* pGraphicInfo)
+    {
+        FCM::Result res;
+
+        ASSERT(pGraphicInfo);
+        ASSERT(pGraphicInfo->structSize >= sizeof(GRAPHIC_INFO));
+
+        LOG(("[AddGraphic] ObjId: %d ResId: %d PlaceAfter: %d\n", 
+            objectId, pGraphicInfo->resourceId, pGraphicInfo->placeAfterObjectId));
+
+        FCM::U_Int32 resourceId = m_pResourcePalette->GetResourceId(pGraphicInfo->resourceId);
+
+        AddChildScale(objectId, resourceId, pGraphicInfo->matrix);
+
+        res = m_pTimelineWriter->PlaceObject(
+            resourceId, 
+            objectId, 
+            pGraphicInfo->placeAfterObjectId, 
+            &pGraphicInfo->matrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddSound(
+        FCM::U_Int32 objectId, 
+        SOUND_INFO* pSoundInfo, 
+        DOM::FrameElement::PISound pSound)
+    {
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = pSound;
+        FCM::Result res;
+
+        ASSERT(pSoundInfo);
+        ASSERT(pSoundInfo->structSize == sizeof(SOUND_INFO));
+
+        LOG(("[AddSound] ObjId: %d ResId: %d\n", 
+            objectId, pSoundInfo->resourceId));
+
+        res = m_pTimelineWriter->PlaceObject(
+            m_pResourcePalette->GetResourceId(pSoundInfo->resourceId), 
+            objectId, 
+            pUnknown);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::UpdateZOrder(FCM::U_Int32 objectId, FCM::U_Int32 placeAfterObjectId)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[UpdateZOrder] ObjId: %d PlaceAfter: %d\n", 
+            objectId, placeAfterObjectId));
+
+        res = m_pTimelineWriter->UpdateZOrder(objectId, placeAfterObjectId);
+
+        return res;
+    }
+
+     FCM::Result TimelineBuilder::UpdateMask(FCM::U_Int32 objectId, FCM::U_Int32 maskTillObjectId)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[UpdateMask] ObjId: %d MaskTill: %d\n", 
+            objectId, maskTillObjectId));
+
+        res = m_pTimelineWriter->UpdateMask(objectId, maskTillObjectId);
+
+        return res;
+    }
+     
+     FCM::Result TimelineBuilder::Remove(FCM::U_Int32 objectId)
+    {
+        FCM::Result res;
+
+        LOG(("[Remove] ObjId: %d\n", objectId));
+
+        res = m_pTimelineWriter->RemoveObject(objectId);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::UpdateBlendMode(FCM::U_Int32 objectId, DOM::FrameElement::BlendMode blendMode)
+    {
+        FCM::Result res;
+
+        LOG(("[UpdateBlendMode] ObjId: %d BlendMode: %d\n", objectId, blendMode));
+
+        res = m_pTimelineWriter->UpdateBlendMode(objectId, blendMode);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::UpdateVisibility(FCM::U_Int32 objectId, FCM::Boolean visible)
+    {
+        FCM::Result res;
+
+        LOG(("[UpdateVisibility] ObjId: %d Visible: %d\n", objectId, visible));
+
+        res = m_pTimelineWriter->UpdateVisibility(objectId, visible);
+
+        return res;
+    }
+
+
+    FCM::Result TimelineBuilder::UpdateGraphicFilter(FCM::U_Int32 objectId, PIFCMList pFilterable)
+    {
+        FCM::U_Int32 count;
+        FCM::Result res;
+        FCM::FCMListPtr pFilterList;
+
+        LOG(("[UpdateGraphicFilter] ObjId: %d\n", objectId));
+
+        res = pFilterable->Count(count);
+        ASSERT(FCM_SUCCESS_CODE(res));
+        
+        for (FCM::U_Int32 i = 0; i < count; i++)
+        {
+            FCM::AutoPtr<FCM::IFCMUnknown> pUnknown = (*pFilterable)[i];
+            res = m_pTimelineWriter->AddGraphicFilter(objectId, pUnknown.m_Ptr);
+
+            if (FCM_FAILURE_CODE(res))
+            {
+                return res;
+            }
+        }
+
+        return FCM_SUCCESS;
+    }
+
+
+    FCM::Result TimelineBuilder::UpdateDisplayTransform(FCM::U_Int32 objectId, const DOM::Utils::MATRIX2D& matrix)
+    {
+        FCM::Result res;
+
+        LOG(("[UpdateDisplayTransform] ObjId: %d\n", objectId));
+
+        std::unordered_map<FCM::U_Int32, FCM::U_Int32>::const_iterator it = m_objectResourceIds.find(objectId);
+        if (it != m_objectResourceIds.end())
+        {
+            AddChildScale(objectId, it->second, matrix);
+        }
+
+        res = m_pTimelineWriter->UpdateDisplayTransform(objectId, matrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::UpdateColorTransform(FCM::U_Int32 objectId, const DOM::Utils::COLOR_MATRIX& colorMatrix)
+    {
+        FCM::Result res;
+
+        LOG(("[UpdateColorTransform] ObjId: %d\n", objectId));
+
+        res = m_pTimelineWriter->UpdateColorTransform(objectId, colorMatrix);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::ShowFrame()        
+    {
+        FCM::Result res;
+
+        LOG(("[ShowFrame] Frame: %d\n", m_frameIndex));
+
+        res = m_pTimelineWriter->ShowFrame(m_frameIndex);
+
+        m_frameIndex++;
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[AddFrameScript] LayerNum: %d\n", layerNum));
+
+        if (pScript != NULL)
+        {
+            res = m_pTimelineWriter->AddFrameScript(pScript, layerNum);
+        }
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::RemoveFrameScript(FCM::U_Int32 layerNum)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[RemoveFrameScript] LayerNum: %d\n", layerNum));
+
+        res = m_pTimelineWriter->RemoveFrameScript(layerNum);
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType)
+    {
+        FCM::Result res = FCM_SUCCESS;
+
+        LOG(("[SetFrameLabel]\n"));
+
+        if (pLabel != NULL)
+        {
+            res = m_pTimelineWriter->SetFrameLabel(pLabel, labelType);
+        }
+
+        return res;
+    }
+
+    FCM::Result TimelineBuilder::Build(
+        FCM::U_Int32 resourceId, 
+        FCM::StringRep16 pName,
+        ITimelineWriter** ppTimelineWriter)
+    {
+        FCM::Result res;
+
+        res = m_pOutputWriter->EndDefineTimeline(resourceId, pName, m_pTimelineWriter);
+
+        *ppTimelineWriter = m_pTimelineWriter;
+
+        m_pResourcePalette->GetBitmapScaleTracker().AddTimeline(resourceId, m_childScales);
+
+        return res;
+    }
+
+
+    void TimelineBuilder::AddChildScale(
+        FCM::U_Int32 objectId, 
+        FCM::U_Int32 resourceId, 
+        const DOM::Utils::MATRIX2D& matrix)
+    {
+        FCM::Double scale = BitmapScaleTracker::GetScale(matrix);
+        ResourceScaleMap::iterator it = m_childScales.find(resourceId);
+
+        m_objectResourceIds[objectId] = resourceId;
+
+        if ((it == m_childScales.end()) || (it->second < scale))
+        {
+            m_childScales[resourceId] = scale;
+        }
+    }
+
+
+    TimelineBuilder::TimelineBuilder() :
+        m_pOutputWriter(NULL),
+        m_pResourcePalette(NULL),
+        m_frameIndex(0)
+    {
+        //LOG(("[CreateTimeline]\n"));
+    }
+
+    TimelineBuilder::~TimelineBuilder()
+    {
+    }
+
+    void TimelineBuilder::Init(IOutputWriter* pOutputWriter, ResourcePalette* pResourcePalette)
+    {
+        m_pOutputWriter = pOutputWriter;
+        m_pResourcePalette = pResourcePalette;
+
+        m_pOutputWriter->StartDefineTimeline();
+
+        // The output writer owns the timeline writer
+        m_pTimelineWriter = m_pOutputWriter->CreateTimelineWriter();
+        ASSERT(m_pTimelineWriter);
+    }
+
+
+    const std::vector<FCM::U_Int32>& TimelineBuilder::GetShapeResourceIds()
+    {
+        return m_shapeResourceIds;
+    }
+
+    /* ----------------------------------------------------- TimelineBuilderFactory */
+
+    TimelineBuilderFactory::TimelineBuilderFactory() :
+        m_pOutputWriter(NULL),
+        m_pResourcePalette(NULL)
+    {
+    }
+
+    TimelineBuilderFactory::~TimelineBuilderFactory()
+    {
+    }
+
+    FCM::Result TimelineBuilderFactory::CreateTimelineBuilder(PITimelineBuilder& pTimelineBuilder)
+    {
+        FCM::Result res = GetCallback()->CreateInstance(NULL, CLSID_TimelineBuilder, IID_ITIMELINE_BUILDER_2, (void**)&pTimelineBuilder);
+
+        TimelineBuilder* pTimeline = static_cast<TimelineBuilder*>(pTimelineBuilder);
+        
+        pTimeline->Init(m_pOutputWriter, m_pResourcePalette);
+
+        return res;
+    }
+
+    void TimelineBuilderFactory::Init(IOutputWriter* pOutputWriter, ResourcePalette* pResourcePalette)
+    {
+        m_pOutputWriter = pOutputWriter;
+        m_pResourcePalette = pResourcePalette;
+    }
+};
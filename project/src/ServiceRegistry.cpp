@@ -0,0 +1,236 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "ServiceRegistry.h"
+
+#include <map>
+#include <mutex>
+#include "ApplicationFCMPublicIDs.h"
+#include "Utils.h"
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+namespace CreateJS
+{
+    struct REGISTERED_SERVICES
+    {
+        FCM::U_Int32 refCount;
+
+        FCM::AutoPtr<FCM::IFCMStringUtils> pStringUtils;
+
+        FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
+
+        FCM::AutoPtr<Application::Service::IOutputConsoleService> pOutputConsole;
+    };
+
+    // Guarded by s_mutex. The helpers are also used by the asset export workers.
+    static std::mutex s_mutex;
+    static std::map<FCM::PIFCMCallback, REGISTERED_SERVICES> s_services;
+    static FCM::U_Int64 s_cachedLookups = 0;
+    static FCM::U_Int64 s_hostLookups = 0;
+}
+
+
+/* -------------------------------------------------- ServiceRegistry */
+
+namespace CreateJS
+{
+    void ServiceRegistry::Register(FCM::PIFCMCallback pCallback)
+    {
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+        ASSERT(pCallback);
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator it = s_services.find(pCallback);
+            if (it != s_services.end())
+            {
+                it->second.refCount++;
+                return;
+            }
+        }
+
+        // Resolved without the lock held; the host may call back into the plugin
+        REGISTERED_SERVICES services;
+        services.refCount = 1;
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, FCM::SRVCID_Core_StringUtils, pUnk)))
+        {
+            services.pStringUtils = pUnk;
+            pUnk.Reset();
+        }
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, FCM::SRVCID_Core_Memory, pUnk)))
+        {
+            services.pCalloc = pUnk;
+            pUnk.Reset();
+        }
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, Application::Service::APP_OUTPUT_CONSOLE_SERVICE, pUnk)))
+        {
+            services.pOutputConsole = pUnk;
+            pUnk.Reset();
+        }
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        std::pair<std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator, bool> inserted =
+            s_services.insert(std::make_pair(pCallback, services));
+        if (!inserted.second)
+        {
+            // Registered by another thread in the meantime
+            inserted.first->second.refCount++;
+        }
+    }
+
+
+    void ServiceRegistry::Unregister(FCM::PIFCMCallback pCallback)
+    {
+        REGISTERED_SERVICES services;
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator it = s_services.find(pCallback);
+            if (it == s_services.end())
+            {
+                ASSERT(0);
+                return;
+            }
+
+            if (--it->second.refCount > 0)
+            {
+                return;
+            }
+
+            services = it->second;
+            s_services.erase(it);
+        }
+
+        // The services are released here, outside the lock
+    }
+
+
+    FCM::AutoPtr<FCM::IFCMStringUtils> ServiceRegistry::GetStringUtilsService(FCM::PIFCMCallback pCallback)
+    {
+        FCM::AutoPtr<FCM::IFCMStringUtils> pStringUtils;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator it = s_services.find(pCallback);
+            if ((it != s_services.end()) && it->second.pStringUtils)
+            {
+                s_cachedLookups++;
+                return it->second.pStringUtils;
+            }
+        }
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, FCM::SRVCID_Core_StringUtils, pUnk)))
+        {
+            pStringUtils = pUnk;
+            pUnk.Reset();
+        }
+
+        return pStringUtils;
+    }
+
+
+    FCM::AutoPtr<FCM::IFCMCalloc> ServiceRegistry::GetCallocService(FCM::PIFCMCallback pCallback)
+    {
+        FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator it = s_services.find(pCallback);
+            if ((it != s_services.end()) && it->second.pCalloc)
+            {
+                s_cachedLookups++;
+                return it->second.pCalloc;
+            }
+        }
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, FCM::SRVCID_Core_Memory, pUnk)))
+        {
+            pCalloc = pUnk;
+            pUnk.Reset();
+        }
+
+        return pCalloc;
+    }
+
+
+    FCM::AutoPtr<Application::Service::IOutputConsoleService> ServiceRegistry::GetOutputConsoleService(
+        FCM::PIFCMCallback pCallback)
+    {
+        FCM::AutoPtr<Application::Service::IOutputConsoleService> pOutputConsole;
+        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+
+            std::map<FCM::PIFCMCallback, REGISTERED_SERVICES>::iterator it = s_services.find(pCallback);
+            if ((it != s_services.end()) && it->second.pOutputConsole)
+            {
+                s_cachedLookups++;
+                return it->second.pOutputConsole;
+            }
+        }
+
+        if (FCM_SUCCESS_CODE(LookUp(pCallback, Application::Service::APP_OUTPUT_CONSOLE_SERVICE, pUnk)))
+        {
+            pOutputConsole = pUnk;
+            pUnk.Reset();
+        }
+
+        return pOutputConsole;
+    }
+
+
+    void ServiceRegistry::GetStats(FCM::U_Int64& cachedLookups, FCM::U_Int64& hostLookups)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        cachedLookups = s_cachedLookups;
+        hostLookups = s_hostLookups;
+    }
+
+
+    void ServiceRegistry::ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        s_cachedLookups = 0;
+        s_hostLookups = 0;
+    }
+
+
+    FCM::Result ServiceRegistry::LookUp(
+        FCM::PIFCMCallback pCallback,
+        const FCM::SRVCID& serviceId,
+        FCM::AutoPtr<FCM::IFCMUnknown>& pService)
+    {
+        FCM::Result res = pCallback->GetService(serviceId, pService.m_Ptr);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_hostLookups++;
+
+        return res;
+    }
+};
@@ -0,0 +1,264 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "ShapeMorpher.h"
+
+#include <math.h>
+
+/* -------------------------------------------------- Constants */
+
+
+/* -------------------------------------------------- Static Functions */
+
+// The sums for the least squares ratio of "values" between "from" and "to"
+static void AddToFit(
+    const std::vector<FCM::Double>& from,
+    const std::vector<FCM::Double>& to,
+    const std::vector<FCM::Double>& values,
+    FCM::Double& numerator,
+    FCM::Double& denominator)
+{
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        FCM::Double change = to[i] - from[i];
+
+        numerator += (values[i] - from[i]) * change;
+        denominator += change * change;
+    }
+}
+
+
+/* -------------------------------------------------- ShapeMorpher */
+
+namespace CreateJS
+{
+    ShapeMorpher::ShapeMorpher()
+        : m_inShape(false)
+    {
+    }
+
+
+    ShapeMorpher::~ShapeMorpher()
+    {
+    }
+
+
+    void ShapeMorpher::Clear()
+    {
+        m_shapes.clear();
+        m_inShape = false;
+    }
+
+
+    void ShapeMorpher::StartShape()
+    {
+        m_shape.resId = 0;
+        m_shape.structure.clear();
+        m_shape.values.clear();
+        m_shape.colors.clear();
+        m_shape.morphable = true;
+
+        m_inShape = true;
+    }
+
+
+    void ShapeMorpher::AddCommand(char command)
+    {
+        if (m_inShape)
+        {
+            m_shape.structure.push_back(command);
+        }
+    }
+
+
+    void ShapeMorpher::AddValue(FCM::Double value)
+    {
+        if (m_inShape)
+        {
+            m_shape.values.push_back(value);
+        }
+    }
+
+
+    void ShapeMorpher::AddColor(const DOM::Utils::COLOR& color)
+    {
+        if (m_inShape)
+        {
+            m_shape.structure.push_back('C');
+            m_shape.colors.push_back(color.red);
+            m_shape.colors.push_back(color.green);
+            m_shape.colors.push_back(color.blue);
+            m_shape.colors.push_back(color.alpha);
+        }
+    }
+
+
+    void ShapeMorpher::SetNotMorphable()
+    {
+        m_shape.morphable = false;
+    }
+
+
+    void ShapeMorpher::EndShape(FCM::U_Int32 resId)
+    {
+        if (!m_inShape)
+        {
+            return;
+        }
+
+        m_inShape = false;
+
+        if (m_shape.morphable && !m_shape.values.empty())
+        {
+            m_shape.resId = resId;
+            m_shapes.push_back(m_shape);
+        }
+    }
+
+
+    void ShapeMorpher::GetMorphs(ShapeMorphMap& morphs)
+    {
+        std::map<std::string, std::vector<FCM::U_Int32> > groups;
+        std::map<std::string, std::vector<FCM::U_Int32> >::const_iterator it;
+
+        morphs.clear();
+
+        for (FCM::U_Int32 i = 0; i < m_shapes.size(); i++)
+        {
+            groups[m_shapes[i].structure].push_back(i);
+        }
+
+        for (it = groups.begin(); it != groups.end(); ++it)
+        {
+            const std::vector<FCM::U_Int32>& shapes = it->second;
+            FCM::U_Int32 start = 0;
+
+            while (start + MORPH_MIN_SHAPES <= shapes.size())
+            {
+                std::vector<FCM::Double> ratios;
+                FCM::U_Int32 end = FindMorph(shapes, start, ratios);
+
+                if (end == start)
+                {
+                    start++;
+                    continue;
+                }
+
+                // The last key may start the next morph
+                for (FCM::U_Int32 i = start + 1; i < end; i++)
+                {
+                    SHAPE_MORPH morph;
+
+                    morph.fromResId = m_shapes[shapes[start]].resId;
+                    morph.toResId = m_shapes[shapes[end]].resId;
+                    morph.ratio = ratios[i - start - 1];
+
+                    morphs[m_shapes[shapes[i]].resId] = morph;
+                }
+
+                start = end;
+            }
+        }
+    }
+
+
+    FCM::U_Int32 ShapeMorpher::FindMorph(
+        const std::vector<FCM::U_Int32>& shapes,
+        FCM::U_Int32 start,
+        std::vector<FCM::Double>& ratios)
+    {
+        FCM::U_Int32 last = start;
+        std::vector<FCM::Double> runRatios;
+
+        // As with tweens, a run that stops following one morph rarely follows it
+        // again further on
+        for (FCM::U_Int32 end = start + MORPH_MIN_SHAPES - 1; end < shapes.size(); end++)
+        {
+            const MORPH_SHAPE& from = m_shapes[shapes[start]];
+            const MORPH_SHAPE& to = m_shapes[shapes[end]];
+            FCM::Boolean fits = true;
+            FCM::Double previous = 0;
+
+            runRatios.clear();
+
+            for (FCM::U_Int32 i = start + 1; (i < end) && fits; i++)
+            {
+                FCM::Double ratio;
+
+                // The ratios of a tween only grow, which keeps unrelated shapes of
+                // the same structure out
+                fits = FitRatio(from, to, m_shapes[shapes[i]], ratio) && (ratio > previous) && (ratio < 1);
+
+                runRatios.push_back(ratio);
+                previous = ratio;
+            }
+
+            if (!fits)
+            {
+                break;
+            }
+
+            last = end;
+            ratios = runRatios;
+        }
+
+        return last;
+    }
+
+
+    FCM::Boolean ShapeMorpher::FitRatio(
+        const MORPH_SHAPE& from,
+        const MORPH_SHAPE& to,
+        const MORPH_SHAPE& shape,
+        FCM::Double& ratio)
+    {
+        FCM::Double numerator = 0;
+        FCM::Double denominator = 0;
+        FCM::Double scale = pow(10.0, MORPH_RATIO_PRECISION);
+
+        // Colors only decide the ratio of shapes that do not move
+        AddToFit(from.values, to.values, shape.values, numerator, denominator);
+        if (denominator == 0)
+        {
+            AddToFit(from.colors, to.colors, shape.colors, numerator, denominator);
+        }
+
+        if (denominator == 0)
+        {
+            return false;
+        }
+
+        // The ratio as it is written
+        ratio = floor((numerator / denominator) * scale + 0.5) / scale;
+
+        for (size_t i = 0; i < shape.values.size(); i++)
+        {
+            FCM::Double value = from.values[i] + (to.values[i] - from.values[i]) * ratio;
+
+            if (fabs(value - shape.values[i]) > MORPH_VALUE_TOLERANCE)
+            {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < shape.colors.size(); i++)
+        {
+            FCM::Double color = floor(from.colors[i] + (to.colors[i] - from.colors[i]) * ratio + 0.5);
+
+            if (fabs(color - shape.colors[i]) > MORPH_COLOR_TOLERANCE)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
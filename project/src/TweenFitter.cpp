@@ -0,0 +1,211 @@
+/*************************************************************************
+* ADOBE SYSTEMS INCORPORATED
+* Copyright 2013 Adobe Systems Incorporated
+* All Rights Reserved.
+
+* NOTICE:  Adobe permits you to use, modify, and distribute this file in accordance with the
+* terms of the Adobe license agreement accompanying it.  If you have received this file from a
+* source other than Adobe, then your use, modification, or distribution of it requires the prior
+* written permission of Adobe.
+**************************************************************************/
+
+#include "TweenFitter.h"
+
+#include <math.h>
+#include <vector>
+
+/* -------------------------------------------------- Constants */
+
+static const FCM::Double kPi = 3.14159265358979323846;
+
+
+/* -------------------------------------------------- Static Functions */
+
+static void ToArray(const CreateJS::TWEEN_TRANSFORM& transform, FCM::Double* pValues)
+{
+    pValues[0] = transform.x;
+    pValues[1] = transform.y;
+    pValues[2] = transform.scaleX;
+    pValues[3] = transform.scaleY;
+    pValues[4] = transform.skewX;
+    pValues[5] = transform.skewY;
+}
+
+
+/* -------------------------------------------------- TweenFitter */
+
+namespace CreateJS
+{
+    void TweenFitter::Decompose(const DOM::Utils::MATRIX2D& matrix, TWEEN_TRANSFORM& transform)
+    {
+        transform.x = matrix.tx;
+        transform.y = matrix.ty;
+        transform.scaleX = sqrt(matrix.a * matrix.a + matrix.b * matrix.b);
+        transform.scaleY = sqrt(matrix.c * matrix.c + matrix.d * matrix.d);
+        transform.skewX = atan2(-matrix.c, matrix.d);
+        transform.skewY = atan2(matrix.b, matrix.a);
+    }
+
+
+    void TweenFitter::Compose(const TWEEN_TRANSFORM& transform, DOM::Utils::MATRIX2D& matrix)
+    {
+        matrix.a = transform.scaleX * cos(transform.skewY);
+        matrix.b = transform.scaleX * sin(transform.skewY);
+        matrix.c = -transform.scaleY * sin(transform.skewX);
+        matrix.d = transform.scaleY * cos(transform.skewX);
+        matrix.tx = transform.x;
+        matrix.ty = transform.y;
+    }
+
+
+    void TweenFitter::Interpolate(
+        const TWEEN_TRANSFORM& start,
+        const TWEEN_TRANSFORM& end,
+        FCM::Double t,
+        FCM::Double ease,
+        DOM::Utils::MATRIX2D& matrix)
+    {
+        TWEEN_TRANSFORM transform;
+        FCM::Double f = t + ease * t * (1 - t);
+
+        transform.x = start.x + (end.x - start.x) * f;
+        transform.y = start.y + (end.y - start.y) * f;
+        transform.scaleX = start.scaleX + (end.scaleX - start.scaleX) * f;
+        transform.scaleY = start.scaleY + (end.scaleY - start.scaleY) * f;
+        transform.skewX = start.skewX + GetAngleDelta(start.skewX, end.skewX) * f;
+        transform.skewY = start.skewY + GetAngleDelta(start.skewY, end.skewY) * f;
+
+        Compose(transform, matrix);
+    }
+
+
+    FCM::U_Int32 TweenFitter::Fit(
+        const DOM::Utils::MATRIX2D& start,
+        const DOM::Utils::MATRIX2D* pMatrices,
+        FCM::U_Int32 count,
+        FCM::Double& ease)
+    {
+        TWEEN_TRANSFORM startTransform;
+        std::vector<TWEEN_TRANSFORM> transforms;
+        FCM::U_Int32 length = 0;
+
+        if (count < TWEEN_MIN_FRAMES)
+        {
+            return 0;
+        }
+
+        Decompose(start, startTransform);
+
+        // A run that stops following one tween rarely follows it again further on
+        for (FCM::U_Int32 n = 1; n <= count; n++)
+        {
+            FCM::Double runEase;
+
+            transforms.resize(n);
+            Decompose(pMatrices[n - 1], transforms[n - 1]);
+
+            if (n < TWEEN_MIN_FRAMES)
+            {
+                continue;
+            }
+
+            if (!FitEase(startTransform, &transforms[0], pMatrices, n, runEase))
+            {
+                break;
+            }
+
+            length = n;
+            ease = runEase;
+        }
+
+        return length;
+    }
+
+
+    FCM::Boolean TweenFitter::FitEase(
+        const TWEEN_TRANSFORM& start,
+        const TWEEN_TRANSFORM* pTransforms,
+        const DOM::Utils::MATRIX2D* pMatrices,
+        FCM::U_Int32 count,
+        FCM::Double& ease)
+    {
+        const TWEEN_TRANSFORM& end = pTransforms[count - 1];
+        FCM::Double startValues[6];
+        FCM::Double endValues[6];
+        FCM::Double numerator = 0;
+        FCM::Double denominator = 0;
+
+        ToArray(start, startValues);
+        ToArray(end, endValues);
+
+        endValues[4] = startValues[4] + GetAngleDelta(startValues[4], endValues[4]);
+        endValues[5] = startValues[5] + GetAngleDelta(startValues[5], endValues[5]);
+
+        // value - linear value = ease * change * t * (1 - t) for every property
+        for (FCM::U_Int32 i = 0; i < count - 1; i++)
+        {
+            FCM::Double t = (FCM::Double)(i + 1) / count;
+            FCM::Double weight = t * (1 - t);
+            FCM::Double values[6];
+
+            ToArray(pTransforms[i], values);
+
+            for (FCM::U_Int32 j = 0; j < 6; j++)
+            {
+                FCM::Double change = endValues[j] - startValues[j];
+                FCM::Double value = (j < 4) ? values[j] : startValues[j] + GetAngleDelta(startValues[j], values[j]);
+                FCM::Double residual = value - (startValues[j] + change * t);
+
+                numerator += residual * change * weight;
+                denominator += change * change * weight * weight;
+            }
+        }
+
+        ease = (denominator > 0) ? (numerator / denominator) : 0;
+        if (ease < -1)
+        {
+            ease = -1;
+        }
+        else if (ease > 1)
+        {
+            ease = 1;
+        }
+
+        for (FCM::U_Int32 i = 0; i < count; i++)
+        {
+            DOM::Utils::MATRIX2D matrix;
+
+            Interpolate(start, end, (FCM::Double)(i + 1) / count, ease, matrix);
+
+            if ((fabs(matrix.tx - pMatrices[i].tx) > TWEEN_TRANSLATE_TOLERANCE) ||
+                (fabs(matrix.ty - pMatrices[i].ty) > TWEEN_TRANSLATE_TOLERANCE) ||
+                (fabs(matrix.a - pMatrices[i].a) > TWEEN_SCALE_TOLERANCE) ||
+                (fabs(matrix.b - pMatrices[i].b) > TWEEN_SCALE_TOLERANCE) ||
+                (fabs(matrix.c - pMatrices[i].c) > TWEEN_SCALE_TOLERANCE) ||
+                (fabs(matrix.d - pMatrices[i].d) > TWEEN_SCALE_TOLERANCE))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    // Difference of two angles in (-pi, pi]
+    FCM::Double TweenFitter::GetAngleDelta(FCM::Double from, FCM::Double to)
+    {
+        FCM::Double delta = fmod(to - from, 2 * kPi);
+
+        if (delta > kPi)
+        {
+            delta -= 2 * kPi;
+        }
+        else if (delta <= -kPi)
+        {
+            delta += 2 * kPi;
+        }
+
+        return delta;
+    }
+};
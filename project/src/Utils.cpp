@@ -31,18 +31,29 @@
     #include <copyfile.h>
 #endif
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
 
+// SSE2 is part of every x64 target
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define USE_SSE2_TRANSCODER
+#endif
+
 #include "IFCMStringUtils.h"
 
 #include <string>
 #include <cstring>
 #include <stdlib.h>
+#include <math.h>
 #include "Application/Service/IOutputConsoleService.h"
 #include "Application/Service/IApplicationService.h"
 #include "ApplicationFCMPublicIDs.h"
+#include "ServiceRegistry.h"
 
 /* -------------------------------------------------- Constants */
 
@@ -53,11 +64,145 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 namespace CreateJS
 {
     static std::string comma = ",";
+
+    static const char hexDigits[] = "0123456789abcdef";
+
+    static const double powersOf10[MAX_NUMBER_PRECISION + 1] = 
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+    };
+
+    // Scaled values must stay below this to fit in a 64 bit integer
+    static const double MAX_SCALED_VALUE = 9.0e18;
 }
 
 
 /* -------------------------------------------------- Static Functions */
 
+namespace CreateJS
+{
+    // Writes the decimal digits of value to pBuffer, left padded with zeros to 
+    // minDigits. Returns the number of characters written.
+    static FCM::U_Int32 FormatDigits(char* pBuffer, FCM::U_Int64 value, FCM::U_Int32 minDigits)
+    {
+        char digits[24];
+        FCM::U_Int32 count = 0;
+
+        do
+        {
+            digits[count++] = (char)('0' + (value % 10));
+            value /= 10;
+        } while (value != 0);
+
+        while (count < minDigits)
+        {
+            digits[count++] = '0';
+        }
+
+        for (FCM::U_Int32 i = 0; i < count; i++)
+        {
+            pBuffer[i] = digits[count - i - 1];
+        }
+
+        return count;
+    }
+
+
+    // Appends the UTF-8 form of a null terminated UTF-16 string to out. Returns false,
+    // leaving out unchanged, if the string contains an unpaired surrogate.
+    static bool AppendUTF8(std::string& out, FCM::CStringRep16 pStr16)
+    {
+        size_t length = 0;
+        size_t start = out.size();
+        size_t i = 0;
+
+        if (pStr16 == NULL)
+        {
+            return true;
+        }
+
+        while (pStr16[length] != 0)
+        {
+            length++;
+        }
+
+        if (length == 0)
+        {
+            return true;
+        }
+
+        // No UTF-16 code unit needs more than 3 bytes (a surrogate pair needs 4)
+        out.resize(start + length * 3);
+        char* pOut = &out[start];
+
+        while (i < length)
+        {
+#ifdef USE_SSE2_TRANSCODER
+            // Copy runs of ASCII 16 code units at a time
+            const __m128i nonAsciiMask = _mm_set1_epi16((short)0xFF80);
+            const __m128i zero = _mm_setzero_si128();
+
+            while ((i + 16) <= length)
+            {
+                __m128i low = _mm_loadu_si128((const __m128i*)(pStr16 + i));
+                __m128i high = _mm_loadu_si128((const __m128i*)(pStr16 + i + 8));
+                __m128i nonAscii = _mm_and_si128(_mm_or_si128(low, high), nonAsciiMask);
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF)
+                {
+                    break;
+                }
+
+                _mm_storeu_si128((__m128i*)pOut, _mm_packus_epi16(low, high));
+                pOut += 16;
+                i += 16;
+            }
+
+            if (i >= length)
+            {
+                break;
+            }
+#endif
+            FCM::U_Int32 c = pStr16[i++];
+
+            if (c < 0x80)
+            {
+                *pOut++ = (char)c;
+            }
+            else if (c < 0x800)
+            {
+                *pOut++ = (char)(0xC0 | (c >> 6));
+                *pOut++ = (char)(0x80 | (c & 0x3F));
+            }
+            else if ((c >= 0xD800) && (c <= 0xDFFF))
+            {
+                if ((c > 0xDBFF) || (i >= length) || (pStr16[i] < 0xDC00) || (pStr16[i] > 0xDFFF))
+                {
+                    out.resize(start);
+                    return false;
+                }
+
+                c = 0x10000 + ((c - 0xD800) << 10) + (pStr16[i++] - 0xDC00);
+
+                *pOut++ = (char)(0xF0 | (c >> 18));
+                *pOut++ = (char)(0x80 | ((c >> 12) & 0x3F));
+                *pOut++ = (char)(0x80 | ((c >> 6) & 0x3F));
+                *pOut++ = (char)(0x80 | (c & 0x3F));
+            }
+            else
+            {
+                *pOut++ = (char)(0xE0 | (c >> 12));
+                *pOut++ = (char)(0x80 | ((c >> 6) & 0x3F));
+                *pOut++ = (char)(0x80 | (c & 0x3F));
+            }
+        }
+
+        out.resize(pOut - out.data());
+
+        return true;
+    }
+}
+
 
 /* -------------------------------------------------- Utils */
 
@@ -65,27 +210,13 @@ namespace CreateJS
 {
     FCM::AutoPtr<FCM::IFCMStringUtils> Utils::GetStringUtilsService(FCM::PIFCMCallback pCallback)
     {
-        FCM::AutoPtr<FCM::IFCMUnknown> pIFCMStringUtilsUnknown;
-        FCM::Result res = pCallback->GetService(FCM::SRVCID_Core_StringUtils, pIFCMStringUtilsUnknown.m_Ptr);
-        if (FCM_FAILURE_CODE(res))
-        {
-            return NULL;
-        }
-        FCM::AutoPtr<FCM::IFCMStringUtils> pIFCMStringUtils = pIFCMStringUtilsUnknown;
-        return pIFCMStringUtils;
+        return ServiceRegistry::GetStringUtilsService(pCallback);
     }
     
 
     FCM::AutoPtr<FCM::IFCMCalloc> Utils::GetCallocService(FCM::PIFCMCallback pCallback)
     {
-        FCM::AutoPtr<FCM::IFCMUnknown> pIFCMCallocUnknown;
-        FCM::Result res = pCallback->GetService(FCM::SRVCID_Core_Memory, pIFCMCallocUnknown.m_Ptr);
-        if (FCM_FAILURE_CODE(res))
-        {
-            return NULL;
-        }
-        FCM::AutoPtr<FCM::IFCMCalloc> pIFCMCalloc = pIFCMCallocUnknown;
-        return pIFCMCalloc;
+        return ServiceRegistry::GetCallocService(pCallback);
     }
     
 
@@ -166,11 +297,19 @@ namespace CreateJS
     
     std::string Utils::ToString(FCM::CStringRep16 pStr16, FCM::PIFCMCallback pCallback)
     {
+        std::string string;
+
+        if (AppendUTF8(string, pStr16))
+        {
+            return string;
+        }
+
+        // Malformed strings are converted by the host, as before
         FCM::StringRep8 pStr8 = NULL;
         FCM::AutoPtr<FCM::IFCMStringUtils> pStrUtils = GetStringUtilsService(pCallback);
         pStrUtils->ConvertStringRep16to8(pStr16, pStr8);
         
-        std::string string = (const char*)pStr8;
+        string = (const char*)pStr8;
         
         FCM::AutoPtr<FCM::IFCMCalloc> pCalloc = GetCallocService(pCallback);
         pCalloc->Free(pStr8);
@@ -184,20 +323,18 @@ namespace CreateJS
         return string;
     }
     
-    std::string Utils::ToString(const double& in)
+    std::string Utils::ToString(const double& in, FCM::U_Int32 precision)
     {
-        char buffer[32];
-        sprintf(buffer,"%.6f", in);
-        std::string str(buffer);
-        return str;
+        char buffer[NUMBER_BUFFER_SIZE];
+        FCM::U_Int32 length = FormatNumber(buffer, in, precision);
+        return std::string(buffer, length);
     }
     
-    std::string Utils::ToString(const float& in)
+    std::string Utils::ToString(const float& in, FCM::U_Int32 precision)
     {
-        char buffer[32];
-        sprintf(buffer,"%.6f", in);
-        std::string str(buffer);
-        return str;
+        char buffer[NUMBER_BUFFER_SIZE];
+        FCM::U_Int32 length = FormatNumber(buffer, in, precision);
+        return std::string(buffer, length);
     }
     
     std::string Utils::ToString(const FCM::U_Int32& in)
@@ -216,21 +353,12 @@ namespace CreateJS
         return str;
     }
     
-    std::string Utils::ToString(const DOM::Utils::MATRIX2D& matrix)
-    {
-        std::string matrixString = "";
-
-        matrixString.append(ToString(matrix.a));
-        matrixString.append(comma);
-        matrixString.append(ToString(matrix.b));
-        matrixString.append(comma);
-        matrixString.append(ToString(matrix.c));
-        matrixString.append(comma);
-        matrixString.append(ToString(matrix.d));
-        matrixString.append(comma);
-        matrixString.append(ToString(matrix.tx));
-        matrixString.append(comma);
-        matrixString.append(ToString(matrix.ty));
+    std::string Utils::ToString(const DOM::Utils::MATRIX2D& matrix, FCM::U_Int32 precision)
+    {
+        std::string matrixString;
+
+        matrixString.reserve(6 * NUMBER_BUFFER_SIZE);
+        AppendMatrix(matrixString, matrix, precision);
 
         return matrixString;
     }
@@ -319,21 +447,123 @@ namespace CreateJS
 
     std::string Utils::ToString(const DOM::Utils::COLOR& color)
     {
-        char cstr[5];
         std::string colorStr;
 
-        colorStr.append("#");
-        sprintf(cstr, "%02x", color.red);
-        colorStr.append(cstr);
-        sprintf(cstr, "%02x", color.green);
-        colorStr.append(cstr);
-        sprintf(cstr, "%02x", color.blue);
-        colorStr.append(cstr);
+        AppendColor(colorStr, color);
 
         return colorStr;
     }
 
 
+    FCM::U_Int32 Utils::FormatNumber(char* pBuffer, double in, FCM::U_Int32 precision)
+    {
+        FCM::U_Int32 length = 0;
+        double scale;
+        double scaled;
+        FCM::U_Int64 value;
+        FCM::U_Int64 intPart;
+        FCM::U_Int64 fracPart;
+        FCM::U_Int64 divisor;
+
+        if (precision > MAX_NUMBER_PRECISION)
+        {
+            precision = MAX_NUMBER_PRECISION;
+        }
+
+        scale = powersOf10[precision];
+        scaled = fabs(in) * scale + 0.5;
+
+        if (!(scaled < MAX_SCALED_VALUE))
+        {
+            // Huge values (and NaN/infinity) are rare, let the C runtime handle them
+            int count = snprintf(pBuffer, NUMBER_BUFFER_SIZE, "%.*g", (int)(precision + 1), in);
+            if ((count < 0) || (count >= NUMBER_BUFFER_SIZE))
+            {
+                count = NUMBER_BUFFER_SIZE - 1;
+            }
+            return (FCM::U_Int32)count;
+        }
+
+        value = (FCM::U_Int64)scaled;
+        divisor = (FCM::U_Int64)scale;
+        intPart = value / divisor;
+        fracPart = value % divisor;
+
+        // Values that round to zero are written as "0" rather than "-0"
+        if ((in < 0) && (value != 0))
+        {
+            pBuffer[length++] = '-';
+        }
+
+        length += FormatDigits(pBuffer + length, intPart, 1);
+
+        if (fracPart != 0)
+        {
+            pBuffer[length++] = '.';
+            length += FormatDigits(pBuffer + length, fracPart, precision);
+
+            while (pBuffer[length - 1] == '0')
+            {
+                length--;
+            }
+        }
+
+        pBuffer[length] = '\0';
+
+        return length;
+    }
+
+
+    void Utils::AppendNumber(std::string& out, double in, FCM::U_Int32 precision)
+    {
+        char buffer[NUMBER_BUFFER_SIZE];
+        FCM::U_Int32 length = FormatNumber(buffer, in, precision);
+
+        out.append(buffer, length);
+    }
+
+
+    void Utils::AppendNumber(std::string& out, FCM::U_Int32 in)
+    {
+        char buffer[NUMBER_BUFFER_SIZE];
+        FCM::U_Int32 length = FormatDigits(buffer, in, 1);
+
+        out.append(buffer, length);
+    }
+
+
+    void Utils::AppendMatrix(std::string& out, const DOM::Utils::MATRIX2D& matrix, FCM::U_Int32 precision)
+    {
+        AppendNumber(out, matrix.a, precision);
+        out.append(comma);
+        AppendNumber(out, matrix.b, precision);
+        out.append(comma);
+        AppendNumber(out, matrix.c, precision);
+        out.append(comma);
+        AppendNumber(out, matrix.d, precision);
+        out.append(comma);
+        AppendNumber(out, matrix.tx, precision);
+        out.append(comma);
+        AppendNumber(out, matrix.ty, precision);
+    }
+
+
+    void Utils::AppendColor(std::string& out, const DOM::Utils::COLOR& color)
+    {
+        char colorStr[7];
+
+        colorStr[0] = '#';
+        colorStr[1] = hexDigits[color.red >> 4];
+        colorStr[2] = hexDigits[color.red & 0xF];
+        colorStr[3] = hexDigits[color.green >> 4];
+        colorStr[4] = hexDigits[color.green & 0xF];
+        colorStr[5] = hexDigits[color.blue >> 4];
+        colorStr[6] = hexDigits[color.blue & 0xF];
+
+        out.append(colorStr, 7);
+    }
+
+
     void Utils::TransformPoint(
             const DOM::Utils::MATRIX2D& matrix, 
             DOM::Utils::POINT2D& inPoint,
@@ -486,11 +716,8 @@ namespace CreateJS
 
     void Utils::Trace(FCM::PIFCMCallback pCallback, const char* fmt, ...)
     {
-        FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
-        FCM::AutoPtr<Application::Service::IOutputConsoleService> outputConsoleService;
-        FCM::Result tempRes = pCallback->GetService(Application::Service::APP_OUTPUT_CONSOLE_SERVICE, pUnk.m_Ptr);
-        outputConsoleService = pUnk;
-        pUnk.Reset();
+        FCM::AutoPtr<Application::Service::IOutputConsoleService> outputConsoleService =
+            ServiceRegistry::GetOutputConsoleService(pCallback);
 
         if (outputConsoleService)
         {
@@ -561,6 +788,40 @@ namespace CreateJS
     }
 
 
+    // Gets the time a file or folder was last modified, in seconds since 1970. Returns
+    // an error if it does not exist.
+    FCM::Result Utils::GetModificationTime(const std::string& path, FCM::U_Int64& time, FCM::PIFCMCallback pCallback)
+    {
+#ifdef _WINDOWS
+
+        struct _stat64 sb;
+
+        FCM::StringRep16 pFullPath = Utils::ToString16(path, pCallback);
+        ASSERT(pFullPath);
+
+        int err = _wstat64(pFullPath, &sb);
+
+        FCM::AutoPtr<FCM::IFCMCalloc> pCalloc = Utils::GetCallocService(pCallback);
+        ASSERT(pCalloc.m_Ptr != NULL);  
+        pCalloc->Free(pFullPath);
+
+#else
+        struct stat sb;
+
+        int err = stat(path.c_str(), &sb);
+#endif
+
+        if (err != 0)
+        {
+            return FCM_GENERAL_ERROR;
+        }
+
+        time = (FCM::U_Int64)sb.st_mtime;
+
+        return FCM_SUCCESS;
+    }
+
+
     // Copies a source folder to a destination folder. In other words, dstFolder contains
     // the srcFolder after the operation.
     FCM::Result Utils::CopyDir(const std::string& srcFolder, const std::string& dstFolder, FCM::PIFCMCallback pCallback)